@@ -25,6 +25,7 @@
 #include "common/util.h"
 #include "common/system.h"
 #include "common/textconsole.h"
+#include "common/trace.h"
 
 #include "audio/mixer_intern.h"
 #include "audio/rate.h"
@@ -269,6 +270,7 @@ void MixerImpl::playStream(
 int MixerImpl::mixCallback(byte *samples, uint len) {
 	assert(samples);
 
+	TRACE_SCOPE("audio", "MixerImpl::mixCallback");
 	Common::StackLock lock(_mutex);
 
 	int16 *buf = (int16 *)samples;
@@ -173,6 +173,19 @@ public:
 	 */
 	virtual bool isWritable() const = 0;
 
+	/**
+	 * Retrieves the size and the last modification time of the file
+	 * referred by this node, without opening it.
+	 *
+	 * @note By default, this is not supported and false is returned.
+	 *
+	 * @param size Set to the size of the file in bytes.
+	 * @param modificationTime Set to the time of the last modification, in
+	 *                         seconds since the Unix epoch.
+	 * @return true if successful, false otherwise.
+	 */
+	virtual bool getFileStat(uint32 &size, uint32 &modificationTime) const { return false; }
+
 
 	/**
 	 * Creates a SeekableReadStream instance corresponding to the file
@@ -32,6 +32,10 @@
 #include "backends/fs/posix/posix-fs-factory.h"
 #include "backends/fs/posix/posix-fs.h"
 
+void POSIXFilesystemFactory::setMapFiles(bool enable) {
+	POSIXFilesystemNode::_mapFiles = enable;
+}
+
 AbstractFSNode *POSIXFilesystemFactory::makeRootFileNode() const {
 	return new POSIXFilesystemNode("/");
 }
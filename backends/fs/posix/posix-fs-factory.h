@@ -31,6 +31,13 @@
  * Parts of this class are documented in the base interface class, FilesystemFactory.
  */
 class POSIXFilesystemFactory : public FilesystemFactory {
+public:
+	/**
+	 * Whether the read streams of all nodes map their files into memory,
+	 * instead of reading them through stdio. Off by default.
+	 */
+	void setMapFiles(bool enable);
+
 protected:
 	virtual AbstractFSNode *makeRootFileNode() const;
 	virtual AbstractFSNode *makeCurrentDirectoryFileNode() const;
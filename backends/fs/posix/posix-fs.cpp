@@ -34,6 +34,10 @@
 #include "backends/fs/stdiostream.h"
 #include "common/algorithm.h"
 
+#ifdef POSIX
+#include "backends/fs/posix/posix-mmapstream.h"
+#endif
+
 #include <sys/param.h>
 #include <sys/stat.h>
 #ifdef PSP2
@@ -59,6 +63,19 @@ void POSIXFilesystemNode::setFlags() {
 	_isDirectory = _isValid ? S_ISDIR(st.st_mode) : false;
 }
 
+bool POSIXFilesystemNode::getFileStat(uint32 &size, uint32 &modificationTime) const {
+	struct stat st;
+
+	if (stat(_path.c_str(), &st) != 0 || S_ISDIR(st.st_mode))
+		return false;
+
+	size = (uint32)st.st_size;
+	modificationTime = (uint32)st.st_mtime;
+	return true;
+}
+
+bool POSIXFilesystemNode::_mapFiles = false;
+
 POSIXFilesystemNode::POSIXFilesystemNode(const Common::String &p) {
 	assert(p.size() > 0);
 
@@ -251,6 +268,16 @@ AbstractFSNode *POSIXFilesystemNode::getParent() const {
 }
 
 Common::SeekableReadStream *POSIXFilesystemNode::createReadStream() {
+#ifdef POSIX
+	// Map the file if the user asked for it, and fall back to stdio for
+	// files which can not be mapped
+	if (_mapFiles) {
+		Common::SeekableReadStream *stream = MmapStream::makeFromPath(getPath());
+		if (stream)
+			return stream;
+	}
+#endif
+
 	return StdioStream::makeFromPath(getPath(), false);
 }
 
@@ -42,6 +42,14 @@ protected:
 	bool _isDirectory;
 	bool _isValid;
 
+	/**
+	 * Whether createReadStream() maps files into memory. This is set once
+	 * at startup, through POSIXFilesystemFactory::setMapFiles().
+	 */
+	static bool _mapFiles;
+
+	friend class POSIXFilesystemFactory;
+
 	virtual AbstractFSNode *makeNode(const Common::String &path) const {
 		return new POSIXFilesystemNode(path);
 	}
@@ -66,6 +74,7 @@ public:
 	virtual bool isDirectory() const { return _isDirectory; }
 	virtual bool isReadable() const { return access(_path.c_str(), R_OK) == 0; }
 	virtual bool isWritable() const { return access(_path.c_str(), W_OK) == 0; }
+	virtual bool getFileStat(uint32 &size, uint32 &modificationTime) const;
 
 	virtual AbstractFSNode *getChild(const Common::String &n) const;
 	virtual bool getChildren(AbstractFSList &list, ListMode mode, bool hidden) const;
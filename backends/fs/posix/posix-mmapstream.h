@@ -0,0 +1,55 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef BACKENDS_FS_POSIX_MMAPSTREAM_H
+#define BACKENDS_FS_POSIX_MMAPSTREAM_H
+
+#include "common/scummsys.h"
+#include "common/memstream.h"
+#include "common/noncopyable.h"
+#include "common/str.h"
+
+/**
+ * A read stream on a file which is mapped into memory as a whole. Reads are
+ * plain copies from the mapping, and getDataPointer() gives access to all of
+ * it, so the data can be used in place. The pages are shared with the page
+ * cache of the system instead of taking up private memory.
+ */
+class MmapStream : public Common::MemoryReadStream, public Common::NonCopyable {
+public:
+	/**
+	 * Given a path, maps the file into memory and wraps the mapping in a
+	 * MmapStream instance. Returns 0 if the file can not be mapped, e.g.
+	 * because it is empty or not a regular file.
+	 */
+	static MmapStream *makeFromPath(const Common::String &path);
+
+	virtual ~MmapStream();
+
+private:
+	MmapStream(void *mapping, uint32 size);
+
+	void *_mapping;
+	uint32 _mappingSize;
+};
+
+#endif
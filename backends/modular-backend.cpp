@@ -29,6 +29,7 @@
 #include "gui/EventRecorder.h"
 
 #include "audio/mixer.h"
+#include "common/trace.h"
 #include "graphics/pixelformat.h"
 
 ModularBackend::ModularBackend()
@@ -154,6 +155,8 @@ void ModularBackend::fillScreen(uint32 col) {
 }
 
 void ModularBackend::updateScreen() {
+	TRACE_SCOPE("graphics", "OSystem::updateScreen");
+
 #ifdef ENABLE_EVENTRECORDER
 	g_eventRec.preDrawOverlayGui();
 #endif
@@ -163,6 +166,8 @@ void ModularBackend::updateScreen() {
 #ifdef ENABLE_EVENTRECORDER
 	g_eventRec.postDrawOverlayGui();
 #endif
+
+	TRACE_FRAME();
 }
 
 void ModularBackend::setShakePos(int shakeOffset) {
@@ -41,6 +41,7 @@
 #include "backends/audiocd/linux/linux-audiocd.h"
 #endif
 
+#include "common/config-manager.h"
 #include "common/textconsole.h"
 
 #include <stdlib.h>
@@ -72,6 +73,9 @@ void OSystem_POSIX::initBackend() {
 	if (_savefileManager == 0)
 		_savefileManager = new POSIXSaveFileManager();
 
+	// The config file and command line have been read by now
+	((POSIXFilesystemFactory *)_fsFactory)->setMapFiles(ConfMan.getBool("mmap_files"));
+
 	// Invoke parent implementation of this method
 	OSystem_SDL::initBackend();
 
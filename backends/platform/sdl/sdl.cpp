@@ -78,6 +78,10 @@ OSystem_SDL::OSystem_SDL()
 	_firstGLMode(0),
 	_defaultSDLMode(0),
 	_defaultGLMode(0),
+#endif
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+	_microsFrequency(1),
+	_microsStart(0),
 #endif
 	_inited(false),
 	_initedSDL(false),
@@ -190,6 +194,13 @@ void OSystem_SDL::initBackend() {
 	// Check if backend has not been initialized
 	assert(!_inited);
 
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+	// getMicros() is used by the mixer thread as well, so its clock is set
+	// up here, before any other thread runs
+	_microsFrequency = SDL_GetPerformanceFrequency();
+	_microsStart = SDL_GetPerformanceCounter();
+#endif
+
 #if SDL_VERSION_ATLEAST(2, 0, 0)
 	const char *sdlDriverName = SDL_GetCurrentVideoDriver();
 #else
@@ -512,6 +523,13 @@ uint32 OSystem_SDL::getMillis(bool skipRecord) {
 	return millis;
 }
 
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+uint64 OSystem_SDL::getMicros() {
+	uint64 ticks = SDL_GetPerformanceCounter() - _microsStart;
+	return ticks / _microsFrequency * 1000000 + ticks % _microsFrequency * 1000000 / _microsFrequency;
+}
+#endif
+
 void OSystem_SDL::delayMillis(uint msecs) {
 #ifdef ENABLE_EVENTRECORDER
 	if (!g_eventRec.processDelayMillis())
@@ -519,6 +537,54 @@ void OSystem_SDL::delayMillis(uint msecs) {
 		SDL_Delay(msecs);
 }
 
+struct SdlThreadStart {
+	OSystem::ThreadProc proc;
+	void *param;
+};
+
+static int sdlThreadProc(void *param) {
+	SdlThreadStart start = *(SdlThreadStart *)param;
+	delete (SdlThreadStart *)param;
+	start.proc(start.param);
+	return 0;
+}
+
+OSystem::ThreadRef OSystem_SDL::createThread(ThreadProc proc, void *param) {
+	SdlThreadStart *start = new SdlThreadStart;
+	start->proc = proc;
+	start->param = param;
+
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+	SDL_Thread *thread = SDL_CreateThread(sdlThreadProc, "ScummVM worker", start);
+#else
+	SDL_Thread *thread = SDL_CreateThread(sdlThreadProc, start);
+#endif
+	if (!thread)
+		delete start;
+
+	return (ThreadRef)thread;
+}
+
+void OSystem_SDL::joinThread(ThreadRef thread) {
+	SDL_WaitThread((SDL_Thread *)thread, 0);
+}
+
+OSystem::SemaphoreRef OSystem_SDL::createSemaphore(uint initialValue) {
+	return (SemaphoreRef)SDL_CreateSemaphore(initialValue);
+}
+
+void OSystem_SDL::waitSemaphore(SemaphoreRef sem) {
+	SDL_SemWait((SDL_sem *)sem);
+}
+
+void OSystem_SDL::postSemaphore(SemaphoreRef sem) {
+	SDL_SemPost((SDL_sem *)sem);
+}
+
+void OSystem_SDL::deleteSemaphore(SemaphoreRef sem) {
+	SDL_DestroySemaphore((SDL_sem *)sem);
+}
+
 void OSystem_SDL::getTimeAndDate(TimeDate &td) const {
 	time_t curTime = time(0);
 	struct tm t = *localtime(&curTime);
@@ -78,13 +78,28 @@ public:
 	virtual void setWindowCaption(const char *caption);
 	virtual void addSysArchivesToSearchSet(Common::SearchSet &s, int priority = 0);
 	virtual uint32 getMillis(bool skipRecord = false);
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+	virtual uint64 getMicros();
+#endif
 	virtual void delayMillis(uint msecs);
+	virtual ThreadRef createThread(ThreadProc proc, void *param);
+	virtual void joinThread(ThreadRef thread);
+	virtual SemaphoreRef createSemaphore(uint initialValue);
+	virtual void waitSemaphore(SemaphoreRef sem);
+	virtual void postSemaphore(SemaphoreRef sem);
+	virtual void deleteSemaphore(SemaphoreRef sem);
 	virtual void getTimeAndDate(TimeDate &td) const;
 	virtual Audio::Mixer *getMixer();
 	virtual Common::TimerManager *getTimerManager();
 	virtual Common::SaveFileManager *getSavefileManager();
 
 protected:
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+	/** The performance counter rate, and its value in initBackend() */
+	uint64 _microsFrequency;
+	uint64 _microsStart;
+#endif
+
 	bool _inited;
 	bool _initedSDL;
 #ifdef USE_SDL_NET
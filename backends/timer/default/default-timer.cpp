@@ -22,6 +22,7 @@
 
 #include "common/scummsys.h"
 #include "backends/timer/default/default-timer.h"
+#include "common/algorithm.h"
 #include "common/util.h"
 #include "common/system.h"
 
@@ -34,48 +35,141 @@ struct TimerSlot {
 	uint32 nextFireTime;	// in milliseconds
 	uint32 nextFireTimeMicro;	// microseconds part of nextFire
 
+	// Statistics
+	uint32 calls;
+	uint32 lastCallTime;	// in milliseconds
+	uint64 intervalSum;		// in microseconds, as all following
+	uint64 jitterSum;
+	uint32 minInterval;
+	uint32 maxInterval;
+	uint32 maxLateness;		// in milliseconds
+
 	TimerSlot *next;
+	TimerSlot **prev;	// the pointer pointing to this slot
 };
 
-void insertPrioQueue(TimerSlot *head, TimerSlot *newSlot) {
-	// The head points to a fake anchor TimerSlot; this common
-	// trick allows us to get rid of many special cases.
-
-	const uint32 nextFireTime = newSlot->nextFireTime;
-	TimerSlot *slot = head;
-	newSlot->next = 0;
-
-	// Insert the new slot into the sorted list of already scheduled
-	// timers in such a way that the list stays sorted...
-	while (true) {
-		assert(slot);
-		if (slot->next == 0 || nextFireTime < slot->next->nextFireTime) {
-			newSlot->next = slot->next;
-			slot->next = newSlot;
-			return;
+static void linkSlot(TimerSlot *&list, TimerSlot *slot) {
+	slot->next = list;
+	if (list)
+		list->prev = &slot->next;
+	slot->prev = &list;
+	list = slot;
+}
+
+static void unlinkSlot(TimerSlot *slot) {
+	*slot->prev = slot->next;
+	if (slot->next)
+		slot->next->prev = slot->prev;
+}
+
+static void deleteSlots(TimerSlot *&list) {
+	while (list) {
+		TimerSlot *slot = list;
+		unlinkSlot(slot);
+		delete slot;
+	}
+}
+
+static void removeSlots(TimerSlot *&list, Common::TimerManager::TimerProc callback) {
+	TimerSlot *slot = list;
+	while (slot) {
+		TimerSlot *next = slot->next;
+		if (slot->callback == callback) {
+			unlinkSlot(slot);
+			delete slot;
 		}
-		slot = slot->next;
+		slot = next;
+	}
+}
+
+static void addStats(Common::Array<Common::TimerStats> &stats, const TimerSlot *slot) {
+	for (; slot; slot = slot->next) {
+		Common::TimerStats s;
+		s.id = slot->id;
+		s.interval = slot->interval;
+		s.calls = slot->calls;
+		s.meanInterval = slot->calls > 1 ? (uint32)(slot->intervalSum / (slot->calls - 1)) : 0;
+		s.minInterval = slot->calls > 1 ? slot->minInterval : 0;
+		s.maxInterval = slot->maxInterval;
+		s.jitter = slot->calls > 1 ? (uint32)(slot->jitterSum / (slot->calls - 1)) : 0;
+		s.maxLateness = slot->maxLateness;
+		stats.push_back(s);
 	}
 }
 
+static bool statsLess(const Common::TimerStats &a, const Common::TimerStats &b) {
+	return a.id < b.id;
+}
+
 
 DefaultTimerManager::DefaultTimerManager() :
-	_head(0) {
+	_wheelTime(g_system->getMillis(true)), _pending(0) {
 
-	_head = new TimerSlot();
-	memset(_head, 0, sizeof(TimerSlot));
+	memset(_root, 0, sizeof(_root));
+	memset(_levels, 0, sizeof(_levels));
 }
 
 DefaultTimerManager::~DefaultTimerManager() {
 	Common::StackLock lock(_mutex);
+	Common::StackLock pendingLock(_pendingMutex);
 
-	TimerSlot *slot = _head;
-	while (slot) {
-		TimerSlot *next = slot->next;
-		delete slot;
-		slot = next;
+	for (int i = 0; i < kRootSize; ++i)
+		deleteSlots(_root[i]);
+	for (int level = 0; level < kLevels; ++level) {
+		for (int i = 0; i < kLevelSize; ++i)
+			deleteSlots(_levels[level][i]);
+	}
+	deleteSlots(_pending);
+}
+
+void DefaultTimerManager::schedule(TimerSlot *slot) {
+	uint32 fireTime = slot->nextFireTime;
+	uint32 delta = fireTime - _wheelTime;
+
+	// Overdue timers fire as soon as possible
+	if ((int32)delta < 0) {
+		fireTime = _wheelTime;
+		delta = 0;
+	}
+
+	if (delta < kRootSize) {
+		linkSlot(_root[fireTime & (kRootSize - 1)], slot);
+		return;
+	}
+
+	// Find the lowest level whose turn covers the fire time
+	int level = 0;
+	int shift = kRootBits;
+	while (level < kLevels - 1 && delta >= (1U << (shift + kLevelBits))) {
+		level++;
+		shift += kLevelBits;
+	}
+	linkSlot(_levels[level][(fireTime >> shift) & (kLevelSize - 1)], slot);
+}
+
+void DefaultTimerManager::cascade(int level, uint index) {
+	// Move the timers of a list down to the lower levels
+	TimerSlot *&list = _levels[level][index];
+	while (list) {
+		TimerSlot *slot = list;
+		unlinkSlot(slot);
+		schedule(slot);
+	}
+}
+
+void DefaultTimerManager::schedulePending() {
+	_pendingMutex.lock();
+	TimerSlot *pending = _pending;
+	if (pending)
+		pending->prev = &pending;
+	_pending = 0;
+	_pendingMutex.unlock();
+
+	while (pending) {
+		TimerSlot *slot = pending;
+		unlinkSlot(slot);
+		schedule(slot);
 	}
-	_head = 0;
 }
 
 void DefaultTimerManager::handler() {
@@ -83,35 +177,87 @@ void DefaultTimerManager::handler() {
 
 	uint32 curTime = g_system->getMillis(true);
 
-	// Repeat as long as there is a TimerSlot that is scheduled to fire.
-	TimerSlot *slot = _head->next;
-	while (slot && slot->nextFireTime < curTime) {
-		// Remove the slot from the priority queue
-		_head->next = slot->next;
-
-		// Update the fire time and reinsert the TimerSlot into the priority
-		// queue.
-		assert(slot->interval > 0);
-		slot->nextFireTime += (slot->interval / 1000);
-		slot->nextFireTimeMicro += (slot->interval % 1000);
-		if (slot->nextFireTimeMicro > 1000) {
-			slot->nextFireTime += slot->nextFireTimeMicro / 1000;
-			slot->nextFireTimeMicro %= 1000;
+	schedulePending();
+
+	// Process every millisecond up to the current one, which fires all
+	// timers scheduled to fire before the current time.
+	while ((int32)(curTime - _wheelTime) > 0) {
+		const uint index = _wheelTime & (kRootSize - 1);
+
+		// At the start of a new turn of the root level, bring down the
+		// timers for it from the upper levels
+		if (index == 0) {
+			int level = 0;
+			int shift = kRootBits;
+			uint levelIndex;
+			do {
+				levelIndex = (_wheelTime >> shift) & (kLevelSize - 1);
+				cascade(level, levelIndex);
+				level++;
+				shift += kLevelBits;
+			} while (levelIndex == 0 && level < kLevels);
 		}
-		insertPrioQueue(_head, slot);
 
-		// Invoke the timer callback
-		assert(slot->callback);
-		slot->callback(slot->refCon);
+		// Timers rescheduled for the same millisecond are put on the
+		// same list again, so they fire as often as they were due
+		TimerSlot *&list = _root[index];
+		while (list) {
+			TimerSlot *slot = list;
+			unlinkSlot(slot);
+
+			// Update the statistics
+			if (slot->calls) {
+				const uint32 elapsed = curTime - slot->lastCallTime;
+				const uint32 actual = elapsed < 0xFFFFFFFF / 1000 ? elapsed * 1000 : 0xFFFFFFFF;
+				slot->intervalSum += actual;
+				slot->jitterSum += actual > slot->interval ? actual - slot->interval : slot->interval - actual;
+				slot->minInterval = MIN(slot->minInterval, actual);
+				slot->maxInterval = MAX(slot->maxInterval, actual);
+			}
+			slot->calls++;
+			slot->lastCallTime = curTime;
+			slot->maxLateness = MAX(slot->maxLateness, curTime - slot->nextFireTime);
 
-		// Look at the next scheduled timer
-		slot = _head->next;
+			// Update the fire time and reschedule the TimerSlot
+			assert(slot->interval > 0);
+			slot->nextFireTime += (slot->interval / 1000);
+			slot->nextFireTimeMicro += (slot->interval % 1000);
+			if (slot->nextFireTimeMicro > 1000) {
+				slot->nextFireTime += slot->nextFireTimeMicro / 1000;
+				slot->nextFireTimeMicro %= 1000;
+			}
+			schedule(slot);
+
+			// Invoke the timer callback
+			assert(slot->callback);
+			slot->callback(slot->refCon);
+		}
+
+		_wheelTime++;
 	}
 }
 
 bool DefaultTimerManager::installTimerProc(TimerProc callback, int32 interval, void *refCon, const Common::String &id) {
 	assert(interval > 0);
-	Common::StackLock lock(_mutex);
+
+	TimerSlot *slot = new TimerSlot;
+	slot->callback = callback;
+	slot->refCon = refCon;
+	slot->id = id;
+	slot->interval = interval;
+	slot->nextFireTime = g_system->getMillis() + interval / 1000;
+	slot->nextFireTimeMicro = interval % 1000;
+	slot->calls = 0;
+	slot->lastCallTime = 0;
+	slot->intervalSum = 0;
+	slot->jitterSum = 0;
+	slot->minInterval = 0xFFFFFFFF;
+	slot->maxInterval = 0;
+	slot->maxLateness = 0;
+
+	// Only the pending list is locked here, the timer is added to the
+	// wheel by the next call to handler()
+	Common::StackLock lock(_pendingMutex);
 
 	if (_callbacks.contains(id)) {
 		if (_callbacks[id] != callback) {
@@ -127,33 +273,22 @@ bool DefaultTimerManager::installTimerProc(TimerProc callback, int32 interval, v
 	}
 	_callbacks[id] = callback;
 
-	TimerSlot *slot = new TimerSlot;
-	slot->callback = callback;
-	slot->refCon = refCon;
-	slot->id = id;
-	slot->interval = interval;
-	slot->nextFireTime = g_system->getMillis() + interval / 1000;
-	slot->nextFireTimeMicro = interval % 1000;
-	slot->next = 0;
-
-	insertPrioQueue(_head, slot);
+	linkSlot(_pending, slot);
 
 	return true;
 }
 
 void DefaultTimerManager::removeTimerProc(TimerProc callback) {
+	// Locking _mutex makes sure the callback is not running
 	Common::StackLock lock(_mutex);
+	Common::StackLock pendingLock(_pendingMutex);
 
-	TimerSlot *slot = _head;
-
-	while (slot->next) {
-		if (slot->next->callback == callback) {
-			TimerSlot *next = slot->next->next;
-			delete slot->next;
-			slot->next = next;
-		} else {
-			slot = slot->next;
-		}
+	removeSlots(_pending, callback);
+	for (int i = 0; i < kRootSize; ++i)
+		removeSlots(_root[i], callback);
+	for (int level = 0; level < kLevels; ++level) {
+		for (int i = 0; i < kLevelSize; ++i)
+			removeSlots(_levels[level][i], callback);
 	}
 
 	// We need to remove all names referencing the timer proc here.
@@ -173,3 +308,20 @@ void DefaultTimerManager::removeTimerProc(TimerProc callback) {
 			_callbacks.erase(i);
 	}
 }
+
+Common::Array<Common::TimerStats> DefaultTimerManager::getTimerStats() {
+	Common::StackLock lock(_mutex);
+	Common::StackLock pendingLock(_pendingMutex);
+
+	Common::Array<Common::TimerStats> stats;
+	addStats(stats, _pending);
+	for (int i = 0; i < kRootSize; ++i)
+		addStats(stats, _root[i]);
+	for (int level = 0; level < kLevels; ++level) {
+		for (int i = 0; i < kLevelSize; ++i)
+			addStats(stats, _levels[level][i]);
+	}
+
+	Common::sort(stats.begin(), stats.end(), statsLess);
+	return stats;
+}
@@ -30,19 +30,50 @@
 
 struct TimerSlot;
 
+/**
+ * Timer manager driven by calls to handler() from the backend.
+ *
+ * The timers are kept in a hierarchical timer wheel: the root level has one
+ * list of timers per millisecond for the next 256 ms, and each further
+ * level has 64 lists, each of which covers a whole turn of the level below.
+ * Whenever the root level completes a turn, the timers of the next list of
+ * the level above are moved down. Inserting and firing a timer thus takes
+ * constant time, however many timers are installed.
+ */
 class DefaultTimerManager : public Common::TimerManager {
 private:
 	typedef Common::HashMap<Common::String, TimerProc, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> TimerSlotMap;
 
+	enum {
+		kRootBits = 8,
+		kLevelBits = 6,
+		kLevels = 4,	// Levels above the root, which cover 32 bits in total
+
+		kRootSize = 1 << kRootBits,
+		kLevelSize = 1 << kLevelBits
+	};
+
 	Common::Mutex _mutex;
-	TimerSlot *_head;
+	TimerSlot *_root[kRootSize];
+	TimerSlot *_levels[kLevels][kLevelSize];
+	uint32 _wheelTime;	///< The next millisecond to be processed
+
+	// Newly installed timers are put on a separate list, so installing a
+	// timer never has to wait for the callbacks handler() is running.
+	Common::Mutex _pendingMutex;
+	TimerSlot *_pending;
 	TimerSlotMap _callbacks;
 
+	void schedule(TimerSlot *slot);
+	void cascade(int level, uint index);
+	void schedulePending();
+
 public:
 	DefaultTimerManager();
 	virtual ~DefaultTimerManager();
 	virtual bool installTimerProc(TimerProc proc, int32 interval, void *refCon, const Common::String &id);
 	virtual void removeTimerProc(TimerProc proc);
+	virtual Common::Array<Common::TimerStats> getTimerStats();
 
 	/**
 	 * Timer callback, to be invoked at regular time intervals by the backend.
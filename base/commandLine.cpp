@@ -103,6 +103,10 @@ static const char HELP_STRING[] =
 	"  --debugflags=FLAGS       Enable engine specific debug flags\n"
 	"                           (separated by commas)\n"
 	"  --debug-channels-only    Show only the specified debug channels\n"
+#ifdef ENABLE_TRACING
+	"  --trace-file=FILE        Write trace events to FILE, which can be viewed in\n"
+	"                           chrome://tracing or the Perfetto UI\n"
+#endif
 	"  -u, --dump-scripts       Enable script dumping if a directory called 'dumps'\n"
 	"                           exists in the current directory\n"
 	"\n"
@@ -260,6 +264,9 @@ void registerDefaults() {
 
 	ConfMan.registerDefault("gui_browser_show_hidden", false);
 
+	ConfMan.registerDefault("md5_cache", true);
+	ConfMan.registerDefault("mmap_files", false);
+
 #ifdef USE_FLUIDSYNTH
 	// The settings are deliberately stored the same way as in Qsynth. The
 	// FluidSynth music driver is responsible for transforming them into
@@ -448,6 +455,11 @@ Common::String parseCommandLine(Common::StringMap &settings, int argc, const cha
 			DO_LONG_OPTION_BOOL("debug-channels-only")
 			END_OPTION
 
+#ifdef ENABLE_TRACING
+			DO_LONG_OPTION("trace-file")
+			END_OPTION
+#endif
+
 			DO_OPTION('e', "music-driver")
 			END_OPTION
 
@@ -956,13 +968,13 @@ void upgradeTargets() {
 		// the target referred to by dom. We update several things
 
 		// Always set the gameid explicitly (in case of legacy targets)
-		dom["gameid"] = g->gameid();
+		dom.setVal("gameid", g->gameid());
 
 		// Always set the GUI options. The user should not modify them, and engines might
 		// gain more features over time, so we want to keep this list up-to-date.
 		if (g->contains("guioptions")) {
 			printf("  -> update guioptions to '%s'\n", (*g)["guioptions"].c_str());
-			dom["guioptions"] = (*g)["guioptions"];
+			dom.setVal("guioptions", (*g)["guioptions"]);
 		} else if (dom.contains("guioptions")) {
 			dom.erase("guioptions");
 		}
@@ -970,13 +982,13 @@ void upgradeTargets() {
 		// Update the language setting but only if none has been set yet.
 		if (lang == Common::UNK_LANG && g->language() != Common::UNK_LANG) {
 			printf("  -> set language to '%s'\n", Common::getLanguageCode(g->language()));
-			dom["language"] = (*g)["language"];
+			dom.setVal("language", (*g)["language"]);
 		}
 
 		// Update the platform setting but only if none has been set yet.
 		if (plat == Common::kPlatformUnknown && g->platform() != Common::kPlatformUnknown) {
 			printf("  -> set platform to '%s'\n", Common::getPlatformCode(g->platform()));
-			dom["platform"] = (*g)["platform"];
+			dom.setVal("platform", (*g)["platform"]);
 		}
 
 		// TODO: We could also update the description. But not everybody will want that.
@@ -986,7 +998,7 @@ void upgradeTargets() {
 #if 0
 		if (desc != g->description()) {
 			printf("  -> update desc from '%s' to\n                      '%s' ?\n", desc.c_str(), g->description().c_str());
-			dom["description"] = (*g)["description"];
+			dom.setVal("description", (*g)["description"]);
 		}
 #endif
 	}
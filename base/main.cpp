@@ -32,24 +32,29 @@
 #define FORBIDDEN_SYMBOL_EXCEPTION_printf
 
 #include "engines/engine.h"
+#include "engines/md5cache.h"
 #include "engines/metaengine.h"
 #include "base/commandLine.h"
 #include "base/plugins.h"
 #include "base/version.h"
 
 #include "common/archive.h"
+#include "common/bufferedstream.h"
 #include "common/config-manager.h"
 #include "common/debug.h"
 #include "common/debug-channels.h" /* for debug manager */
 #include "common/events.h"
 #include "gui/EventRecorder.h"
 #include "common/fs.h"
+#include "common/macresman.h"
 #ifdef ENABLE_EVENTRECORDER
 #include "common/recorderfile.h"
 #endif
 #include "common/system.h"
 #include "common/textconsole.h"
 #include "common/tokenizer.h"
+#include "common/trace.h"
+#include "common/transformtables.h"
 #include "common/translation.h"
 #include "common/osd_message_queue.h"
 
@@ -260,7 +265,9 @@ static Common::Error runGame(const EnginePlugin *plugin, OSystem &system, const
 	system.engineInit();
 
 	// Run the engine
+	TRACE_BEGIN("engine", "Engine::run");
 	Common::Error result = engine->run();
+	TRACE_END("engine", "Engine::run");
 
 	// Inform backend that the engine finished
 	system.engineDone();
@@ -274,8 +281,9 @@ static Common::Error runGame(const EnginePlugin *plugin, OSystem &system, const
 	// We clear all debug levels again even though the engine should do it
 	DebugMan.clearAllDebugChannels();
 
-	// Reset the file/directory mappings
+	// Reset the file/directory mappings, and forget the files opened
 	SearchMan.clear();
+	Common::MacResManager::clearCache();
 
 	// Return result (== 0 means no error)
 	return result;
@@ -435,6 +443,12 @@ extern "C" int scummvm_main(int argc, const char * const argv[]) {
 	// the command line params) was read.
 	system.initBackend();
 
+#ifdef ENABLE_TRACING
+	// Start writing trace events, if requested
+	if (!ConfMan.get("trace_file").empty())
+		Common::startTrace(ConfMan.get("trace_file"));
+#endif
+
 	// If we received an invalid graphics mode parameter via command line
 	// we check this here. We can't do it until after the backend is inited,
 	// or there won't be a graphics manager to ask for the supported modes.
@@ -463,6 +477,11 @@ extern "C" int scummvm_main(int argc, const char * const argv[]) {
 	system.getAudioCDManager();
 	MusicManager::instance();
 	Common::DebugManager::instance();
+	// The transform tables and the read-ahead stream list are shared with
+	// the mixer thread, so they (and their mutexes) must exist before the
+	// first audio stream starts
+	Common::TransformTables::instance();
+	Common::ReadAheadStreamList::instance();
 
 	// Init the event manager. As the virtual keyboard is loaded here, it must
 	// take place after the backend is initiated and the screen has been setup
@@ -613,6 +632,11 @@ extern "C" int scummvm_main(int argc, const char * const argv[]) {
 	Cloud::CloudManager::destroy();
 #endif
 #endif
+#ifdef ENABLE_TRACING
+	Common::stopTrace();
+#endif
+	// Writes the cache to disk, needs the config manager for the save path.
+	MD5Cache::destroy();
 	PluginManager::instance().unloadAllPlugins();
 	PluginManager::destroy();
 	GUI::GuiManager::destroy();
@@ -623,6 +647,7 @@ extern "C" int scummvm_main(int argc, const char * const argv[]) {
 	GUI::EventRecorder::destroy();
 #endif
 	Common::SearchManager::destroy();
+	Common::MacResManager::clearCache();
 #ifdef USE_TRANSLATION
 	Common::TranslationManager::destroy();
 #endif
@@ -634,6 +659,8 @@ extern "C" int scummvm_main(int argc, const char * const argv[]) {
 #endif
 	EngineManager::destroy();
 	Graphics::YUVToRGBManager::destroy();
+	Common::TransformTables::destroy();
+	Common::ReadAheadStreamList::destroy();
 
 	return 0;
 }
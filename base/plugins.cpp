@@ -335,7 +335,7 @@ void PluginManagerUncached::updateConfigWithFileName(const Common::String &gameI
 
 		Common::ConfigManager::Domain *domain = ConfMan.getDomain("plugin_files");
 		assert(domain);
-		(*domain)[gameId] = (*_currentPlugin)->getFileName();
+		domain->setVal(gameId, (*_currentPlugin)->getFileName());
 
 		ConfMan.flushToDisk();
 	}
@@ -445,6 +445,7 @@ void PluginManager::addToPluginsInMemList(Plugin *plugin) {
 // Engine plugins
 
 #include "engines/metaengine.h"
+#include "engines/md5cache.h"
 
 namespace Common {
 DECLARE_SINGLETON(EngineManager);
@@ -527,6 +528,10 @@ GameList EngineManager::detectGames(const Common::FSList &fslist) const {
 			candidates.push_back((**iter)->detectGames(fslist));
 		}
 	} while (PluginManager::instance().loadNextPlugin());
+
+	// Persist newly computed checksums from time to time, so a long
+	// running mass add does not lose them all when interrupted.
+	MD5CacheMan.flush(false);
 	return candidates;
 }
 
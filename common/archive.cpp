@@ -39,6 +39,10 @@ SeekableReadStream *GenericArchiveMember::createReadStream() const {
 	return _parent->createReadStreamForMember(_name);
 }
 
+String GenericArchiveMember::getFingerprint() const {
+	return _parent->getMemberFingerprint(_name);
+}
+
 
 int Archive::listMatchingMembers(ArchiveMemberList &list, const String &pattern) const {
 	// Get all "names" (TODO: "files" ?)
@@ -92,6 +96,7 @@ void SearchSet::insert(const Node &node) {
 			break;
 	}
 	_list.insert(it, node);
+	invalidateIndex();
 }
 
 void SearchSet::add(const String &name, Archive *archive, int priority, bool autoFree) {
@@ -173,6 +178,7 @@ void SearchSet::remove(const String &name) {
 		if (it->_autoFree)
 			delete it->_arc;
 		_list.erase(it);
+		invalidateIndex();
 	}
 }
 
@@ -187,6 +193,7 @@ void SearchSet::clear() {
 	}
 
 	_list.clear();
+	invalidateIndex();
 }
 
 void SearchSet::setPriority(const String &name, int priority) {
@@ -205,17 +212,77 @@ void SearchSet::setPriority(const String &name, int priority) {
 	insert(node);
 }
 
-bool SearchSet::hasFile(const String &name) const {
-	if (name.empty())
-		return false;
+void SearchSet::setUseIndex(bool useIndex) {
+	_useIndex = useIndex;
+	invalidateIndex();
+}
+
+void SearchSet::invalidateIndex() {
+	if (_index.empty())
+		return;
+
+	_index.clear();
+	++_indexStats.invalidations;
+}
 
+Archive *SearchSet::findArchive(const String &name) const {
 	ArchiveNodeList::const_iterator it = _list.begin();
 	for (; it != _list.end(); ++it) {
 		if (it->_arc->hasFile(name))
-			return true;
+			return it->_arc;
+	}
+
+	return 0;
+}
+
+Archive *SearchSet::lookupArchive(const String &name) const {
+	if (!_useIndex)
+		return findArchive(name);
+
+	// Note: this is const, but fills the (mutable) index and statistics.
+	ArchiveIndex::iterator i = _index.find(name);
+	if (i != _index.end()) {
+		// Archives in front of the indexed one may have gained the member
+		// since, so ask them first. The indexed archive is usually the
+		// first one anyway. As names are indexed case insensitively, make
+		// sure the indexed archive really has the member in the case we
+		// were asked for.
+		ArchiveNodeList::const_iterator it = _list.begin();
+		for (; it != _list.end() && it->_arc != i->_value; ++it) {
+			if (it->_arc->hasFile(name)) {
+				++_indexStats.misses;
+				i->_value = it->_arc;
+				return it->_arc;
+			}
+		}
+
+		if (it != _list.end() && i->_value->hasFile(name)) {
+			++_indexStats.hits;
+			return i->_value;
+		}
 	}
 
-	return false;
+	// Only remember archives which have the member. Misses are not cached,
+	// as archives may get the member later on.
+	++_indexStats.misses;
+	Archive *arc = findArchive(name);
+	if (arc)
+		_index[name] = arc;
+	return arc;
+}
+
+Archive *SearchSet::getArchiveForMember(const String &name) const {
+	if (name.empty())
+		return 0;
+
+	return lookupArchive(name);
+}
+
+bool SearchSet::hasFile(const String &name) const {
+	if (name.empty())
+		return false;
+
+	return lookupArchive(name) != 0;
 }
 
 int SearchSet::listMatchingMembers(ArchiveMemberList &list, const String &pattern) const {
@@ -242,11 +309,9 @@ const ArchiveMemberPtr SearchSet::getMember(const String &name) const {
 	if (name.empty())
 		return ArchiveMemberPtr();
 
-	ArchiveNodeList::const_iterator it = _list.begin();
-	for (; it != _list.end(); ++it) {
-		if (it->_arc->hasFile(name))
-			return it->_arc->getMember(name);
-	}
+	Archive *arc = lookupArchive(name);
+	if (arc)
+		return arc->getMember(name);
 
 	return ArchiveMemberPtr();
 }
@@ -255,8 +320,24 @@ SeekableReadStream *SearchSet::createReadStreamForMember(const String &name) con
 	if (name.empty())
 		return 0;
 
+	// The index only tells which archive reports the member in hasFile().
+	// If that archive fails to open it, or no archive reports it, ask all
+	// archives in turn, as some serve members hasFile() does not know about.
+	Archive *indexed = 0;
+	if (_useIndex) {
+		indexed = lookupArchive(name);
+		if (indexed) {
+			SeekableReadStream *stream = indexed->createReadStreamForMember(name);
+			if (stream)
+				return stream;
+		}
+	}
+
 	ArchiveNodeList::const_iterator it = _list.begin();
 	for (; it != _list.end(); ++it) {
+		if (it->_arc == indexed)
+			continue;
+
 		SeekableReadStream *stream = it->_arc->createReadStreamForMember(name);
 		if (stream)
 			return stream;
@@ -267,6 +348,7 @@ SeekableReadStream *SearchSet::createReadStreamForMember(const String &name) con
 
 
 SearchManager::SearchManager() {
+	setUseIndex(true);
 	clear();    // Force a reset
 }
 
@@ -27,6 +27,8 @@
 #include "common/list.h"
 #include "common/ptr.h"
 #include "common/singleton.h"
+#include "common/hashmap.h"
+#include "common/hash-str.h"
 
 namespace Common {
 
@@ -48,6 +50,15 @@ public:
 	virtual SeekableReadStream *createReadStream() const = 0;
 	virtual String getName() const = 0;
 	virtual String getDisplayName() const { return getName(); }
+
+	/**
+	 * Returns a short string which changes whenever the contents of the
+	 * member change, found without reading them: e.g. the size and the
+	 * modification time of a file, or the CRC of a zip member.
+	 *
+	 * @return the fingerprint, or an empty string if there is none
+	 */
+	virtual String getFingerprint() const { return String(); }
 };
 
 typedef SharedPtr<ArchiveMember> ArchiveMemberPtr;
@@ -71,6 +82,7 @@ public:
 	GenericArchiveMember(const String &name, const Archive *parent);
 	String getName() const;
 	SeekableReadStream *createReadStream() const;
+	String getFingerprint() const;
 };
 
 
@@ -117,6 +129,12 @@ public:
 	 * @return the newly created input stream
 	 */
 	virtual SeekableReadStream *createReadStreamForMember(const String &name) const = 0;
+
+	/**
+	 * Returns the fingerprint of the member with the specified name.
+	 * @see ArchiveMember::getFingerprint
+	 */
+	virtual String getMemberFingerprint(const String &name) const { return String(); }
 };
 
 
@@ -126,8 +144,25 @@ public:
  * contained Archives, hence the simplistic policy of always looking for the first
  * match. SearchSet *DOES* guarantee that searches are performed in *DESCENDING*
  * priority order. In case of conflicting priorities, insertion order prevails.
+ *
+ * Optionally, a SearchSet can remember which archive served a given name, so
+ * that repeated lookups of the same name only ask that archive, and the ones
+ * in front of it, which may have gained the member since. The index is filled
+ * lazily and dropped whenever the set of archives changes. Names no archive
+ * has are not remembered, and opening a member falls back to asking every
+ * archive when the indexed one cannot open it.
  */
 class SearchSet : public Archive {
+public:
+	struct IndexStats {
+		uint32 hits;			///< lookups answered by the index
+		uint32 misses;			///< lookups which had to walk the archives
+		uint32 invalidations;	///< number of times the index was dropped
+
+		IndexStats() : hits(0), misses(0), invalidations(0) {}
+	};
+
+private:
 	struct Node {
 		int		_priority;
 		String	_name;
@@ -146,7 +181,28 @@ class SearchSet : public Archive {
 	// Add an archive keeping the list sorted by descending priority.
 	void insert(const Node& node);
 
+	// Maps member names to the archive serving them. The index is filled
+	// by lookups, which includes const methods like hasFile(), hence it is
+	// mutable, as are its statistics.
+	typedef HashMap<String, Archive *, IgnoreCase_Hash, IgnoreCase_EqualTo> ArchiveIndex;
+	mutable ArchiveIndex _index;
+	mutable IndexStats _indexStats;
+	bool _useIndex;
+
+	// Find the first archive containing the given member.
+	Archive *findArchive(const String &name) const;
+
+	// Like findArchive, but answered from the index when it is enabled.
+	Archive *lookupArchive(const String &name) const;
+
+protected:
+	/**
+	 * Enable or disable the member name index.
+	 */
+	void setUseIndex(bool useIndex);
+
 public:
+	SearchSet() : _useIndex(false) {}
 	virtual ~SearchSet() { clear(); }
 
 	/**
@@ -230,6 +286,28 @@ public:
 	 */
 	void setPriority(const String& name, int priority);
 
+	/**
+	 * Drop all cached lookups of the member name index. This happens
+	 * automatically when archives are added or removed, but has to be
+	 * called when the contents of an archive in the set changed.
+	 */
+	void invalidateIndex();
+
+	/**
+	 * Return the statistics of the member name index.
+	 */
+	const IndexStats &getIndexStats() const { return _indexStats; }
+
+	/**
+	 * Return the number of names currently cached in the member name index.
+	 */
+	uint getIndexSize() const { return _index.size(); }
+
+	/**
+	 * Return the first archive which has the given member, or 0 if none has.
+	 */
+	Archive *getArchiveForMember(const String &name) const;
+
 	virtual bool hasFile(const String &name) const;
 	virtual int listMatchingMembers(ArchiveMemberList &list, const String &pattern) const;
 	virtual int listMembers(ArchiveMemberList &list) const;
@@ -0,0 +1,197 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "common/arena.h"
+#include "common/mutex.h"
+#include "common/textconsole.h"
+#include "common/util.h"
+
+namespace Common {
+
+// Spaced so that rounding up wastes at most a third of a block
+const uint32 Arena::_classSizes[Arena::kNumSizeClasses] = {
+	16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048, 3072, 4096
+};
+
+Arena *Arena::_first = 0;
+
+Arena::Arena(const char *name, bool threadSafe)
+	: _name(name), _mutex(0), _largeBlocks(0) {
+	if (threadSafe)
+		_mutex = new Mutex();
+
+	memset(&_stats, 0, sizeof(_stats));
+	createPools();
+
+	_nextArena = _first;
+	_first = this;
+}
+
+Arena::~Arena() {
+	if (_stats.liveBlocks)
+		warning("Arena '%s' destroyed with %d blocks still allocated", _name, _stats.liveBlocks);
+
+	freeLargeBlocks();
+	destroyPools();
+	delete _mutex;
+
+	Arena **arena = &_first;
+	while (*arena != this)
+		arena = &(*arena)->_nextArena;
+	*arena = _nextArena;
+}
+
+void Arena::lock() const {
+	if (_mutex)
+		_mutex->lock();
+}
+
+void Arena::unlock() const {
+	if (_mutex)
+		_mutex->unlock();
+}
+
+void Arena::createPools() {
+	for (int i = 0; i < kNumSizeClasses; ++i)
+		_pools[i] = new MemoryPool(sizeof(BlockHeader) + _classSizes[i]);
+}
+
+void Arena::destroyPools() {
+	for (int i = 0; i < kNumSizeClasses; ++i)
+		delete _pools[i];
+}
+
+void Arena::freeLargeBlocks() {
+	while (_largeBlocks) {
+		LargeBlock *block = _largeBlocks;
+		_largeBlocks = block->next;
+		::free(block);
+	}
+}
+
+void *Arena::allocate(size_t size) {
+	int sizeClass = 0;
+	while (sizeClass < kNumSizeClasses && size > _classSizes[sizeClass])
+		++sizeClass;
+
+	lock();
+
+	BlockHeader *header;
+	if (sizeClass < kNumSizeClasses) {
+		header = (BlockHeader *)_pools[sizeClass]->allocChunk();
+		header->sizeClass = sizeClass;
+		_stats.usedBytes += _classSizes[sizeClass];
+	} else {
+		LargeBlock *block = (LargeBlock *)::malloc(sizeof(LargeBlock) + sizeof(BlockHeader) + size);
+		if (!block)
+			error("Arena '%s': Out of memory allocating %d bytes", _name, (int)size);
+
+		block->prev = 0;
+		block->next = _largeBlocks;
+		if (_largeBlocks)
+			_largeBlocks->prev = block;
+		_largeBlocks = block;
+
+		header = (BlockHeader *)(block + 1);
+		header->sizeClass = kLargeBlock;
+		_stats.usedBytes += size;
+		_stats.reservedBytes += sizeof(LargeBlock) + sizeof(BlockHeader) + size;
+	}
+	header->size = size;
+
+	_stats.allocations++;
+	_stats.liveBlocks++;
+	_stats.requestedBytes += size;
+	_stats.peakRequestedBytes = MAX(_stats.peakRequestedBytes, _stats.requestedBytes);
+
+	unlock();
+
+	return header + 1;
+}
+
+void Arena::deallocate(void *ptr) {
+	if (!ptr)
+		return;
+
+	BlockHeader *header = (BlockHeader *)ptr - 1;
+	const uint32 size = header->size;
+
+	lock();
+
+	if (header->sizeClass != kLargeBlock) {
+		assert(header->sizeClass < kNumSizeClasses);
+		_stats.usedBytes -= _classSizes[header->sizeClass];
+		_pools[header->sizeClass]->freeChunk(header);
+	} else {
+		LargeBlock *block = (LargeBlock *)header - 1;
+		if (block->prev)
+			block->prev->next = block->next;
+		else
+			_largeBlocks = block->next;
+		if (block->next)
+			block->next->prev = block->prev;
+
+		_stats.usedBytes -= size;
+		_stats.reservedBytes -= sizeof(LargeBlock) + sizeof(BlockHeader) + size;
+		::free(block);
+	}
+
+	_stats.liveBlocks--;
+	_stats.requestedBytes -= size;
+
+	unlock();
+}
+
+void Arena::freeAll() {
+	lock();
+
+	freeLargeBlocks();
+	destroyPools();
+	createPools();
+
+	_stats.liveBlocks = 0;
+	_stats.requestedBytes = 0;
+	_stats.usedBytes = 0;
+	_stats.reservedBytes = 0;
+
+	unlock();
+}
+
+void Arena::freeUnusedPages() {
+	lock();
+	for (int i = 0; i < kNumSizeClasses; ++i)
+		_pools[i]->freeUnusedPages();
+	unlock();
+}
+
+Arena::Stats Arena::getStats() const {
+	lock();
+
+	Stats stats = _stats;
+	for (int i = 0; i < kNumSizeClasses; ++i)
+		stats.reservedBytes += _pools[i]->getReservedSize();
+
+	unlock();
+	return stats;
+}
+
+} // End of namespace Common
@@ -0,0 +1,147 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef COMMON_ARENA_H
+#define COMMON_ARENA_H
+
+#include "common/scummsys.h"
+#include "common/memorypool.h"
+
+namespace Common {
+
+class Mutex;
+
+/**
+ * A general purpose allocator for a single subsystem, built on top of one
+ * MemoryPool per size class. Requests are rounded up to the next size class,
+ * so blocks of similar size share pages; requests bigger than the largest
+ * class are passed on to malloc. Either way, the arena keeps track of them,
+ * so it can report its usage and free everything at once.
+ *
+ * An arena is meant to be owned by one subsystem, which keeps its
+ * allocations away from everybody else's. Arenas which are used from more
+ * than one thread have to be created with threadSafe set, which makes them
+ * take a mutex for every call.
+ *
+ * All existing arenas are linked together, so they can be listed e.g. by
+ * the 'arenas' debugger command.
+ */
+class Arena {
+public:
+	struct Stats {
+		uint32 allocations;		///< Number of allocate() calls
+		uint32 liveBlocks;		///< Number of blocks currently allocated
+		size_t requestedBytes;	///< Bytes currently requested by the users
+		size_t usedBytes;		///< Bytes of the size classes used for them
+		size_t peakRequestedBytes;
+		size_t reservedBytes;	///< Bytes obtained from malloc, pages and big blocks
+	};
+
+	/**
+	 * Create an arena.
+	 *
+	 * @param name			a name for the arena, shown in statistics
+	 * @param threadSafe	whether the arena can be used from several threads;
+	 *						if set, the arena must not be created before g_system
+	 */
+	explicit Arena(const char *name, bool threadSafe = false);
+	~Arena();
+
+	/** Allocate size bytes. Never returns 0. */
+	void *allocate(size_t size);
+
+	/**
+	 * Return a block to the arena. The block must have been obtained from
+	 * allocate() of the very same arena. Passing 0 is allowed.
+	 */
+	void deallocate(void *ptr);
+
+	/**
+	 * Free all blocks of the arena at once, as well as the pages used for
+	 * them. All pointers obtained from the arena become invalid.
+	 */
+	void freeAll();
+
+	/** Return pages which hold no blocks to the system. */
+	void freeUnusedPages();
+
+	const char *getName() const { return _name; }
+	Stats getStats() const;
+
+	/** First arena of the list of all arenas. */
+	static const Arena *getFirst() { return _first; }
+	/** Next arena in the list of all arenas, or 0. */
+	const Arena *getNext() const { return _nextArena; }
+
+private:
+	Arena(const Arena &);
+	Arena &operator=(const Arena &);
+
+	enum {
+		kNumSizeClasses = 16,
+		kLargeBlock = 0xFFFF
+	};
+
+	/** Stored in front of every block. */
+	struct BlockHeader {
+		uint16 sizeClass;
+		uint16 padding;
+		uint32 size;
+	};
+
+	/** Stored in front of the header of blocks bigger than any size class. */
+	struct LargeBlock {
+		LargeBlock *prev;
+		LargeBlock *next;
+	};
+
+	static const uint32 _classSizes[kNumSizeClasses];
+
+	const char *_name;
+	Mutex *_mutex;
+	MemoryPool *_pools[kNumSizeClasses];
+	LargeBlock *_largeBlocks;
+	Stats _stats;
+
+	static Arena *_first;
+	Arena *_nextArena;
+
+	void lock() const;
+	void unlock() const;
+	void createPools();
+	void destroyPools();
+	void freeLargeBlocks();
+};
+
+} // End of namespace Common
+
+/**
+ * Declare class specific new and delete operators, which allocate the
+ * objects of the class, and of all classes derived from it, from the
+ * given arena. The arena expression is evaluated on each call.
+ * This has to be placed in a public section of the class.
+ */
+#define DECLARE_ARENA_ALLOCATED(ARENA) \
+	static void *operator new(size_t size) { return (ARENA).allocate(size); } \
+	static void operator delete(void *ptr) { (ARENA).deallocate(ptr); }
+
+#endif
@@ -66,6 +66,17 @@ public:
 		}
 	}
 
+#if __cplusplus >= 201103L
+	/**
+	 * Construct an array by taking over the storage of another one, which
+	 * is left empty.
+	 */
+	Array(Array<T> &&array) : _capacity(array._capacity), _size(array._size), _storage(array._storage) {
+		array._capacity = array._size = 0;
+		array._storage = 0;
+	}
+#endif
+
 	/**
 	 * Construct an array by copying data from a regular array.
 	 */
@@ -84,12 +95,69 @@ public:
 
 	/** Appends element to the end of the array. */
 	void push_back(const T &element) {
-		if (_size + 1 <= _capacity)
-			new ((void *)&_storage[_size++]) T(element);
-		else
-			insert_aux(end(), &element, &element + 1);
+		// The element may be part of this array, so when growing, it has
+		// to be copied before the old storage goes away.
+		T *oldStorage = growForAppend();
+		new ((void *)&_storage[_size]) T(element);
+		finishAppend(oldStorage);
+	}
+
+#if __cplusplus >= 201103L
+	/** Appends element to the end of the array, moving it there. */
+	void push_back(T &&element) {
+		T *oldStorage = growForAppend();
+		new ((void *)&_storage[_size]) T(Common::move(element));
+		finishAppend(oldStorage);
 	}
 
+	/**
+	 * Constructs a new element at the end of the array, passing the given
+	 * arguments to its constructor, and returns a reference to it.
+	 */
+	template<class... Args>
+	T &emplace_back(Args &&... args) {
+		T *oldStorage = growForAppend();
+		new ((void *)&_storage[_size]) T(Common::forward<Args>(args)...);
+		finishAppend(oldStorage);
+		return back();
+	}
+#else
+	/**
+	 * Constructs a new element at the end of the array, passing the given
+	 * arguments to its constructor, and returns a reference to it.
+	 */
+	T &emplace_back() {
+		T *oldStorage = growForAppend();
+		new ((void *)&_storage[_size]) T();
+		finishAppend(oldStorage);
+		return back();
+	}
+
+	template<class A1>
+	T &emplace_back(const A1 &a1) {
+		T *oldStorage = growForAppend();
+		new ((void *)&_storage[_size]) T(a1);
+		finishAppend(oldStorage);
+		return back();
+	}
+
+	template<class A1, class A2>
+	T &emplace_back(const A1 &a1, const A2 &a2) {
+		T *oldStorage = growForAppend();
+		new ((void *)&_storage[_size]) T(a1, a2);
+		finishAppend(oldStorage);
+		return back();
+	}
+
+	template<class A1, class A2, class A3>
+	T &emplace_back(const A1 &a1, const A2 &a2, const A3 &a3) {
+		T *oldStorage = growForAppend();
+		new ((void *)&_storage[_size]) T(a1, a2, a3);
+		finishAppend(oldStorage);
+		return back();
+	}
+#endif
+
 	void push_back(const Array<T> &array) {
 		if (_size + array.size() <= _capacity) {
 			uninitialized_copy(array.begin(), array.end(), end());
@@ -182,6 +250,23 @@ public:
 		return *this;
 	}
 
+#if __cplusplus >= 201103L
+	Array<T> &operator=(Array<T> &&array) {
+		if (this == &array)
+			return *this;
+
+		freeStorage(_storage, _size);
+		_capacity = array._capacity;
+		_size = array._size;
+		_storage = array._storage;
+
+		array._capacity = array._size = 0;
+		array._storage = 0;
+
+		return *this;
+	}
+#endif
+
 	size_type size() const {
 		return _size;
 	}
@@ -245,8 +330,8 @@ public:
 		allocCapacity(newCapacity);
 
 		if (oldStorage) {
-			// Copy old data
-			uninitialized_copy(oldStorage, oldStorage + _size, _storage);
+			// Move old data
+			uninitialized_move(oldStorage, oldStorage + _size, _storage);
 			freeStorage(oldStorage, _size);
 		}
 	}
@@ -292,6 +377,29 @@ protected:
 		free(storage);
 	}
 
+	/**
+	 * Make room for appending one element. If the array has to grow, new
+	 * storage is allocated with room to spare, and the old storage is
+	 * returned. It stays valid until finishAppend() is called, once the
+	 * new element has been constructed at _storage[_size].
+	 */
+	T *growForAppend() {
+		if (_size + 1 <= _capacity)
+			return 0;
+
+		T *const oldStorage = _storage;
+		allocCapacity(roundUpCapacity(_size + 1));
+		return oldStorage;
+	}
+
+	void finishAppend(T *oldStorage) {
+		if (oldStorage) {
+			uninitialized_move(oldStorage, oldStorage + _size, _storage);
+			freeStorage(oldStorage, _size);
+		}
+		_size++;
+	}
+
 	/**
 	 * Insert a range of elements coming from this or another array.
 	 * Unlike std::vector::insert, this method does not accept
@@ -319,14 +427,15 @@ protected:
 				// storage to avoid conflicts.
 				allocCapacity(roundUpCapacity(_size + n));
 
-				// Copy the data from the old storage till the position where
-				// we insert new data
-				uninitialized_copy(oldStorage, oldStorage + idx, _storage);
-				// Copy the data we insert
+				// Copy the data we insert. This comes first, since it may
+				// come from the old storage, which is moved from next.
 				uninitialized_copy(first, last, _storage + idx);
-				// Afterwards copy the old data from the position where we
+				// Move the data from the old storage till the position where
+				// we insert new data
+				uninitialized_move(oldStorage, oldStorage + idx, _storage);
+				// Afterwards move the old data from the position where we
 				// insert.
-				uninitialized_copy(oldStorage + idx, oldStorage + _size, _storage + idx + n);
+				uninitialized_move(oldStorage + idx, oldStorage + _size, _storage + idx + n);
 
 				freeStorage(oldStorage, _size);
 			} else if (idx + n <= _size) {
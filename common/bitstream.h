@@ -29,6 +29,7 @@
 #include "common/textconsole.h"
 #include "common/stream.h"
 #include "common/types.h"
+#include "common/util.h"
 
 namespace Common {
 
@@ -53,7 +54,14 @@ public:
 	/** Skip the specified amount of bits. */
 	virtual void skip(uint32 n) = 0;
 
-	/** Skip the bits to closest data value border. */
+	/**
+	 * Skip the bits to closest data value border.
+	 *
+	 * peekBits() may read data values ahead, so the data stream is usually
+	 * positioned past the bits handed out so far. Aligning also seeks the
+	 * data stream back to right after the last value used, so it can then
+	 * be read from directly.
+	 */
 	virtual void align() = 0;
 
 	/** Read a bit from the bit stream. */
@@ -65,12 +73,18 @@ public:
 	/** Read a bit from the bit stream, without changing the stream's position. */
 	virtual uint32 peekBit() = 0;
 
-	/** Read a multi-bit value from the bit stream, without changing the stream's position. */
+	/**
+	 * Read a multi-bit value from the bit stream, without changing the stream's position.
+	 * Bits past the end of the stream read as 0.
+	 */
 	virtual uint32 peekBits(uint8 n) = 0;
 
 	/** Add a bit to the value x, making it an n+1-bit value. */
 	virtual void addBit(uint32 &x, uint32 n) = 0;
 
+	/** Are the bits of each data value handed out starting with the MSB? */
+	virtual bool isMSBFirst() const = 0;
+
 protected:
 	BitStream() {
 	}
@@ -95,6 +109,14 @@ private:
 	uint32 _value;   ///< Current value.
 	uint8  _inValue; ///< Position within the current value.
 
+	/**
+	 * Data values already read from the stream by peekBits(), which come
+	 * after the current value. Enough to peek 32 bits with 8-bit values.
+	 * align() returns them to the stream.
+	 */
+	uint32 _ahead[4];
+	uint8  _aheadCount;
+
 	/** Read a data value. */
 	inline uint32 readData() {
 		if (isLE) {
@@ -119,22 +141,51 @@ private:
 
 	/** Read the next data value. */
 	inline void readValue() {
-		if ((size() - pos()) < valueBits)
-			error("BitStreamImpl::readValue(): End of bit stream reached");
+		if (_aheadCount > 0) {
+			_value = _ahead[0];
+			for (uint8 i = 1; i < _aheadCount; i++)
+				_ahead[i - 1] = _ahead[i];
+			_aheadCount--;
+		} else {
+			if ((size() - pos()) < valueBits)
+				error("BitStreamImpl::readValue(): End of bit stream reached");
 
-		_value = readData();
-		if (_stream->err() || _stream->eos())
-			error("BitStreamImpl::readValue(): Read error");
+			_value = readData();
+			if (_stream->err() || _stream->eos())
+				error("BitStreamImpl::readValue(): Read error");
+		}
 
 		// If we're reading the bits MSB first, we need to shift the value to that position
 		if (isMSB2LSB)
 			_value <<= 32 - valueBits;
+	}
+
+	/** Return the n-th data value after the current one, reading it if necessary. 0 past the end. */
+	inline uint32 peekValue(uint8 n) {
+		while (_aheadCount <= n) {
+			if ((uint32)(_stream->size() - _stream->pos()) < (valueBits >> 3))
+				return 0;
+
+			_ahead[_aheadCount++] = readData();
 		}
 
+		return _ahead[n];
+	}
+
+	/** Stream position after the current value, not counting the values read ahead. */
+	inline uint32 streamPos() const {
+		return _stream->pos() - _aheadCount * (valueBits >> 3);
+	}
+
+	/** The lowest n bits set; n may be 32. */
+	static inline uint32 lowMask(uint32 n) {
+		return (n >= 32) ? 0xFFFFFFFF : ((1u << n) - 1);
+	}
+
 public:
 	/** Create a bit stream using this input data stream and optionally delete it on destruction. */
 	BitStreamImpl(SeekableReadStream *stream, DisposeAfterUse::Flag disposeAfterUse = DisposeAfterUse::NO) :
-		_stream(stream), _disposeAfterUse(disposeAfterUse), _value(0), _inValue(0) {
+		_stream(stream), _disposeAfterUse(disposeAfterUse), _value(0), _inValue(0), _aheadCount(0) {
 
 		if ((valueBits != 8) && (valueBits != 16) && (valueBits != 32))
 			error("BitStreamImpl: Invalid memory layout %d, %d, %d", valueBits, isLE, isMSB2LSB);
@@ -142,7 +193,7 @@ public:
 
 	/** Create a bit stream using this input data stream. */
 	BitStreamImpl(SeekableReadStream &stream) :
-		_stream(&stream), _disposeAfterUse(DisposeAfterUse::NO), _value(0), _inValue(0) {
+		_stream(&stream), _disposeAfterUse(DisposeAfterUse::NO), _value(0), _inValue(0), _aheadCount(0) {
 
 		if ((valueBits != 8) && (valueBits != 16) && (valueBits != 32))
 			error("BitStreamImpl: Invalid memory layout %d, %d, %d", valueBits, isLE, isMSB2LSB);
@@ -195,52 +246,57 @@ public:
 		if (n > 32)
 			error("BitStreamImpl::getBits(): Too many bits requested to be read");
 
-		// Read the number of bits
-		uint32 v = 0;
-
-		if (isMSB2LSB) {
-			while (n-- > 0)
-				v = (v << 1) | getBit();
-		} else {
-			for (uint32 i = 0; i < n; i++)
-				v = (v >> 1) | (((uint32) getBit()) << 31);
-
-			v >>= (32 - n);
-		}
+		uint32 v = peekBits(n);
+		skip(n);
 
 		return v;
 	}
 
 	/** Read a bit from the bit stream, without changing the stream's position. */
 	uint32 peekBit() {
-		uint32 value   = _value;
-		uint8  inValue = _inValue;
-		uint32 curPos  = _stream->pos();
-
-		uint32 v = getBit();
-
-		_stream->seek(curPos);
-		_inValue = inValue;
-		_value   = value;
-
-		return v;
+		return peekBits(1);
 	}
 
 	/**
 	 * Read a multi-bit value from the bit stream, without changing the stream's position.
 	 *
-	 * The bit order is the same as in getBits().
+	 * The bit order is the same as in getBits(). Bits past the end of the
+	 * stream read as 0.
 	 */
 	uint32 peekBits(uint8 n) {
-		uint32 value   = _value;
-		uint8  inValue = _inValue;
-		uint32 curPos  = _stream->pos();
+		if (n == 0)
+			return 0;
 
-		uint32 v = getBits(n);
+		if (n > 32)
+			error("BitStreamImpl::peekBits(): Too many bits requested to be read");
+
+		// Bits left in the current value
+		const uint32 avail = (_inValue == 0) ? 0 : valueBits - _inValue;
 
-		_stream->seek(curPos);
-		_inValue = inValue;
-		_value   = value;
+		if (n <= avail) {
+			if (isMSB2LSB)
+				return _value >> (32 - n);
+			else
+				return _value & lowMask(n);
+		}
+
+		// Take the rest from the following values, a whole value at a time
+		uint32 v = 0;
+		if (avail > 0)
+			v = isMSB2LSB ? (_value >> (32 - avail)) : (_value & lowMask(avail));
+
+		uint32 got = avail;
+		for (uint8 i = 0; got < n; i++) {
+			const uint32 data = peekValue(i);
+			const uint32 take = MIN<uint32>(n - got, valueBits);
+
+			if (isMSB2LSB)
+				v = (take == 32) ? data : ((v << take) | (data >> (valueBits - take)));
+			else
+				v |= (data & lowMask(take)) << got;
+
+			got += take;
+		}
 
 		return v;
 	}
@@ -266,32 +322,58 @@ public:
 			x = (x & ~(1 << n)) | (getBit() << n);
 	}
 
+	bool isMSBFirst() const {
+		return isMSB2LSB;
+	}
+
 	/** Rewind the bit stream back to the start. */
 	void rewind() {
 		_stream->seek(0);
 
-		_value   = 0;
-		_inValue = 0;
+		_value      = 0;
+		_inValue    = 0;
+		_aheadCount = 0;
 	}
 
 	/** Skip the specified amount of bits. */
 	void skip(uint32 n) {
-		while (n-- > 0)
-			getBit();
+		while (n > 0) {
+			if (_inValue == 0)
+				readValue();
+
+			// Drop as many bits of the current value as possible at once
+			const uint32 take = MIN<uint32>(n, valueBits - _inValue);
+			if (take == 32)
+				_value = 0;
+			else if (isMSB2LSB)
+				_value <<= take;
+			else
+				_value >>= take;
+
+			_inValue = (_inValue + take) % valueBits;
+			n -= take;
+		}
 	}
 
 	/** Skip the bits to closest data value border. */
 	void align() {
-		while (_inValue)
-			getBit();
+		if (_inValue)
+			skip(valueBits - _inValue);
+
+		// Hand the values read ahead back to the data stream
+		if (_aheadCount > 0) {
+			_stream->seek(-(int32)(_aheadCount * (valueBits >> 3)), SEEK_CUR);
+			_aheadCount = 0;
+		}
 	}
 
 	/** Return the stream position in bits. */
 	uint32 pos() const {
-		if (_stream->pos() == 0)
+		const uint32 sp = streamPos();
+		if (sp == 0)
 			return 0;
 
-		uint32 p = (_inValue == 0) ? _stream->pos() : ((_stream->pos() - 1) & ~((uint32) ((valueBits >> 3) - 1)));
+		uint32 p = (_inValue == 0) ? sp : ((sp - 1) & ~((uint32) ((valueBits >> 3) - 1)));
 		return p * 8 + _inValue;
 	}
 
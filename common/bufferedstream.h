@@ -23,7 +23,11 @@
 #ifndef COMMON_BUFFEREDSTREAM_H
 #define COMMON_BUFFEREDSTREAM_H
 
+#include "common/array.h"
+#include "common/singleton.h"
+#include "common/str.h"
 #include "common/stream.h"
+#include "common/system.h"
 #include "common/types.h"
 
 namespace Common {
@@ -50,6 +54,76 @@ ReadStream *wrapBufferedReadStream(ReadStream *parentStream, uint32 bufSize, Dis
  */
 SeekableReadStream *wrapBufferedSeekableReadStream(SeekableReadStream *parentStream, uint32 bufSize, DisposeAfterUse::Flag disposeParentStream);
 
+/**
+ * Take an arbitrary SeekableReadStream and wrap it in a custom stream which
+ * reads ahead of the position of its user. The read-ahead window starts
+ * small and doubles with every refill which continues where the previous one
+ * ended, so sequential reading soon takes big chunks from the parent stream,
+ * while random access only reads what it needs. Seeking does not discard
+ * the buffered data, and does not touch the parent stream at all until data
+ * outside of the buffer is needed.
+ *
+ * The buffer grows with the window, so streams which are never read
+ * sequentially only allocate the smallest one.
+ *
+ * Statistics of all read-ahead streams, including a histogram of the time
+ * spent waiting for the parent stream, can be shown with the 'streams'
+ * debugger command.
+ *
+ * It is safe to call this with a NULL parameter (in this case, NULL is
+ * returned).
+ *
+ * @param parentStream			the stream to read from
+ * @param disposeParentStream	whether to delete parentStream with the wrapper
+ * @param name					name of the stream, shown in the statistics
+ */
+SeekableReadStream *wrapReadAheadStream(SeekableReadStream *parentStream, DisposeAfterUse::Flag disposeParentStream, const String &name = String());
+
+/**
+ * Statistics of one stream created by wrapReadAheadStream().
+ */
+struct ReadAheadStats {
+	enum {
+		kLatencyBuckets = 12
+	};
+
+	String name;
+	uint32 window;			///< Current size of the read-ahead window
+	uint32 bytesRead;		///< Bytes returned to the user
+	uint32 refills;			///< Reads from the parent stream
+	uint32 seeks;			///< Seeks outside of the buffered data
+	/**
+	 * How often the user had to wait for the parent stream, by the time
+	 * waited: latency[0] counts waits below 1 ms, latency[i] waits of
+	 * 2^(i-1) to 2^i ms, the last bucket everything longer.
+	 */
+	uint32 latency[kLatencyBuckets];
+};
+
+/**
+ * Keeps track of the statistics of all streams created by
+ * wrapReadAheadStream(). Streams may be created and destroyed on the mixer
+ * thread, so the list and its mutex are created at startup, before any
+ * other thread runs.
+ */
+class ReadAheadStreamList : public Singleton<ReadAheadStreamList> {
+public:
+	void add(const ReadAheadStats *stats);
+	void remove(const ReadAheadStats *stats);
+
+	/** Return the statistics of all existing read-ahead streams. */
+	Array<ReadAheadStats> getStats();
+
+private:
+	friend class Singleton<SingletonBaseType>;
+	ReadAheadStreamList();
+	~ReadAheadStreamList();
+
+	/** Guards _streams; 0 if there is no backend, and hence no threads. */
+	OSystem::MutexRef _mutex;
+	Array<const ReadAheadStats *> _streams;
+};
+
 /**
  * Take an arbitrary WriteStream and wrap it in a custom stream which
  * transparently provides buffering.
@@ -34,6 +34,21 @@ static bool isValidDomainName(const Common::String &domName) {
 	return *p == 0;
 }
 
+/**
+ * Find the end of the line starting at pos, and return the start of the
+ * next one. Like SeekableReadStream::readLine, this accepts LF, CR/LF and
+ * CR line breaks.
+ */
+static const char *nextLine(const char *pos, const char *end, const char *&lineEnd) {
+	while (pos < end && *pos != '\n' && *pos != '\r')
+		pos++;
+	lineEnd = pos;
+
+	if (pos < end && *pos++ == '\r' && pos < end && *pos == '\n')
+		pos++;
+	return pos;
+}
+
 namespace Common {
 
 DECLARE_SINGLETON(ConfigManager);
@@ -52,7 +67,8 @@ char const *const ConfigManager::kCloudDomain = "cloud";
 #pragma mark -
 
 
-ConfigManager::ConfigManager() : _activeDomain(0) {
+ConfigManager::ConfigManager() : _activeDomain(0), _domainsChanged(true) {
+	memset(&_stats, 0, sizeof(_stats));
 }
 
 void ConfigManager::defragment() {
@@ -78,6 +94,8 @@ void ConfigManager::copyFrom(ConfigManager &source) {
 	_activeDomainName = source._activeDomainName;
 	_activeDomain = &_gameDomains[_activeDomainName];
 	_filename = source._filename;
+	_domainsChanged = source._domainsChanged;
+	_stats = source._stats;
 }
 
 
@@ -98,6 +116,7 @@ void ConfigManager::loadDefaultConfigFile() {
 		// No config file -> create new one!
 		debug("Default configuration file missing, creating a new one");
 
+		_domainsChanged = true;
 		flushToDisk();
 	}
 }
@@ -109,6 +128,7 @@ void ConfigManager::loadConfigFile(const String &filename) {
 	File cfg_file;
 	if (!cfg_file.open(node)) {
 		debug("Creating configuration file: %s", filename.c_str());
+		_domainsChanged = true;
 	} else {
 		debug("Using configuration file: %s", _filename.c_str());
 		loadFromStream(cfg_file);
@@ -116,28 +136,34 @@ void ConfigManager::loadConfigFile(const String &filename) {
 }
 
 /**
- * Add a ready-made domain based on its name and contents
+ * Add a domain based on its name, and return it so it can be filled in.
  * The domain name should not already exist in the ConfigManager.
  **/
-void ConfigManager::addDomain(const String &domainName, const ConfigManager::Domain &domain) {
+ConfigManager::Domain *ConfigManager::addDomain(const String &domainName, bool isGameDomain) {
 	if (domainName.empty())
-		return;
+		return 0;
 	if (domainName == kApplicationDomain) {
-		_appDomain = domain;
+		_appDomain = Domain();
+		return &_appDomain;
 #ifdef ENABLE_KEYMAPPER
 	} else if (domainName == kKeymapperDomain) {
-		_keymapperDomain = domain;
+		_keymapperDomain = Domain();
+		return &_keymapperDomain;
 #endif
 #ifdef USE_CLOUD
 	} else if (domainName == kCloudDomain) {
-		_cloudDomain = domain;
+		_cloudDomain = Domain();
+		return &_cloudDomain;
 #endif
-	} else if (domain.contains("gameid")) {
+	} else if (isGameDomain) {
 		// If the domain contains "gameid" we assume it's a game domain
-		if (_gameDomains.contains(domainName))
+		const bool exists = _gameDomains.contains(domainName);
+		if (exists)
 			warning("Game domain %s already exists in ConfigManager", domainName.c_str());
 
-		_gameDomains[domainName] = domain;
+		Domain &domain = _gameDomains[domainName];
+		if (exists)
+			domain = Domain();
 
 		_domainSaveOrder.push_back(domainName);
 
@@ -146,84 +172,122 @@ void ConfigManager::addDomain(const String &domainName, const ConfigManager::Dom
 		// the ghost domain
 		if (_miscDomains.contains(domainName))
 			_miscDomains.erase(domainName);
+		return &domain;
 	} else {
 		// Otherwise it's a miscellaneous domain
-		if (_miscDomains.contains(domainName))
+		const bool exists = _miscDomains.contains(domainName);
+		if (exists)
 			warning("Misc domain %s already exists in ConfigManager", domainName.c_str());
 
-		_miscDomains[domainName] = domain;
+		Domain &domain = _miscDomains[domainName];
+		if (exists)
+			domain = Domain();
+		return &domain;
 	}
 }
 
 
 void ConfigManager::loadFromStream(SeekableReadStream &stream) {
-	String domainName;
-	String comment;
-	Domain domain;
-	int lineno = 0;
+	const uint32 startTime = g_system ? g_system->getMillis() : 0;
 
-	_appDomain.clear();
+	_appDomain = Domain();
 	_gameDomains.clear();
 	_miscDomains.clear();
-	_transientDomain.clear();
+	_transientDomain = Domain();
 	_domainSaveOrder.clear();
 
 #ifdef ENABLE_KEYMAPPER
-	_keymapperDomain.clear();
+	_keymapperDomain = Domain();
 #endif
 #ifdef USE_CLOUD
-	_cloudDomain.clear();
+	_cloudDomain = Domain();
 #endif
 
+	// Keep the whole file in memory. The domains refer to it, so they
+	// can be parsed when they are needed, and written back verbatim if
+	// they are not modified.
+	String text;
+	const uint32 size = stream.size() - stream.pos();
+	if (stream.getDataPointer()) {
+		text = String((const char *)stream.getDataPointer() + stream.pos(), size);
+	} else {
+		char *buf = (char *)malloc(size);
+		if (!buf)
+			error("ConfigManager: Out of memory loading the config file");
+		text = String(buf, stream.read(buf, size));
+		free(buf);
+	}
+
+	const char *const base = text.c_str();
+	const char *const end = base + text.size();
+
+	String domainName;
+	String domainComment;
+	String comment;
+	uint32 sourceBegin = 0, sourceEnd = 0;
+	bool isGameDomain = false;
+	int lineno = 0;
+
 	// TODO: Detect if a domain occurs multiple times (or likewise, if
 	// a key occurs multiple times inside one domain).
 
-	while (!stream.eos() && !stream.err()) {
+	// Only determine where the domains are here, and check the syntax of
+	// every line, so errors are still reported with line numbers when the
+	// file is loaded. Apart from the comments of the domains, which belong
+	// to the lines before them, the contents are left to parseSource().
+	const char *pos = base;
+	while (pos < end) {
 		lineno++;
 
-		// Read a line
-		String line = stream.readLine();
+		const char *line = pos;
+		const char *lineEnd;
+		pos = nextLine(pos, end, lineEnd);
 
-		if (line.size() == 0) {
+		if (line == lineEnd) {
 			// Do nothing
 		} else if (line[0] == '#') {
 			// Accumulate comments here. Once we encounter either the start
 			// of a new domain, or a key-value-pair, we associate the value
 			// of the 'comment' variable with that entity.
-			comment += line;
+			comment += String(line, lineEnd);
 			comment += "\n";
 		} else if (line[0] == '[') {
 			// It's a new domain which begins here.
 			// Determine where the previously accumulated domain goes, if we accumulated anything.
-			addDomain(domainName, domain);
-			domain.clear();
-			const char *p = line.c_str() + 1;
+			Domain *domain = addDomain(domainName, isGameDomain);
+			if (domain)
+				domain->setSource(text, domainComment, sourceBegin, sourceEnd);
+
+			const char *p = line + 1;
 			// Get the domain name, and check whether it's valid (that
 			// is, verify that it only consists of alphanumerics,
 			// dashes and underscores).
-			while (*p && (isAlnum(*p) || *p == '-' || *p == '_'))
+			while (p < lineEnd && (isAlnum(*p) || *p == '-' || *p == '_'))
 				p++;
 
-			if (*p == '\0')
+			if (p == lineEnd)
 				error("Config file buggy: missing ] in line %d", lineno);
 			else if (*p != ']')
 				error("Config file buggy: Invalid character '%c' occurred in section name in line %d", *p, lineno);
 
-			domainName = String(line.c_str() + 1, p);
+			domainName = String(line + 1, p);
+
+			sourceBegin = sourceEnd = pos - base;
+			isGameDomain = false;
 
-			domain.setDomainComment(comment);
+			domainComment = comment;
 			comment.clear();
 
 		} else {
 			// This line should be a line with a 'key=value' pair, or an empty one.
 
 			// Skip leading whitespaces
-			const char *t = line.c_str();
-			while (isSpace(*t))
+			const char *t = line;
+			while (t < lineEnd && isSpace(*t))
 				t++;
 
 			// Skip empty lines / lines with only whitespace
-			if (*t == 0)
+			if (t == lineEnd)
 				continue;
 
 			// If no domain has been set, this config file is invalid!
@@ -232,32 +296,96 @@ void ConfigManager::loadFromStream(SeekableReadStream &stream) {
 			}
 
 			// Split string at '=' into 'key' and 'value'. First, find the "=" delimeter.
-			const char *p = strchr(t, '=');
+			const char *p = (const char *)memchr(t, '=', lineEnd - t);
 			if (!p)
-				error("Config file buggy: Junk found in line line %d: '%s'", lineno, t);
+				error("Config file buggy: Junk found in line line %d: '%s'", lineno, String(t, lineEnd).c_str());
+
+			// If the domain contains "gameid" we assume it's a game domain
+			const char *keyEnd = p;
+			while (keyEnd > t && isSpace(keyEnd[-1]))
+				keyEnd--;
+			if (keyEnd - t == 6 && !scumm_strnicmp(t, "gameid", 6))
+				isGameDomain = true;
+
+			// The domain extends at least up to here. Comments after the
+			// last key/value pair go to the next domain.
+			sourceEnd = lineEnd - base;
+			comment.clear();
+		}
+	}
 
-			// Extract the key/value pair
-			String key(t, p);
-			String value(p + 1);
+	// Add the last domain found
+	Domain *domain = addDomain(domainName, isGameDomain);
+	if (domain)
+		domain->setSource(text, domainComment, sourceBegin, sourceEnd);
 
-			// Trim of spaces
-			key.trim();
-			value.trim();
+	_domainsChanged = false;
+	_stats.loadTime = g_system ? g_system->getMillis() - startTime : 0;
+	debug(1, "ConfigManager: Indexed %d domains in %d ms", _gameDomains.size() + _miscDomains.size(), _stats.loadTime);
+}
 
-			// Finally, store the key/value pair in the active domain
-			domain[key] = value;
+void ConfigManager::Domain::setSource(const String &text, const String &comment, uint32 begin, uint32 end) {
+	_source = text;
+	_sourceBegin = begin;
+	_sourceEnd = end;
+	_parsed = false;
+	_domainComment = comment;
+}
 
-			// Store comment
-			domain.setKVComment(key, comment);
-			comment.clear();
+void ConfigManager::Domain::parseSource() const {
+	_parsed = true;
+
+	const char *pos = _source.c_str() + _sourceBegin;
+	const char *const end = _source.c_str() + _sourceEnd;
+	String comment;
+
+	// The lines have been checked by loadFromStream() already
+	while (pos < end) {
+		const char *line = pos;
+		const char *lineEnd;
+		pos = nextLine(pos, end, lineEnd);
+
+		if (line == lineEnd)
+			continue;
+
+		if (line[0] == '#') {
+			comment += String(line, lineEnd);
+			comment += "\n";
+			continue;
 		}
-	}
 
-	addDomain(domainName, domain); // Add the last domain found
+		const char *t = line;
+		while (t < lineEnd && isSpace(*t))
+			t++;
+		if (t == lineEnd)
+			continue;
+
+		// Extract the key/value pair
+		const char *p = (const char *)memchr(t, '=', lineEnd - t);
+		String key(t, p);
+		String value(p + 1, lineEnd);
+
+		// Trim of spaces
+		key.trim();
+		value.trim();
+
+		// Finally, store the key/value pair and its comment
+		_entries[key] = value;
+		_keyValueComments[key] = comment;
+		comment.clear();
+	}
 }
 
 void ConfigManager::flushToDisk() {
 #ifndef __DC__
+	// Many places flush after every change of the options, so skip
+	// writing the file if it already is up to date
+	if (!isDirty()) {
+		_stats.skippedFlushes++;
+		return;
+	}
+
+	const uint32 startTime = g_system ? g_system->getMillis() : 0;
 	WriteStream *stream;
 
 	if (_filename.empty()) {
@@ -279,47 +407,138 @@ void ConfigManager::flushToDisk() {
 		stream = dump;
 	}
 
+	saveToStream(*stream);
+
+	stream->finalize();
+	if (stream->err())
+		warning("Unable to write configuration file");
+	else
+		markClean();
+
+	delete stream;
+
+	_stats.flushes++;
+	_stats.flushTime = g_system ? g_system->getMillis() - startTime : 0;
+	debug(1, "ConfigManager: Wrote configuration file in %d ms", _stats.flushTime);
+#endif // !__DC__
+}
+
+void ConfigManager::saveToStream(WriteStream &stream) {
 	// Write the application domain
-	writeDomain(*stream, kApplicationDomain, _appDomain);
+	writeDomain(stream, kApplicationDomain, _appDomain);
 
 #ifdef ENABLE_KEYMAPPER
 	// Write the keymapper domain
-	writeDomain(*stream, kKeymapperDomain, _keymapperDomain);
+	writeDomain(stream, kKeymapperDomain, _keymapperDomain);
 #endif
 #ifdef USE_CLOUD
 	// Write the cloud domain
-	writeDomain(*stream, kCloudDomain, _cloudDomain);
+	writeDomain(stream, kCloudDomain, _cloudDomain);
 #endif
 
 	DomainMap::const_iterator d;
 
 	// Write the miscellaneous domains next
 	for (d = _miscDomains.begin(); d != _miscDomains.end(); ++d) {
-		writeDomain(*stream, d->_key, d->_value);
+		writeDomain(stream, d->_key, d->_value);
 	}
 
 	// First write the domains in _domainSaveOrder, in that order.
 	// Note: It's possible for _domainSaveOrder to list domains which
 	// are not present anymore, so we validate each name.
+	HashMap<String, bool> inSaveOrder;
 	Array<String>::const_iterator i;
 	for (i = _domainSaveOrder.begin(); i != _domainSaveOrder.end(); ++i) {
-		if (_gameDomains.contains(*i)) {
-			writeDomain(*stream, *i, _gameDomains[*i]);
+		inSaveOrder[*i] = true;
+		d = _gameDomains.find(*i);
+		if (d != _gameDomains.end()) {
+			writeDomain(stream, *i, d->_value);
 		}
 	}
 
 	// Now write the domains which haven't been written yet
 	for (d = _gameDomains.begin(); d != _gameDomains.end(); ++d) {
-		if (find(_domainSaveOrder.begin(), _domainSaveOrder.end(), d->_key) == _domainSaveOrder.end())
-			writeDomain(*stream, d->_key, d->_value);
+		if (!inSaveOrder.contains(d->_key))
+			writeDomain(stream, d->_key, d->_value);
 	}
+}
 
-	delete stream;
+bool ConfigManager::isDirty() const {
+	if (_domainsChanged || _appDomain._dirty)
+		return true;
+#ifdef ENABLE_KEYMAPPER
+	if (_keymapperDomain._dirty)
+		return true;
+#endif
+#ifdef USE_CLOUD
+	if (_cloudDomain._dirty)
+		return true;
+#endif
 
-#endif // !__DC__
+	DomainMap::const_iterator d;
+	for (d = _miscDomains.begin(); d != _miscDomains.end(); ++d) {
+		if (d->_value._dirty)
+			return true;
+	}
+	for (d = _gameDomains.begin(); d != _gameDomains.end(); ++d) {
+		if (d->_value._dirty)
+			return true;
+	}
+	return false;
+}
+
+void ConfigManager::markClean() {
+	_domainsChanged = false;
+	_appDomain._dirty = false;
+#ifdef ENABLE_KEYMAPPER
+	_keymapperDomain._dirty = false;
+#endif
+#ifdef USE_CLOUD
+	_cloudDomain._dirty = false;
+#endif
+
+	DomainMap::iterator d;
+	for (d = _miscDomains.begin(); d != _miscDomains.end(); ++d)
+		d->_value._dirty = false;
+	for (d = _gameDomains.begin(); d != _gameDomains.end(); ++d)
+		d->_value._dirty = false;
+}
+
+ConfigManager::Stats ConfigManager::getStats() const {
+	Stats stats = _stats;
+	stats.domains = _gameDomains.size() + _miscDomains.size();
+	stats.parsedDomains = 0;
+
+	DomainMap::const_iterator d;
+	for (d = _miscDomains.begin(); d != _miscDomains.end(); ++d) {
+		if (d->_value._parsed)
+			stats.parsedDomains++;
+	}
+	for (d = _gameDomains.begin(); d != _gameDomains.end(); ++d) {
+		if (d->_value._parsed)
+			stats.parsedDomains++;
+	}
+	return stats;
 }
 
 void ConfigManager::writeDomain(WriteStream &stream, const String &name, const Domain &domain) {
+	if (!domain._source.empty()) {
+		// Unmodified since it was loaded, so copy it from the file
+		// without parsing it
+		if (domain._sourceBegin == domain._sourceEnd)
+			return;     // Don't bother writing empty domains.
+
+		stream.writeString(domain._domainComment);
+		stream.writeByte('[');
+		stream.writeString(name);
+		stream.writeByte(']');
+		stream.writeByte('\n');
+		stream.write(domain._source.c_str() + domain._sourceBegin, domain._sourceEnd - domain._sourceBegin);
+		stream.writeByte('\n');
+		stream.writeByte('\n');
+		return;
+	}
+
 	if (domain.empty())
 		return;     // Don't bother writing empty domains.
 
@@ -468,7 +687,7 @@ const String &ConfigManager::get(const String &key) const {
 	if (_transientDomain.contains(key))
 		return _transientDomain[key];
 	else if (_activeDomain && _activeDomain->contains(key))
-		return (*_activeDomain)[key];
+		return ((const Domain *)_activeDomain)->getVal(key);
 	else if (_appDomain.contains(key))
 		return _appDomain[key];
 
@@ -536,9 +755,9 @@ void ConfigManager::set(const String &key, const String &value) {
 	// Write the new key/value pair into the active domain, resp. into
 	// the application domain if no game domain is active.
 	if (_activeDomain)
-		(*_activeDomain)[key] = value;
+		_activeDomain->setVal(key, value);
 	else
-		_appDomain[key] = value;
+		_appDomain.setVal(key, value);
 }
 
 void ConfigManager::set(const String &key, const String &value, const String &domName) {
@@ -556,7 +775,7 @@ void ConfigManager::set(const String &key, const String &value, const String &do
 		error("ConfigManager::set(%s,%s,%s) called on non-existent domain",
 		      key.c_str(), value.c_str(), domName.c_str());
 
-	(*domain)[key] = value;
+	domain->setVal(key, value);
 
 	// TODO/FIXME: We used to erase the given key from the transient domain
 	// here. Do we still want to do that?
@@ -599,7 +818,7 @@ void ConfigManager::setBool(const String &key, bool value, const String &domName
 
 
 void ConfigManager::registerDefault(const String &key, const String &value) {
-	_defaultsDomain[key] = value;
+	_defaultsDomain.setVal(key, value);
 }
 
 void ConfigManager::registerDefault(const String &key, const char *value) {
@@ -636,6 +855,7 @@ void ConfigManager::addGameDomain(const String &domName) {
 	// the given name already exists?
 
 	_gameDomains[domName];
+	_domainsChanged = true;
 
 	// Add it to the _domainSaveOrder, if it's not already in there
 	if (find(_domainSaveOrder.begin(), _domainSaveOrder.end(), domName) == _domainSaveOrder.end())
@@ -647,6 +867,7 @@ void ConfigManager::addMiscDomain(const String &domName) {
 	assert(isValidDomainName(domName));
 
 	_miscDomains[domName];
+	_domainsChanged = true;
 }
 
 void ConfigManager::removeGameDomain(const String &domName) {
@@ -657,12 +878,14 @@ void ConfigManager::removeGameDomain(const String &domName) {
 		_activeDomain = 0;
 	}
 	_gameDomains.erase(domName);
+	_domainsChanged = true;
 }
 
 void ConfigManager::removeMiscDomain(const String &domName) {
 	assert(!domName.empty());
 	assert(isValidDomainName(domName));
 	_miscDomains.erase(domName);
+	_domainsChanged = true;
 }
 
 
@@ -695,9 +918,10 @@ void ConfigManager::renameDomain(const String &oldName, const String &newName, D
 	Domain &newDom = map[newName];
 	Domain::const_iterator iter;
 	for (iter = oldDom.begin(); iter != oldDom.end(); ++iter)
-		newDom[iter->_key] = iter->_value;
+		newDom.setVal(iter->_key, iter->_value);
 
 	map.erase(oldName);
+	_domainsChanged = true;
 }
 
 bool ConfigManager::hasGameDomain(const String &domName) const {
@@ -712,7 +936,19 @@ bool ConfigManager::hasMiscDomain(const String &domName) const {
 
 #pragma mark -
 
+void ConfigManager::Domain::setVal(const String &key, const String &value) {
+	// Setting a value to what it already is does not need a flush
+	ensureParsed();
+	StringMap::const_iterator i = _entries.find(key);
+	if (i != _entries.end() && i->_value == value)
+		return;
+
+	modify();
+	_entries.setVal(key, value);
+}
+
 void ConfigManager::Domain::setDomainComment(const String &comment) {
+	modify();
 	_domainComment = comment;
 }
 const String &ConfigManager::Domain::getDomainComment() const {
@@ -720,12 +956,15 @@ const String &ConfigManager::Domain::getDomainComment() const {
 }
 
 void ConfigManager::Domain::setKVComment(const String &key, const String &comment) {
+	modify();
 	_keyValueComments[key] = comment;
 }
 const String &ConfigManager::Domain::getKVComment(const String &key) const {
+	ensureParsed();
 	return _keyValueComments[key];
 }
 bool ConfigManager::Domain::hasKVComment(const String &key) const {
+	ensureParsed();
 	return _keyValueComments.contains(key);
 }
 
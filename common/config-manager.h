@@ -46,32 +46,55 @@ class ConfigManager : public Singleton<ConfigManager> {
 
 public:
 
+	/**
+	 * A set of key/value pairs. Domains loaded from the config file keep
+	 * the part of the file they came from, and only parse it when they are
+	 * accessed for the first time. As long as they are not modified, they
+	 * are written back by copying that part of the file.
+	 */
 	class Domain {
 	private:
-		StringMap _entries;
-		StringMap _keyValueComments;
+		friend class ConfigManager;
+
+		mutable StringMap _entries;
+		mutable StringMap _keyValueComments;
 		String _domainComment;
 
+		/** The config file text, shared by all domains loaded from it. */
+		String _source;
+		/** Range of the key/value lines of this domain in _source. */
+		uint32 _sourceBegin, _sourceEnd;
+		mutable bool _parsed;
+		/** Set if the domain was modified since it was last written. */
+		bool _dirty;
+
+		void setSource(const String &text, const String &comment, uint32 begin, uint32 end);
+		void parseSource() const;
+		void ensureParsed() const { if (!_parsed) parseSource(); }
+		void modify() { ensureParsed(); _source.clear(); _dirty = true; }
+
 	public:
+		Domain() : _sourceBegin(0), _sourceEnd(0), _parsed(true), _dirty(false) {}
+
 		typedef StringMap::const_iterator const_iterator;
-		const_iterator begin() const { return _entries.begin(); }
-		const_iterator end()   const { return _entries.end(); }
+		const_iterator begin() const { ensureParsed(); return _entries.begin(); }
+		const_iterator end()   const { ensureParsed(); return _entries.end(); }
 
-		bool empty() const { return _entries.empty(); }
+		bool empty() const { ensureParsed(); return _entries.empty(); }
 
-		bool contains(const String &key) const { return _entries.contains(key); }
+		bool contains(const String &key) const { ensureParsed(); return _entries.contains(key); }
 
-		String &operator[](const String &key) { return _entries[key]; }
-		const String &operator[](const String &key) const { return _entries[key]; }
+		// Values are read-only, so that reading them does not mark the
+		// domain as modified; use setVal() to change them
+		const String &operator[](const String &key) const { ensureParsed(); return _entries[key]; }
 
-		void setVal(const String &key, const String &value) { _entries.setVal(key, value); }
+		void setVal(const String &key, const String &value);
 
-		String &getVal(const String &key) { return _entries.getVal(key); }
-		const String &getVal(const String &key) const { return _entries.getVal(key); }
+		const String &getVal(const String &key) const { ensureParsed(); return _entries.getVal(key); }
 
-		void clear() { _entries.clear(); }
+		void clear() { modify(); _entries.clear(); }
 
-		void erase(const String &key) { _entries.erase(key); }
+		void erase(const String &key) { modify(); _entries.erase(key); }
 
 		void setDomainComment(const String &comment);
 		const String &getDomainComment() const;
@@ -149,8 +172,34 @@ public:
 	void				registerDefault(const String &key, int value);
 	void				registerDefault(const String &key, bool value);
 
+	/**
+	 * Write the configuration to the config file. This does nothing if no
+	 * domain was added, removed or modified since the last load or flush,
+	 * so it is cheap to call after every change of the options.
+	 */
 	void				flushToDisk();
 
+	/**
+	 * Load the configuration from a stream in the format of the config
+	 * file, replacing the current one. Only the positions of the domains
+	 * are determined here, their contents are parsed when they are used.
+	 */
+	void				loadFromStream(SeekableReadStream &stream);
+
+	/** Write the configuration to a stream in the format of the config file. */
+	void				saveToStream(WriteStream &stream);
+
+	struct Stats {
+		uint32 loadTime;		///< Milliseconds spent in the last load
+		uint32 flushTime;		///< Milliseconds spent in the last flush which wrote the file
+		uint32 flushes;			///< Number of flushes which wrote the file
+		uint32 skippedFlushes;	///< Number of flushes which had nothing to write
+		uint32 domains;			///< Number of game and misc domains
+		uint32 parsedDomains;	///< Number of them which have been parsed so far
+	};
+
+	Stats				getStats() const;
+
 	void				setActiveDomain(const String &domName);
 	Domain *			getActiveDomain() { return _activeDomain; }
 	const Domain *		getActiveDomain() const { return _activeDomain; }
@@ -178,10 +227,11 @@ private:
 	friend class Singleton<SingletonBaseType>;
 	ConfigManager();
 
-	void			loadFromStream(SeekableReadStream &stream);
-	void			addDomain(const String &domainName, const Domain &domain);
+	Domain *		addDomain(const String &domainName, bool isGameDomain);
 	void			writeDomain(WriteStream &stream, const String &name, const Domain &domain);
 	void			renameDomain(const String &oldName, const String &newName, DomainMap &map);
+	bool			isDirty() const;
+	void			markClean();
 
 	Domain			_transientDomain;
 	DomainMap		_gameDomains;
@@ -203,6 +253,10 @@ private:
 	Domain *		_activeDomain;
 
 	String			_filename;
+
+	/** Set if domains were added, removed or renamed since the last flush. */
+	bool			_domainsChanged;
+	Stats			_stats;
 };
 
 } // End of namespace Common
@@ -73,9 +73,8 @@ static void displayCoroStats() {
 #endif
 
 CoroBaseContext::CoroBaseContext(const char *func)
-	: _line(0), _sleep(0), _subctx(0) {
+	: _line(0), _sleep(0), _subctx(0), _funcName(func) {
 #ifdef COROUTINE_DEBUG
-	_funcName = func;
 	changeCoroStats(_funcName, +1);
 	s_coroCount++;
 #endif
@@ -107,6 +106,7 @@ CoroutineScheduler::CoroutineScheduler() {
 
 	pRCfunction = NULL;
 	pidCounter = 0;
+	_profiling = false;
 
 	active = new PROCESS;
 	active->pPrevious = NULL;
@@ -131,6 +131,7 @@ CoroutineScheduler::~CoroutineScheduler() {
 	active = 0;
 
 	// Clear the event list
+	_eventIndex.clear();
 	Common::List<EVENT *>::iterator i;
 	for (i = _events.begin(); i != _events.end(); ++i)
 		delete *i;
@@ -158,11 +159,13 @@ void CoroutineScheduler::reset() {
 	// Kill all running processes (i.e. free memory allocated for their state).
 	PROCESS *pProc = active->pNext;
 	while (pProc != NULL) {
+		addProfile(_profile, pProc, false);
 		delete pProc->state;
 		pProc->state = 0;
 		Common::fill(&pProc->pidWaiting[0], &pProc->pidWaiting[CORO_MAX_PID_WAITING], 0);
 		pProc = pProc->pNext;
 	}
+	_pidIndex.clear();
 
 	// no active processes
 	pCurrent = active->pNext = NULL;
@@ -229,7 +232,16 @@ void CoroutineScheduler::schedule() {
 		if (--pProc->sleepTime <= 0) {
 			// process is ready for dispatch, activate it
 			pCurrent = pProc;
-			pProc->coroAddr(pProc->state, pProc->param);
+			if (_profiling) {
+				const uint32 startTime = g_system->getMillis(true);
+				pProc->coroAddr(pProc->state, pProc->param);
+				pProc->stats.time += g_system->getMillis(true) - startTime;
+			} else {
+				pProc->coroAddr(pProc->state, pProc->param);
+			}
+			pProc->stats.runs++;
+			if (pProc->state && !pProc->funcName)
+				pProc->funcName = pProc->state->_funcName;
 
 			if (!pProc->state || pProc->state->_sleep <= 0) {
 				// Coroutine finished
@@ -270,6 +282,8 @@ void CoroutineScheduler::rescheduleAll() {
 	active->pNext->pPrevious = pCurrent;
 	active->pNext = pCurrent;
 	pCurrent->pPrevious = active;
+
+	reindexProcess(pCurrent);
 }
 
 void CoroutineScheduler::reschedule(PPROCESS pReSchedProc) {
@@ -307,6 +321,8 @@ void CoroutineScheduler::reschedule(PPROCESS pReSchedProc) {
 	pEnd->pNext = pReSchedProc;
 	pReSchedProc->pPrevious = pEnd;
 	pReSchedProc->pNext = NULL;
+
+	reindexProcess(pReSchedProc);
 }
 
 void CoroutineScheduler::giveWay(PPROCESS pReSchedProc) {
@@ -340,6 +356,8 @@ void CoroutineScheduler::giveWay(PPROCESS pReSchedProc) {
 	pEnd->pNext = pReSchedProc;
 	pReSchedProc->pPrevious = pEnd;
 	pReSchedProc->pNext = NULL;
+
+	reindexProcess(pReSchedProc);
 }
 
 void CoroutineScheduler::waitForSingleObject(CORO_PARAM, int pid, uint32 duration, bool *expired) {
@@ -350,12 +368,14 @@ void CoroutineScheduler::waitForSingleObject(CORO_PARAM, int pid, uint32 duratio
 		uint32 endTime;
 		PROCESS *pProcess;
 		EVENT *pEvent;
+		bool woken;
 	CORO_END_CONTEXT(_ctx);
 
 	CORO_BEGIN_CODE(_ctx);
 
 	// Signal the process Id this process is now waiting for
 	pCurrent->pidWaiting[0] = pid;
+	_ctx->woken = false;
 
 	_ctx->endTime = (duration == CORO_INFINITE) ? CORO_INFINITE : g_system->getMillis() + duration;
 	if (expired)
@@ -373,6 +393,7 @@ void CoroutineScheduler::waitForSingleObject(CORO_PARAM, int pid, uint32 duratio
 		if ((_ctx->pProcess == NULL) && (_ctx->pEvent == NULL)) {
 			if (expired)
 				*expired = false;
+			_ctx->woken = true;
 			break;
 		}
 
@@ -385,6 +406,7 @@ void CoroutineScheduler::waitForSingleObject(CORO_PARAM, int pid, uint32 duratio
 
 			if (expired)
 				*expired = false;
+			_ctx->woken = true;
 			break;
 		}
 
@@ -395,6 +417,11 @@ void CoroutineScheduler::waitForSingleObject(CORO_PARAM, int pid, uint32 duratio
 	// Signal waiting is done
 	Common::fill(&pCurrent->pidWaiting[0], &pCurrent->pidWaiting[CORO_MAX_PID_WAITING], 0);
 
+	if (_ctx->woken)
+		pCurrent->stats.eventWakeups++;
+	else
+		pCurrent->stats.sleepWakeups++;
+
 	CORO_END_CODE;
 }
 
@@ -417,6 +444,7 @@ void CoroutineScheduler::waitForMultipleObjects(CORO_PARAM, int nCount, uint32 *
 	// Signal the waiting events
 	assert(nCount < CORO_MAX_PID_WAITING);
 	Common::copy(pidList, pidList + nCount, pCurrent->pidWaiting);
+	_ctx->signalled = false;
 
 	_ctx->endTime = (duration == CORO_INFINITE) ? CORO_INFINITE : g_system->getMillis() + duration;
 	if (expired)
@@ -462,6 +490,11 @@ void CoroutineScheduler::waitForMultipleObjects(CORO_PARAM, int nCount, uint32 *
 	// Signal waiting is done
 	Common::fill(&pCurrent->pidWaiting[0], &pCurrent->pidWaiting[CORO_MAX_PID_WAITING], 0);
 
+	if (_ctx->signalled)
+		pCurrent->stats.eventWakeups++;
+	else
+		pCurrent->stats.sleepWakeups++;
+
 	CORO_END_CODE;
 }
 
@@ -485,6 +518,8 @@ void CoroutineScheduler::sleep(CORO_PARAM, uint32 duration) {
 		CORO_SLEEP(1);
 	}
 
+	pCurrent->stats.sleepWakeups++;
+
 	CORO_END_CODE;
 }
 
@@ -539,6 +574,11 @@ PROCESS *CoroutineScheduler::createProcess(uint32 pid, CORO_ADDR coroAddr, const
 
 	// set new process id
 	pProc->pid = pid;
+	indexProcess(pProc);
+
+	// clear profiling data
+	pProc->funcName = NULL;
+	memset(&pProc->stats, 0, sizeof(pProc->stats));
 
 	// set new process specific info
 	if (sizeParam) {
@@ -581,6 +621,9 @@ void CoroutineScheduler::killProcess(PROCESS *pKillProc) {
 	delete pKillProc->state;
 	pKillProc->state = 0;
 
+	addProfile(_profile, pKillProc, false);
+	unindexProcess(pKillProc);
+
 	// Take the process out of the active chain list
 	pKillProc->pPrevious->pNext = pKillProc->pNext;
 	if (pKillProc->pNext)
@@ -612,49 +655,31 @@ int CoroutineScheduler::getCurrentPID() const {
 
 int CoroutineScheduler::killMatchingProcess(uint32 pidKill, int pidMask) {
 	int numKilled = 0;
-	PROCESS *pProc, *pPrev; // process list pointers
+	PROCESS *pProc, *pNext; // process list pointers
 
-	for (pProc = active->pNext, pPrev = active; pProc != NULL; pPrev = pProc, pProc = pProc->pNext) {
-		if ((pProc->pid & (uint32)pidMask) == pidKill) {
-			// found a matching process
+	if (pidMask == -1) {
+		// Without a mask, the processes are found through the index
+		for (pProc = getProcess(pidKill); pProc != NULL; pProc = pNext) {
+			pNext = pProc->pidNext;
 
 			// dont kill the current process
 			if (pProc != pCurrent) {
-				// kill this process
+				killProcess(pProc);
 				numKilled++;
+			}
+		}
+	} else {
+		for (pProc = active->pNext; pProc != NULL; pProc = pNext) {
+			pNext = pProc->pNext;
 
-				// Free the process' resources
-				if (pRCfunction != NULL)
-					(pRCfunction)(pProc);
-
-				delete pProc->state;
-				pProc->state = 0;
-
-				// make prev point to next to unlink pProc
-				pPrev->pNext = pProc->pNext;
-				if (pProc->pNext)
-					pPrev->pNext->pPrevious = pPrev;
-
-				// link first free process after pProc
-				pProc->pNext = pFreeProcesses;
-				pProc->pPrevious = NULL;
-				pFreeProcesses->pPrevious = pProc;
-
-				// make pProc the first free process
-				pFreeProcesses = pProc;
-
-				// set to a process on the active list
-				pProc = pPrev;
+			// dont kill the current process
+			if ((pProc->pid & (uint32)pidMask) == pidKill && pProc != pCurrent) {
+				killProcess(pProc);
+				numKilled++;
 			}
 		}
 	}
 
-#ifdef DEBUG
-	// adjust process in use
-	numProcs -= numKilled;
-	assert(numProcs >= 0);
-#endif
-
 	// return number of processes killed
 	return numKilled;
 }
@@ -664,22 +689,116 @@ void CoroutineScheduler::setResourceCallback(VFPTRPP pFunc) {
 }
 
 PROCESS *CoroutineScheduler::getProcess(uint32 pid) {
-	PROCESS *pProc = active->pNext;
-	while ((pProc != NULL) && (pProc->pid != pid))
-		pProc = pProc->pNext;
-
-	return pProc;
+	return _pidIndex.getVal(pid, NULL);
 }
 
 EVENT *CoroutineScheduler::getEvent(uint32 pid) {
-	Common::List<EVENT *>::iterator i;
-	for (i = _events.begin(); i != _events.end(); ++i) {
-		EVENT *evt = *i;
-		if (evt->pid == pid)
-			return evt;
+	return _eventIndex.getVal(pid, NULL);
+}
+
+void CoroutineScheduler::indexProcess(PROCESS *pProc) {
+	PROCESS *&pFirst = _pidIndex[pProc->pid];
+	if (!pFirst) {
+		pProc->pidPrevious = pProc->pidNext = NULL;
+		pFirst = pProc;
+		return;
+	}
+
+	// The processes with the same Id are kept in the order of the active
+	// list, so that getProcess() returns the first one, as a search of the
+	// list would. Only processes sharing their Id need this search.
+	PROCESS *pNext = pProc->pNext;
+	while (pNext && pNext->pid != pProc->pid)
+		pNext = pNext->pNext;
+
+	PROCESS *pPrev;
+	if (pNext) {
+		pPrev = pNext->pidPrevious;
+	} else {
+		for (pPrev = pFirst; pPrev->pidNext; pPrev = pPrev->pidNext)
+			;
+	}
+
+	pProc->pidNext = pNext;
+	pProc->pidPrevious = pPrev;
+	if (pNext)
+		pNext->pidPrevious = pProc;
+	if (pPrev)
+		pPrev->pidNext = pProc;
+	else
+		pFirst = pProc;
+}
+
+void CoroutineScheduler::unindexProcess(PROCESS *pProc) {
+	if (pProc->pidNext)
+		pProc->pidNext->pidPrevious = pProc->pidPrevious;
+
+	if (pProc->pidPrevious)
+		pProc->pidPrevious->pidNext = pProc->pidNext;
+	else if (pProc->pidNext)
+		_pidIndex[pProc->pid] = pProc->pidNext;
+	else
+		_pidIndex.erase(pProc->pid);
+}
+
+void CoroutineScheduler::reindexProcess(PROCESS *pProc) {
+	if (pProc->pidNext || pProc->pidPrevious) {
+		unindexProcess(pProc);
+		indexProcess(pProc);
+	}
+}
+
+void CoroutineScheduler::addProfile(Array<CoroProfile> &profile, const PROCESS *pProc, bool active) {
+	CoroProfile *entry = NULL;
+	for (uint i = 0; i < profile.size(); ++i) {
+		if (profile[i].coroAddr == pProc->coroAddr) {
+			entry = &profile[i];
+			break;
+		}
 	}
 
-	return NULL;
+	if (!entry) {
+		CoroProfile newEntry;
+		memset(&newEntry, 0, sizeof(newEntry));
+		newEntry.coroAddr = pProc->coroAddr;
+		profile.push_back(newEntry);
+		entry = &profile.back();
+	}
+
+	if (!entry->funcName)
+		entry->funcName = pProc->funcName;
+	entry->processes++;
+	if (active)
+		entry->active++;
+	entry->stats.runs += pProc->stats.runs;
+	entry->stats.time += pProc->stats.time;
+	entry->stats.eventWakeups += pProc->stats.eventWakeups;
+	entry->stats.sleepWakeups += pProc->stats.sleepWakeups;
+}
+
+static bool profileLess(const CoroProfile &a, const CoroProfile &b) {
+	if (a.stats.time != b.stats.time)
+		return a.stats.time > b.stats.time;
+	return a.stats.runs > b.stats.runs;
+}
+
+Array<CoroProfile> CoroutineScheduler::getProfile() const {
+	Array<CoroProfile> profile = _profile;
+	for (const PROCESS *pProc = active->pNext; pProc != NULL; pProc = pProc->pNext)
+		addProfile(profile, pProc, true);
+
+	Common::sort(profile.begin(), profile.end(), profileLess);
+	return profile;
+}
+
+void CoroutineScheduler::setProfiling(bool enable) {
+	_profiling = enable;
+}
+
+void CoroutineScheduler::resetProfile() {
+	_profile.clear();
+	for (PROCESS *pProc = active->pNext; pProc != NULL; pProc = pProc->pNext)
+		memset(&pProc->stats, 0, sizeof(pProc->stats));
 }
 
 
@@ -691,6 +810,7 @@ uint32 CoroutineScheduler::createEvent(bool bManualReset, bool bInitialState) {
 	evt->pulsing = false;
 
 	_events.push_back(evt);
+	_eventIndex[evt->pid] = evt;
 	return evt->pid;
 }
 
@@ -698,6 +818,7 @@ void CoroutineScheduler::closeEvent(uint32 pidEvent) {
 	EVENT *evt = getEvent(pidEvent);
 	if (evt) {
 		_events.remove(evt);
+		_eventIndex.erase(pidEvent);
 		delete evt;
 	}
 }
@@ -25,6 +25,8 @@
 
 #include "common/scummsys.h"
 #include "common/util.h"    // for SCUMMVM_CURRENT_FUNCTION
+#include "common/array.h"
+#include "common/flathashmap.h"
 #include "common/list.h"
 #include "common/singleton.h"
 
@@ -54,9 +56,7 @@ struct CoroBaseContext {
 	int _line;
 	int _sleep;
 	CoroBaseContext *_subctx;
-#ifdef COROUTINE_DEBUG
 	const char *_funcName;
-#endif
 	/**
 	 * Creates a coroutine context
 	 */
@@ -297,10 +297,20 @@ public:
 /** Coroutine parameter for methods converted to coroutines */
 typedef void (*CORO_ADDR)(CoroContext &, const void *);
 
+/** Profiling data of a process, or of all processes of a coroutine */
+struct CoroStats {
+	uint32 runs;            ///< number of times the coroutine was run
+	uint32 time;            ///< milliseconds spent running it, while profiling
+	uint32 eventWakeups;    ///< waits ended by the process or event waited for
+	uint32 sleepWakeups;    ///< sleeps and waits ended because their time was up
+};
+
 /** process structure */
 struct PROCESS {
 	PROCESS *pNext;     ///< pointer to next process in active or free list
 	PROCESS *pPrevious; ///< pointer to previous process in active or free list
+	PROCESS *pidNext;       ///< next active process with the same process ID
+	PROCESS *pidPrevious;   ///< previous active process with the same process ID
 
 	CoroContext state;      ///< the state of the coroutine
 	CORO_ADDR  coroAddr;    ///< the entry point of the coroutine
@@ -309,9 +319,21 @@ struct PROCESS {
 	uint32 pid;         ///< process ID
 	uint32 pidWaiting[CORO_MAX_PID_WAITING];    ///< Process ID(s) process is currently waiting on
 	char param[CORO_PARAM_SIZE];    ///< process specific info
+
+	const char *funcName;   ///< name of the coroutine, known once it has run
+	CoroStats stats;        ///< profiling data
 };
 typedef PROCESS *PPROCESS;
 
+/** Profiling data of all processes running the same coroutine */
+struct CoroProfile {
+	CORO_ADDR coroAddr;     ///< the entry point of the coroutine
+	const char *funcName;   ///< name of the coroutine, or NULL if not known
+	uint32 processes;       ///< number of processes which ran it
+	uint32 active;          ///< number of them which are still active
+	CoroStats stats;
+};
+
 
 /** Event structure */
 struct EVENT {
@@ -362,6 +384,21 @@ private:
 	/** Event list */
 	Common::List<EVENT *> _events;
 
+	/**
+	 * The first active process of each process Id. The others follow
+	 * through PROCESS::pidNext, in the order of the active list.
+	 */
+	FlatHashMap<uint32, PROCESS *> _pidIndex;
+
+	/** The events by event Id */
+	FlatHashMap<uint32, EVENT *> _eventIndex;
+
+	/** Profiling data of the processes which have been killed */
+	Array<CoroProfile> _profile;
+
+	/** Whether the time spent in each process is measured */
+	bool _profiling;
+
 #ifdef DEBUG
 	// diagnostic process counters
 	int numProcs;
@@ -382,6 +419,16 @@ private:
 
 	PROCESS *getProcess(uint32 pid);
 	EVENT *getEvent(uint32 pid);
+
+	void indexProcess(PROCESS *pProc);
+	void unindexProcess(PROCESS *pProc);
+	/** Updates the index after the process moved in the active list */
+	void reindexProcess(PROCESS *pProc);
+
+	/**
+	 * Adds the profiling data of a process to the entry of its coroutine
+	 */
+	static void addProfile(Array<CoroProfile> &profile, const PROCESS *pProc, bool active);
 public:
 	/**
 	 * Kills all processes and places them on the free list.
@@ -395,6 +442,29 @@ public:
 	void printStats();
 #endif
 
+	/**
+	 * Returns the profiling data of the coroutines run since the last
+	 * resetProfile(), sorted by the time spent in them.
+	 *
+	 * @remarks     The time is measured with the millisecond clock, so a
+	 * single short run mostly counts as 0 or 1 ms. Only the sums over many
+	 * runs are meaningful.
+	 */
+	Array<CoroProfile> getProfile() const;
+
+	/**
+	 * Clears the profiling data
+	 */
+	void resetProfile();
+
+	/**
+	 * Enables or disables measuring the time spent in each process, which
+	 * costs two clock reads per process run. It is disabled by default;
+	 * the counts of runs and wakeups are always kept.
+	 */
+	void setProfiling(bool enable);
+	bool isProfiling() const { return _profiling; }
+
 	/**
 	 * Give all active processes a chance to run
 	 */
@@ -24,29 +24,35 @@
 
 #include "common/cosinetables.h"
 #include "common/scummsys.h"
+#include "common/transformtables.h"
 
 namespace Common {
 
-CosineTable::CosineTable(int bitPrecision) {
-	assert((bitPrecision >= 4) && (bitPrecision <= 16));
-
-	_bitPrecision = bitPrecision;
-
-	int m = 1 << _bitPrecision;
+static void *buildCosineTable(int bitPrecision) {
+	int m = 1 << bitPrecision;
 	double freq = 2 * M_PI / m;
-	_table = new float[m / 2];
+	float *table = (float *)malloc(m / 2 * sizeof(float));
 
 	// Table contains cos(2*pi*i/m) for 0<=i<m/4,
 	// followed by 3m/4<=i<m
 	for (int i = 0; i <= m / 4; i++)
-		_table[i] = cos(i * freq);
+		table[i] = cos(i * freq);
 
 	for (int i = 1; i < m / 4; i++)
-		_table[m / 2 - i] = _table[i];
+		table[m / 2 - i] = table[i];
+
+	return table;
+}
+
+CosineTable::CosineTable(int bitPrecision) {
+	assert((bitPrecision >= 4) && (bitPrecision <= 16));
+
+	_bitPrecision = bitPrecision;
+	_table = (const float *)TransformTables::instance().getTable(TransformTables::kCosine, _bitPrecision, buildCosineTable);
 }
 
 CosineTable::~CosineTable() {
-	delete[] _table;
+	// The table is owned by TransformTables
 }
 
 } // End of namespace Common
@@ -27,25 +27,30 @@
 // Copyright (c) 2010 Vitor Sessak
 
 #include "common/dct.h"
+#include "common/transformtables.h"
 
 namespace Common {
 
-DCT::DCT(int bits, TransformType trans) : _bits(bits), _cos(_bits + 2), _trans(trans), _rdft(0) {
-	int n = 1 << _bits;
+static void *buildCsc2Table(int bits) {
+	int n = 1 << bits;
+	float *csc2 = (float *)malloc(n / 2 * sizeof(float));
 
-	_tCos = _cos.getTable();
+	for (int i = 0; i < (n / 2); i++)
+		csc2[i] = 0.5 / sin((M_PI / (2 * n) * (2 * i + 1)));
 
-	_csc2 = new float[n / 2];
+	return csc2;
+}
+
+DCT::DCT(int bits, TransformType trans) : _bits(bits), _cos(_bits + 2), _trans(trans), _rdft(0) {
+	_tCos = _cos.getTable();
 
 	_rdft = new RDFT(_bits, (_trans == DCT_III) ? RDFT::IDFT_C2R : RDFT::DFT_R2C);
 
-	for (int i = 0; i < (n / 2); i++)
-		_csc2[i] = 0.5 / sin((M_PI / (2 * n) * (2 * i + 1)));
+	_csc2 = (const float *)TransformTables::instance().getTable(TransformTables::kDCTCosecants, _bits, buildCsc2Table);
 }
 
 DCT::~DCT() {
 	delete _rdft;
-	delete[] _csc2;
 }
 
 void DCT::calc(float *data) {
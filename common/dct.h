@@ -64,7 +64,7 @@ private:
 	CosineTable _cos;
 	const float *_tCos;
 
-	float *_csc2;
+	const float *_csc2;
 
 	RDFT *_rdft;
 
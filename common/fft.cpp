@@ -30,6 +30,15 @@
 #include "common/fft.h"
 #include "common/util.h"
 #include "common/textconsole.h"
+#include "common/transformtables.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define FFT_USE_SSE
+#include <xmmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define FFT_USE_NEON
+#include <arm_neon.h>
+#endif
 
 namespace Common {
 
@@ -39,13 +48,13 @@ FFT::FFT(int bits, int inverse) : _bits(bits), _inverse(inverse) {
 	int n = 1 << bits;
 
 	_tmpBuf = new Complex[n];
-	_expTab = new Complex[n / 2];
-	_revTab = new uint16[n];
 
 	_splitRadix = 1;
 
-	for (int i = 0; i < n; i++)
-		_revTab[-splitRadixPermutation(i, n, _inverse) & (n - 1)] = i;
+	if (_inverse)
+		_revTab = (const uint16 *)TransformTables::instance().getTable(TransformTables::kFFTInversePermutation, _bits, buildInverseRevTab);
+	else
+		_revTab = (const uint16 *)TransformTables::instance().getTable(TransformTables::kFFTPermutation, _bits, buildRevTab);
 
 	for (int i = 0; i < ARRAYSIZE(_cosTables); i++) {
 		if (i+4 <= _bits)
@@ -60,11 +69,27 @@ FFT::~FFT() {
 		delete _cosTables[i];
 	}
 
-	delete[] _revTab;
-	delete[] _expTab;
 	delete[] _tmpBuf;
 }
 
+uint16 *FFT::buildPermutation(int bits, int inverse) {
+	int n = 1 << bits;
+	uint16 *revTab = (uint16 *)malloc(n * sizeof(uint16));
+
+	for (int i = 0; i < n; i++)
+		revTab[-splitRadixPermutation(i, n, inverse) & (n - 1)] = i;
+
+	return revTab;
+}
+
+void *FFT::buildRevTab(int bits) {
+	return buildPermutation(bits, 0);
+}
+
+void *FFT::buildInverseRevTab(int bits) {
+	return buildPermutation(bits, 1);
+}
+
 const uint16 *FFT::getRevTab() const {
 	return _revTab;
 }
@@ -173,11 +198,84 @@ static void name(Complex *z, const float *wre, unsigned int n) { \
 	} while(--n);\
 }
 
+#if !defined(FFT_USE_SSE) && !defined(FFT_USE_NEON)
+
 PASS(pass)
 #undef BUTTERFLIES
 #define BUTTERFLIES BUTTERFLIES_BIG
 PASS(pass_big)
 
+#else
+
+/*
+ * The same pass as above, for two complex values at a time. In terms of
+ * complex numbers, with w the twiddle factor of a0...a3:
+ *   u = a2 * conj(w), v = a3 * w, s = v + u, d = v - u
+ *   a0 = a0 + s, a2 = a0 - s, a1 = a1 + i * d, a3 = a1 - i * d
+ * The twiddle factors of z[k] are wre[k] and wre[2 * n - k].
+ */
+
+#if defined(FFT_USE_SSE)
+
+typedef __m128 fft_vec;
+
+static inline fft_vec vecLoad(const Complex *z) { return _mm_loadu_ps(&z->re); }
+static inline void vecStore(Complex *z, fft_vec v) { _mm_storeu_ps(&z->re, v); }
+static inline fft_vec vecSet(float a, float b) { return _mm_set_ps(b, b, a, a); }
+static inline fft_vec vecAdd(fft_vec a, fft_vec b) { return _mm_add_ps(a, b); }
+static inline fft_vec vecSub(fft_vec a, fft_vec b) { return _mm_sub_ps(a, b); }
+static inline fft_vec vecMul(fft_vec a, fft_vec b) { return _mm_mul_ps(a, b); }
+/** Swap the real and the imaginary parts, and negate the new real parts. */
+static inline fft_vec vecSwapNeg(fft_vec a) {
+	return _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)), _mm_set_ps(1.0f, -1.0f, 1.0f, -1.0f));
+}
+
+#elif defined(FFT_USE_NEON)
+
+typedef float32x4_t fft_vec;
+
+static inline fft_vec vecLoad(const Complex *z) { return vld1q_f32(&z->re); }
+static inline void vecStore(Complex *z, fft_vec v) { vst1q_f32(&z->re, v); }
+static inline fft_vec vecSet(float a, float b) { return vcombine_f32(vdup_n_f32(a), vdup_n_f32(b)); }
+static inline fft_vec vecAdd(fft_vec a, fft_vec b) { return vaddq_f32(a, b); }
+static inline fft_vec vecSub(fft_vec a, fft_vec b) { return vsubq_f32(a, b); }
+static inline fft_vec vecMul(fft_vec a, fft_vec b) { return vmulq_f32(a, b); }
+/** Swap the real and the imaginary parts, and negate the new real parts. */
+static inline fft_vec vecSwapNeg(fft_vec a) {
+	static const float sign[4] = { -1.0f, 1.0f, -1.0f, 1.0f };
+	return vmulq_f32(vrev64q_f32(a), vld1q_f32(sign));
+}
+
+#endif
+
+static void pass_simd(Complex *z, const float *wre, unsigned int n) {
+	const int o1 = 2 * n;
+	const int o2 = 4 * n;
+	const int o3 = 6 * n;
+
+	for (int k = 0; k < o1; k += 2) {
+		const fft_vec wr = vecSet(wre[k], wre[k + 1]);
+		const fft_vec wi = vecSet(wre[o1 - k], wre[o1 - k - 1]);
+
+		const fft_vec a0 = vecLoad(z + k);
+		const fft_vec a1 = vecLoad(z + o1 + k);
+		const fft_vec a2 = vecLoad(z + o2 + k);
+		const fft_vec a3 = vecLoad(z + o3 + k);
+
+		const fft_vec u = vecSub(vecMul(a2, wr), vecMul(vecSwapNeg(a2), wi));
+		const fft_vec v = vecAdd(vecMul(a3, wr), vecMul(vecSwapNeg(a3), wi));
+		const fft_vec s = vecAdd(v, u);
+		const fft_vec id = vecSwapNeg(vecSub(v, u));
+
+		vecStore(z + k,      vecAdd(a0, s));
+		vecStore(z + o1 + k, vecAdd(a1, id));
+		vecStore(z + o2 + k, vecSub(a0, s));
+		vecStore(z + o3 + k, vecSub(a1, id));
+	}
+}
+
+#endif
+
 void FFT::fft4(Complex *z) {
 	float t1, t2, t3, t4, t5, t6, t7, t8;
 
@@ -242,10 +340,14 @@ void FFT::fft(int n, int logn, Complex *z) {
 		fft((n / 4), logn - 2, z + (n / 4) * 2);
 		fft((n / 4), logn - 2, z + (n / 4) * 3);
 		assert(_cosTables[logn - 4]);
+#if defined(FFT_USE_SSE) || defined(FFT_USE_NEON)
+		pass_simd(z, _cosTables[logn - 4]->getTable(), (n / 4) / 2);
+#else
 		if (n > 1024)
 			pass_big(z, _cosTables[logn - 4]->getTable(), (n / 4) / 2);
 		else
 			pass(z, _cosTables[logn - 4]->getTable(), (n / 4) / 2);
+#endif
 	}
 }
 
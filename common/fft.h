@@ -63,15 +63,19 @@ private:
 	int _bits;
 	int _inverse;
 
-	uint16 *_revTab;
+	/** The permutation, shared by all FFTs of the same size and direction. */
+	const uint16 *_revTab;
 
-	Complex *_expTab;
 	Complex *_tmpBuf;
 
 	int _splitRadix;
 
 	static int splitRadixPermutation(int i, int n, int inverse);
 
+	static uint16 *buildPermutation(int bits, int inverse);
+	static void *buildRevTab(int bits);
+	static void *buildInverseRevTab(int bits);
+
 	CosineTable *_cosTables[13];
 
 	void fft4(Complex *z);
@@ -125,6 +125,11 @@ public:
 	int32 size() const;	// implement abstract SeekableReadStream method
 	bool seek(int32 offs, int whence = SEEK_SET);	// implement abstract SeekableReadStream method
 	uint32 read(void *dataPtr, uint32 dataSize);	// implement abstract SeekableReadStream method
+	/**
+	 * Subclasses which change what read() returns, e.g. by decrypting the
+	 * data, must override this to return 0.
+	 */
+	virtual const byte *getDataPointer() const;	// override SeekableReadStream method
 };
 
 
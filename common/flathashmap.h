@@ -0,0 +1,648 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+// The flat hash map in this file follows the design of the "Swiss table"
+// hash maps: one control byte per slot, holding 7 bits of the hash of the
+// key stored in it, is used to filter a whole group of slots at once.
+
+#ifndef COMMON_FLATHASHMAP_H
+#define COMMON_FLATHASHMAP_H
+
+#include "common/func.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FLATHASHMAP_USE_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define FLATHASHMAP_USE_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace Common {
+
+namespace FlatHashMapImpl {
+
+enum {
+	kCtrlEmpty = -128,
+	kCtrlDeleted = -2
+	// Full slots hold the 7 hash bits of their key, i.e. 0 to 127
+};
+
+inline int countTrailingZeros(uint32 v) {
+#if GCC_ATLEAST(3, 4)
+	return __builtin_ctz(v);
+#elif defined(_MSC_VER)
+	unsigned long result = 0;
+	_BitScanForward(&result, v);
+	return result;
+#else
+	int n = 0;
+	while (!(v & 1)) {
+		v >>= 1;
+		n++;
+	}
+	return n;
+#endif
+}
+
+inline int countLeadingZeros(uint32 v, int width) {
+	// Counts from bit width - 1 downwards; v must be non-zero
+#if GCC_ATLEAST(3, 4)
+	return __builtin_clz(v) - (32 - width);
+#elif defined(_MSC_VER)
+	unsigned long result = 0;
+	_BitScanReverse(&result, v);
+	return width - 1 - result;
+#else
+	int n = 0;
+	for (uint32 bit = 1 << (width - 1); !(v & bit); bit >>= 1)
+		n++;
+	return n;
+#endif
+}
+
+/**
+ * A group of consecutive control bytes. All match functions return a mask
+ * with bit i set if the i-th control byte of the group matches.
+ */
+#if defined(FLATHASHMAP_USE_SSE2)
+struct Group {
+	enum { kWidth = 16 };
+	__m128i _ctrl;
+
+	explicit Group(const int8 *ctrl) : _ctrl(_mm_loadu_si128((const __m128i *)ctrl)) {}
+
+	uint32 match(int8 h2) const {
+		return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), _ctrl));
+	}
+
+	uint32 matchEmpty() const {
+		return match(kCtrlEmpty);
+	}
+
+	uint32 matchEmptyOrDeleted() const {
+		return _mm_movemask_epi8(_ctrl);
+	}
+};
+#elif defined(FLATHASHMAP_USE_NEON)
+struct Group {
+	enum { kWidth = 8 };
+	int8x8_t _ctrl;
+
+	explicit Group(const int8 *ctrl) : _ctrl(vld1_s8(ctrl)) {}
+
+	static uint32 toMask(uint8x8_t matches) {
+		static const uint8 bits[8] = { 1, 2, 4, 8, 16, 32, 64, 128 };
+		uint8x8_t m = vand_u8(matches, vld1_u8(bits));
+		m = vpadd_u8(m, m);
+		m = vpadd_u8(m, m);
+		m = vpadd_u8(m, m);
+		return vget_lane_u8(m, 0);
+	}
+
+	uint32 match(int8 h2) const {
+		return toMask(vceq_s8(_ctrl, vdup_n_s8(h2)));
+	}
+
+	uint32 matchEmpty() const {
+		return match(kCtrlEmpty);
+	}
+
+	uint32 matchEmptyOrDeleted() const {
+		return toMask(vclt_s8(_ctrl, vdup_n_s8(0)));
+	}
+};
+#else
+struct Group {
+	enum { kWidth = 8 };
+	const int8 *_ctrl;
+
+	explicit Group(const int8 *ctrl) : _ctrl(ctrl) {}
+
+	uint32 match(int8 h2) const {
+		uint32 mask = 0;
+		for (int i = 0; i < kWidth; ++i) {
+			if (_ctrl[i] == h2)
+				mask |= 1 << i;
+		}
+		return mask;
+	}
+
+	uint32 matchEmpty() const {
+		return match(kCtrlEmpty);
+	}
+
+	uint32 matchEmptyOrDeleted() const {
+		uint32 mask = 0;
+		for (int i = 0; i < kWidth; ++i) {
+			if (_ctrl[i] < 0)
+				mask |= 1 << i;
+		}
+		return mask;
+	}
+};
+#endif
+
+} // End of namespace FlatHashMapImpl
+
+/**
+ * FlatHashMap<Key,Val> is an open addressing hash map which stores its keys
+ * and values inline, next to a separate array of control bytes. Lookups
+ * usually cost a single probe of the control bytes, which are checked a
+ * group at a time using SSE2 or NEON where available, and one access to the
+ * matching slot.
+ *
+ * The interface is the same as the one of HashMap, and the same hash and
+ * equality functors are used, so a map can be switched from one to the other
+ * by changing its type. There is one important difference though: inserting
+ * new keys may move all entries, which invalidates any iterators, pointers
+ * and references into the map. Only switch maps whose users do not keep
+ * those around.
+ *
+ * The gain is in maps too large for the cache and in keys which are
+ * expensive to compare. Small maps of small integer keys, which HashMap
+ * indexes directly with its identity hash, are faster with HashMap.
+ */
+template<class Key, class Val, class HashFunc = Hash<Key>, class EqualFunc = EqualTo<Key> >
+class FlatHashMap {
+public:
+	typedef uint size_type;
+
+private:
+
+	typedef FlatHashMap<Key, Val, HashFunc, EqualFunc> FHM_t;
+	typedef FlatHashMapImpl::Group Group;
+
+	struct Node {
+		const Key _key;
+		Val _value;
+		explicit Node(const Key &key) : _key(key), _value() {}
+	};
+
+	enum {
+		FLATHASHMAP_MIN_CAPACITY = 16,
+
+		// The map is rehashed once live and deleted entries fill more than
+		// 7/8 of its slots. There must always be empty slots left, since
+		// they are what terminates an unsuccessful lookup.
+		FLATHASHMAP_LOADFACTOR_NUMERATOR = 7,
+		FLATHASHMAP_LOADFACTOR_DENOMINATOR = 8
+	};
+
+	int8 *_ctrl;		///< Control bytes, followed by a copy of the first group
+	Node *_slots;		///< Raw storage for the entries
+	size_type _mask;	///< Capacity of the map minus one; the capacity is a power of two
+	size_type _size;
+	size_type _deleted;	///< Number of slots marked as deleted
+
+	HashFunc _hash;
+	EqualFunc _equal;
+
+	/** Default value, returned by the const getVal. */
+	const Val _defaultVal;
+
+	static const size_type NONE_FOUND = (size_type)-1;
+
+	static uint32 mixHash(uint hash) {
+		// Spread the bits, many of our hash functions are the identity
+		return (uint32)hash * 0x9E3779B1U;
+	}
+
+	static size_type probeStart(uint32 hash) {
+		return hash ^ (hash >> 16);
+	}
+
+	static int8 hashTag(uint32 hash) {
+		return (int8)(hash >> 25);
+	}
+
+	bool isFull(size_type idx) const {
+		return _ctrl[idx] >= 0;
+	}
+
+	void setCtrl(size_type idx, int8 value) {
+		_ctrl[idx] = value;
+		// Mirror the first group after the end, so groups can be loaded
+		// from any slot without wrapping around.
+		if (idx < (size_type)Group::kWidth)
+			_ctrl[_mask + 1 + idx] = value;
+	}
+
+	void allocStorage(size_type capacity);
+	void freeStorage();
+	void assign(const FHM_t &map);
+	size_type lookup(const Key &key) const;
+	size_type findFreeSlot(uint32 hash) const;
+	size_type lookupAndCreateIfMissing(const Key &key);
+	void rehash(size_type newCapacity);
+	void eraseSlot(size_type idx);
+
+	template<class NodeType>
+	class IteratorImpl {
+		friend class FlatHashMap;
+		template<class T> friend class IteratorImpl;
+	protected:
+		typedef const FlatHashMap hashmap_t;
+
+		size_type _idx;
+		hashmap_t *_hashmap;
+
+	protected:
+		IteratorImpl(size_type idx, hashmap_t *hashmap) : _idx(idx), _hashmap(hashmap) {}
+
+		NodeType *deref() const {
+			assert(_hashmap != 0);
+			assert(_idx <= _hashmap->_mask);
+			assert(_hashmap->isFull(_idx));
+			return &_hashmap->_slots[_idx];
+		}
+
+	public:
+		IteratorImpl() : _idx(0), _hashmap(0) {}
+		template<class T>
+		IteratorImpl(const IteratorImpl<T> &c) : _idx(c._idx), _hashmap(c._hashmap) {}
+
+		NodeType &operator*() const { return *deref(); }
+		NodeType *operator->() const { return deref(); }
+
+		bool operator==(const IteratorImpl &iter) const { return _idx == iter._idx && _hashmap == iter._hashmap; }
+		bool operator!=(const IteratorImpl &iter) const { return !(*this == iter); }
+
+		IteratorImpl &operator++() {
+			assert(_hashmap);
+			do {
+				_idx++;
+			} while (_idx <= _hashmap->_mask && !_hashmap->isFull(_idx));
+			if (_idx > _hashmap->_mask)
+				_idx = NONE_FOUND;
+
+			return *this;
+		}
+
+		IteratorImpl operator++(int) {
+			IteratorImpl old = *this;
+			operator ++();
+			return old;
+		}
+	};
+
+public:
+	typedef IteratorImpl<Node> iterator;
+	typedef IteratorImpl<const Node> const_iterator;
+
+	FlatHashMap();
+	FlatHashMap(const FHM_t &map);
+	~FlatHashMap();
+
+	FHM_t &operator=(const FHM_t &map) {
+		if (this == &map)
+			return *this;
+
+		// Remove the previous content and ...
+		clear();
+		freeStorage();
+		// ... copy the new stuff.
+		assign(map);
+		return *this;
+	}
+
+	bool contains(const Key &key) const;
+
+	Val &operator[](const Key &key);
+	const Val &operator[](const Key &key) const;
+
+	Val &getVal(const Key &key);
+	const Val &getVal(const Key &key) const;
+	const Val &getVal(const Key &key, const Val &defaultVal) const;
+	void setVal(const Key &key, const Val &val);
+
+	void clear(bool shrinkArray = 0);
+
+	void erase(iterator entry);
+	void erase(const Key &key);
+
+	size_type size() const { return _size; }
+
+	iterator	begin() {
+		// Find and return the first non-empty entry
+		for (size_type ctr = 0; ctr <= _mask; ++ctr) {
+			if (isFull(ctr))
+				return iterator(ctr, this);
+		}
+		return end();
+	}
+	iterator	end() {
+		return iterator(NONE_FOUND, this);
+	}
+
+	const_iterator	begin() const {
+		// Find and return the first non-empty entry
+		for (size_type ctr = 0; ctr <= _mask; ++ctr) {
+			if (isFull(ctr))
+				return const_iterator(ctr, this);
+		}
+		return end();
+	}
+	const_iterator	end() const {
+		return const_iterator(NONE_FOUND, this);
+	}
+
+	iterator	find(const Key &key) {
+		return iterator(lookup(key), this);
+	}
+
+	const_iterator	find(const Key &key) const {
+		return const_iterator(lookup(key), this);
+	}
+
+	bool empty() const {
+		return (_size == 0);
+	}
+};
+
+//-------------------------------------------------------
+// FlatHashMap functions
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+FlatHashMap<Key, Val, HashFunc, EqualFunc>::FlatHashMap() : _defaultVal() {
+	allocStorage(FLATHASHMAP_MIN_CAPACITY);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+FlatHashMap<Key, Val, HashFunc, EqualFunc>::FlatHashMap(const FHM_t &map) : _defaultVal() {
+	assign(map);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+FlatHashMap<Key, Val, HashFunc, EqualFunc>::~FlatHashMap() {
+	clear();
+	freeStorage();
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::allocStorage(size_type capacity) {
+	assert(capacity >= (size_type)Group::kWidth);
+	_mask = capacity - 1;
+	_size = 0;
+	_deleted = 0;
+
+	_ctrl = (int8 *)malloc(capacity + Group::kWidth);
+	_slots = (Node *)malloc(capacity * sizeof(Node));
+	assert(_ctrl && _slots);
+	memset(_ctrl, FlatHashMapImpl::kCtrlEmpty, capacity + Group::kWidth);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::freeStorage() {
+	free(_ctrl);
+	free(_slots);
+}
+
+/**
+ * Internal method for assigning the content of another FlatHashMap
+ * to this one.
+ *
+ * @note We do *not* deallocate the previous storage here -- the caller is
+ *       responsible for doing that!
+ */
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::assign(const FHM_t &map) {
+	allocStorage(map._mask + 1);
+
+	// Entries keep their slots, so the control bytes can be copied as is
+	memcpy(_ctrl, map._ctrl, _mask + 1 + Group::kWidth);
+	for (size_type ctr = 0; ctr <= _mask; ++ctr) {
+		if (map.isFull(ctr)) {
+			Node *node = new (&_slots[ctr]) Node(map._slots[ctr]._key);
+			node->_value = map._slots[ctr]._value;
+		}
+	}
+	_size = map._size;
+	_deleted = map._deleted;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::clear(bool shrinkArray) {
+	for (size_type ctr = 0; ctr <= _mask; ++ctr) {
+		if (isFull(ctr))
+			_slots[ctr].~Node();
+	}
+
+	if (shrinkArray && _mask + 1 > FLATHASHMAP_MIN_CAPACITY) {
+		freeStorage();
+		allocStorage(FLATHASHMAP_MIN_CAPACITY);
+	} else {
+		memset(_ctrl, FlatHashMapImpl::kCtrlEmpty, _mask + 1 + Group::kWidth);
+		_size = 0;
+		_deleted = 0;
+	}
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::rehash(size_type newCapacity) {
+	const size_type old_size = _size;
+	const size_type old_mask = _mask;
+	int8 *old_ctrl = _ctrl;
+	Node *old_slots = _slots;
+
+	allocStorage(newCapacity);
+
+	// Move all the old entries over. Since we know that no key exists twice
+	// in the old table, we can skip the _equal() checks of a lookup.
+	for (size_type ctr = 0; ctr <= old_mask; ++ctr) {
+		if (old_ctrl[ctr] < 0)
+			continue;
+
+		Node &node = old_slots[ctr];
+		const uint32 hash = mixHash(_hash(node._key));
+		const size_type idx = findFreeSlot(hash);
+		new (&_slots[idx]) Node(node._key);
+		_slots[idx]._value = node._value;
+		setCtrl(idx, hashTag(hash));
+		_size++;
+		node.~Node();
+	}
+
+	// Perform a sanity check: Old number of elements should match the new one!
+	// This check will fail if some previous operation corrupted this hashmap.
+	assert(_size == old_size);
+
+	free(old_ctrl);
+	free(old_slots);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+typename FlatHashMap<Key, Val, HashFunc, EqualFunc>::size_type FlatHashMap<Key, Val, HashFunc, EqualFunc>::lookup(const Key &key) const {
+	const uint32 hash = mixHash(_hash(key));
+	const int8 tag = hashTag(hash);
+	size_type pos = probeStart(hash) & _mask;
+
+	// Triangular probing over groups visits every group once, as long as
+	// the capacity is a power of two.
+	for (size_type step = Group::kWidth; ; step += Group::kWidth) {
+		const Group group(_ctrl + pos);
+		for (uint32 matches = group.match(tag); matches; matches &= matches - 1) {
+			const size_type idx = (pos + FlatHashMapImpl::countTrailingZeros(matches)) & _mask;
+			if (_equal(_slots[idx]._key, key))
+				return idx;
+		}
+		if (group.matchEmpty())
+			return NONE_FOUND;
+		pos = (pos + step) & _mask;
+	}
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+typename FlatHashMap<Key, Val, HashFunc, EqualFunc>::size_type FlatHashMap<Key, Val, HashFunc, EqualFunc>::findFreeSlot(uint32 hash) const {
+	size_type pos = probeStart(hash) & _mask;
+	for (size_type step = Group::kWidth; ; step += Group::kWidth) {
+		const uint32 slots = Group(_ctrl + pos).matchEmptyOrDeleted();
+		if (slots)
+			return (pos + FlatHashMapImpl::countTrailingZeros(slots)) & _mask;
+		pos = (pos + step) & _mask;
+	}
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+typename FlatHashMap<Key, Val, HashFunc, EqualFunc>::size_type FlatHashMap<Key, Val, HashFunc, EqualFunc>::lookupAndCreateIfMissing(const Key &key) {
+	size_type ctr = lookup(key);
+	if (ctr != NONE_FOUND)
+		return ctr;
+
+	// Keep the load factor below a certain threshold. Deleted entries are
+	// also counted. If they make up most of it, rehashing at the same
+	// capacity is enough to get rid of them.
+	size_type capacity = _mask + 1;
+	if ((_size + _deleted + 1) * FLATHASHMAP_LOADFACTOR_DENOMINATOR >
+	        capacity * FLATHASHMAP_LOADFACTOR_NUMERATOR) {
+		if ((_size + 1) * 2 * FLATHASHMAP_LOADFACTOR_DENOMINATOR > capacity * FLATHASHMAP_LOADFACTOR_NUMERATOR)
+			capacity *= 2;
+		rehash(capacity);
+	}
+
+	const uint32 hash = mixHash(_hash(key));
+	ctr = findFreeSlot(hash);
+	if (_ctrl[ctr] == FlatHashMapImpl::kCtrlDeleted)
+		_deleted--;
+	new (&_slots[ctr]) Node(key);
+	setCtrl(ctr, hashTag(hash));
+	_size++;
+
+	return ctr;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+bool FlatHashMap<Key, Val, HashFunc, EqualFunc>::contains(const Key &key) const {
+	return lookup(key) != NONE_FOUND;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::operator[](const Key &key) {
+	return getVal(key);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::operator[](const Key &key) const {
+	return getVal(key);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getVal(const Key &key) {
+	// The lookup may reallocate _slots, so it has to happen first
+	size_type ctr = lookupAndCreateIfMissing(key);
+	return _slots[ctr]._value;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getVal(const Key &key) const {
+	return getVal(key, _defaultVal);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+const Val &FlatHashMap<Key, Val, HashFunc, EqualFunc>::getVal(const Key &key, const Val &defaultVal) const {
+	size_type ctr = lookup(key);
+	if (ctr != NONE_FOUND)
+		return _slots[ctr]._value;
+	else
+		return defaultVal;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::setVal(const Key &key, const Val &val) {
+	size_type ctr = lookupAndCreateIfMissing(key);
+	_slots[ctr]._value = val;
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::eraseSlot(size_type idx) {
+	_slots[idx].~Node();
+	_size--;
+
+	if (_size == 0) {
+		// Nothing left, so all deleted markers can go too
+		memset(_ctrl, FlatHashMapImpl::kCtrlEmpty, _mask + 1 + Group::kWidth);
+		_deleted = 0;
+		return;
+	}
+
+	// A lookup only continues past a group without empty slots. If there
+	// are fewer than a group's width of non-empty slots between the empty
+	// slots around this one, every group containing it also contains one of
+	// those, so no lookup ever probed past it: it can become empty again
+	// instead of leaving a deleted marker behind, which would lengthen the
+	// probes until the next rehash.
+	const uint32 emptyAfter = Group(_ctrl + idx).matchEmpty();
+	const uint32 emptyBefore = Group(_ctrl + ((idx - Group::kWidth) & _mask)).matchEmpty();
+	if (emptyAfter && emptyBefore &&
+	        FlatHashMapImpl::countTrailingZeros(emptyAfter) +
+	        FlatHashMapImpl::countLeadingZeros(emptyBefore, Group::kWidth) < (int)Group::kWidth) {
+		setCtrl(idx, FlatHashMapImpl::kCtrlEmpty);
+	} else {
+		setCtrl(idx, FlatHashMapImpl::kCtrlDeleted);
+		_deleted++;
+	}
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::erase(iterator entry) {
+	// Check whether we have a valid iterator
+	assert(entry._hashmap == this);
+	assert(entry._idx <= _mask);
+	assert(isFull(entry._idx));
+
+	eraseSlot(entry._idx);
+}
+
+template<class Key, class Val, class HashFunc, class EqualFunc>
+void FlatHashMap<Key, Val, HashFunc, EqualFunc>::erase(const Key &key) {
+	size_type ctr = lookup(key);
+	if (ctr != NONE_FOUND)
+		eraseSlot(ctr);
+}
+
+} // End of namespace Common
+
+#endif
@@ -125,6 +125,17 @@ bool FSNode::isWritable() const {
 	return _realNode && _realNode->isWritable();
 }
 
+bool FSNode::getFileStat(uint32 &size, uint32 &modificationTime) const {
+	return _realNode && _realNode->getFileStat(size, modificationTime);
+}
+
+String FSNode::getFingerprint() const {
+	uint32 size, modificationTime;
+	if (!getFileStat(size, modificationTime))
+		return String();
+	return String::format("%u/%u", size, modificationTime);
+}
+
 SeekableReadStream *FSNode::createReadStream() const {
 	if (_realNode == 0)
 		return 0;
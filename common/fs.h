@@ -213,6 +213,21 @@ public:
 	 */
 	bool isWritable() const;
 
+	/**
+	 * Retrieve the size and the last modification time (in seconds since the
+	 * Unix epoch) of the file referred by this node, without opening it.
+	 * Not all backends support this.
+	 *
+	 * @return true if successful, false otherwise.
+	 */
+	bool getFileStat(uint32 &size, uint32 &modificationTime) const;
+
+	/**
+	 * The fingerprint of a file is made of its size and modification time.
+	 * @see ArchiveMember::getFingerprint
+	 */
+	virtual String getFingerprint() const;
+
 	/**
 	 * Creates a SeekableReadStream instance corresponding to the file
 	 * referred by this node. This assumes that the node actually refers
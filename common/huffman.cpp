@@ -33,7 +33,8 @@ Huffman::Symbol::Symbol(uint32 c, uint32 s) : code(c), symbol(s) {
 }
 
 
-Huffman::Huffman(uint8 maxLength, uint32 codeCount, const uint32 *codes, const uint8 *lengths, const uint32 *symbols) {
+Huffman::Huffman(uint8 maxLength, uint32 codeCount, const uint32 *codes, const uint8 *lengths, const uint32 *symbols, bool msbFirst) :
+	_msbFirst(msbFirst), _tableBits(0) {
 	assert(codeCount > 0);
 
 	assert(codes);
@@ -58,6 +59,8 @@ Huffman::Huffman(uint8 maxLength, uint32 codeCount, const uint32 *codes, const u
 		// And put the pointer to the symbol/code struct into the symbol list.
 		_symbols[i] = &_codes[lengths[i] - 1].back();
 	}
+
+	buildTable();
 }
 
 Huffman::~Huffman() {
@@ -66,9 +69,106 @@ Huffman::~Huffman() {
 void Huffman::setSymbols(const uint32 *symbols) {
 	for (uint32 i = 0; i < _symbols.size(); i++)
 		_symbols[i]->symbol = symbols ? *symbols++ : i;
+
+	// The table holds the symbols, too
+	buildTable();
+}
+
+void Huffman::fillTable(uint32 offset, uint32 tableBits, uint32 code, uint32 length, uint32 codeLength, uint32 symbol) {
+	// The code fills all entries whose index starts with its first length
+	// bits. With MSB first, these are at the top of the index, otherwise at
+	// the bottom.
+	const uint32 count = 1 << (tableBits - length);
+	for (uint32 i = 0; i < count; i++) {
+		const uint32 index = _msbFirst ? ((code << (tableBits - length)) | i) : (code | (i << length));
+
+		TableEntry &entry = _table[offset + index];
+		entry.value = symbol;
+		entry.length = codeLength;
+		entry.subBits = 0;
+	}
+}
+
+void Huffman::buildTable() {
+	_tableBits = MIN<uint32>(kTableBits, _codes.size());
+
+	TableEntry empty;
+	empty.value = 0;
+	empty.length = 0;
+	empty.subBits = 0;
+
+	_table.clear();
+	_table.resize(1 << _tableBits);
+	for (uint32 i = 0; i < _table.size(); i++)
+		_table[i] = empty;
+
+	const uint32 prefixMask = (1 << _tableBits) - 1;
+
+	// Codes up to _tableBits long go into the first level directly. For the
+	// longer ones, find out how big the second level tables have to be.
+	for (uint32 i = 0; i < _codes.size(); i++) {
+		const uint32 length = i + 1;
+
+		for (CodeList::const_iterator cCode = _codes[i].begin(); cCode != _codes[i].end(); ++cCode) {
+			if (length <= _tableBits) {
+				fillTable(0, _tableBits, cCode->code, length, length, cCode->symbol);
+			} else {
+				const uint32 prefix = _msbFirst ? (cCode->code >> (length - _tableBits)) : (cCode->code & prefixMask);
+				_table[prefix].subBits = MAX<uint32>(_table[prefix].subBits, length - _tableBits);
+			}
+		}
+	}
+
+	for (uint32 prefix = 0; prefix <= prefixMask; prefix++) {
+		if (_table[prefix].subBits > kMaxSubBits) {
+			_table[prefix].subBits = kSubBitsSlow;
+		} else if (_table[prefix].subBits) {
+			_table[prefix].value = _table.size();
+			for (uint32 i = 0; i < (1u << _table[prefix].subBits); i++)
+				_table.push_back(empty);
+		}
+	}
+
+	for (uint32 i = _tableBits; i < _codes.size(); i++) {
+		const uint32 length = i + 1;
+		const uint32 restLength = length - _tableBits;
+
+		for (CodeList::const_iterator cCode = _codes[i].begin(); cCode != _codes[i].end(); ++cCode) {
+			const uint32 prefix = _msbFirst ? (cCode->code >> restLength) : (cCode->code & prefixMask);
+			const uint32 rest = _msbFirst ? (cCode->code & ((1 << restLength) - 1)) : (cCode->code >> _tableBits);
+			const TableEntry &sub = _table[prefix];
+			if (sub.subBits == kSubBitsSlow)
+				continue;
+
+			// The entries store the length of the whole code
+			fillTable(sub.value, sub.subBits, rest, restLength, length, cCode->symbol);
+		}
+	}
 }
 
 uint32 Huffman::getSymbol(BitStream &bits) const {
+	if (bits.isMSBFirst() != _msbFirst)
+		return getSymbolSlow(bits);
+
+	const TableEntry *entry = &_table[bits.peekBits(_tableBits)];
+
+	if (entry->subBits) {
+		if (entry->subBits == kSubBitsSlow)
+			return getSymbolSlow(bits);
+
+		const uint32 all = bits.peekBits(_tableBits + entry->subBits);
+		const uint32 index = _msbFirst ? (all & ((1 << entry->subBits) - 1)) : (all >> _tableBits);
+		entry = &_table[entry->value + index];
+	}
+
+	if (!entry->length)
+		error("Unknown Huffman code");
+
+	bits.skip(entry->length);
+	return entry->value;
+}
+
+uint32 Huffman::getSymbolSlow(BitStream &bits) const {
 	uint32 code = 0;
 
 	for (uint32 i = 0; i < _codes.size(); i++) {
@@ -48,17 +48,40 @@ public:
 	 *  @param codes The actual codes.
 	 *  @param lengths Lengths of the individual codes.
 	 *  @param symbols The symbols. If 0, assume they are identical to the code indices.
+	 *  @param msbFirst The bit order of the streams the codes will be read
+	 *                  from, see BitStream::isMSBFirst(). The lookup table
+	 *                  is built for it; codes read from streams of the other
+	 *                  order are decoded bit by bit.
 	 */
-	Huffman(uint8 maxLength, uint32 codeCount, const uint32 *codes, const uint8 *lengths, const uint32 *symbols = 0);
+	Huffman(uint8 maxLength, uint32 codeCount, const uint32 *codes, const uint8 *lengths, const uint32 *symbols = 0, bool msbFirst = true);
 	~Huffman();
 
 	/** Modify the codes' symbols. */
 	void setSymbols(const uint32 *symbols = 0);
 
-	/** Return the next symbol in the bitstream. */
+	/**
+	 * Return the next symbol in the bitstream.
+	 *
+	 * This peeks at the bits of the longest code, so the bitstream may read
+	 * data values ahead of its position, see BitStream::align().
+	 */
 	uint32 getSymbol(BitStream &bits) const;
 
 private:
+	enum {
+		/** Number of bits looked up at once in the first level of the table. */
+		kTableBits = 9,
+
+		/**
+		 * Maximal number of bits indexing a second level table. Longer
+		 * codes are decoded bit by bit, instead of blowing up the table.
+		 */
+		kMaxSubBits = 7,
+
+		/** subBits of the first level entries of codes decoded bit by bit. */
+		kSubBitsSlow = 0xFF
+	};
+
 	struct Symbol {
 		uint32 code;
 		uint32 symbol;
@@ -66,6 +89,18 @@ private:
 		Symbol(uint32 c, uint32 s);
 	};
 
+	/**
+	 * An entry of the lookup table. It either holds the symbol of a code
+	 * and its length, or, for codes longer than the first level, points
+	 * to a second level table indexed by the following subBits bits.
+	 * Entries not matching any code have neither length nor subBits set.
+	 */
+	struct TableEntry {
+		uint32 value;	///< The symbol, or the offset of the second level table
+		uint8 length;	///< Length of the code in bits
+		uint8 subBits;	///< Bits indexing the second level table, or kSubBitsSlow
+	};
+
 	typedef List<Symbol> CodeList;
 	typedef Array<CodeList> CodeLists;
 	typedef Array<Symbol *> SymbolList;
@@ -75,6 +110,19 @@ private:
 
 	/** Sorted list of pointers to the symbols. */
 	SymbolList _symbols;
+
+	/** Whether the lookup table is laid out for streams with MSB first. */
+	bool _msbFirst;
+
+	/** The lookup table, rebuilt whenever the symbols change. */
+	Array<TableEntry> _table;
+	uint8 _tableBits;
+
+	void buildTable();
+	void fillTable(uint32 offset, uint32 tableBits, uint32 code, uint32 length, uint32 codeLength, uint32 symbol);
+
+	/** Decode the next code bit by bit, by searching the code lists. */
+	uint32 getSymbolSlow(BitStream &bits) const;
 };
 
 } // End of namespace Common
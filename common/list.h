@@ -24,6 +24,7 @@
 #define COMMON_LIST_H
 
 #include "common/list_intern.h"
+#include "common/memory.h"
 
 namespace Common {
 
@@ -58,6 +59,24 @@ public:
 		insert(begin(), list.begin(), list.end());
 	}
 
+#if __cplusplus >= 201103L
+	/** Construct a list by taking over the nodes of another one, which is left empty. */
+	List(List<t_T> &&list) {
+		_anchor._prev = &_anchor;
+		_anchor._next = &_anchor;
+
+		splice(list);
+	}
+
+	List<t_T> &operator=(List<t_T> &&list) {
+		if (this != &list) {
+			clear();
+			splice(list);
+		}
+		return *this;
+	}
+#endif
+
 	~List() {
 		clear();
 	}
@@ -131,6 +150,18 @@ public:
 		insert(&_anchor, element);
 	}
 
+#if __cplusplus >= 201103L
+	/** Inserts element at the start of the list, moving it there. */
+	void push_front(t_T &&element) {
+		insertNode(_anchor._next, new Node(Common::move(element)));
+	}
+
+	/** Appends element to the end of the list, moving it there. */
+	void push_back(t_T &&element) {
+		insertNode(&_anchor, new Node(Common::move(element)));
+	}
+#endif
+
 	/** Removes the first element of the list. */
 	void pop_front() {
 		assert(!empty());
@@ -245,7 +276,10 @@ protected:
 	 * Inserts element before pos.
 	 */
 	void insert(NodeBase *pos, const t_T &element) {
-		ListInternal::NodeBase *newNode = new Node(element);
+		insertNode(pos, new Node(element));
+	}
+
+	void insertNode(NodeBase *pos, NodeBase *newNode) {
 		assert(newNode);
 
 		newNode->_next = pos;
@@ -253,6 +287,24 @@ protected:
 		newNode->_prev->_next = newNode;
 		newNode->_next->_prev = newNode;
 	}
+
+#if __cplusplus >= 201103L
+	/** Moves all nodes of the given list to the end of this one. */
+	void splice(List<t_T> &list) {
+		if (list.empty())
+			return;
+
+		NodeBase *first = list._anchor._next;
+		NodeBase *last = list._anchor._prev;
+		list._anchor._prev = &list._anchor;
+		list._anchor._next = &list._anchor;
+
+		first->_prev = _anchor._prev;
+		_anchor._prev->_next = first;
+		last->_next = &_anchor;
+		_anchor._prev = last;
+	}
+#endif
 };
 
 } // End of namespace Common
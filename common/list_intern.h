@@ -24,6 +24,7 @@
 #define COMMON_LIST_INTERN_H
 
 #include "common/scummsys.h"
+#include "common/memory.h"
 
 namespace Common {
 
@@ -41,6 +42,9 @@ namespace ListInternal {
 		T _data;
 
 		Node(const T &x) : _data(x) {}
+#if __cplusplus >= 201103L
+		Node(T &&x) : _data(Common::move(x)) {}
+#endif
 	};
 
 	template<typename T> struct ConstIterator;
@@ -21,12 +21,14 @@
  */
 
 #include "common/scummsys.h"
+#include "common/bufferedstream.h"
 #include "common/debug.h"
 #include "common/util.h"
 #include "common/file.h"
 #include "common/fs.h"
 #include "common/macresman.h"
 #include "common/md5.h"
+#include "common/memstream.h"
 #include "common/substream.h"
 #include "common/textconsole.h"
 #include "common/archive.h"
@@ -46,9 +48,50 @@ namespace Common {
 #define MBI_RFLEN 87
 #define MAXNAMELEN 63
 
-MacResManager::MacResManager() {
-	memset(this, 0, sizeof(MacResManager));
-	close();
+MacResManager::ForkCache *MacResManager::_forkCache = 0;
+uint32 MacResManager::_forkCacheClock = 0;
+
+MacResManager::ResIndex::ResIndex() : resTypes(0), resLists(0) {
+	memset(&resMap, 0, sizeof(resMap));
+}
+
+MacResManager::ResIndex::~ResIndex() {
+	for (int i = 0; i < resMap.numTypes; i++) {
+		for (int j = 0; j < resTypes[i].items; j++)
+			if (resLists[i][j].nameOffset != -1)
+				delete[] resLists[i][j].name;
+
+		delete[] resLists[i];
+	}
+
+	delete[] resLists;
+	delete[] resTypes;
+}
+
+/** A resource read directly from the memory of its fork. */
+class MacResourceMemoryStream : public MemoryReadStream {
+public:
+	MacResourceMemoryStream(const SharedPtr<SeekableReadStream> &fork, const byte *data, uint32 size)
+		: MemoryReadStream(data, size), _fork(fork) {}
+
+private:
+	SharedPtr<SeekableReadStream> _fork;
+};
+
+/** A resource read from its fork as needed, which is shared with the manager. */
+class MacResourceSubStream : public SafeSeekableSubReadStream {
+public:
+	MacResourceSubStream(const SharedPtr<SeekableReadStream> &fork, uint32 begin, uint32 end)
+		: SafeSeekableSubReadStream(fork.get(), begin, end), _fork(fork) {}
+
+private:
+	SharedPtr<SeekableReadStream> _fork;
+};
+
+MacResManager::MacResManager()
+	: _mode(kResForkNone), _resForkOffset(-1), _resForkSize(0), _dataOffset(0), _dataLength(0),
+	  _mapOffset(0), _mapLength(0), _resTypes(0), _resLists(0) {
+	memset(&_resMap, 0, sizeof(_resMap));
 }
 
 MacResManager::~MacResManager() {
@@ -59,20 +102,18 @@ void MacResManager::close() {
 	_resForkOffset = -1;
 	_mode = kResForkNone;
 
-	for (int i = 0; i < _resMap.numTypes; i++) {
-		for (int j = 0; j < _resTypes[i].items; j++)
-			if (_resLists[i][j].nameOffset != -1)
-				delete[] _resLists[i][j].name;
-
-		delete[] _resLists[i];
-	}
-
-	delete[] _resLists; _resLists = 0;
-	delete[] _resTypes; _resTypes = 0;
-	delete _stream; _stream = 0;
+	_index.reset();
+	_resLists = 0;
+	_resTypes = 0;
+	_stream.reset();
 	_resMap.numTypes = 0;
 }
 
+void MacResManager::clearCache() {
+	delete _forkCache;
+	_forkCache = 0;
+}
+
 bool MacResManager::hasDataFork() const {
 	return !_baseFileName.empty();
 }
@@ -99,7 +140,7 @@ String MacResManager::computeResForkMD5AsString(uint32 length) const {
 	uint32 dataLength = _stream->readUint32BE();
 
 
-	SeekableSubReadStream resForkStream(_stream, dataOffset, dataOffset + dataLength);
+	SeekableSubReadStream resForkStream(_stream.get(), dataOffset, dataOffset + dataLength);
 	return computeStreamMD5AsString(resForkStream, MIN<uint32>(length, _resForkSize));
 }
 
@@ -122,49 +163,7 @@ bool MacResManager::open(const String &fileName) {
 	}
 #endif
 
-	File *file = new File();
-
-	// Prefer standalone files first, starting with raw forks
-	if (file->open(fileName + ".rsrc") && loadFromRawFork(*file)) {
-		_baseFileName = fileName;
-		return true;
-	}
-	file->close();
-
-	// Then try for AppleDouble using Apple's naming
-	if (file->open(constructAppleDoubleName(fileName)) && loadFromAppleDouble(*file)) {
-		_baseFileName = fileName;
-		return true;
-	}
-	file->close();
-
-	// Check .bin for MacBinary next
-	if (file->open(fileName + ".bin") && loadFromMacBinary(*file)) {
-		_baseFileName = fileName;
-		return true;
-	}
-	file->close();
-
-	// As a last resort, see if just the data fork exists
-	if (file->open(fileName)) {
-		_baseFileName = fileName;
-
-		// FIXME: Is this really needed?
-		if (isMacBinary(*file)) {
-			file->seek(0);
-			if (loadFromMacBinary(*file))
-				return true;
-		}
-
-		file->seek(0);
-		_stream = file;
-		return true;
-	}
-
-	delete file;
-
-	// The file doesn't exist
-	return false;
+	return openForks(0, fileName, fileName);
 }
 
 bool MacResManager::open(const FSNode &path, const String &fileName) {
@@ -186,54 +185,80 @@ bool MacResManager::open(const FSNode &path, const String &fileName) {
 	}
 #endif
 
+	return openForks(&path, fileName, path.getPath() + "/" + fileName);
+}
+
+SeekableReadStream *MacResManager::openStream(const FSNode *path, const String &fileName) {
+	if (!path) {
+		File *file = new File();
+		if (file->open(fileName))
+			return file;
+
+		delete file;
+		return 0;
+	}
+
+	FSNode fsNode = path->getChild(fileName);
+	if (fsNode.exists() && !fsNode.isDirectory())
+		return fsNode.createReadStream();
+
+	return 0;
+}
+
+bool MacResManager::openForks(const FSNode *path, const String &fileName, const String &cacheKey) {
+	if (openCached(path, fileName, cacheKey))
+		return true;
+
 	// Prefer standalone files first, starting with raw forks
-	FSNode fsNode = path.getChild(fileName + ".rsrc");
-	if (fsNode.exists() && !fsNode.isDirectory()) {
-		SeekableReadStream *stream = fsNode.createReadStream();
+	SeekableReadStream *stream = openStream(path, fileName + ".rsrc");
+	if (stream) {
 		if (loadFromRawFork(*stream)) {
 			_baseFileName = fileName;
+			addToCache(path, cacheKey, fileName + ".rsrc");
 			return true;
 		}
 		delete stream;
 	}
 
 	// Then try for AppleDouble using Apple's naming
-	fsNode = path.getChild(constructAppleDoubleName(fileName));
-	if (fsNode.exists() && !fsNode.isDirectory()) {
-		SeekableReadStream *stream = fsNode.createReadStream();
+	stream = openStream(path, constructAppleDoubleName(fileName));
+	if (stream) {
 		if (loadFromAppleDouble(*stream)) {
 			_baseFileName = fileName;
+			addToCache(path, cacheKey, constructAppleDoubleName(fileName));
 			return true;
 		}
 		delete stream;
 	}
 
 	// Check .bin for MacBinary next
-	fsNode = path.getChild(fileName + ".bin");
-	if (fsNode.exists() && !fsNode.isDirectory()) {
-		SeekableReadStream *stream = fsNode.createReadStream();
+	stream = openStream(path, fileName + ".bin");
+	if (stream) {
 		if (loadFromMacBinary(*stream)) {
 			_baseFileName = fileName;
+			addToCache(path, cacheKey, fileName + ".bin");
 			return true;
 		}
 		delete stream;
 	}
 
 	// As a last resort, see if just the data fork exists
-	fsNode = path.getChild(fileName);
-	if (fsNode.exists() && !fsNode.isDirectory()) {
-		SeekableReadStream *stream = fsNode.createReadStream();
+	stream = openStream(path, fileName);
+	if (stream) {
 		_baseFileName = fileName;
 
 		// FIXME: Is this really needed?
 		if (isMacBinary(*stream)) {
 			stream->seek(0);
-			if (loadFromMacBinary(*stream))
+			if (loadFromMacBinary(*stream)) {
+				addToCache(path, cacheKey, fileName);
 				return true;
+			}
 		}
 
 		stream->seek(0);
-		_stream = stream;
+		_stream = SharedPtr<SeekableReadStream>(stream);
+		addToCache(path, cacheKey, fileName);
 		return true;
 	}
 
@@ -241,6 +266,105 @@ bool MacResManager::open(const FSNode &path, const String &fileName) {
 	return false;
 }
 
+bool MacResManager::openCached(const FSNode *path, const String &fileName, const String &cacheKey) {
+	if (!_forkCache)
+		return false;
+
+	ForkCache::iterator i = _forkCache->find(cacheKey);
+	if (i == _forkCache->end())
+		return false;
+
+	// Check the file is still the same, or look for the forks again
+	CachedFork &fork = i->_value;
+	if (getForkArchive(path, fork.forkFileName) != fork.archive)
+		return false;
+
+	SeekableReadStream *stream = openStream(path, fork.forkFileName);
+	if (!stream || stream->size() != fork.fileSize) {
+		delete stream;
+		return false;
+	}
+
+	_stream = SharedPtr<SeekableReadStream>(stream);
+	_mode = fork.mode;
+	_resForkOffset = fork.resForkOffset;
+
+	byte fingerprint[kFingerprintSize];
+	readFingerprint(fingerprint);
+	if (memcmp(fingerprint, fork.fingerprint, kFingerprintSize)) {
+		close();
+		return false;
+	}
+
+	_baseFileName = fileName;
+	_resForkSize = fork.resForkSize;
+	_dataOffset = fork.dataOffset;
+	_dataLength = fork.dataLength;
+	_mapOffset = fork.mapOffset;
+	_mapLength = fork.mapLength;
+
+	_index = fork.index;
+	if (_index) {
+		_resMap = _index->resMap;
+		_resTypes = _index->resTypes;
+		_resLists = _index->resLists;
+	}
+
+	fork.lastUse = ++_forkCacheClock;
+	return true;
+}
+
+void MacResManager::addToCache(const FSNode *path, const String &cacheKey, const String &forkFileName) {
+	if (!_forkCache)
+		_forkCache = new ForkCache();
+
+	// Make room by dropping the least recently opened file
+	if (_forkCache->size() >= kMaxCachedForks && !_forkCache->contains(cacheKey)) {
+		ForkCache::iterator oldest = _forkCache->begin();
+		for (ForkCache::iterator i = _forkCache->begin(); i != _forkCache->end(); ++i) {
+			if (i->_value.lastUse < oldest->_value.lastUse)
+				oldest = i;
+		}
+		_forkCache->erase(oldest);
+	}
+
+	CachedFork &fork = (*_forkCache)[cacheKey];
+	fork.forkFileName = forkFileName;
+	fork.archive = getForkArchive(path, forkFileName);
+	fork.fileSize = _stream->size();
+	readFingerprint(fork.fingerprint);
+	fork.lastUse = ++_forkCacheClock;
+	fork.mode = _mode;
+	fork.resForkOffset = _resForkOffset;
+	fork.resForkSize = _resForkSize;
+	fork.dataOffset = _dataOffset;
+	fork.dataLength = _dataLength;
+	fork.mapOffset = _mapOffset;
+	fork.mapLength = _mapLength;
+	fork.index = _index;
+}
+
+const Archive *MacResManager::getForkArchive(const FSNode *path, const String &forkFileName) {
+	// Files of a node are identified by their path, which is the cache key
+	if (path)
+		return 0;
+
+	return SearchMan.getArchiveForMember(forkFileName);
+}
+
+void MacResManager::readFingerprint(byte fingerprint[kFingerprintSize]) const {
+	memset(fingerprint, 0, kFingerprintSize);
+
+	const int32 pos = _stream->pos();
+	_stream->seek(0);
+	_stream->read(fingerprint, MIN<int32>(_stream->size(), kFingerprintSize - 16));
+	if (_mode != kResForkNone && _resForkOffset >= 0) {
+		_stream->seek(_resForkOffset);
+		_stream->read(fingerprint + kFingerprintSize - 16, 16);
+	}
+	_stream->seek(pos);
+}
+
 bool MacResManager::exists(const String &fileName) {
 	// Try the file name by itself
 	if (File::exists(fileName))
@@ -455,7 +579,7 @@ bool MacResManager::load(SeekableReadStream &stream) {
 	debug(7, "got header: data %d [%d] map %d [%d]",
 		_dataOffset, _dataLength, _mapOffset, _mapLength);
 
-	_stream = &stream;
+	_stream = SharedPtr<SeekableReadStream>(&stream);
 
 	readMap();
 	return true;
@@ -468,7 +592,7 @@ SeekableReadStream *MacResManager::getDataFork() {
 	if (_mode == kResForkMacBinary) {
 		_stream->seek(MBI_DFLEN);
 		uint32 dataSize = _stream->readUint32BE();
-		return new SeekableSubReadStream(_stream, MBI_INFOHDR, MBI_INFOHDR + dataSize);
+		return new MacResourceSubStream(_stream, MBI_INFOHDR, MBI_INFOHDR + dataSize);
 	}
 
 	File *file = new File();
@@ -555,29 +679,14 @@ SeekableReadStream *MacResManager::getResource(uint32 typeID, uint16 resID) {
 	if (resNum == -1)
 		return NULL;
 
-	_stream->seek(_dataOffset + _resLists[typeNum][resNum].dataOffset);
-	uint32 len = _stream->readUint32BE();
-
-	// Ignore resources with 0 length
-	if (!len)
-		return 0;
-
-	return _stream->readStream(len);
+	return readResource(_resLists[typeNum][resNum].dataOffset);
 }
 
 SeekableReadStream *MacResManager::getResource(const String &fileName) {
 	for (uint32 i = 0; i < _resMap.numTypes; i++) {
 		for (uint32 j = 0; j < _resTypes[i].items; j++) {
-			if (_resLists[i][j].nameOffset != -1 && fileName.equalsIgnoreCase(_resLists[i][j].name)) {
-				_stream->seek(_dataOffset + _resLists[i][j].dataOffset);
-				uint32 len = _stream->readUint32BE();
-
-				// Ignore resources with 0 length
-				if (!len)
-					return 0;
-
-				return _stream->readStream(len);
-			}
+			if (_resLists[i][j].nameOffset != -1 && fileName.equalsIgnoreCase(_resLists[i][j].name))
+				return readResource(_resLists[i][j].dataOffset);
 		}
 	}
 
@@ -590,22 +699,37 @@ SeekableReadStream *MacResManager::getResource(uint32 typeID, const String &file
 			continue;
 
 		for (uint32 j = 0; j < _resTypes[i].items; j++) {
-			if (_resLists[i][j].nameOffset != -1 && fileName.equalsIgnoreCase(_resLists[i][j].name)) {
-				_stream->seek(_dataOffset + _resLists[i][j].dataOffset);
-				uint32 len = _stream->readUint32BE();
-
-				// Ignore resources with 0 length
-				if (!len)
-					return 0;
-
-				return _stream->readStream(len);
-			}
+			if (_resLists[i][j].nameOffset != -1 && fileName.equalsIgnoreCase(_resLists[i][j].name))
+				return readResource(_resLists[i][j].dataOffset);
 		}
 	}
 
 	return 0;
 }
 
+SeekableReadStream *MacResManager::readResource(uint32 dataOffset) {
+	_stream->seek(_dataOffset + dataOffset);
+	uint32 len = _stream->readUint32BE();
+
+	// Ignore resources with 0 length
+	if (!len)
+		return 0;
+
+	const uint32 begin = _stream->pos();
+	if (begin + len > (uint32)_stream->size())
+		return _stream->readStream(len);
+
+	// Refer to the fork rather than copying the data, if possible
+	const byte *data = _stream->getDataPointer();
+	if (data)
+		return new MacResourceMemoryStream(_stream, data + begin, len);
+
+	if (len >= kStreamedResourceSize)
+		return wrapBufferedSeekableReadStream(new MacResourceSubStream(_stream, begin, begin + len), 4096, DisposeAfterUse::YES);
+
+	return _stream->readStream(len);
+}
+
 void MacResManager::readMap() {
 	_stream->seek(_mapOffset + 22);
 
@@ -615,8 +739,12 @@ void MacResManager::readMap() {
 	_resMap.numTypes = _stream->readUint16BE();
 	_resMap.numTypes++;
 
+	// The map is owned by the index, which is shared with the cache
+	_index = SharedPtr<ResIndex>(new ResIndex());
+	_index->resMap = _resMap;
+
 	_stream->seek(_mapOffset + _resMap.typeOffset + 2);
-	_resTypes = new ResType[_resMap.numTypes];
+	_resTypes = _index->resTypes = new ResType[_resMap.numTypes];
 
 	for (int i = 0; i < _resMap.numTypes; i++) {
 		_resTypes[i].id = _stream->readUint32BE();
@@ -627,7 +755,7 @@ void MacResManager::readMap() {
 		debug(8, "resType: <%s> items: %d offset: %d (0x%x)", tag2str(_resTypes[i].id), _resTypes[i].items,  _resTypes[i].offset, _resTypes[i].offset);
 	}
 
-	_resLists = new ResPtr[_resMap.numTypes];
+	_resLists = _index->resLists = new ResPtr[_resMap.numTypes];
 
 	for (int i = 0; i < _resMap.numTypes; i++) {
 		_resLists[i] = new Resource[_resTypes[i].items];
@@ -32,6 +32,9 @@
 
 #include "common/array.h"
 #include "common/fs.h"
+#include "common/hashmap.h"
+#include "common/hash-str.h"
+#include "common/ptr.h"
 #include "common/str.h"
 #include "common/str-array.h"
 
@@ -46,6 +49,14 @@ typedef Array<uint32> MacResTagArray;
 /**
  * Class for handling Mac data and resource forks.
  * It can read from raw, MacBinary, and AppleDouble formats.
+ *
+ * Which of these a file is stored in, and the resource map of its fork, are
+ * remembered when it is opened, so opening the same file again, e.g. with
+ * another MacResManager, neither has to look for the fork nor read the map.
+ * A remembered file is only used if it is still served by the same archive,
+ * and its size and first bytes did not change. The cache keeps the most
+ * recently opened files, and is cleared by clearCache(), which is done after
+ * game detection and after every game.
  */
 class MacResManager {
 
@@ -109,8 +120,18 @@ public:
 	 */
 	bool hasResFork() const;
 
+	/**
+	 * Forget all files opened so far; see the class description.
+	 */
+	static void clearCache();
+
 	/**
 	 * Read resource from the MacBinary file
+	 *
+	 * If the fork is kept in memory, e.g. because it is memory-mapped, the
+	 * returned stream reads from there; big resources are read from the
+	 * fork as needed. Either way, the stream can outlive the manager.
+	 *
 	 * @param typeID FourCC of the type
 	 * @param resID Resource ID to fetch
 	 * @return Pointer to a SeekableReadStream with loaded resource
@@ -182,10 +203,17 @@ public:
 	bool loadFromMacBinary(SeekableReadStream &stream);
 
 private:
-	SeekableReadStream *_stream;
+	SharedPtr<SeekableReadStream> _stream;
 	String _baseFileName;
 
+	/** Open a file, through SearchMan if path is 0. */
+	static SeekableReadStream *openStream(const FSNode *path, const String &fileName);
+	bool openForks(const FSNode *path, const String &fileName, const String &cacheKey);
+	bool openCached(const FSNode *path, const String &fileName, const String &cacheKey);
+	void addToCache(const FSNode *path, const String &cacheKey, const String &forkFileName);
+
 	bool load(SeekableReadStream &stream);
+	SeekableReadStream *readResource(uint32 dataOffset);
 
 	bool loadFromRawFork(SeekableReadStream &stream);
 	bool loadFromAppleDouble(SeekableReadStream &stream);
@@ -206,13 +234,21 @@ private:
 	 */
 	static bool isRawFork(SeekableReadStream &stream);
 
-	enum {
+	enum ResForkMode {
 		kResForkNone = 0,
 		kResForkRaw,
 		kResForkMacBinary,
 		kResForkAppleDouble
 	} _mode;
 
+	/**
+	 * Resources bigger than this are not read into memory at once by
+	 * getResource(), unless the fork is in memory anyway.
+	 */
+	enum {
+		kStreamedResourceSize = 256 * 1024
+	};
+
 	void readMap();
 
 	struct ResMap {
@@ -238,6 +274,52 @@ private:
 
 	typedef Resource *ResPtr;
 
+	/** The resource map, which is shared by all managers using the same file. */
+	struct ResIndex {
+		ResMap resMap;
+		ResType *resTypes;
+		ResPtr *resLists;
+
+		ResIndex();
+		~ResIndex();
+	};
+
+	enum {
+		/**
+		 * Bytes compared to tell whether a cached file is still the same:
+		 * the start of the file, and the header of the fork.
+		 */
+		kFingerprintSize = 128 + 16,
+		/** Files remembered at most; the least recently opened go first. */
+		kMaxCachedForks = 64
+	};
+
+	/** How a file was opened, see openCached(). */
+	struct CachedFork {
+		String forkFileName;	///< Name of the file the fork was found in
+		const Archive *archive;	///< Archive of SearchMan serving that file
+		int32 fileSize;
+		byte fingerprint[kFingerprintSize];
+		uint32 lastUse;
+		ResForkMode mode;
+		int32 resForkOffset;
+		uint32 resForkSize;
+		uint32 dataOffset;
+		uint32 dataLength;
+		uint32 mapOffset;
+		uint32 mapLength;
+		SharedPtr<ResIndex> index;
+	};
+
+	typedef HashMap<String, CachedFork, IgnoreCase_Hash, IgnoreCase_EqualTo> ForkCache;
+	static ForkCache *_forkCache;
+	static uint32 _forkCacheClock;
+
+	static const Archive *getForkArchive(const FSNode *path, const String &forkFileName);
+	void readFingerprint(byte fingerprint[kFingerprintSize]) const;
+
+	SharedPtr<ResIndex> _index;
+
 	int32 _resForkOffset;
 	uint32 _resForkSize;
 
@@ -30,6 +30,15 @@
 #include "common/endian.h"
 #include "common/str.h"
 #include "common/stream.h"
+#include "common/util.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MD5_USE_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define MD5_USE_NEON
+#include <arm_neon.h>
+#endif
 
 namespace Common {
 
@@ -243,6 +252,263 @@ void md5_finish(md5_context *ctx, uint8 digest[16]) {
 	PUT_UINT32(ctx->state[3], digest, 12);
 }
 
+/*
+ * Multi-buffer MD5: the same block function is run on several independent
+ * messages at once, one message per 32 bit lane of a SIMD register. Without
+ * SIMD support, the lanes are processed one after another.
+ */
+
+#define MD5_LANES kMD5Lanes
+
+static const uint32 md5_k[64] = {
+	0xD76AA478, 0xE8C7B756, 0x242070DB, 0xC1BDCEEE, 0xF57C0FAF, 0x4787C62A, 0xA8304613, 0xFD469501,
+	0x698098D8, 0x8B44F7AF, 0xFFFF5BB1, 0x895CD7BE, 0x6B901122, 0xFD987193, 0xA679438E, 0x49B40821,
+	0xF61E2562, 0xC040B340, 0x265E5A51, 0xE9B6C7AA, 0xD62F105D, 0x02441453, 0xD8A1E681, 0xE7D3FBC8,
+	0x21E1CDE6, 0xC33707D6, 0xF4D50D87, 0x455A14ED, 0xA9E3E905, 0xFCEFA3F8, 0x676F02D9, 0x8D2A4C8A,
+	0xFFFA3942, 0x8771F681, 0x6D9D6122, 0xFDE5380C, 0xA4BEEA44, 0x4BDECFA9, 0xF6BB4B60, 0xBEBFBC70,
+	0x289B7EC6, 0xEAA127FA, 0xD4EF3085, 0x04881D05, 0xD9D4D039, 0xE6DB99E5, 0x1FA27CF8, 0xC4AC5665,
+	0xF4292244, 0x432AFF97, 0xAB9423A7, 0xFC93A039, 0x655B59C3, 0x8F0CCC92, 0xFFEFF47D, 0x85845DD1,
+	0x6FA87E4F, 0xFE2CE6E0, 0xA3014314, 0x4E0811A1, 0xF7537E82, 0xBD3AF235, 0x2AD7D2BB, 0xEB86D391
+};
+
+#if defined(MD5_USE_SSE2)
+
+typedef __m128i md5_vec;
+
+static inline md5_vec md5v_set(uint32 a, uint32 b, uint32 c, uint32 d) { return _mm_set_epi32(d, c, b, a); }
+static inline md5_vec md5v_dup(uint32 x) { return _mm_set1_epi32(x); }
+static inline void md5v_get(md5_vec v, uint32 out[4]) { _mm_storeu_si128((__m128i *)out, v); }
+static inline md5_vec md5v_add(md5_vec x, md5_vec y) { return _mm_add_epi32(x, y); }
+static inline md5_vec md5v_and(md5_vec x, md5_vec y) { return _mm_and_si128(x, y); }
+static inline md5_vec md5v_or(md5_vec x, md5_vec y) { return _mm_or_si128(x, y); }
+static inline md5_vec md5v_xor(md5_vec x, md5_vec y) { return _mm_xor_si128(x, y); }
+static inline md5_vec md5v_ornot(md5_vec x, md5_vec y) { return _mm_or_si128(x, _mm_xor_si128(y, _mm_set1_epi32(-1))); }
+static inline md5_vec md5v_rotl(md5_vec x, int n) {
+	return _mm_or_si128(_mm_sll_epi32(x, _mm_cvtsi32_si128(n)), _mm_srl_epi32(x, _mm_cvtsi32_si128(32 - n)));
+}
+
+#elif defined(MD5_USE_NEON)
+
+typedef uint32x4_t md5_vec;
+
+static inline md5_vec md5v_set(uint32 a, uint32 b, uint32 c, uint32 d) {
+	const uint32 lanes[4] = { a, b, c, d };
+	return vld1q_u32(lanes);
+}
+static inline md5_vec md5v_dup(uint32 x) { return vdupq_n_u32(x); }
+static inline void md5v_get(md5_vec v, uint32 out[4]) { vst1q_u32(out, v); }
+static inline md5_vec md5v_add(md5_vec x, md5_vec y) { return vaddq_u32(x, y); }
+static inline md5_vec md5v_and(md5_vec x, md5_vec y) { return vandq_u32(x, y); }
+static inline md5_vec md5v_or(md5_vec x, md5_vec y) { return vorrq_u32(x, y); }
+static inline md5_vec md5v_xor(md5_vec x, md5_vec y) { return veorq_u32(x, y); }
+static inline md5_vec md5v_ornot(md5_vec x, md5_vec y) { return vornq_u32(x, y); }
+static inline md5_vec md5v_rotl(md5_vec x, int n) {
+	return vorrq_u32(vshlq_u32(x, vdupq_n_s32(n)), vshlq_u32(x, vdupq_n_s32(n - 32)));
+}
+
+#endif
+
+static void md5_process_lanes(md5_context *ctx[MD5_LANES], const uint8 *data[MD5_LANES]) {
+#if defined(MD5_USE_SSE2) || defined(MD5_USE_NEON)
+	md5_vec X[16], A, B, C, D, F, T;
+	int i;
+
+	for (i = 0; i < 16; i++)
+		X[i] = md5v_set(READ_LE_UINT32(data[0] + i * 4), READ_LE_UINT32(data[1] + i * 4),
+		                READ_LE_UINT32(data[2] + i * 4), READ_LE_UINT32(data[3] + i * 4));
+
+	A = md5v_set(ctx[0]->state[0], ctx[1]->state[0], ctx[2]->state[0], ctx[3]->state[0]);
+	B = md5v_set(ctx[0]->state[1], ctx[1]->state[1], ctx[2]->state[1], ctx[3]->state[1]);
+	C = md5v_set(ctx[0]->state[2], ctx[1]->state[2], ctx[2]->state[2], ctx[3]->state[2]);
+	D = md5v_set(ctx[0]->state[3], ctx[1]->state[3], ctx[2]->state[3], ctx[3]->state[3]);
+
+	const md5_vec A0 = A, B0 = B, C0 = C, D0 = D;
+
+#define STEP(k, s)                                                                  \
+	{                                                                               \
+		T = md5v_add(md5v_add(A, F), md5v_add(md5v_dup(md5_k[i]), X[k]));          \
+		A = D; D = C; C = B;                                                        \
+		B = md5v_add(B, md5v_rotl(T, s));                                           \
+		i++;                                                                        \
+	}
+
+#define F1 F = md5v_xor(D, md5v_and(B, md5v_xor(C, D)))
+#define F2 F = md5v_xor(C, md5v_and(D, md5v_xor(B, C)))
+#define F3 F = md5v_xor(md5v_xor(B, C), D)
+#define F4 F = md5v_xor(C, md5v_ornot(B, D))
+
+	// Four steps at a time, so the rotations are by constants
+	i = 0;
+	while (i < 16) {
+		F1; STEP(i,  7);
+		F1; STEP(i, 12);
+		F1; STEP(i, 17);
+		F1; STEP(i, 22);
+	}
+	while (i < 32) {
+		F2; STEP((5 * i + 1) & 15,  5);
+		F2; STEP((5 * i + 1) & 15,  9);
+		F2; STEP((5 * i + 1) & 15, 14);
+		F2; STEP((5 * i + 1) & 15, 20);
+	}
+	while (i < 48) {
+		F3; STEP((3 * i + 5) & 15,  4);
+		F3; STEP((3 * i + 5) & 15, 11);
+		F3; STEP((3 * i + 5) & 15, 16);
+		F3; STEP((3 * i + 5) & 15, 23);
+	}
+	while (i < 64) {
+		F4; STEP((7 * i) & 15,  6);
+		F4; STEP((7 * i) & 15, 10);
+		F4; STEP((7 * i) & 15, 15);
+		F4; STEP((7 * i) & 15, 21);
+	}
+
+#undef F1
+#undef F2
+#undef F3
+#undef F4
+#undef STEP
+
+	uint32 out[4][4];
+	md5v_get(md5v_add(A, A0), out[0]);
+	md5v_get(md5v_add(B, B0), out[1]);
+	md5v_get(md5v_add(C, C0), out[2]);
+	md5v_get(md5v_add(D, D0), out[3]);
+
+	for (i = 0; i < MD5_LANES; i++) {
+		ctx[i]->state[0] = out[0][i];
+		ctx[i]->state[1] = out[1][i];
+		ctx[i]->state[2] = out[2][i];
+		ctx[i]->state[3] = out[3][i];
+	}
+#else
+	for (int i = 0; i < MD5_LANES; i++)
+		md5_process(ctx[i], data[i]);
+#endif
+}
+
+/**
+ * The state of one message in the multi-buffer hashing: the MD5 context,
+ * and the chunk of the stream read last.
+ */
+struct md5_lane {
+	enum {
+		kChunkSize = 4096	// multiple of the block size
+	};
+
+	md5_context ctx;
+	ReadStream *stream;
+	uint32 left;		// bytes still to be hashed, if the length is restricted
+	uint32 chunkPos;
+	uint32 chunkSize;
+	bool done;
+	uint8 chunk[kChunkSize];
+};
+
+static void md5_lanes(ReadStream *const *streams, uint count, uint8 (*digests)[16], uint32 length) {
+	md5_lane *lanes = new md5_lane[count];
+
+	// Inactive lanes are fed a dummy block into a dummy context
+	md5_context dummyCtx;
+	md5_starts(&dummyCtx);
+	static const uint8 dummyData[64] = { 0 };
+
+	for (uint i = 0; i < count; i++) {
+		md5_starts(&lanes[i].ctx);
+		lanes[i].stream = streams[i];
+		lanes[i].left = length;
+		lanes[i].chunkPos = lanes[i].chunkSize = 0;
+		lanes[i].done = false;
+	}
+
+	while (true) {
+		// Read the next chunk of every lane which used up its last one
+		uint active = 0;
+		for (uint i = 0; i < count; i++) {
+			md5_lane &lane = lanes[i];
+			if (!lane.done && lane.chunkPos == lane.chunkSize) {
+				uint32 toRead = (length && lane.left < md5_lane::kChunkSize) ? lane.left : (uint32)md5_lane::kChunkSize;
+				lane.chunkPos = 0;
+				lane.chunkSize = toRead ? lane.stream->read(lane.chunk, toRead) : 0;
+				if (length)
+					lane.left -= lane.chunkSize;
+				if (lane.chunkSize == 0) {
+					lane.done = true;
+					md5_finish(&lane.ctx, digests[i]);
+				}
+			}
+			if (!lane.done)
+				active++;
+		}
+
+		if (!active)
+			break;
+
+		// The lanes which are at a block boundary and have a full block of
+		// data are hashed together, as long as they all have blocks left
+		md5_context *ctx[MD5_LANES];
+		const uint8 *data[MD5_LANES];
+		uint ready = 0;
+		uint32 blocks = 0xFFFFFFFF;
+		for (uint i = 0; i < MD5_LANES; i++) {
+			ctx[i] = &dummyCtx;
+			data[i] = dummyData;
+			if (i >= count)
+				continue;
+
+			md5_lane &lane = lanes[i];
+			uint32 avail = lane.chunkSize - lane.chunkPos;
+			if (!lane.done && (lane.ctx.total[0] & 0x3F) == 0 && avail >= 64) {
+				ctx[i] = &lane.ctx;
+				blocks = MIN(blocks, avail / 64);
+				ready++;
+			}
+		}
+
+		if (ready >= 2) {
+			for (uint32 b = 0; b < blocks; b++) {
+				for (uint i = 0; i < count; i++) {
+					if (ctx[i] != &dummyCtx)
+						data[i] = lanes[i].chunk + lanes[i].chunkPos + b * 64;
+				}
+				md5_process_lanes(ctx, data);
+			}
+
+			for (uint i = 0; i < count; i++) {
+				if (ctx[i] == &dummyCtx)
+					continue;
+				lanes[i].chunkPos += blocks * 64;
+				lanes[i].ctx.total[0] += blocks * 64;
+				if (lanes[i].ctx.total[0] < blocks * 64)
+					lanes[i].ctx.total[1]++;
+			}
+		}
+
+		// Whatever does not fit the lanes, like the ends of the streams,
+		// goes through the normal code
+		for (uint i = 0; i < count; i++) {
+			md5_lane &lane = lanes[i];
+			if (lane.done || (ready >= 2 && ctx[i] != &dummyCtx))
+				continue;
+			md5_update(&lane.ctx, lane.chunk + lane.chunkPos, lane.chunkSize - lane.chunkPos);
+			lane.chunkPos = lane.chunkSize;
+		}
+	}
+
+	delete[] lanes;
+}
+
+bool computeStreamsMD5(ReadStream *const *streams, uint count, uint8 (*digests)[16], uint32 length) {
+#ifdef DISABLE_MD5
+	for (uint i = 0; i < count; i++)
+		memset(digests[i], 0, 16);
+#else
+	for (uint first = 0; first < count; first += MD5_LANES)
+		md5_lanes(streams + first, MIN<uint>(count - first, MD5_LANES), digests + first, length);
+#endif
+	return true;
+}
 
 bool computeStreamMD5(ReadStream &stream, uint8 digest[16], uint32 length) {
 
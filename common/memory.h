@@ -27,6 +27,37 @@
 
 namespace Common {
 
+#if __cplusplus >= 201103L
+
+template<class T> struct RemoveReference { typedef T type; };
+template<class T> struct RemoveReference<T &> { typedef T type; };
+template<class T> struct RemoveReference<T &&> { typedef T type; };
+
+/**
+ * Turns its argument into an rvalue reference, so that it can be moved
+ * from. This is the same as std::move.
+ */
+template<class T>
+inline typename RemoveReference<T>::type &&move(T &&t) {
+	return static_cast<typename RemoveReference<T>::type &&>(t);
+}
+
+/**
+ * Passes on an argument with the value category it was given with. This is
+ * the same as std::forward.
+ */
+template<class T>
+inline T &&forward(typename RemoveReference<T>::type &t) {
+	return static_cast<T &&>(t);
+}
+
+template<class T>
+inline T &&forward(typename RemoveReference<T>::type &&t) {
+	return static_cast<T &&>(t);
+}
+
+#endif
+
 /**
  * Copies data from the range [first, last) to [dst, dst + (last - first)).
  * It requires the range [dst, dst + (last - first)) to be valid and
@@ -39,6 +70,23 @@ Type *uninitialized_copy(In first, In last, Type *dst) {
 	return dst;
 }
 
+/**
+ * Moves data from the range [first, last) to [dst, dst + (last - first)).
+ * It requires the range [dst, dst + (last - first)) to be valid and
+ * uninitialized. The source objects are left in a moved-from state, so the
+ * caller still has to destroy them. Without C++11, the data is copied.
+ */
+template<class Type>
+Type *uninitialized_move(Type *first, Type *last, Type *dst) {
+#if __cplusplus >= 201103L
+	while (first != last)
+		new ((void *)dst++) Type(Common::move(*first++));
+	return dst;
+#else
+	return uninitialized_copy(first, last, dst);
+#endif
+}
+
 /**
  * Initializes the memory [first, first + (last - first)) with the value x.
  * It requires the range [first, first + (last - first)) to be valid and
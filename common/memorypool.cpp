@@ -112,6 +112,13 @@ void MemoryPool::freeChunk(void *ptr) {
 	_next = ptr;
 }
 
+size_t MemoryPool::getReservedSize() const {
+	size_t size = 0;
+	for (size_t i = 0; i < _pages.size(); ++i)
+		size += _pages[i].numChunks * _chunkSize;
+	return size;
+}
+
 // Technically not compliant C++ to compare unrelated pointers. In practice...
 bool MemoryPool::isPointerInPage(void *ptr, const Page &page) {
 	return (ptr >= page.start) && (ptr < (char *)page.start + page.numChunks * _chunkSize);
@@ -94,6 +94,12 @@ public:
 	 * Return the chunk size used by this memory pool.
 	 */
 	size_t	getChunkSize() const { return _chunkSize; }
+
+	/**
+	 * Return the number of bytes in the pages of this memory pool, both
+	 * in used and in free chunks.
+	 */
+	size_t	getReservedSize() const;
 };
 
 /**
@@ -1,6 +1,7 @@
 MODULE := common
 
 MODULE_OBJS := \
+	arena.o \
 	archive.o \
 	config-manager.o \
 	coroutines.o \
@@ -34,6 +35,7 @@ MODULE_OBJS := \
 	system.o \
 	textconsole.o \
 	tokenizer.o \
+	trace.o \
 	translation.o \
 	unarj.o \
 	unzip.o \
@@ -51,7 +53,8 @@ MODULE_OBJS += \
 	fft.o \
 	huffman.o \
 	rdft.o \
-	sinetables.o
+	sinetables.o \
+	transformtables.o
 
 ifdef ENABLE_EVENTRECORDER
 MODULE_OBJS += \
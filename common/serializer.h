@@ -23,11 +23,36 @@
 #ifndef COMMON_SERIALIZER_H
 #define COMMON_SERIALIZER_H
 
+#include "common/array.h"
+#include "common/endian.h"
+#include "common/memstream.h"
 #include "common/stream.h"
 #include "common/str.h"
+#include "common/util.h"
 
 namespace Common {
 
+/**
+ * Whether arrays of T are stored like the data in a save file, if they have
+ * the same size and byte order. This is true for integers and enums, but
+ * not for types where a conversion of the value is needed.
+ */
+template<typename T> struct SerializerRawCopy { enum { kValue = 1 }; };
+template<> struct SerializerRawCopy<bool> { enum { kValue = 0 }; };
+template<> struct SerializerRawCopy<float> { enum { kValue = 0 }; };
+template<> struct SerializerRawCopy<double> { enum { kValue = 0 }; };
+
+#ifdef SCUMM_LITTLE_ENDIAN
+#define SYNC_NATIVE_LE 1
+#define SYNC_NATIVE_BE 0
+#else
+#define SYNC_NATIVE_LE 0
+#define SYNC_NATIVE_BE 1
+#endif
+
+#define SYNC_READ_BYTE(ptr) (*(const byte *)(ptr))
+#define SYNC_WRITE_BYTE(ptr, val) (*(byte *)(ptr) = (val))
+
 
 #define SYNC_AS(SUFFIX,TYPE,SIZE) \
 	template<typename T> \
@@ -43,6 +68,36 @@ namespace Common {
 		_bytesSynced += SIZE; \
 	}
 
+// Arrays are copied as a whole if their layout matches the file, otherwise
+// they are converted through a buffer, which still saves the stream calls
+// for every single element
+#define SYNC_ARRAY_AS(SUFFIX,TYPE,SIZE,NATIVE,READ,WRITE) \
+	template<typename T> \
+	void syncArrayAs ## SUFFIX(T *vals, uint32 count, Version minVersion = 0, Version maxVersion = kLastVersion) { \
+		if (_version < minVersion || _version > maxVersion) \
+			return; \
+		if (sizeof(T) == SIZE && (SIZE == 1 || NATIVE) && SerializerRawCopy<T>::kValue) { \
+			syncBytes((byte *)vals, count * SIZE); \
+			return; \
+		} \
+		byte buf[kArrayBufferSize]; \
+		while (count) { \
+			const uint32 n = MIN<uint32>(count, kArrayBufferSize / SIZE); \
+			if (_loadStream) { \
+				_loadStream->read(buf, n * SIZE); \
+				for (uint32 i = 0; i < n; ++i) \
+					vals[i] = static_cast<T>((TYPE)READ(buf + i * SIZE)); \
+			} else { \
+				for (uint32 i = 0; i < n; ++i) \
+					WRITE(buf + i * SIZE, (TYPE)vals[i]); \
+				_saveStream->write(buf, n * SIZE); \
+			} \
+			_bytesSynced += n * SIZE; \
+			vals += n; \
+			count -= n; \
+		} \
+	}
+
 
 /**
  * This class allows syncing / serializing data (primarily game savestates)
@@ -55,10 +110,13 @@ namespace Common {
  *
  * @todo Maybe rename this to Synchronizer?
  *
- * @todo One feature the SCUMM code has but that is missing here: Support for
- *       syncing arrays of a given type and *fixed* size; and also support
- *       for when the array size changed between versions. Also, support for
- *       2D-arrays.
+ * Arrays of a fixed size can be synced with the syncArrayAs methods, which
+ * are much faster than syncing every element on its own. Data can be split
+ * into chunks prefixed with their size, which loaders can skip without
+ * knowing their contents.
+ *
+ * @todo One feature the SCUMM code has but that is missing here: Support
+ *       for when the array size changed between versions.
  *
  * @todo Proper error handling!
  */
@@ -68,6 +126,19 @@ public:
 	static const Version kLastVersion = 0xFFFFFFFF;
 
 protected:
+	enum {
+		kArrayBufferSize = 512
+	};
+
+	/** A chunk which has been begun but not ended yet. */
+	struct Chunk {
+		WriteStream *saveStream;	///< Stream the chunk is written to when ended
+		MemoryWriteStreamDynamic *buffer;	///< Contents of the chunk being saved
+		int32 end;				///< Position after the chunk being loaded
+		uint32 size;			///< Size of the chunk being loaded
+		uint bytesSynced;		///< Bytes synced before the contents of the chunk
+	};
+
 	SeekableReadStream *_loadStream;
 	WriteStream *_saveStream;
 
@@ -75,12 +146,17 @@ protected:
 
 	Version _version;
 
+	Array<Chunk> _chunks;
+
 public:
 	Serializer(SeekableReadStream *in, WriteStream *out)
 		: _loadStream(in), _saveStream(out), _bytesSynced(0), _version(0) {
 		assert(in || out);
 	}
-	virtual ~Serializer() {}
+	virtual ~Serializer() {
+		for (uint i = 0; i < _chunks.size(); ++i)
+			delete _chunks[i].buffer;
+	}
 
 	inline bool isSaving() { return (_saveStream != 0); }
 	inline bool isLoading() { return (_loadStream != 0); }
@@ -105,6 +181,18 @@ public:
 	SYNC_AS(Sint32LE, int32, 4)
 	SYNC_AS(Sint32BE, int32, 4)
 
+	SYNC_ARRAY_AS(Byte, byte, 1, 1, SYNC_READ_BYTE, SYNC_WRITE_BYTE)
+
+	SYNC_ARRAY_AS(Uint16LE, uint16, 2, SYNC_NATIVE_LE, READ_LE_UINT16, WRITE_LE_UINT16)
+	SYNC_ARRAY_AS(Uint16BE, uint16, 2, SYNC_NATIVE_BE, READ_BE_UINT16, WRITE_BE_UINT16)
+	SYNC_ARRAY_AS(Sint16LE, int16, 2, SYNC_NATIVE_LE, READ_LE_UINT16, WRITE_LE_UINT16)
+	SYNC_ARRAY_AS(Sint16BE, int16, 2, SYNC_NATIVE_BE, READ_BE_UINT16, WRITE_BE_UINT16)
+
+	SYNC_ARRAY_AS(Uint32LE, uint32, 4, SYNC_NATIVE_LE, READ_LE_UINT32, WRITE_LE_UINT32)
+	SYNC_ARRAY_AS(Uint32BE, uint32, 4, SYNC_NATIVE_BE, READ_BE_UINT32, WRITE_BE_UINT32)
+	SYNC_ARRAY_AS(Sint32LE, int32, 4, SYNC_NATIVE_LE, READ_LE_UINT32, WRITE_LE_UINT32)
+	SYNC_ARRAY_AS(Sint32BE, int32, 4, SYNC_NATIVE_BE, READ_BE_UINT32, WRITE_BE_UINT32)
+
 	/**
 	 * Returns true if an I/O failure occurred.
 	 * This flag is never cleared automatically. In order to clear it,
@@ -210,6 +298,60 @@ public:
 		return match;
 	}
 
+	/**
+	 * Begin a chunk of data, which is prefixed with its size. Loaders can
+	 * skip a chunk they don't know by ending it right away; endChunk()
+	 * always continues after the end of the chunk. This also allows newer
+	 * versions to add fields to the end of a chunk.
+	 *
+	 * Chunks can be nested, and every call must be matched by a call to
+	 * endChunk(). While saving, the contents of the chunk are kept in
+	 * memory until it is ended.
+	 *
+	 * @return the size of the chunk contents when loading, 0 otherwise
+	 */
+	uint32 beginChunk() {
+		Chunk chunk;
+		chunk.saveStream = 0;
+		chunk.buffer = 0;
+		chunk.end = 0;
+		chunk.size = 0;
+
+		if (isLoading()) {
+			chunk.size = _loadStream->readUint32LE();
+			chunk.end = _loadStream->pos() + chunk.size;
+		} else {
+			chunk.saveStream = _saveStream;
+			chunk.buffer = new MemoryWriteStreamDynamic(DisposeAfterUse::YES);
+			_saveStream = chunk.buffer;
+		}
+		_bytesSynced += 4;
+		chunk.bytesSynced = _bytesSynced;
+
+		_chunks.push_back(chunk);
+		return chunk.size;
+	}
+
+	/**
+	 * End the chunk begun last. When loading, this skips the rest of the
+	 * chunk; when saving, it writes the chunk out.
+	 */
+	void endChunk() {
+		assert(!_chunks.empty());
+		Chunk chunk = _chunks.back();
+		_chunks.pop_back();
+
+		if (isLoading()) {
+			_loadStream->seek(chunk.end);
+			_bytesSynced = chunk.bytesSynced + chunk.size;
+		} else {
+			_saveStream = chunk.saveStream;
+			_saveStream->writeUint32LE(chunk.buffer->size());
+			_saveStream->write(chunk.buffer->getData(), chunk.buffer->size());
+			delete chunk.buffer;
+		}
+	}
+
 	/**
 	 * Sync a C-string, by treating it as a zero-terminated byte sequence.
 	 * @todo Replace this method with a special Syncer class for Common::String
@@ -236,6 +378,11 @@ public:
 };
 
 #undef SYNC_AS
+#undef SYNC_ARRAY_AS
+#undef SYNC_NATIVE_LE
+#undef SYNC_NATIVE_BE
+#undef SYNC_READ_BYTE
+#undef SYNC_WRITE_BYTE
 
 
 // Mixin class / interface
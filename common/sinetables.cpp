@@ -24,29 +24,35 @@
 
 #include "common/scummsys.h"
 #include "common/sinetables.h"
+#include "common/transformtables.h"
 
 namespace Common {
 
-SineTable::SineTable(int bitPrecision) {
-	assert((bitPrecision >= 4) && (bitPrecision <= 16));
-
-	_bitPrecision = bitPrecision;
-
-	int m = 1 << _bitPrecision;
+static void *buildSineTable(int bitPrecision) {
+	int m = 1 << bitPrecision;
 	double freq = 2 * M_PI / m;
-	_table = new float[m / 2];
+	float *table = (float *)malloc(m / 2 * sizeof(float));
 
 	// Table contains sin(2*pi*i/m) for 0<=i<m/4,
 	// followed by m/2<=i<3m/4
 	for (int i = 0; i < m / 4; i++)
-		_table[i] = sin(i * freq);
+		table[i] = sin(i * freq);
 
 	for (int i = 0; i < m / 4; i++)
-		_table[m / 4 + i] = -_table[i];
+		table[m / 4 + i] = -table[i];
+
+	return table;
+}
+
+SineTable::SineTable(int bitPrecision) {
+	assert((bitPrecision >= 4) && (bitPrecision <= 16));
+
+	_bitPrecision = bitPrecision;
+	_table = (const float *)TransformTables::instance().getTable(TransformTables::kSine, _bitPrecision, buildSineTable);
 }
 
 SineTable::~SineTable() {
-	delete[] _table;
+	// The table is owned by TransformTables
 }
 
 } // End of namespace Common
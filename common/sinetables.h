@@ -30,6 +30,9 @@ public:
 	/**
 	 * Construct a sine table with the specified bit precision
 	 *
+	 * The table is only calculated the first time a precision is asked
+	 * for, and then shared by all SineTables of that precision.
+	 *
 	 * @param bitPrecision Precision of the table, which must be in range [4, 16]
 	 */
 	SineTable(int bitPrecision);
@@ -53,7 +56,7 @@ public:
 	int getPrecision() { return _bitPrecision; }
 
 private:
-	float *_table;
+	const float *_table;
 	int _bitPrecision;
 };
 
@@ -75,6 +75,11 @@ public:
 	static void destroy() {
 		T::destroyInstance();
 	}
+
+	/** Returns whether the instance has been created already. */
+	static bool hasInstance() {
+		return _singleton != 0;
+	}
 protected:
 	Singleton<T>()		{ }
 #ifdef __SYMBIAN32__
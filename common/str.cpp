@@ -23,6 +23,7 @@
 #include "common/hash-str.h"
 #include "common/list.h"
 #include "common/memorypool.h"
+#include "common/mutex.h"
 #include "common/str.h"
 #include "common/util.h"
 
@@ -30,6 +31,36 @@ namespace Common {
 
 MemoryPool *g_refCountPool = 0; // FIXME: This is never freed right now
 
+// Guards g_refCountPool while String::setThreadSafe(true) is in effect
+static Mutex *g_refCountPoolMutex = 0;
+static int g_threadSafeNesting = 0;
+
+static int *allocRefCount() {
+	if (g_refCountPoolMutex)
+		g_refCountPoolMutex->lock();
+
+	if (g_refCountPool == 0) {
+		g_refCountPool = new MemoryPool(sizeof(int));
+		assert(g_refCountPool);
+	}
+	int *refCount = (int *)g_refCountPool->allocChunk();
+
+	if (g_refCountPoolMutex)
+		g_refCountPoolMutex->unlock();
+	return refCount;
+}
+
+static void freeRefCount(int *refCount) {
+	if (g_refCountPoolMutex)
+		g_refCountPoolMutex->lock();
+
+	assert(g_refCountPool);
+	g_refCountPool->freeChunk(refCount);
+
+	if (g_refCountPoolMutex)
+		g_refCountPoolMutex->unlock();
+}
+
 static uint32 computeCapacity(uint32 len) {
 	// By default, for the capacity we use the next multiple of 32
 	return ((len + 32 - 1) & ~0x1F);
@@ -90,6 +121,25 @@ String::String(const String &str)
 	assert(_str != 0);
 }
 
+#if __cplusplus >= 201103L
+String::String(String &&str)
+	: _size(str._size) {
+	if (str.isStorageIntern()) {
+		memcpy(_storage, str._storage, _builtinCapacity);
+		_str = _storage;
+	} else {
+		// Take over the external storage, including its refcount
+		_extern._refCount = str._extern._refCount;
+		_extern._capacity = str._extern._capacity;
+		_str = str._str;
+
+		str._str = str._storage;
+		str._storage[0] = 0;
+	}
+	str._size = 0;
+}
+#endif
+
 String::String(char c)
 	: _size(0), _str(_storage) {
 
@@ -173,12 +223,7 @@ void String::ensureCapacity(uint32 new_size, bool keep_old) {
 void String::incRefCount() const {
 	assert(!isStorageIntern());
 	if (_extern._refCount == 0) {
-		if (g_refCountPool == 0) {
-			g_refCountPool = new MemoryPool(sizeof(int));
-			assert(g_refCountPool);
-		}
-
-		_extern._refCount = (int *)g_refCountPool->allocChunk();
+		_extern._refCount = allocRefCount();
 		*_extern._refCount = 2;
 	} else {
 		++(*_extern._refCount);
@@ -195,10 +240,8 @@ void String::decRefCount(int *oldRefCount) {
 	if (!oldRefCount || *oldRefCount <= 0) {
 		// The ref count reached zero, so we free the string storage
 		// and the ref count storage.
-		if (oldRefCount) {
-			assert(g_refCountPool);
-			g_refCountPool->freeChunk(oldRefCount);
-		}
+		if (oldRefCount)
+			freeRefCount(oldRefCount);
 		delete[] _str;
 
 		// Even though _str points to a freed memory block now,
@@ -207,6 +250,19 @@ void String::decRefCount(int *oldRefCount) {
 	}
 }
 
+void String::setThreadSafe(bool threadSafe) {
+	if (threadSafe) {
+		if (g_threadSafeNesting++ == 0)
+			g_refCountPoolMutex = new Mutex();
+	} else {
+		assert(g_threadSafeNesting > 0);
+		if (--g_threadSafeNesting == 0) {
+			delete g_refCountPoolMutex;
+			g_refCountPoolMutex = 0;
+		}
+	}
+}
+
 String &String::operator=(const char *str) {
 	uint32 len = strlen(str);
 	ensureCapacity(len, false);
@@ -248,6 +304,33 @@ String &String::operator=(char c) {
 	return *this;
 }
 
+#if __cplusplus >= 201103L
+String &String::operator=(String &&str) {
+	if (&str == this)
+		return *this;
+
+	if (str.isStorageIntern()) {
+		decRefCount(_extern._refCount);
+		_size = str._size;
+		_str = _storage;
+		memcpy(_str, str._str, _size + 1);
+	} else {
+		decRefCount(_extern._refCount);
+
+		_extern._refCount = str._extern._refCount;
+		_extern._capacity = str._extern._capacity;
+		_size = str._size;
+		_str = str._str;
+
+		str._str = str._storage;
+		str._storage[0] = 0;
+		str._size = 0;
+	}
+
+	return *this;
+}
+#endif
+
 String &String::operator+=(const char *str) {
 	if (_str <= str && str <= _str + _size)
 		return operator+=(String(str));
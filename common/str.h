@@ -120,6 +120,11 @@ public:
 	/** Construct a copy of the given string. */
 	String(const String &str);
 
+#if __cplusplus >= 201103L
+	/** Construct a string by taking over the storage of another one, which is left empty. */
+	String(String &&str);
+#endif
+
 	/** Construct a string consisting of the given character. */
 	explicit String(char c);
 
@@ -127,6 +132,9 @@ public:
 
 	String &operator=(const char *str);
 	String &operator=(const String &str);
+#if __cplusplus >= 201103L
+	String &operator=(String &&str);
+#endif
 	String &operator=(char c);
 	String &operator+=(const char *str);
 	String &operator+=(const String &str);
@@ -283,6 +291,18 @@ public:
 	 */
 	static String vformat(const char *fmt, va_list args);
 
+	/**
+	 * Make creating, copying and destroying strings safe while several
+	 * threads are running, as long as no String instance is used by more
+	 * than one of them at a time. All strings share the pool their
+	 * reference counts are allocated from; this guards it with a mutex.
+	 *
+	 * Calls nest: every call with true has to be balanced by a call with
+	 * false once the threads have finished. Both must be made on the thread
+	 * which starts and joins the other threads.
+	 */
+	static void setThreadSafe(bool threadSafe);
+
 public:
 
 	iterator begin() {
@@ -22,9 +22,11 @@
 
 #include "common/ptr.h"
 #include "common/stream.h"
+#include "common/bufferedstream.h"
 #include "common/memstream.h"
 #include "common/substream.h"
 #include "common/str.h"
+#include "common/system.h"
 
 namespace Common {
 
@@ -261,6 +263,11 @@ bool SeekableSubReadStream::seek(int32 offset, int whence) {
 	return ret;
 }
 
+const byte *SeekableSubReadStream::getDataPointer() const {
+	const byte *data = _parentStream->getDataPointer();
+	return data ? data + _begin : 0;
+}
+
 uint32 SafeSeekableSubReadStream::read(void *dataPtr, uint32 dataSize) {
 	// Make sure the parent stream is at the right position
 	seek(0, SEEK_CUR);
@@ -466,6 +473,249 @@ SeekableReadStream *wrapBufferedSeekableReadStream(SeekableReadStream *parentStr
 
 namespace {
 
+/**
+ * Wrapper class which reads ahead with a window adapted to the access
+ * pattern.
+ * @see wrapReadAheadStream
+ */
+class ReadAheadStream : public SeekableReadStream {
+public:
+	ReadAheadStream(SeekableReadStream *parentStream, DisposeAfterUse::Flag disposeParentStream, const String &name);
+	virtual ~ReadAheadStream();
+
+	virtual bool eos() const { return _eos; }
+	virtual bool err() const { return _err; }
+	virtual void clearErr();
+
+	virtual uint32 read(void *dataPtr, uint32 dataSize);
+
+	virtual int32 pos() const { return _pos; }
+	virtual int32 size() const { return _size; }
+	virtual bool seek(int32 offset, int whence = SEEK_SET);
+
+private:
+	enum {
+		kMinWindow = 4 * 1024,
+		kMaxWindow = 256 * 1024
+	};
+
+	DisposablePtr<SeekableReadStream> _parentStream;
+	const int32 _size;
+	uint32 _parentPos;
+	uint32 _pos;
+	bool _eos;
+	bool _err;
+
+	/** The buffer grows with the window, up to the size of the stream. */
+	byte *_buf;
+	uint32 _bufCapacity;
+	uint32 _bufStart;
+	uint32 _bufSize;
+	uint32 _window;
+
+	ReadAheadStats _stats;
+
+	uint32 readParent(byte *dataPtr, uint32 position, uint32 dataSize);
+	bool fill(uint32 position);
+	void recordLatency(uint32 startTime);
+
+	static uint32 getMillis();
+};
+
+ReadAheadStream::ReadAheadStream(SeekableReadStream *parentStream, DisposeAfterUse::Flag disposeParentStream, const String &name)
+	: _parentStream(parentStream, disposeParentStream),
+	_size(parentStream->size()),
+	_parentPos(parentStream->pos()),
+	_pos(_parentPos),
+	_eos(false),
+	_err(false),
+	_buf(0),
+	_bufCapacity(0),
+	_bufStart(0),
+	_bufSize(0),
+	_window(kMinWindow) {
+
+	_stats.name = name;
+	_stats.window = _window;
+	_stats.bytesRead = 0;
+	_stats.refills = 0;
+	_stats.seeks = 0;
+	memset(_stats.latency, 0, sizeof(_stats.latency));
+
+	ReadAheadStreamList::instance().add(&_stats);
+}
+
+ReadAheadStream::~ReadAheadStream() {
+	ReadAheadStreamList::instance().remove(&_stats);
+
+	delete[] _buf;
+}
+
+uint32 ReadAheadStream::getMillis() {
+	return g_system ? g_system->getMillis() : 0;
+}
+
+void ReadAheadStream::recordLatency(uint32 startTime) {
+	uint32 time = getMillis() - startTime;
+	int bucket = 0;
+	while (time && bucket < ReadAheadStats::kLatencyBuckets - 1) {
+		time >>= 1;
+		++bucket;
+	}
+	_stats.latency[bucket]++;
+}
+
+void ReadAheadStream::clearErr() {
+	_parentStream->clearErr();
+	_eos = _err = false;
+}
+
+uint32 ReadAheadStream::readParent(byte *dataPtr, uint32 position, uint32 dataSize) {
+	if (position != _parentPos)
+		_parentStream->seek(position);
+	const uint32 n = _parentStream->read(dataPtr, dataSize);
+	_parentPos = position + n;
+	return n;
+}
+
+bool ReadAheadStream::fill(uint32 position) {
+	// Sequential access grows the window, anything else starts over with
+	// the smallest one
+	const bool sequential = _bufSize && position == _bufStart + _bufSize;
+	_window = sequential ? MIN<uint32>(_window * 2, kMaxWindow) : (uint32)kMinWindow;
+	_stats.window = _window;
+	_stats.refills++;
+
+	// The buffered data is replaced anyway, so there is nothing to copy
+	// when the buffer grows
+	const uint32 wanted = MIN<uint32>(_window, _size);
+	if (wanted > _bufCapacity) {
+		delete[] _buf;
+		_buf = new byte[wanted];
+		_bufCapacity = wanted;
+	}
+
+	const uint32 startTime = getMillis();
+	_bufStart = position;
+	_bufSize = readParent(_buf, position, wanted);
+	_err |= _parentStream->err();
+	recordLatency(startTime);
+
+	return _bufSize != 0;
+}
+
+uint32 ReadAheadStream::read(void *dataPtr, uint32 dataSize) {
+	byte *ptr = (byte *)dataPtr;
+	uint32 total = 0;
+
+	while (dataSize) {
+		if (_pos >= _bufStart && _pos < _bufStart + _bufSize) {
+			const uint32 n = MIN(dataSize, _bufStart + _bufSize - _pos);
+			memcpy(ptr, _buf + (_pos - _bufStart), n);
+			ptr += n;
+			_pos += n;
+			total += n;
+			dataSize -= n;
+		} else if (dataSize >= (uint32)kMaxWindow) {
+			// Big requests go to the parent stream directly
+			const uint32 startTime = getMillis();
+			const uint32 n = readParent(ptr, _pos, dataSize);
+			_err |= _parentStream->err();
+			recordLatency(startTime);
+			_stats.refills++;
+			_pos += n;
+			total += n;
+			if (n < dataSize)
+				_eos = true;
+			break;
+		} else if (!fill(_pos)) {
+			_eos = true;
+			break;
+		}
+	}
+
+	_stats.bytesRead += total;
+	return total;
+}
+
+bool ReadAheadStream::seek(int32 offset, int whence) {
+	switch (whence) {
+	case SEEK_END:
+		offset += _size;
+		break;
+	case SEEK_CUR:
+		offset += _pos;
+		break;
+	default:
+		break;
+	}
+
+	if (offset < 0 || offset > _size)
+		return false;
+
+	// Nothing is read until the data is needed, so seeking back and forth
+	// is free
+	if ((uint32)offset < _bufStart || (uint32)offset > _bufStart + _bufSize)
+		_stats.seeks++;
+	_pos = offset;
+	_eos = false;
+	return true;
+}
+
+} // End of anonymous namespace
+
+SeekableReadStream *wrapReadAheadStream(SeekableReadStream *parentStream, DisposeAfterUse::Flag disposeParentStream, const String &name) {
+	if (parentStream)
+		return new ReadAheadStream(parentStream, disposeParentStream, name);
+	return 0;
+}
+
+DECLARE_SINGLETON(ReadAheadStreamList);
+
+ReadAheadStreamList::ReadAheadStreamList() : _mutex(g_system ? g_system->createMutex() : 0) {
+}
+
+ReadAheadStreamList::~ReadAheadStreamList() {
+	if (_mutex)
+		g_system->deleteMutex(_mutex);
+}
+
+void ReadAheadStreamList::add(const ReadAheadStats *stats) {
+	if (_mutex)
+		g_system->lockMutex(_mutex);
+	_streams.push_back(stats);
+	if (_mutex)
+		g_system->unlockMutex(_mutex);
+}
+
+void ReadAheadStreamList::remove(const ReadAheadStats *stats) {
+	if (_mutex)
+		g_system->lockMutex(_mutex);
+	for (uint i = 0; i < _streams.size(); ++i) {
+		if (_streams[i] == stats) {
+			_streams.remove_at(i);
+			break;
+		}
+	}
+	if (_mutex)
+		g_system->unlockMutex(_mutex);
+}
+
+Array<ReadAheadStats> ReadAheadStreamList::getStats() {
+	Array<ReadAheadStats> stats;
+	if (_mutex)
+		g_system->lockMutex(_mutex);
+	for (uint i = 0; i < _streams.size(); ++i)
+		stats.push_back(*_streams[i]);
+	if (_mutex)
+		g_system->unlockMutex(_mutex);
+	return stats;
+}
+
+#pragma mark -
+
+namespace {
+
 /**
  * Wrapper class which adds buffering to any WriteStream.
  */
@@ -485,6 +485,16 @@ public:
 	 */
 	virtual bool skip(uint32 offset) { return seek(offset, SEEK_CUR); }
 
+	/**
+	 * Returns a pointer to the whole data of the stream, if the stream keeps
+	 * it in memory, e.g. because it wraps a memory buffer or a memory-mapped
+	 * file. The pointer stays valid as long as the stream exists.
+	 *
+	 * @return a pointer to size() bytes of data, or 0 if the stream reads
+	 *         its data from somewhere else
+	 */
+	virtual const byte *getDataPointer() const { return 0; }
+
 	/**
 	 * Reads at most one less than the number of characters specified
 	 * by bufSize from the and stores them in the string buf. Reading
@@ -981,6 +981,15 @@ public:
 	*/
 	virtual uint32 getMillis(bool skipRecord = false) = 0;
 
+	/**
+	 * Get the number of microseconds since the program was started, for
+	 * measurements which need a finer resolution than getMillis(). Values
+	 * are never recorded by the event recorder. The default implementation
+	 * is based on getMillis(), backends override it if they have a better
+	 * clock.
+	 */
+	virtual uint64 getMicros() { return (uint64)getMillis(true) * 1000; }
+
 	/** Delay/sleep for the specified amount of milliseconds. */
 	virtual void delayMillis(uint msecs) = 0;
 
@@ -1059,6 +1068,8 @@ public:
 	 *
 	 * Hence backends which do not use threads to implement the timers simply
 	 * can use dummy implementations for these methods.
+	 *
+	 * Note that the optional thread handling methods below need these as well.
 	 */
 	//@{
 
@@ -1100,6 +1111,74 @@ public:
 
 
 
+	/**
+	 * @name Thread handling
+	 * Backends may optionally allow running work on separate threads, e.g.
+	 * to keep the GUI responsive during long running scans. This is purely
+	 * an optimization: client code must always be prepared for
+	 * createThread() to fail, and then do the work on the calling thread.
+	 *
+	 * Code running on such a thread must not use any OSystem functionality
+	 * besides the mutex and semaphore functions, delayMillis() and file
+	 * system access through Common::FSNode, and must synchronize all access
+	 * to shared data with the mutex functions. Strings may only be used while
+	 * Common::String::setThreadSafe(true) is in effect, and even then copies
+	 * of a Common::String or Common::SharedPtr must not be handed to another
+	 * thread, since they share a reference count which is not atomic.
+	 */
+	//@{
+
+	typedef struct OpaqueThread *ThreadRef;
+	typedef void (*ThreadProc)(void *param);
+
+	/**
+	 * Start a new thread running proc(param).
+	 * @return the new thread, or 0 if threads are not supported or an
+	 *         error occurred.
+	 */
+	virtual ThreadRef createThread(ThreadProc proc, void *param) { return 0; }
+
+	/**
+	 * Wait for the given thread to finish and release it.
+	 * @param thread	the thread to wait for.
+	 */
+	virtual void joinThread(ThreadRef thread) {}
+
+	typedef struct OpaqueSemaphore *SemaphoreRef;
+
+	/**
+	 * Create a new counting semaphore, to let threads sleep until there is
+	 * work for them.
+	 * @param initialValue	the initial count of the semaphore.
+	 * @return the new semaphore, or 0 if semaphores are not supported or an
+	 *         error occurred.
+	 */
+	virtual SemaphoreRef createSemaphore(uint initialValue) { return 0; }
+
+	/**
+	 * Wait until the count of the given semaphore is positive, then
+	 * decrement it.
+	 * @param sem	the semaphore to wait for.
+	 */
+	virtual void waitSemaphore(SemaphoreRef sem) {}
+
+	/**
+	 * Increment the count of the given semaphore, waking up one waiting
+	 * thread.
+	 * @param sem	the semaphore to post.
+	 */
+	virtual void postSemaphore(SemaphoreRef sem) {}
+
+	/**
+	 * Delete the given semaphore. No thread may be waiting for it.
+	 * @param sem	the semaphore to delete.
+	 */
+	virtual void deleteSemaphore(SemaphoreRef sem) {}
+
+	//@}
+
+
+
 	/** @name Sound */
 	//@{
 
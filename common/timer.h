@@ -24,11 +24,27 @@
 #define COMMON_TIMER_H
 
 #include "common/scummsys.h"
+#include "common/array.h"
 #include "common/str.h"
 #include "common/noncopyable.h"
 
 namespace Common {
 
+/**
+ * Timing statistics of an installed timer callback. The times between two
+ * invocations are measured with the millisecond clock.
+ */
+struct TimerStats {
+	String id;
+	uint32 interval;		///< Requested interval, in microseconds
+	uint32 calls;			///< Number of invocations
+	uint32 meanInterval;	///< Average time between two invocations, in microseconds
+	uint32 minInterval;		///< Shortest time between two invocations, in microseconds
+	uint32 maxInterval;		///< Longest time between two invocations, in microseconds
+	uint32 jitter;			///< Average difference of the time between two invocations to the interval, in microseconds
+	uint32 maxLateness;		///< Longest delay of an invocation after it was due, in milliseconds
+};
+
 class TimerManager : NonCopyable {
 public:
 	typedef void (*TimerProc)(void *refCon);
@@ -55,6 +71,12 @@ public:
 	 * and no instance of this callback will be running anymore.
 	 */
 	virtual void removeTimerProc(TimerProc proc) = 0;
+
+	/**
+	 * Return the timing statistics of all installed timer callbacks, or an
+	 * empty array if the timer manager does not keep any.
+	 */
+	virtual Array<TimerStats> getTimerStats() { return Array<TimerStats>(); }
 };
 
 } // End of namespace Common
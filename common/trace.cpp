@@ -0,0 +1,286 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+
+#include "common/trace.h"
+#include "common/file.h"
+#include "common/mutex.h"
+#include "common/str.h"
+#include "common/system.h"
+#include "common/textconsole.h"
+
+namespace Common {
+
+TraceRecorder::TraceRecorder(bool threadSafe)
+	: _stream(0), _disposeStream(DisposeAfterUse::YES), _threadSafe(threadSafe), _mutex(0), _running(false), _current(0), _dropped(0), _firstEvent(true), _haveStartTime(false), _startTime(0),
+	_writer(0), _wakeUp(0), _flushRequested(false), _stopping(false) {
+}
+
+TraceRecorder::~TraceRecorder() {
+	stop();
+	delete _mutex;
+}
+
+void TraceRecorder::start(WriteStream *stream, DisposeAfterUse::Flag disposeStream) {
+	stop();
+
+	if (_threadSafe && !_mutex)
+		_mutex = new Mutex();
+
+	_dropped = 0;
+	_firstEvent = true;
+	_haveStartTime = false;
+	_tracks.clear();
+	_buffers[0].reserve(4096);
+	_buffers[1].reserve(4096);
+	_stream = stream;
+	_disposeStream = disposeStream;
+	_stream->writeString("[\n");
+
+	// Without threads, or semaphores to wake them up, the events are
+	// written by flushIfNeeded()
+	if (_threadSafe) {
+		_wakeUp = g_system->createSemaphore(0);
+		if (_wakeUp) {
+			_stopping = false;
+			_writer = g_system->createThread(writerProc, this);
+			if (!_writer) {
+				g_system->deleteSemaphore(_wakeUp);
+				_wakeUp = 0;
+			}
+		}
+	}
+
+	lock();
+	_running = true;
+	unlock();
+}
+
+bool TraceRecorder::stop() {
+	if (!_stream)
+		return true;
+
+	// Events added from now on are ignored
+	lock();
+	_running = false;
+	unlock();
+
+	if (_writer) {
+		_stopping = true;
+		g_system->postSemaphore(_wakeUp);
+		g_system->joinThread(_writer);
+		g_system->deleteSemaphore(_wakeUp);
+		_writer = 0;
+		_wakeUp = 0;
+	}
+
+	// The writer thread left the other buffer empty
+	flush();
+
+	_stream->writeString("\n]\n");
+	_stream->finalize();
+	const bool result = !_stream->err();
+	if (_disposeStream == DisposeAfterUse::YES)
+		delete _stream;
+	_stream = 0;
+	return result;
+}
+
+void TraceRecorder::lock() const {
+	if (_mutex)
+		_mutex->lock();
+}
+
+void TraceRecorder::unlock() const {
+	if (_mutex)
+		_mutex->unlock();
+}
+
+void TraceRecorder::addEvent(const Event &event) {
+	lock();
+	if (_running) {
+		Array<Event> &events = _buffers[_current];
+		if (events.size() < kMaxPendingEvents)
+			events.push_back(event);
+		else
+			_dropped++;
+	}
+	unlock();
+}
+
+void TraceRecorder::addEvent(char phase, const char *category, const char *name, int32 value) {
+	Event event;
+	event.category = category;
+	event.name = name;
+	event.time = g_system->getMicros();
+	event.value = value;
+	event.phase = phase;
+	addEvent(event);
+}
+
+uint32 TraceRecorder::getPendingEvents() const {
+	lock();
+	uint32 pending = _buffers[_current].size();
+	unlock();
+	return pending;
+}
+
+void TraceRecorder::flush() {
+	// Swap the buffers, so other threads can go on adding events while the
+	// pending ones are written
+	lock();
+	Array<Event> &events = _buffers[_current];
+	_current ^= 1;
+	_flushRequested = false;
+	unlock();
+
+	for (uint i = 0; i < events.size(); ++i)
+		writeEvent(events[i]);
+
+	// Keep the storage for the next swap
+	events.resize(0);
+}
+
+void TraceRecorder::flushIfNeeded() {
+	lock();
+	const bool needed = !_flushRequested && _buffers[_current].size() >= kFlushThreshold;
+	if (needed && _writer)
+		_flushRequested = true;
+	unlock();
+
+	if (!needed)
+		return;
+	if (_writer)
+		g_system->postSemaphore(_wakeUp);
+	else
+		flush();
+}
+
+void TraceRecorder::writerProc(void *param) {
+	TraceRecorder *recorder = (TraceRecorder *)param;
+	for (;;) {
+		g_system->waitSemaphore(recorder->_wakeUp);
+		if (recorder->_stopping)
+			break;
+		recorder->flush();
+	}
+}
+
+uint TraceRecorder::getTrack(const char *category) {
+	for (uint i = 0; i < _tracks.size(); ++i) {
+		if (_tracks[i] == category || !strcmp(_tracks[i], category))
+			return i + 1;
+	}
+
+	// Name the new track after the category
+	_tracks.push_back(category);
+	writeRecord(String::format("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+		_tracks.size(), category));
+	return _tracks.size();
+}
+
+void TraceRecorder::writeEvent(const Event &event) {
+	if (!_haveStartTime) {
+		_startTime = event.time;
+		_haveStartTime = true;
+	}
+
+	// Events of other threads can be slightly older than the first one
+	const uint64 time = event.time > _startTime ? event.time - _startTime : 0;
+	const uint track = getTrack(event.category);
+
+	// Timestamps are in microseconds, which are printed in two parts, since
+	// there is no portable format for 64 bit values
+	const String timestamp = time >= 1000000000 ?
+		String::format("%u%09u", (uint)(time / 1000000000), (uint)(time % 1000000000)) :
+		String::format("%u", (uint)time);
+
+	String record = String::format("{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%c\",\"ts\":%s,\"pid\":1,\"tid\":%d",
+		event.name, event.category, event.phase == kPhaseFrame ? (char)kPhaseInstant : event.phase,
+		timestamp.c_str(), track);
+	if (event.phase == kPhaseCounter)
+		record += String::format(",\"args\":{\"value\":%d}", event.value);
+	else if (event.phase == kPhaseInstant)
+		record += ",\"s\":\"t\"";
+	else if (event.phase == kPhaseFrame)
+		record += ",\"s\":\"g\"";
+	record += '}';
+	writeRecord(record);
+}
+
+void TraceRecorder::writeRecord(const String &record) {
+	if (!_firstEvent)
+		_stream->writeString(",\n");
+	_firstEvent = false;
+	_stream->writeString(record);
+}
+
+bool gTraceEnabled = false;
+
+// The recorder of all traces. It is created by the first trace, and then
+// kept, since other threads can still be about to add an event when a trace
+// is stopped; they find the recorder stopped, and the event is ignored.
+static TraceRecorder *s_recorder = 0;
+
+bool startTrace(const String &filename) {
+	stopTrace();
+
+	DumpFile *file = new DumpFile();
+	if (!file->open(filename, true)) {
+		warning("Could not create trace file '%s'", filename.c_str());
+		delete file;
+		return false;
+	}
+
+	if (!s_recorder)
+		s_recorder = new TraceRecorder(true);
+
+	s_recorder->start(file);
+	gTraceEnabled = true;
+	return true;
+}
+
+void stopTrace() {
+	if (!gTraceEnabled)
+		return;
+
+	gTraceEnabled = false;
+	if (!s_recorder->stop())
+		warning("Could not write trace file");
+	if (s_recorder->getDroppedEvents())
+		warning("%d trace events were dropped", s_recorder->getDroppedEvents());
+}
+
+void addTraceEvent(char phase, const char *category, const char *name, int32 value) {
+	if (s_recorder)
+		s_recorder->addEvent(phase, category, name, value);
+}
+
+void addTraceFrame() {
+	if (!s_recorder)
+		return;
+
+	s_recorder->addEvent(TraceRecorder::kPhaseFrame, "frame", "Frame");
+	s_recorder->flushIfNeeded();
+}
+
+} // End of namespace Common
@@ -0,0 +1,252 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+
+#ifndef COMMON_TRACE_H
+#define COMMON_TRACE_H
+
+#include "common/scummsys.h"
+#include "common/array.h"
+#include "common/system.h"
+#include "common/types.h"
+
+namespace Common {
+
+class Mutex;
+class String;
+class WriteStream;
+
+/**
+ * Records trace events, i.e. the begin and end of scopes, counter values
+ * and instants, and writes them in the JSON format of Chrome traces, which
+ * can be viewed in chrome://tracing or the Perfetto UI.
+ *
+ * Events are kept in a binary form until they are flushed, so recording one
+ * is cheap: category and name are not copied and must stay valid until the
+ * events are flushed, which is why they should always be string literals.
+ * Every category is shown as a track of its own, so scopes of the same
+ * category must be properly nested, and only be used from one thread.
+ *
+ * The events are collected in one of two buffers, while the other one is
+ * written. A thread safe recorder writes them on a thread of its own, if
+ * the backend supports threads; otherwise they are written by flush().
+ *
+ * Usually there is no need to use this class directly; use the TRACE_*
+ * macros below instead.
+ */
+class TraceRecorder {
+public:
+	enum Phase {
+		kPhaseBegin = 'B',
+		kPhaseEnd = 'E',
+		kPhaseCounter = 'C',
+		kPhaseInstant = 'i',
+		kPhaseFrame = 'F'	///< Frame marker, written as an instant across all tracks
+	};
+
+	struct Event {
+		const char *category;
+		const char *name;
+		uint64 time;	///< Microseconds, as returned by OSystem::getMicros()
+		int32 value;	///< Value of counters
+		char phase;
+	};
+
+	/**
+	 * Create a recorder. If threadSafe is set, events can be added from any
+	 * thread, and the recorder must not be started before g_system exists.
+	 */
+	TraceRecorder(bool threadSafe);
+	~TraceRecorder();
+
+	/**
+	 * Start writing events to the given stream. Events added while the
+	 * recorder is not started are ignored.
+	 *
+	 * @param stream		the stream to write the JSON file to
+	 * @param disposeStream	whether to delete the stream when stopping
+	 */
+	void start(WriteStream *stream, DisposeAfterUse::Flag disposeStream = DisposeAfterUse::YES);
+
+	/**
+	 * Write the pending events and finish the JSON file. Returns false on
+	 * write errors.
+	 */
+	bool stop();
+
+	/** Add an event; if too many events are pending, it is dropped. */
+	void addEvent(const Event &event);
+
+	/** Add an event which happened now. */
+	void addEvent(char phase, const char *category, const char *name, int32 value = 0);
+
+	uint32 getPendingEvents() const;
+	uint32 getDroppedEvents() const { return _dropped; }
+
+	/**
+	 * Write the pending events to the stream. Events can be added by other
+	 * threads meanwhile. Must only be called by the thread which started
+	 * the recorder, and not if the recorder has a writer thread.
+	 */
+	void flush();
+
+	/**
+	 * Have the pending events written if there are enough of them, by the
+	 * writer thread if there is one, else right away. Call this regularly,
+	 * e.g. once per frame, from the thread which started the recorder.
+	 */
+	void flushIfNeeded();
+
+private:
+	TraceRecorder(const TraceRecorder &);
+	TraceRecorder &operator=(const TraceRecorder &);
+
+	enum {
+		kMaxPendingEvents = 1 << 20,
+		kFlushThreshold = 16384
+	};
+
+	WriteStream *_stream;
+	DisposeAfterUse::Flag _disposeStream;
+	bool _threadSafe;
+	Mutex *_mutex;
+	bool _running;		///< Whether events are accepted
+	Array<Event> _buffers[2];
+	uint _current;		///< Buffer events are added to
+	uint32 _dropped;
+	bool _firstEvent;
+	bool _haveStartTime;
+	uint64 _startTime;
+	Array<const char *> _tracks;	///< Categories seen so far, in order of their track ids
+
+	// The writer thread waits on _wakeUp, and writes the pending events
+	// until _stopping is set
+	OSystem::ThreadRef _writer;
+	OSystem::SemaphoreRef _wakeUp;
+	bool _flushRequested;
+	bool _stopping;
+
+	static void writerProc(void *param);
+
+	void lock() const;
+	void unlock() const;
+	uint getTrack(const char *category);
+	void writeEvent(const Event &event);
+	void writeRecord(const String &record);
+};
+
+/** Set while a trace file is being written. */
+extern bool gTraceEnabled;
+
+/**
+ * Start writing all trace events to the given file. A trace which is
+ * already running is stopped first. Returns false if the file can't be
+ * created.
+ */
+bool startTrace(const String &filename);
+
+/** Stop writing trace events, and close the trace file. */
+void stopTrace();
+
+/**
+ * Add an event to the running trace, if any. Use the TRACE_* macros instead,
+ * which do nothing when tracing is disabled.
+ */
+void addTraceEvent(char phase, const char *category, const char *name, int32 value = 0);
+
+/**
+ * Mark the end of a frame. This also has the pending events of the trace
+ * written once there are enough of them, so it must be called from the
+ * main thread only.
+ */
+void addTraceFrame();
+
+/** Records the begin and end of the surrounding scope. */
+class TraceScope {
+public:
+	TraceScope(const char *category, const char *name) : _category(category), _name(name), _active(gTraceEnabled) {
+		if (_active)
+			addTraceEvent(TraceRecorder::kPhaseBegin, _category, _name);
+	}
+
+	~TraceScope() {
+		if (_active && gTraceEnabled)
+			addTraceEvent(TraceRecorder::kPhaseEnd, _category, _name);
+	}
+
+private:
+	const char *_category;
+	const char *_name;
+	bool _active;
+};
+
+} // End of namespace Common
+
+/**
+ * Trace events. Category and name have to be string literals. Unless
+ * ScummVM is configured with --disable-tracing, in which case they compile
+ * to nothing, these only check a flag while no trace is running.
+ *
+ *   TRACE_SCOPE(category, name)          record the time spent in the current scope
+ *   TRACE_BEGIN(category, name)          begin of a scope ...
+ *   TRACE_END(category, name)            ... and its end
+ *   TRACE_COUNTER(category, name, value) record the value of a counter
+ *   TRACE_INSTANT(category, name)        mark a point in time
+ *   TRACE_FRAME()                        mark the end of a frame; main thread only
+ */
+#ifdef ENABLE_TRACING
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+#define TRACE_SCOPE(category, name) \
+	Common::TraceScope TRACE_CONCAT(traceScope, __LINE__)(category, name)
+
+#define TRACE_EVENT(phase, category, name, value) \
+	do { \
+		if (Common::gTraceEnabled) \
+			Common::addTraceEvent(phase, category, name, value); \
+	} while (0)
+
+#define TRACE_BEGIN(category, name) TRACE_EVENT(Common::TraceRecorder::kPhaseBegin, category, name, 0)
+#define TRACE_END(category, name) TRACE_EVENT(Common::TraceRecorder::kPhaseEnd, category, name, 0)
+#define TRACE_COUNTER(category, name, value) TRACE_EVENT(Common::TraceRecorder::kPhaseCounter, category, name, value)
+#define TRACE_INSTANT(category, name) TRACE_EVENT(Common::TraceRecorder::kPhaseInstant, category, name, 0)
+
+#define TRACE_FRAME() \
+	do { \
+		if (Common::gTraceEnabled) \
+			Common::addTraceFrame(); \
+	} while (0)
+
+#else
+
+#define TRACE_SCOPE(category, name) do {} while (0)
+#define TRACE_BEGIN(category, name) do {} while (0)
+#define TRACE_END(category, name) do {} while (0)
+#define TRACE_COUNTER(category, name, value) do {} while (0)
+#define TRACE_INSTANT(category, name) do {} while (0)
+#define TRACE_FRAME() do {} while (0)
+
+#endif
+
+#endif
@@ -0,0 +1,62 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+
+#include "common/transformtables.h"
+
+namespace Common {
+
+DECLARE_SINGLETON(TransformTables);
+
+TransformTables::TransformTables() : _mutex(g_system ? g_system->createMutex() : 0) {
+	memset(_tables, 0, sizeof(_tables));
+}
+
+TransformTables::~TransformTables() {
+	for (int type = 0; type < kTypeCount; type++) {
+		for (int bits = 0; bits <= kMaxBits; bits++)
+			free(_tables[type][bits]);
+	}
+
+	if (_mutex)
+		g_system->deleteMutex(_mutex);
+}
+
+const void *TransformTables::getTable(Type type, int bits, BuildProc build) {
+	assert(type < kTypeCount);
+	assert((bits >= 0) && (bits <= kMaxBits));
+
+	if (_mutex)
+		g_system->lockMutex(_mutex);
+
+	void *&table = _tables[type][bits];
+	if (!table)
+		table = build(bits);
+	const void *result = table;
+
+	if (_mutex)
+		g_system->unlockMutex(_mutex);
+
+	return result;
+}
+
+} // End of namespace Common
@@ -0,0 +1,79 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+
+#ifndef COMMON_TRANSFORMTABLES_H
+#define COMMON_TRANSFORMTABLES_H
+
+#include "common/singleton.h"
+#include "common/system.h"
+
+namespace Common {
+
+/**
+ * Owns the tables of the transforms in common: the cosine and sine tables,
+ * the FFT permutations and the DCT cosecants. Codecs set up their transforms
+ * anew for every stream, so each table is only built the first time its size
+ * is asked for, and then kept until the cache is destroyed at shutdown.
+ *
+ * Tables may be asked for from several threads at once, e.g. by audio
+ * streams set up on the mixer thread. The cache itself is created at
+ * startup, before any such thread runs.
+ */
+class TransformTables : public Singleton<TransformTables> {
+public:
+	enum Type {
+		kCosine,
+		kSine,
+		kFFTPermutation,
+		kFFTInversePermutation,
+		kDCTCosecants,
+
+		kTypeCount
+	};
+
+	enum {
+		kMaxBits = 16
+	};
+
+	/** Builds a table of the given size, allocated with malloc(). */
+	typedef void *(*BuildProc)(int bits);
+
+	/**
+	 * Return the table of the given type and size, calling build() to
+	 * create it if it does not exist yet.
+	 */
+	const void *getTable(Type type, int bits, BuildProc build);
+
+private:
+	friend class Singleton<SingletonBaseType>;
+	TransformTables();
+	~TransformTables();
+
+	/** Guards _tables; 0 if there is no backend, and hence no threads. */
+	OSystem::MutexRef _mutex;
+	void *_tables[kTypeCount][kMaxBits + 1];
+};
+
+} // End of namespace Common
+
+#endif // COMMON_TRANSFORMTABLES_H
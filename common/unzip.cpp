@@ -106,6 +106,13 @@ typedef struct {
 #include "common/fs.h"
 #include "common/unzip.h"
 #include "common/memstream.h"
+#include "common/substream.h"
+#include "common/array.h"
+#include "common/ptr.h"
+#include "common/util.h"
+#include "common/debug.h"
+#include "common/textconsole.h"
+#include "common/zlib.h"
 
 #include "common/hashmap.h"
 #include "common/hash-str.h"
@@ -382,6 +389,7 @@ typedef Common::HashMap<Common::String, cached_file_in_zip, Common::IgnoreCase_H
 */
 typedef struct {
 	Common::SeekableReadStream *_stream;				/* io structore of the zipfile */
+	Common::SharedPtr<Common::SeekableReadStream> _sharedStream;	/* owns _stream, shared with member streams */
 	unz_global_info gi;				/* public global information */
 	uLong byte_before_the_zipfile;	/* byte before the zipfile, (>0 for sfx)*/
 	uLong num_file;					/* number of the current file in the zipfile*/
@@ -544,6 +552,7 @@ unzFile unzOpen(Common::SeekableReadStream *stream) {
 	int err=UNZ_OK;
 
 	us->_stream = stream;
+	us->_sharedStream = Common::SharedPtr<Common::SeekableReadStream>(stream);
 
 	central_pos = unzlocal_SearchCentralDir(*us->_stream);
 	if (central_pos==0)
@@ -595,7 +604,6 @@ unzFile unzOpen(Common::SeekableReadStream *stream) {
 		err=UNZ_BADZIPFILE;
 
 	if (err != UNZ_OK) {
-		delete us->_stream;
 		delete us;
 		return NULL;
 	}
@@ -644,7 +652,8 @@ int unzClose(unzFile file) {
 	if (s->pfile_in_zip_read != NULL)
 		unzCloseCurrentFile(file);
 
-	delete s->_stream;
+	// The zipfile stream itself is released by _sharedStream, once the
+	// last member stream referencing it has been deleted as well.
 	delete s;
 	return UNZ_OK;
 }
@@ -1419,6 +1428,21 @@ int unzGetGlobalComment(unzFile file, char *szComment, uLong uSizeBuf) {
 
 namespace Common {
 
+/**
+ * Substream over the data of a member. It keeps a reference to the zipfile
+ * stream, so it stays valid after the ZipArchive is deleted. Like
+ * SafeSeekableSubReadStream, the zipfile stream is repositioned before each
+ * read, so several members can be read at the same time.
+ */
+class ZipMemberStream : public SafeSeekableSubReadStream {
+	SharedPtr<SeekableReadStream> _zipStream;
+
+public:
+	ZipMemberStream(const SharedPtr<SeekableReadStream> &zipStream, uint32 begin, uint32 end)
+		: SafeSeekableSubReadStream(zipStream.get(), begin, end, DisposeAfterUse::NO), _zipStream(zipStream) {
+	}
+};
+
 
 class ZipArchive : public Archive {
 	unzFile _zipFile;
@@ -1433,6 +1457,7 @@ public:
 	virtual int listMembers(ArchiveMemberList &list) const;
 	virtual const ArchiveMemberPtr getMember(const String &name) const;
 	virtual SeekableReadStream *createReadStreamForMember(const String &name) const;
+	virtual String getMemberFingerprint(const String &name) const;
 };
 
 /*
@@ -1489,32 +1514,43 @@ SeekableReadStream *ZipArchive::createReadStreamForMember(const String &name) co
 	if (unzLocateFile(_zipFile, name.c_str(), 2) != UNZ_OK)
 		return 0;
 
-	unz_file_info fileInfo;
-	if (unzOpenCurrentFile(_zipFile) != UNZ_OK)
-		return 0;
+	unz_s *s = (unz_s *)_zipFile;
 
-	if (unzGetCurrentFileInfo(_zipFile, &fileInfo, NULL, 0, NULL, 0, NULL, 0) != UNZ_OK)
+	uInt iSizeVar;
+	uLong offsetLocalExtrafield;
+	uInt sizeLocalExtrafield;
+	if (unzlocal_CheckCurrentFileCoherencyHeader(s, &iSizeVar, &offsetLocalExtrafield, &sizeLocalExtrafield) != UNZ_OK)
 		return 0;
 
-	byte *buffer = (byte *)malloc(fileInfo.uncompressed_size);
-	assert(buffer);
+	const unz_file_info &fileInfo = s->cur_file_info;
+	uint32 dataOffset = s->cur_file_info_internal.offset_curfile + SIZEZIPLOCALHEADER +
+	                    iSizeVar + s->byte_before_the_zipfile;
 
-	if (unzReadCurrentFile(_zipFile, buffer, fileInfo.uncompressed_size) != (int)fileInfo.uncompressed_size) {
-		free(buffer);
-		return 0;
-	}
+	// Stored members are handed out as plain substreams of the zipfile, no
+	// data is copied at all.
+	if (fileInfo.compression_method == 0)
+		return new ZipMemberStream(s->_sharedStream, dataOffset, dataOffset + fileInfo.uncompressed_size);
 
-	if (unzCloseCurrentFile(_zipFile) != UNZ_OK) {
-		free(buffer);
-		return 0;
-	}
+#ifdef USE_ZLIB
+	// Deflated members are inflated on demand from a substream as well
+	if (fileInfo.compression_method == Z_DEFLATED)
+		return wrapDeflateReadStream(new ZipMemberStream(s->_sharedStream, dataOffset, dataOffset + fileInfo.compressed_size),
+		                             fileInfo.uncompressed_size, fileInfo.crc);
+#endif
+
+	warning("ZipArchive: Unsupported compression method %d for '%s'", (int)fileInfo.compression_method, name.c_str());
+	return 0;
+}
 
-	return new MemoryReadStream(buffer, fileInfo.uncompressed_size, DisposeAfterUse::YES);
+String ZipArchive::getMemberFingerprint(const String &name) const {
+	// Looked up in the hash directly, so the current file stays as it is
+	const unz_s *const archive = (const unz_s *)_zipFile;
+	ZipHash::const_iterator i = archive->_hash.find(name);
+	if (i == archive->_hash.end())
+		return String();
 
-	// FIXME: instead of reading all into a memory stream, we could
-	// instead create a new ZipStream class. But then we have to be
-	// careful to handle the case where the client code opens multiple
-	// files in the archive and tries to use them independently.
+	const unz_file_info &fileInfo = i->_value.cur_file_info;
+	return String::format("%u/%08x", (uint)fileInfo.uncompressed_size, (uint)fileInfo.crc);
 }
 
 Archive *makeZipArchive(const String &name) {
@@ -22,12 +22,287 @@
 
 #include "common/xmlparser.h"
 #include "common/archive.h"
+#include "common/endian.h"
 #include "common/fs.h"
 #include "common/memstream.h"
 #include "common/system.h"
+#include "common/textconsole.h"
 
 namespace Common {
 
+enum {
+	kCompiledVersion = 1
+};
+
+/** Records of the compiled form written by XMLParser::parse() */
+enum CompiledRecord {
+	kCompiledEnd = 0,
+	kCompiledName = 1,		///< Defines the next property name
+	kCompiledKeyStart = 2,
+	kCompiledKeyEnd = 3
+};
+
+#pragma mark - XMLNameTable
+
+static uint hashName(const char *name, uint32 length) {
+	uint hash = 0;
+	while (length--)
+		hash = hash * 33 + (byte)*name++;
+	return hash;
+}
+
+XMLNameTable::XMLNameTable() {
+	clear();
+}
+
+void XMLNameTable::clear() {
+	_names.clear();
+	_slots.clear();
+	for (int i = 0; i < 64; ++i)
+		_slots.push_back(-1);
+}
+
+uint XMLNameTable::findSlot(const char *name, uint32 length) const {
+	const uint mask = _slots.size() - 1;
+	uint slot = hashName(name, length) & mask;
+	while (_slots[slot] != -1) {
+		const String &other = _names[_slots[slot]];
+		if (other.size() == length && !memcmp(other.c_str(), name, length))
+			break;
+		slot = (slot + 1) & mask;
+	}
+	return slot;
+}
+
+void XMLNameTable::grow() {
+	const uint size = _slots.size() * 2;
+	_slots.clear();
+	for (uint i = 0; i < size; ++i)
+		_slots.push_back(-1);
+
+	for (uint i = 0; i < _names.size(); ++i)
+		_slots[findSlot(_names[i].c_str(), _names[i].size())] = i;
+}
+
+int XMLNameTable::find(const char *name, uint32 length) const {
+	return _slots[findSlot(name, length)];
+}
+
+int XMLNameTable::intern(const char *name, uint32 length) {
+	uint slot = findSlot(name, length);
+	if (_slots[slot] != -1)
+		return _slots[slot];
+
+	// Keep the table at most half full
+	if ((_names.size() + 1) * 2 > _slots.size()) {
+		grow();
+		slot = findSlot(name, length);
+	}
+
+	_slots[slot] = _names.size();
+	_names.push_back(String(name, length));
+	return _slots[slot];
+}
+
+#pragma mark - XMLPullParser
+
+XMLPullParser::XMLPullParser(const char *data, uint32 size, XMLNameTable &names)
+	: _data(data), _end(data + size), _pos(data), _names(names),
+	_needHeader(true), _pendingEnd(false), _header(false) {
+
+	for (int c = 0; c < 256; ++c)
+		_nameChars[c] = isAlnum(c) || c == '_';
+}
+
+XMLPullParser::Event XMLPullParser::error(const char *message) {
+	_error = message;
+	return kEventError;
+}
+
+void XMLPullParser::skipSpaces() {
+	while (_pos < _end && isSpace(*_pos))
+		++_pos;
+}
+
+bool XMLPullParser::skipComment() {
+	// Expects to be at "<!"
+	_pos += 2;
+	if (_end - _pos < 2 || _pos[0] != '-' || _pos[1] != '-') {
+		error("Malformed comment syntax.");
+		return false;
+	}
+
+	for (_pos += 2; _pos < _end && *_pos; ++_pos) {
+		if (_pos[0] == '-' && _pos + 1 < _end && _pos[1] == '-') {
+			if (_pos + 2 >= _end || _pos[2] != '>') {
+				error("Malformed comment (double-hyphen inside comment body).");
+				return false;
+			}
+
+			_pos += 3;
+			return true;
+		}
+	}
+
+	error("Comment has no closure.");
+	return false;
+}
+
+bool XMLPullParser::skipBlanks() {
+	// Comments may even appear inside of keys
+	for (;;) {
+		skipSpaces();
+		if (_end - _pos < 2 || _pos[0] != '<' || _pos[1] != '!')
+			return true;
+		if (!skipComment())
+			return false;
+	}
+}
+
+bool XMLPullParser::parseName(XMLStringView &name) {
+	const char *start = _pos;
+	while (_pos < _end && _nameChars[(byte)*_pos])
+		++_pos;
+
+	name = XMLStringView(start, _pos - start);
+
+	// Names must be followed by something which can't be part of them
+	const char c = peek();
+	return isSpace(c) || c == '>' || c == '=' || c == '/';
+}
+
+bool XMLPullParser::parseValue(XMLStringView &value) {
+	const char quote = peek();
+	if (quote != '"' && quote != '\'')
+		return parseName(value);
+
+	const char *start = ++_pos;
+	while (_pos < _end && *_pos && *_pos != quote)
+		++_pos;
+
+	if (peek() != quote)
+		return false;
+
+	value = XMLStringView(start, _pos - start);
+	++_pos;
+	return true;
+}
+
+XMLPullParser::Event XMLPullParser::parseKey() {
+	// Expects to be after the '<'
+	bool closing = false;
+	_header = false;
+
+	if (_pos == _end || !*_pos)
+		return error("Unexpected end of file.");
+
+	if (_needHeader) {
+		if (*_pos != '?')
+			return error("Expecting XML header.");
+		++_pos;
+		_header = true;
+		_needHeader = false;
+	} else if (*_pos == '/') {
+		++_pos;
+		closing = true;
+	} else if (*_pos == '?') {
+		return error("Unexpected header. There may only be one XML header per file.");
+	}
+
+	if (!skipBlanks())
+		return kEventError;
+	if (!parseName(_name))
+		return error("Invalid key name.");
+	if (!skipBlanks())
+		return kEventError;
+
+	if (closing) {
+		if (_keys.empty() || _keys.back().length != _name.length || memcmp(_keys.back().data, _name.data, _name.length))
+			return error("Unexpected closure.");
+
+		if (peek() != '>')
+			return error("Invalid syntax in key closure.");
+
+		++_pos;
+		_keys.pop_back();
+		return kEventKeyEnd;
+	}
+
+	_properties.clear();
+	for (;;) {
+		const char c = peek();
+
+		if (c == '/' || (c == '?' && _header)) {
+			++_pos;
+			if (peek() != '>')
+				return error("Expecting key closure after '/' symbol.");
+
+			++_pos;
+			_pendingEnd = true;
+			return kEventKeyStart;
+		}
+
+		if (c == '>') {
+			if (_header)
+				return error("XML Header must be self-closed.");
+
+			++_pos;
+			_keys.push_back(_name);
+			return kEventKeyStart;
+		}
+
+		if (c == 0)
+			return error("Unexpected end of file.");
+
+		XMLStringView propertyName;
+		if (!parseName(propertyName))
+			return error("Error when parsing key value.");
+
+		if (!skipBlanks())
+			return kEventError;
+		if (peek() != '=')
+			return error("Syntax error after key name.");
+		++_pos;
+		if (!skipBlanks())
+			return kEventError;
+
+		Property property;
+		property.name = _names.intern(propertyName.data, propertyName.length);
+		if (!parseValue(property.value))
+			return error("Invalid key value.");
+
+		for (uint i = 0; i < _properties.size(); ++i) {
+			if (_properties[i].name == property.name)
+				return error("Invalid key value.");
+		}
+
+		_properties.push_back(property);
+		if (!skipBlanks())
+			return kEventError;
+	}
+}
+
+XMLPullParser::Event XMLPullParser::next() {
+	if (_pendingEnd) {
+		_pendingEnd = false;
+		return kEventKeyEnd;
+	}
+
+	if (!skipBlanks())
+		return kEventError;
+
+	if (_pos == _end || !*_pos)
+		return kEventEOF;
+
+	if (*_pos != '<')
+		return error("Parser expecting key start.");
+
+	++_pos;
+	return parseKey();
+}
+
+#pragma mark - XMLParser
+
 XMLParser::~XMLParser() {
 	while (!_activeKey.empty())
 		freeNode(_activeKey.pop());
@@ -80,60 +355,42 @@ void XMLParser::close() {
 bool XMLParser::parserError(const String &errStr) {
 	_state = kParserError;
 
-	const int startPosition = _stream->pos();
-	int currentPosition = startPosition;
-	int lineCount = 1;
-	char c = 0;
-
-	_stream->seek(0, SEEK_SET);
-
-	while (currentPosition--) {
-		c = _stream->readByte();
-
-		if (c == '\n' || c == '\r')
-			lineCount++;
-	}
+	Common::String errorMessage;
 
-	assert(_stream->pos() == startPosition);
-	currentPosition = startPosition;
-
-	Common::String errorMessage = Common::String::format("\n  File <%s>, line %d:\n", _fileName.c_str(), lineCount);
-
-	if (startPosition > 1) {
-		int keyOpening = 0;
-		int keyClosing = 0;
-
-		while (currentPosition-- && keyOpening == 0) {
-			_stream->seek(-2, SEEK_CUR);
-			c = _stream->readByte();
-
-			if (c == '<')
-				keyOpening = currentPosition - 1;
-			else if (c == '>')
-				keyClosing = currentPosition;
+	if (_data) {
+		const uint32 position = MIN(_offset, _dataSize);
+		int lineCount = 1;
+		for (uint32 i = 0; i < position; ++i) {
+			if (_data[i] == '\n' || _data[i] == '\r')
+				lineCount++;
 		}
 
-		_stream->seek(startPosition, SEEK_SET);
-		currentPosition = startPosition;
-		while (keyClosing == 0 && c && currentPosition++) {
-			c = _stream->readByte();
+		errorMessage = Common::String::format("\n  File <%s>, line %d:\n", _fileName.c_str(), lineCount);
 
-			if (c == '>')
-				keyClosing = currentPosition;
-		}
+		// Show the key around the error
+		if (position > 1) {
+			uint32 keyOpening = position;
+			while (keyOpening > 0 && _data[keyOpening - 1] != '<')
+				keyOpening--;
+			if (keyOpening > 0)
+				keyOpening--;
 
-		currentPosition = (keyClosing - keyOpening);
-		_stream->seek(keyOpening, SEEK_SET);
+			uint32 keyClosing = position;
+			while (keyClosing < _dataSize && _data[keyClosing] && _data[keyClosing] != '>')
+				keyClosing++;
 
-		while (currentPosition--)
-			errorMessage += (char)_stream->readByte();
+			errorMessage += String(_data + keyOpening, keyClosing - keyOpening);
+		}
+	} else {
+		errorMessage = Common::String::format("\n  File <%s> (compiled):\n", _fileName.c_str());
 	}
 
 	errorMessage += "\n\nParser error: ";
 	errorMessage += errStr;
 	errorMessage += "\n\n";
 
-	g_system->logMessage(LogMessageType::kError, errorMessage.c_str());
+	if (g_system)
+		g_system->logMessage(LogMessageType::kError, errorMessage.c_str());
 
 	return false;
 }
@@ -153,29 +410,41 @@ bool XMLParser::parseXMLHeader(ParserNode *node) {
 	return true;
 }
 
-bool XMLParser::parseActiveKey(bool closed) {
+void XMLParser::prepareLayout() {
+	if (_XMLkeys)
+		return;
+
+	buildLayout();
+
+	// Property names are compared as atoms
+	for (List<XMLKeyLayout *>::iterator i = _layoutList.begin(); i != _layoutList.end(); ++i) {
+		for (List<XMLKeyLayout::XMLKeyProperty>::iterator j = (*i)->properties.begin(); j != (*i)->properties.end(); ++j)
+			j->atom = _names.intern(j->name);
+	}
+}
+
+bool XMLParser::parseActiveKey() {
 	bool ignore = false;
 	assert(_activeKey.empty() == false);
 
 	ParserNode *key = _activeKey.top();
 
-	if (key->name == "xml" && key->header == true) {
-		assert(closed);
-		return parseXMLHeader(key) && closeKey();
-	}
-
 	XMLKeyLayout *layout = (_activeKey.size() == 1) ? _XMLkeys : getParentNode(key)->layout;
 
-	if (layout->children.contains(key->name)) {
-		key->layout = layout->children[key->name];
+	ChildMap::const_iterator child = layout->children.find(key->name);
+	if (child != layout->children.end()) {
+		key->layout = child->_value;
 
-		StringMap localMap = key->values;
-		int keyCount = localMap.size();
+		int keyCount = _activeProperties.size();
 
 		for (List<XMLKeyLayout::XMLKeyProperty>::const_iterator i = key->layout->properties.begin(); i != key->layout->properties.end(); ++i) {
-			if (i->required && !localMap.contains(i->name))
+			bool found = false;
+			for (uint j = 0; j < _activeProperties.size() && !found; ++j)
+				found = _activeProperties[j] == i->atom;
+
+			if (i->required && !found)
 				return parserError("Missing required property '" + i->name + "' inside key '" + key->name + "'");
-			else if (localMap.contains(i->name))
+			else if (found)
 				keyCount--;
 		}
 
@@ -203,40 +472,32 @@ bool XMLParser::parseActiveKey(bool closed) {
 		return false;
 	}
 
-	if (closed)
-		return closeKey();
-
 	return true;
 }
 
-bool XMLParser::parseKeyValue(String keyName) {
-	assert(_activeKey.empty() == false);
+bool XMLParser::openKey(ParserNode *node) {
+	node->depth = _activeKey.size();
+	node->ignore = false;
+	node->layout = 0;
+	_activeKey.push(node);
 
-	if (_activeKey.top()->values.contains(keyName))
-		return false;
-
-	_token.clear();
-	char stringStart;
-
-	if (_char == '"' || _char == '\'') {
-		stringStart = _char;
-		_char = _stream->readByte();
-
-		while (_char && _char != stringStart) {
-			_token += _char;
-			_char = _stream->readByte();
-		}
+	if (node->header) {
+		if (node->name == "xml")
+			return parseXMLHeader(node);
+		// Other headers are checked against the layout, which rejects them
+	}
 
-		if (_char == 0)
-			return false;
+	return parseActiveKey();
+}
 
-		_char = _stream->readByte();
+bool XMLParser::endKey() {
+	if (_activeKey.empty())
+		return parserError("Unexpected closure.");
 
-	} else if (!parseToken()) {
-		return false;
-	}
+	const String name = _activeKey.top()->name;
+	if (!closeKey())
+		return parserError("Missing data when closing key '" + name + "'.");
 
-	_activeKey.top()->values[keyName] = _token;
 	return true;
 }
 
@@ -298,225 +559,232 @@ bool XMLParser::closeKey() {
 	return result;
 }
 
-bool XMLParser::parse() {
+static void writeCompiledString(WriteStream *stream, const char *str, uint32 length) {
+	stream->writeUint16LE(length);
+	stream->write(str, length);
+}
+
+bool XMLParser::parse(WriteStream *compiled) {
 	if (_stream == 0)
 		return false;
 
-	// Make sure we are at the start of the stream.
+	// The pull parser works on the whole text at once
 	_stream->seek(0, SEEK_SET);
+	_dataSize = _stream->size();
+	byte *ownData = 0;
+	_data = (const char *)_stream->getDataPointer();
+	if (!_data) {
+		ownData = (byte *)malloc(_dataSize);
+		if (!ownData && _dataSize)
+			return parserError("Not enough memory to load the XML file.");
+		_dataSize = _stream->read(ownData, _dataSize);
+		_data = (const char *)ownData;
+	}
 
-	if (_XMLkeys == 0)
-		buildLayout();
+	prepareLayout();
 
 	while (!_activeKey.empty())
 		freeNode(_activeKey.pop());
 
 	cleanup();
 
-	bool activeClosure = false;
-	bool activeHeader = false;
-	bool selfClosure;
-
-	_state = kParserNeedHeader;
-	_activeKey.clear();
-
-	_char = _stream->readByte();
-
-	while (_char && _state != kParserError) {
-		if (skipSpaces())
-			continue;
-
-		if (skipComments())
-			continue;
+	_state = kParserNeedKey;
+	_offset = 0;
 
-		switch (_state) {
-		case kParserNeedHeader:
-		case kParserNeedKey:
-			if (_char != '<') {
-				parserError("Parser expecting key start.");
-				break;
-			}
-
-			if ((_char = _stream->readByte()) == 0) {
-				parserError("Unexpected end of file.");
-				break;
-			}
+	XMLPullParser parser(_data, _dataSize, _names);
+	for (int c = 0; c < 256; ++c)
+		parser.setNameChar(c, isValidNameChar(c));
 
-			if (_state == kParserNeedHeader) {
-				if (_char != '?') {
-					parserError("Expecting XML header.");
-					break;
-				}
-
-				_char = _stream->readByte();
-				activeHeader = true;
-			} else if (_char == '/') {
-				_char = _stream->readByte();
-				activeClosure = true;
-			} else if (_char == '?') {
-				parserError("Unexpected header. There may only be one XML header per file.");
-				break;
-			}
+	// Compiled files have their own atoms, defined as they are used
+	Array<int> compiledAtoms;
+	int compiledNames = 0;
+	if (compiled) {
+		compiled->writeUint32BE(MKTAG('X', 'M', 'L', 'C'));
+		compiled->writeUint32LE(kCompiledVersion);
+	}
 
-			_state = kParserNeedKeyName;
+	bool result = true;
+	bool seenHeader = false;
+	while (result) {
+		const XMLPullParser::Event event = parser.next();
+		_offset = parser.getOffset();
+
+		if (event == XMLPullParser::kEventError) {
+			result = parserError(parser.getError());
+		} else if (event == XMLPullParser::kEventEOF) {
+			if (!seenHeader || !_activeKey.empty())
+				result = parserError("Unexpected end of file.");
 			break;
-
-		case kParserNeedKeyName:
-			if (!parseToken()) {
-				parserError("Invalid key name.");
-				break;
+		} else if (event == XMLPullParser::kEventKeyEnd) {
+			if (compiled)
+				compiled->writeByte(kCompiledKeyEnd);
+			result = endKey();
+		} else {
+			const Array<XMLPullParser::Property> &properties = parser.getProperties();
+			ParserNode *node = allocNode();
+			node->name = parser.getName().toString();
+			node->header = parser.isHeader();
+			seenHeader = true;
+
+			_activeProperties.clear();
+			for (uint i = 0; i < properties.size(); ++i) {
+				_activeProperties.push_back(properties[i].name);
+				node->values[_names.getName(properties[i].name)] = properties[i].value.toString();
 			}
 
-			if (activeClosure) {
-				if (_activeKey.empty() || _token != _activeKey.top()->name) {
-					parserError("Unexpected closure.");
-					break;
+			if (compiled) {
+				for (uint i = 0; i < properties.size(); ++i) {
+					const int atom = properties[i].name;
+					while (compiledAtoms.size() <= (uint)atom)
+						compiledAtoms.push_back(-1);
+					if (compiledAtoms[atom] == -1) {
+						compiled->writeByte(kCompiledName);
+						writeCompiledString(compiled, _names.getName(atom).c_str(), _names.getName(atom).size());
+						compiledAtoms[atom] = compiledNames++;
+					}
 				}
-			} else {
-				ParserNode *node = allocNode(); //new ParserNode;
-				node->name = _token;
-				node->ignore = false;
-				node->header = activeHeader;
-				node->depth = _activeKey.size();
-				node->layout = 0;
-				_activeKey.push(node);
-			}
 
-			_state = kParserNeedPropertyName;
-			break;
-
-		case kParserNeedPropertyName:
-			if (activeClosure) {
-				if (!closeKey()) {
-					parserError("Missing data when closing key '" + _activeKey.top()->name + "'.");
-					break;
+				compiled->writeByte(kCompiledKeyStart);
+				writeCompiledString(compiled, node->name.c_str(), node->name.size());
+				compiled->writeByte(node->header);
+				compiled->writeUint16LE(properties.size());
+				for (uint i = 0; i < properties.size(); ++i) {
+					compiled->writeUint16LE(compiledAtoms[properties[i].name]);
+					writeCompiledString(compiled, properties[i].value.data, properties[i].value.length);
 				}
-
-				activeClosure = false;
-
-				if (_char != '>')
-					parserError("Invalid syntax in key closure.");
-				else
-					_state = kParserNeedKey;
-
-				_char = _stream->readByte();
-				break;
 			}
 
-			selfClosure = false;
-
-			if (_char == '/' || (_char == '?' && activeHeader)) {
-				selfClosure = true;
-				_char = _stream->readByte();
-			}
-
-			if (_char == '>') {
-				if (activeHeader && !selfClosure) {
-					parserError("XML Header must be self-closed.");
-				} else if (parseActiveKey(selfClosure)) {
-					_char = _stream->readByte();
-					_state = kParserNeedKey;
-				}
+			result = openKey(node);
+		}
+	}
 
-				activeHeader = false;
-				break;
-			}
+	if (compiled)
+		compiled->writeByte(kCompiledEnd);
 
-			if (selfClosure)
-				parserError("Expecting key closure after '/' symbol.");
-			else if (!parseToken())
-				parserError("Error when parsing key value.");
-			else
-				_state = kParserNeedPropertyOperator;
+	free(ownData);
+	_data = 0;
+	_dataSize = 0;
 
-			break;
+	return result;
+}
 
-		case kParserNeedPropertyOperator:
-			if (_char != '=')
-				parserError("Syntax error after key name.");
-			else
-				_state = kParserNeedPropertyValue;
+namespace {
 
-			_char = _stream->readByte();
-			break;
+/** Reads the records of compiled XML from memory */
+struct CompiledReader {
+	const byte *pos;
+	const byte *end;
 
-		case kParserNeedPropertyValue:
-			if (!parseKeyValue(_token))
-				parserError("Invalid key value.");
-			else
-				_state = kParserNeedPropertyName;
+	bool has(uint32 n) const { return (uint32)(end - pos) >= n; }
 
-			break;
+	byte readByte() {
+		return has(1) ? *pos++ : 0;
+	}
 
-		default:
-			break;
+	uint16 readUint16() {
+		if (!has(2)) {
+			pos = end;
+			return 0;
 		}
+		const uint16 value = READ_LE_UINT16(pos);
+		pos += 2;
+		return value;
 	}
 
-	if (_state == kParserError)
-		return false;
+	bool readString(String &str) {
+		const uint16 length = readUint16();
+		if (!has(length))
+			return false;
+		str = String((const char *)pos, length);
+		pos += length;
+		return true;
+	}
+};
 
-	if (_state != kParserNeedKey || !_activeKey.empty())
-		return parserError("Unexpected end of file.");
+} // End of anonymous namespace
 
-	return true;
-}
+bool XMLParser::parseCompiled(SeekableReadStream *stream) {
+	const uint32 size = stream->size() - stream->pos();
+	byte *ownData = 0;
+	const byte *data = stream->getDataPointer();
+	if (data) {
+		data += stream->pos();
+	} else {
+		ownData = (byte *)malloc(size);
+		if (!ownData && size) {
+			_data = 0;
+			return parserError("Not enough memory to load the compiled XML file.");
+		}
+		stream->read(ownData, size);
+		data = ownData;
+	}
 
-bool XMLParser::skipSpaces() {
-	if (!isSpace(_char))
-		return false;
+	prepareLayout();
 
-	while (_char && isSpace(_char))
-		_char = _stream->readByte();
+	while (!_activeKey.empty())
+		freeNode(_activeKey.pop());
 
-	return true;
-}
+	cleanup();
 
-bool XMLParser::skipComments() {
-	if (_char == '<') {
-		_char = _stream->readByte();
+	_state = kParserNeedKey;
+	_data = 0;
 
-		if (_char != '!') {
-			_stream->seek(-1, SEEK_CUR);
-			_char = '<';
-			return false;
-		}
+	CompiledReader reader = { data, data + size };
+	bool result = true;
 
-		if (_stream->readByte() != '-' || _stream->readByte() != '-')
-			return parserError("Malformed comment syntax.");
+	if (!reader.has(8) || READ_BE_UINT32(data) != MKTAG('X', 'M', 'L', 'C') || READ_LE_UINT32(data + 4) != kCompiledVersion)
+		result = parserError("Invalid compiled XML data.");
+	reader.pos += 8;
 
-		_char = _stream->readByte();
+	// Atoms of the compiled data, mapped to our own
+	Array<int> atoms;
+	String name;
 
-		while (_char) {
-			if (_char == '-') {
-				if (_stream->readByte() == '-') {
+	while (result) {
+		if (!reader.has(1)) {
+			result = parserError("Unexpected end of compiled data.");
+			break;
+		}
 
-					if (_stream->readByte() != '>')
-						return parserError("Malformed comment (double-hyphen inside comment body).");
+		const byte record = reader.readByte();
+		if (record == kCompiledEnd) {
+			if (!_activeKey.empty())
+				result = parserError("Unexpected end of file.");
+			break;
+		}
 
-					_char = _stream->readByte();
-					return true;
-				}
+		if (record == kCompiledName) {
+			result = reader.readString(name) || parserError("Invalid compiled XML data.");
+			atoms.push_back(_names.intern(name));
+		} else if (record == kCompiledKeyEnd) {
+			result = endKey();
+		} else if (record == kCompiledKeyStart) {
+			ParserNode *node = allocNode();
+			result = reader.readString(node->name);
+			node->header = reader.readByte() != 0;
+
+			_activeProperties.clear();
+			const uint16 count = reader.readUint16();
+			for (uint16 i = 0; i < count && result; ++i) {
+				const uint16 atom = reader.readUint16();
+				result = atom < atoms.size() && reader.readString(node->values[_names.getName(atoms[atom])]);
+				if (result)
+					_activeProperties.push_back(atoms[atom]);
 			}
 
-			_char = _stream->readByte();
+			if (!result) {
+				freeNode(node);
+				result = parserError("Invalid compiled XML data.");
+			} else {
+				result = openKey(node);
+			}
+		} else {
+			result = parserError("Invalid compiled XML data.");
 		}
-
-		return parserError("Comment has no closure.");
 	}
 
-	return false;
-}
-
-bool XMLParser::parseToken() {
-	_token.clear();
-
-	while (isValidNameChar(_char)) {
-		_token += _char;
-		_char = _stream->readByte();
-	}
-
-	return isSpace(_char) != 0 || _char == '>' || _char == '=' || _char == '/';
+	free(ownData);
+	return result;
 }
 
 } // End of namespace Common
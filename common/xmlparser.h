@@ -26,6 +26,7 @@
 #include "common/scummsys.h"
 #include "common/types.h"
 
+#include "common/array.h"
 #include "common/fs.h"
 #include "common/list.h"
 #include "common/hashmap.h"
@@ -37,6 +38,7 @@
 namespace Common {
 
 class SeekableReadStream;
+class WriteStream;
 
 #define MAX_XML_DEPTH 8
 
@@ -78,6 +80,131 @@ class SeekableReadStream;
 
 #define PARSER_END() layout.clear(); }
 
+/**
+ * A string inside the buffer given to an XMLPullParser. It is not
+ * null-terminated, and only valid as long as the buffer.
+ */
+struct XMLStringView {
+	const char *data;
+	uint32 length;
+
+	XMLStringView() : data(0), length(0) {}
+	XMLStringView(const char *d, uint32 l) : data(d), length(l) {}
+
+	bool equals(const char *str) const {
+		return !strncmp(data, str, length) && str[length] == 0;
+	}
+
+	String toString() const { return String(data, length); }
+};
+
+/**
+ * Maps names to small integers, called atoms, so that they can be compared
+ * and looked up without comparing strings. Atoms are handed out in order,
+ * starting at 0, and stay valid until clear() is called.
+ */
+class XMLNameTable {
+public:
+	XMLNameTable();
+
+	/** Return the atom of the given name, adding the name if needed. */
+	int intern(const char *name, uint32 length);
+	int intern(const String &name) { return intern(name.c_str(), name.size()); }
+
+	/** Return the atom of the given name, or -1 if it was never interned. */
+	int find(const char *name, uint32 length) const;
+
+	const String &getName(int atom) const { return _names[atom]; }
+	uint size() const { return _names.size(); }
+
+	void clear();
+
+private:
+	Array<String> _names;
+	Array<int> _slots; ///< Open addressing hash table of atoms, -1 if empty
+
+	uint findSlot(const char *name, uint32 length) const;
+	void grow();
+};
+
+/**
+ * A pull parser for the XML dialect understood by XMLParser. Instead of
+ * calling back for each key, it returns one event at a time from next(), and
+ * gives access to the names and values of the current key as views into the
+ * source buffer. Property names are interned into an XMLNameTable.
+ *
+ * The parser checks the syntax and that keys are closed in order, but has
+ * no idea of layouts; that is left to its user.
+ */
+class XMLPullParser {
+public:
+	enum Event {
+		kEventKeyStart,	///< A key was opened; self-closed keys are followed by kEventKeyEnd
+		kEventKeyEnd,	///< The key on top was closed
+		kEventEOF,		///< The end of the buffer was reached outside of any key
+		kEventError		///< A syntax error, see getError()
+	};
+
+	struct Property {
+		int name;				///< Atom of the property name
+		XMLStringView value;
+	};
+
+	/**
+	 * Create a parser for the given buffer, which must stay valid as long
+	 * as the parser. Parsing stops at the end of the buffer, or at the first
+	 * null byte.
+	 */
+	XMLPullParser(const char *data, uint32 size, XMLNameTable &names);
+
+	/** Parse up to the next event. */
+	Event next();
+
+	/** Name of the key of the last kEventKeyStart or kEventKeyEnd. */
+	const XMLStringView &getName() const { return _name; }
+
+	/** Whether the last opened key is the XML header. */
+	bool isHeader() const { return _header; }
+
+	/** Properties of the key of the last kEventKeyStart. */
+	const Array<Property> &getProperties() const { return _properties; }
+
+	/** Nesting depth of the current key, 0 for the outermost one. */
+	uint getDepth() const { return _keys.size(); }
+
+	/** Offset of the parser in the buffer. */
+	uint32 getOffset() const { return _pos - _data; }
+
+	const String &getError() const { return _error; }
+
+	/** Set whether a character may be part of key and property names. */
+	void setNameChar(byte c, bool valid) { _nameChars[c] = valid; }
+
+private:
+	const char *const _data;
+	const char *const _end;
+	const char *_pos;
+	XMLNameTable &_names;
+
+	bool _needHeader;
+	bool _pendingEnd;
+	bool _header;
+	XMLStringView _name;
+	Array<Property> _properties;
+	Array<XMLStringView> _keys;
+	String _error;
+	bool _nameChars[256];
+
+	char peek() const { return _pos < _end ? *_pos : 0; }
+	void skipSpaces();
+	bool skipComment();
+	bool skipBlanks();
+	bool parseName(XMLStringView &name);
+	bool parseValue(XMLStringView &value);
+	Event parseKey();
+	Event error(const char *message);
+};
+
 /**
  * The base XMLParser class implements generic functionality for parsing
  * XML-like files.
@@ -92,7 +219,7 @@ public:
 	/**
 	 * Parser constructor.
 	 */
-	XMLParser() : _XMLkeys(0), _stream(0) {}
+	XMLParser() : _XMLkeys(0), _stream(0), _state(kParserNeedKey), _data(0), _dataSize(0), _offset(0) {}
 
 	virtual ~XMLParser();
 
@@ -119,6 +246,7 @@ public:
 		struct XMLKeyProperty {
 			String name;
 			bool required;
+			int atom; ///< Name of the property in the name table of the parser
 		};
 
 		List<XMLKeyProperty> properties;
@@ -184,8 +312,20 @@ public:
 	/**
 	 * The actual parsing function.
 	 * Parses the loaded data stream, returns true if successful.
+	 *
+	 * @param compiled	if given, the parsed keys are also written to this
+	 *					stream, in a binary form which parseCompiled() can
+	 *					parse again without the cost of the XML syntax
 	 */
-	bool parse();
+	bool parse(WriteStream *compiled = 0);
+
+	/**
+	 * Parses keys written by parse() to its compiled stream. This checks
+	 * the layout and calls the key callbacks exactly like parsing the
+	 * original XML, but the syntax does not need to be checked again.
+	 * Returns true if successful.
+	 */
+	bool parseCompiled(SeekableReadStream *stream);
 
 	/**
 	 * Returns the active node being parsed (the one on top of
@@ -260,15 +400,10 @@ protected:
 	bool closeKey();
 
 	/**
-	 * Parses the value of a given key. There's no reason to overload this.
+	 * Called once a key has been parsed. It checks the key against the
+	 * layout, and calls the keyCallback.
 	 */
-	bool parseKeyValue(String keyName);
-
-	/**
-	 * Called once a key has been parsed. It handles the closing/cleanup of the
-	 * node stack and calls the keyCallback.
-	 */
-	bool parseActiveKey(bool closed);
+	bool parseActiveKey();
 
 	/**
 	 * Prints an error message when parsing fails and stops the parser.
@@ -277,18 +412,6 @@ protected:
 	 */
 	bool parserError(const String &errStr);
 
-	/**
-	 * Skips spaces/whitelines etc.
-	 * @return true if any spaces were skipped.
-	 */
-	bool skipSpaces();
-
-	/**
-	 * Skips comment blocks and comment lines.
-	 * @return true if any comments were skipped.
-	 */
-	bool skipComments();
-
 	/**
 	 * Check if a given character can be part of a KEY or VALUE name.
 	 * Overload this if you want to support keys with strange characters
@@ -298,11 +421,6 @@ protected:
 		return isAlnum(c) || c == '_';
 	}
 
-	/**
-	 * Parses a the first textual token found.
-	 */
-	bool parseToken();
-
 	/**
 	 * Parses the values inside an integer key.
 	 * The count parameter specifies the number of values inside
@@ -337,16 +455,23 @@ protected:
 	List<XMLKeyLayout *> _layoutList;
 
 private:
-	char _char;
 	SeekableReadStream *_stream;
 	String _fileName;
 
 	ParserState _state; /** Internal state of the parser */
 
-	String _error; /** Current error message */
-	String _token; /** Current text token */
-
 	Stack<ParserNode *> _activeKey; /** Node stack of the parsed keys */
+
+	XMLNameTable _names; /** Property names of the layout and the parsed keys */
+	Array<int> _activeProperties; /** Property names of the last opened key */
+
+	const char *_data; /** Text being parsed, 0 if parsing compiled keys */
+	uint32 _dataSize;
+	uint32 _offset; /** Position of the parser in _data, for errors */
+
+	bool openKey(ParserNode *node);
+	bool endKey();
+	void prepareLayout();
 };
 
 } // End of namespace Common
@@ -24,10 +24,12 @@
 #define FORBIDDEN_SYMBOL_ALLOW_ALL
 
 #include "common/zlib.h"
+#include "common/array.h"
 #include "common/ptr.h"
 #include "common/util.h"
 #include "common/stream.h"
 #include "common/debug.h"
+#include "common/system.h"
 #include "common/textconsole.h"
 
 #if defined(USE_ZLIB)
@@ -146,161 +148,422 @@ static bool _shownBackwardSeekingWarning = false;
 #endif
 
 /**
- * A simple wrapper class which can be used to wrap around an arbitrary
- * other SeekableReadStream and will then provide on-the-fly decompression support.
- * Assumes the compressed data to be in gzip format.
+ * On-the-fly inflating stream, which backs both the gzip read wrapper and the
+ * deflated members of ZIP archives. It takes over an arbitrary other
+ * SeekableReadStream holding the compressed data, which is either in gzip or
+ * zlib format, or raw deflate data without any header.
+ *
+ * Only the last 32 KB of uncompressed data (the deflate window) are kept
+ * around. While inflating, the stream remembers the decompressor state at
+ * deflate block boundaries every now and then. Seeking backwards resumes
+ * from the closest of these checkpoints, instead of from the start of the
+ * data.
  */
-class GZipReadStream : public SeekableReadStream {
+class InflateReadStream : public SeekableReadStream {
 protected:
 	enum {
-		BUFSIZE = 16384		// 1 << MAX_WBITS
+		BUFSIZE = 16384,
+		WINDOWSIZE = 32768,		// 1 << MAX_WBITS
+		MIN_CHECKPOINT_SPAN = 128 * 1024,
+		MAX_CHECKPOINTS = 32
+	};
+
+	struct Checkpoint {
+		uint32 outPos;		// position in the uncompressed data
+		uint32 inPos;		// position in the compressed data
+		int bits;			// bits of the byte before inPos not yet consumed
+		uint32 windowSize;
+		byte *window;
 	};
 
 	byte	_buf[BUFSIZE];
+	byte	_window[WINDOWSIZE];
 
 	ScopedPtr<SeekableReadStream> _wrapped;
 	z_stream _stream;
 	int _zlibErr;
-	uint32 _pos;
+	int _windowBits;	///< windowBits _stream was set up with, 0 if none
+	bool _raw;			///< whether the data is raw deflate data
+	uint32 _inSize;
+	uint32 _inPos;		///< compressed bytes fed to zlib so far
+	uint32 _winPos;		///< write position in _window
+	bool _winFull;		///< whether _window wrapped around at least once
+	uint32 _outStart;	///< first inflated byte not yet returned by read()
+	uint32 _outAvail;	///< inflated bytes not yet returned by read()
+	uint32 _outPos;		///< total bytes inflated so far
 	uint32 _origSize;
 	bool _eos;
 
-public:
+	// zlib checks the CRC of gzip and zlib data itself, we only do so
+	// for raw deflate data, and only when all of it is inflated in one go.
+	uint32 _crc;
+	uint32 _crcExpected;
+	bool _checkCrc;
 
-	GZipReadStream(SeekableReadStream *w, uint32 knownSize = 0) : _wrapped(w), _stream() {
-		assert(w != 0);
+	Array<Checkpoint> _checkpoints;
+	uint32 _checkpointSpan;
 
-		// Verify file header is correct
-		w->seek(0, SEEK_SET);
-		uint16 header = w->readUint16BE();
-		assert(header == 0x1F8B ||
-		       ((header & 0x0F00) == 0x0800 && header % 31 == 0));
+	bool fillWindow();
+	void addCheckpoint();
+	bool restart(const Checkpoint *checkpoint);
+	bool skip(uint32 len);
 
-		if (header == 0x1F8B) {
-			// Retrieve the original file size
-			w->seek(-4, SEEK_END);
-			_origSize = w->readUint32LE();
-		} else {
-			// Original size not available in zlib format
-			// use an otherwise known size if supplied.
-			_origSize = knownSize;
-		}
-		_pos = 0;
-		w->seek(0, SEEK_SET);
+public:
+	/**
+	 * @param wrapped	the compressed data, deleted together with this stream
+	 * @param raw		whether the data is raw deflate data, instead of gzip
+	 *					or zlib data
+	 * @param origSize	the size of the uncompressed data, 0 if not known
+	 * @param crc		for raw deflate data, the CRC-32 of the uncompressed data
+	 */
+	InflateReadStream(SeekableReadStream *wrapped, bool raw, uint32 origSize, uint32 crc = 0);
+	~InflateReadStream();
+
+	bool err() const { return (_zlibErr != Z_OK) && (_zlibErr != Z_STREAM_END); }
+	void clearErr() {
+		// only reset _eos; I/O and inflate errors are not recoverable
 		_eos = false;
+	}
 
-		// Adding 32 to windowBits indicates to zlib that it is supposed to
-		// automatically detect whether gzip or zlib headers are used for
-		// the compressed file. This feature was added in zlib 1.2.0.4,
-		// released 10 August 2003.
-		// Note: This is *crucial* for savegame compatibility, do *not* remove!
-		_zlibErr = inflateInit2(&_stream, MAX_WBITS + 32);
-		if (_zlibErr != Z_OK)
-			return;
+	uint32 read(void *dataPtr, uint32 dataSize);
+	bool eos() const { return _eos; }
+
+	int32 pos() const { return _outPos - _outAvail; }
+	int32 size() const { return _origSize; }
+	bool seek(int32 offset, int whence = SEEK_SET);
+};
+
+InflateReadStream::InflateReadStream(SeekableReadStream *wrapped, bool raw, uint32 origSize, uint32 crc)
+	: _wrapped(wrapped), _stream(), _windowBits(0), _raw(raw), _origSize(origSize), _eos(false),
+	  _crcExpected(crc) {
+	assert(wrapped != 0);
+	_inSize = wrapped->size();
+	_checkpointSpan = MAX<uint32>(MIN_CHECKPOINT_SPAN, _origSize / MAX_CHECKPOINTS);
+
+	restart(0);
+}
+
+InflateReadStream::~InflateReadStream() {
+	inflateEnd(&_stream);
+
+	for (uint i = 0; i < _checkpoints.size(); ++i)
+		free(_checkpoints[i].window);
+}
+
+uint32 InflateReadStream::read(void *dataPtr, uint32 dataSize) {
+	byte *dst = (byte *)dataPtr;
+	uint32 total = 0;
+
+	while (total < dataSize) {
+		if (_outAvail == 0 && !fillWindow()) {
+			_eos = true;
+			break;
+		}
 
-		// Setup input buffer
-		_stream.next_in = _buf;
-		_stream.avail_in = 0;
+		uint32 n = MIN(_outAvail, dataSize - total);
+		memcpy(dst + total, _window + _outStart, n);
+		_outStart += n;
+		_outAvail -= n;
+		total += n;
 	}
 
-	~GZipReadStream() {
-		inflateEnd(&_stream);
+	return total;
+}
+
+bool InflateReadStream::seek(int32 offset, int whence) {
+	int32 newPos = 0;
+	switch (whence) {
+	case SEEK_SET:
+		newPos = offset;
+		break;
+	case SEEK_CUR:
+		newPos = pos() + offset;
+		break;
+	case SEEK_END:
+		// NOTE: This can be an expensive operation (see below).
+		newPos = size() + offset;
+		break;
 	}
 
-	bool err() const { return (_zlibErr != Z_OK) && (_zlibErr != Z_STREAM_END); }
-	void clearErr() {
-		// only reset _eos; I/O errors are not recoverable
-		_eos = false;
+	if (newPos < 0)
+		return false;
+
+	_eos = false;
+
+	// Find the closest checkpoint at or before the new position
+	const Checkpoint *checkpoint = 0;
+	for (uint i = 0; i < _checkpoints.size() && _checkpoints[i].outPos <= (uint32)newPos; ++i)
+		checkpoint = &_checkpoints[i];
+
+	// Seeking backwards requires restarting the decompression. Resuming
+	// at a checkpoint also pays off when seeking forward past it.
+	if ((uint32)newPos < (uint32)pos() || (checkpoint && checkpoint->outPos > (uint32)pos())) {
+#ifndef RELEASE_BUILD
+		if (!checkpoint && !_shownBackwardSeekingWarning) {
+			// We only throw this warning once per stream, to avoid
+			// getting the console swarmed with warnings when consecutive
+			// seeks are made.
+			debug(1, "Backward seeking in InflateReadStream detected");
+			_shownBackwardSeekingWarning = true;
+		}
+#endif
+		debug(9, "InflateReadStream: Restarting at %d to seek to %d", checkpoint ? (int)checkpoint->outPos : 0, newPos);
+		if (!restart(checkpoint))
+			return false;
 	}
 
-	uint32 read(void *dataPtr, uint32 dataSize) {
-		_stream.next_out = (byte *)dataPtr;
-		_stream.avail_out = dataSize;
+	return skip(newPos - pos());
+}
 
-		// Keep going while we get no error
-		while (_zlibErr == Z_OK && _stream.avail_out) {
-			if (_stream.avail_in == 0 && !_wrapped->eos()) {
-				// If we are out of input data: Read more data, if available.
-				_stream.next_in = _buf;
-				_stream.avail_in = _wrapped->read(_buf, BUFSIZE);
+bool InflateReadStream::fillWindow() {
+	while (_zlibErr == Z_OK) {
+		if (_winPos == WINDOWSIZE) {
+			_winPos = 0;
+			_winFull = true;
+		}
+
+		if (_stream.avail_in == 0 && _inPos < _inSize) {
+			// If we are out of input data: Read more data, if available.
+			uint32 len = MIN<uint32>(BUFSIZE, _inSize - _inPos);
+			if (_wrapped->read(_buf, len) != len) {
+				_zlibErr = Z_ERRNO;
+				return false;
 			}
-			_zlibErr = inflate(&_stream, Z_NO_FLUSH);
+			_inPos += len;
+			_stream.next_in = _buf;
+			_stream.avail_in = len;
 		}
 
-		// Update the position counter
-		_pos += dataSize - _stream.avail_out;
+		_stream.next_out = _window + _winPos;
+		_stream.avail_out = WINDOWSIZE - _winPos;
 
-		if (_zlibErr == Z_STREAM_END && _stream.avail_out > 0)
-			_eos = true;
+		// Z_BLOCK makes inflate() return at the end of each deflate block,
+		// which are the only places where checkpoints can be taken.
+		_zlibErr = inflate(&_stream, Z_BLOCK);
+		if (_zlibErr == Z_BUF_ERROR && _stream.avail_in == 0 && _inPos < _inSize)
+			_zlibErr = Z_OK;
+
+		uint32 produced = WINDOWSIZE - _winPos - _stream.avail_out;
+		_outStart = _winPos;
+		_outAvail = produced;
+		_winPos += produced;
+		_outPos += produced;
+
+		if (_checkCrc)
+			_crc = crc32(_crc, _window + _outStart, produced);
+
+		if (_zlibErr == Z_OK && (_stream.data_type & 128) && !(_stream.data_type & 64)) {
+			uint32 lastOutPos = _checkpoints.empty() ? 0 : _checkpoints.back().outPos;
+			if (_outPos >= lastOutPos + _checkpointSpan)
+				addCheckpoint();
+		}
+
+		if (_zlibErr == Z_STREAM_END && _checkCrc && _crc != _crcExpected) {
+			warning("InflateReadStream: CRC mismatch");
+			_zlibErr = Z_DATA_ERROR;
+		}
 
-		return dataSize - _stream.avail_out;
+		if (produced)
+			return true;
 	}
 
-	bool eos() const {
-		return _eos;
+	return false;
+}
+
+void InflateReadStream::addCheckpoint() {
+	Checkpoint checkpoint;
+	checkpoint.outPos = _outPos;
+	checkpoint.inPos = _inPos - _stream.avail_in;
+	checkpoint.bits = _stream.data_type & 7;
+	checkpoint.windowSize = _winFull ? (uint32)WINDOWSIZE : _winPos;
+	checkpoint.window = (byte *)malloc(checkpoint.windowSize);
+	if (!checkpoint.window)
+		return;
+
+	// Unroll the ring buffer so the oldest byte comes first
+	if (_winFull) {
+		memcpy(checkpoint.window, _window + _winPos, WINDOWSIZE - _winPos);
+		memcpy(checkpoint.window + WINDOWSIZE - _winPos, _window, _winPos);
+	} else {
+		memcpy(checkpoint.window, _window, _winPos);
 	}
-	int32 pos() const {
-		return _pos;
+
+	_checkpoints.push_back(checkpoint);
+}
+
+bool InflateReadStream::restart(const Checkpoint *checkpoint) {
+	// Adding 32 to windowBits indicates to zlib that it is supposed to
+	// automatically detect whether gzip or zlib headers are used for
+	// the compressed file. This feature was added in zlib 1.2.0.4,
+	// released 10 August 2003.
+	// Note: This is *crucial* for savegame compatibility, do *not* remove!
+	//
+	// A checkpoint however is in the middle of the raw deflate data, past
+	// any header, so inflating resumes without one. Negative windowBits
+	// tell zlib there is no header.
+	const int windowBits = (_raw || checkpoint) ? -MAX_WBITS : MAX_WBITS + 32;
+	if (windowBits == _windowBits) {
+		_zlibErr = inflateReset(&_stream);
+	} else {
+		inflateEnd(&_stream);
+		_zlibErr = inflateInit2(&_stream, windowBits);
+		_windowBits = (_zlibErr == Z_OK) ? windowBits : 0;
 	}
-	int32 size() const {
-		return _origSize;
+	if (_zlibErr != Z_OK)
+		return false;
+
+	_stream.next_in = _buf;
+	_stream.avail_in = 0;
+	_outAvail = 0;
+	_outStart = 0;
+	_winFull = false;
+
+	if (!checkpoint) {
+		_inPos = 0;
+		_outPos = 0;
+		_winPos = 0;
+		_crc = 0;
+		_checkCrc = _raw;
+		_wrapped->seek(0, SEEK_SET);
+		return true;
 	}
-	bool seek(int32 offset, int whence = SEEK_SET) {
-		int32 newPos = 0;
-		switch (whence) {
-		case SEEK_SET:
-			newPos = offset;
-			break;
-		case SEEK_CUR:
-			newPos = _pos + offset;
-			break;
-		case SEEK_END:
-			// NOTE: This can be an expensive operation (see below).
-			newPos = size() + offset;
-			break;
+
+	_inPos = checkpoint->inPos;
+	_outPos = checkpoint->outPos;
+	_checkCrc = false;
+
+	if (checkpoint->bits) {
+		_wrapped->seek(_inPos - 1, SEEK_SET);
+		byte partial = _wrapped->readByte();
+		_zlibErr = inflatePrime(&_stream, checkpoint->bits, partial >> (8 - checkpoint->bits));
+		if (_zlibErr != Z_OK)
+			return false;
+	}
+	_wrapped->seek(_inPos, SEEK_SET);
+
+	_zlibErr = inflateSetDictionary(&_stream, checkpoint->window, checkpoint->windowSize);
+	if (_zlibErr != Z_OK)
+		return false;
+
+	// Restore our copy of the window as well, later checkpoints need it
+	memcpy(_window, checkpoint->window, checkpoint->windowSize);
+	_winPos = checkpoint->windowSize;
+	return true;
+}
+
+bool InflateReadStream::skip(uint32 len) {
+	while (len > 0) {
+		if (_outAvail == 0 && !fillWindow())
+			return false;
+
+		uint32 n = MIN(_outAvail, len);
+		_outStart += n;
+		_outAvail -= n;
+		len -= n;
+	}
+
+	return true;
+}
+
+/**
+ * A simple wrapper class which can be used to wrap around an arbitrary
+ * other SeekableReadStream and will then provide on-the-fly decompression support.
+ * Assumes the compressed data to be in gzip format.
+ */
+class GZipReadStream : public InflateReadStream {
+	static uint32 readOriginalSize(SeekableReadStream *w, uint32 knownSize) {
+		// Verify file header is correct
+		w->seek(0, SEEK_SET);
+		uint16 header = w->readUint16BE();
+		assert(header == 0x1F8B ||
+		       ((header & 0x0F00) == 0x0800 && header % 31 == 0));
+
+		if (header == 0x1F8B) {
+			// Retrieve the original file size
+			w->seek(-4, SEEK_END);
+			return w->readUint32LE();
 		}
 
-		assert(newPos >= 0);
+		// Original size not available in zlib format
+		// use an otherwise known size if supplied.
+		return knownSize;
+	}
 
-		if ((uint32)newPos < _pos) {
-			// To search backward, we have to restart the whole decompression
-			// from the start of the file. A rather wasteful operation, best
-			// to avoid it. :/
+public:
+	GZipReadStream(SeekableReadStream *w, uint32 knownSize = 0)
+		: InflateReadStream(w, false, readOriginalSize(w, knownSize)) {
+	}
+};
 
-#ifndef RELEASE_BUILD
-			if (!_shownBackwardSeekingWarning) {
-				// We only throw this warning once per stream, to avoid
-				// getting the console swarmed with warnings when consecutive
-				// seeks are made.
-				debug(1, "Backward seeking in GZipReadStream detected");
-				_shownBackwardSeekingWarning = true;
-			}
-#endif
+/**
+ * Keeps the zlib state of a finished GZipWriteStream around, so the next one
+ * can reuse it instead of allocating its roughly 256 KB anew. Savegames are
+ * written one after another, so a single spare state is enough.
+ */
+class DeflateStreamPool {
+public:
+	enum {
+		// The level Z_DEFAULT_COMPRESSION stands for
+		LEVEL = 6
+	};
 
-			_pos = 0;
-			_wrapped->seek(0, SEEK_SET);
-			_zlibErr = inflateReset(&_stream);
-			if (_zlibErr != Z_OK)
-				return false;	// FIXME: STREAM REWRITE
-			_stream.next_in = _buf;
-			_stream.avail_in = 0;
+	DeflateStreamPool() : _spare(0) {}
+
+	~DeflateStreamPool() {
+		if (_spare) {
+			deflateEnd(_spare);
+			delete _spare;
 		}
+	}
+
+	z_stream *acquire() {
+		z_stream *stream = _spare;
+		_spare = 0;
 
-		offset = newPos - _pos;
+		if (stream && deflateReset(stream) == Z_OK)
+			return stream;
 
-		// Skip the given amount of data (very inefficient if one tries to skip
-		// huge amounts of data, but usually client code will only skip a few
-		// bytes, so this should be fine.
-		byte tmpBuf[1024];
-		while (!err() && offset > 0) {
-			offset -= read(tmpBuf, MIN((int32)sizeof(tmpBuf), offset));
+		if (stream) {
+			deflateEnd(stream);
+			delete stream;
 		}
 
-		_eos = false;
-		return true;	// FIXME: STREAM REWRITE
+		stream = new z_stream();
+
+		// Adding 16 to windowBits indicates to zlib that it is supposed to
+		// write gzip headers. This feature was added in zlib 1.2.0.4,
+		// released 10 August 2003.
+		// Note: This is *crucial* for savegame compatibility, do *not* remove!
+		int zlibErr = deflateInit2(stream,
+		                 LEVEL,
+		                 Z_DEFLATED,
+		                 MAX_WBITS + 16,
+		                 8,
+				 Z_DEFAULT_STRATEGY);
+		assert(zlibErr == Z_OK);
+		(void)zlibErr;
+
+		return stream;
 	}
+
+	void release(z_stream *stream) {
+		if (_spare) {
+			deflateEnd(_spare);
+			delete _spare;
+		}
+		_spare = stream;
+	}
+
+private:
+	z_stream *_spare;
 };
 
+static DeflateStreamPool &getDeflateStreamPool() {
+	// Constructed on first use, to avoid a global constructor
+	static DeflateStreamPool pool;
+	return pool;
+}
+
 /**
  * A simple wrapper class which can be used to wrap around an arbitrary
  * other WriteStream and will then provide on-the-fly compression support.
@@ -314,50 +577,43 @@ protected:
 
 	byte	_buf[BUFSIZE];
 	ScopedPtr<WriteStream> _wrapped;
-	z_stream _stream;
+	z_stream *_stream;
 	int _zlibErr;
 	uint32 _pos;
+	uint32 _startTime;
 
 	void processData(int flushType) {
 		// This function is called by both write() and finalize().
-		while (_zlibErr == Z_OK && (_stream.avail_in || flushType == Z_FINISH)) {
-			if (_stream.avail_out == 0) {
+		while (_zlibErr == Z_OK && (_stream->avail_in || flushType == Z_FINISH)) {
+			if (_stream->avail_out == 0) {
 				if (_wrapped->write(_buf, BUFSIZE) != BUFSIZE) {
 					_zlibErr = Z_ERRNO;
 					break;
 				}
-				_stream.next_out = _buf;
-				_stream.avail_out = BUFSIZE;
+				_stream->next_out = _buf;
+				_stream->avail_out = BUFSIZE;
 			}
-			_zlibErr = deflate(&_stream, flushType);
+			_zlibErr = deflate(_stream, flushType);
 		}
 	}
 
 public:
-	GZipWriteStream(WriteStream *w) : _wrapped(w), _stream(), _pos(0) {
+	GZipWriteStream(WriteStream *w) : _wrapped(w), _pos(0) {
 		assert(w != 0);
 
-		// Adding 16 to windowBits indicates to zlib that it is supposed to
-		// write gzip headers. This feature was added in zlib 1.2.0.4,
-		// released 10 August 2003.
-		// Note: This is *crucial* for savegame compatibility, do *not* remove!
-		_zlibErr = deflateInit2(&_stream,
-		                 Z_DEFAULT_COMPRESSION,
-		                 Z_DEFLATED,
-		                 MAX_WBITS + 16,
-		                 8,
-				 Z_DEFAULT_STRATEGY);
-		assert(_zlibErr == Z_OK);
+		_startTime = g_system ? g_system->getMillis() : 0;
+		_stream = getDeflateStreamPool().acquire();
+		_zlibErr = Z_OK;
 
-		_stream.next_out = _buf;
-		_stream.avail_out = BUFSIZE;
-		_stream.avail_in = 0;
-		_stream.next_in = 0;
+		_stream->next_out = _buf;
+		_stream->avail_out = BUFSIZE;
+		_stream->avail_in = 0;
+		_stream->next_in = 0;
 	}
 
 	~GZipWriteStream() {
 		finalize();
-		deflateEnd(&_stream);
+		getDeflateStreamPool().release(_stream);
 	}
 
 	bool err() const {
@@ -380,7 +636,7 @@ public:
 
 		// Since processData only writes out blocks of size BUFSIZE,
 		// we may have to flush some stragglers.
-		uint remainder = BUFSIZE - _stream.avail_out;
+		uint remainder = BUFSIZE - _stream->avail_out;
 		if (remainder > 0) {
 			if (_wrapped->write(_buf, remainder) != remainder) {
 				_zlibErr = Z_ERRNO;
@@ -389,6 +645,10 @@ public:
 
 		// Finalize the wrapped savefile, too
 		_wrapped->finalize();
+
+		debug(3, "GZipWriteStream: Compressed %u bytes to %u at level %d in %u ms",
+		      (uint)_stream->total_in, (uint)_stream->total_out, (int)DeflateStreamPool::LEVEL,
+		      g_system ? g_system->getMillis() - _startTime : 0);
 	}
 
 	uint32 write(const void *dataPtr, uint32 dataSize) {
@@ -398,14 +658,14 @@ public:
 		// Hook in the new data ...
 		// Note: We need to make a const_cast here, as zlib is not aware
 		// of the const keyword.
-		_stream.next_in = const_cast<byte *>((const byte *)dataPtr);
-		_stream.avail_in = dataSize;
+		_stream->next_in = const_cast<byte *>((const byte *)dataPtr);
+		_stream->avail_in = dataSize;
 
 		// ... and flush it to disk
 		processData(Z_NO_FLUSH);
 
-		_pos += dataSize - _stream.avail_in;
-		return dataSize - _stream.avail_in;
+		_pos += dataSize - _stream->avail_in;
+		return dataSize - _stream->avail_in;
 	}
 
 	virtual int32 pos() const { return _pos; }
@@ -413,6 +673,20 @@ public:
 
 #endif	// USE_ZLIB
 
+#if defined(USE_ZLIB)
+SeekableReadStream *wrapDeflateReadStream(SeekableReadStream *toBeWrapped, uint32 uncompressedSize, uint32 crc) {
+	if (!toBeWrapped)
+		return 0;
+
+	InflateReadStream *stream = new InflateReadStream(toBeWrapped, true, uncompressedSize, crc);
+	if (stream->err()) {
+		delete stream;
+		return 0;
+	}
+	return stream;
+}
+#endif
+
 SeekableReadStream *wrapCompressedReadStream(SeekableReadStream *toBeWrapped, uint32 knownSize) {
 	if (toBeWrapped) {
 		uint16 header = toBeWrapped->readUint16BE();
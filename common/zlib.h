@@ -96,6 +96,27 @@ bool inflateZlibHeaderless(byte *dst, uint dstLen, const byte *src, uint srcLen,
  */
 bool inflateZlibInstallShield(byte *dst, uint dstLen, const byte *src, uint srcLen);
 
+/**
+ * Take a SeekableReadStream holding raw deflate data, i.e. without any zlib
+ * or gzip header, and wrap it in a custom stream which inflates it on the
+ * fly. Like the streams returned by wrapCompressedReadStream(), it is
+ * seekable, and resumes inflating from a recent checkpoint when seeking
+ * backwards.
+ *
+ * It is safe to call this with a NULL parameter (in this case, NULL is
+ * returned).
+ *
+ * @param toBeWrapped		the stream holding the compressed data. It is
+ *							destroyed together with the returned stream, or
+ *							right away if NULL is returned.
+ * @param uncompressedSize	the size of the uncompressed data.
+ * @param crc				the CRC-32 of the uncompressed data, which is
+ *							checked when the data is read from start to end.
+ *
+ * @return the wrapped stream, or NULL if zlib could not be set up.
+ */
+SeekableReadStream *wrapDeflateReadStream(SeekableReadStream *toBeWrapped, uint32 uncompressedSize, uint32 crc);
+
 #endif
 
 /**
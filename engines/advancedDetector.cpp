@@ -31,6 +31,7 @@
 #include "common/translation.h"
 #include "gui/EventRecorder.h"
 #include "engines/advancedDetector.h"
+#include "engines/md5cache.h"
 #include "engines/obsolete.h"
 
 static GameDescriptor toGameDescriptor(const ADGameDescription &g, const PlainGameDescriptor *sg) {
@@ -180,6 +181,9 @@ GameList AdvancedMetaEngine::detectGames(const Common::FSList &fslist) const {
 		}
 	}
 
+	// The files opened for detection are of no use for the game started later
+	Common::MacResManager::clearCache();
+
 	return detectedGames;
 }
 
@@ -405,13 +409,18 @@ bool AdvancedMetaEngine::getFileProperties(const Common::FSNode &parent, const F
 	if (!allFiles.contains(fname))
 		return false;
 
+	const Common::FSNode &node = allFiles[fname];
+	if (MD5CacheMan.lookup(node, _md5Bytes, fileProps.md5, fileProps.size))
+		return true;
+
 	Common::File testFile;
 
-	if (!testFile.open(allFiles[fname]))
+	if (!testFile.open(node))
 		return false;
 
 	fileProps.size = (int32)testFile.size();
 	fileProps.md5 = Common::computeStreamMD5AsString(testFile, _md5Bytes);
+	MD5CacheMan.store(node, _md5Bytes, fileProps.md5);
 	return true;
 }
 
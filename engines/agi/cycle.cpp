@@ -21,6 +21,7 @@
  */
 
 #include "common/config-manager.h"
+#include "common/trace.h"
 
 #include "agi/agi.h"
 #include "agi/sprite.h"
@@ -128,6 +129,8 @@ void AgiEngine::resetControllers() {
 }
 
 void AgiEngine::interpretCycle() {
+	TRACE_SCOPE("engine", "AgiEngine::interpretCycle");
+
 	ScreenObjEntry *screenObjEgo = &_game.screenObjTable[SCREENOBJECTS_EGO_ENTRY];
 	bool oldSound;
 	byte oldScore;
@@ -23,6 +23,7 @@
 #include "bladerunner/archive.h"
 
 #include "common/debug.h"
+#include "common/memstream.h"
 
 namespace BladeRunner {
 
@@ -150,6 +151,11 @@ Common::SeekableReadStream *MIXArchive::createReadStreamForMember(const Common::
 	uint32 start = _entries[i].offset + 6 + 12 * _entry_count;
 	uint32 end   = _entries[i].length + start;
 
+	// Use the data in place if the archive is mapped into memory
+	const byte *data = _fd.getDataPointer();
+	if (data)
+		return new Common::MemoryReadStream(data + start, end - start);
+
 	return new Common::SafeSeekableSubReadStream(&_fd, start, end, DisposeAfterUse::NO);
 }
 
@@ -40,10 +40,8 @@ void InventoryObject::synchronize(Common::Serializer &s) {
 		s.syncAsByte(_vocabList[i]._prepType);
 	}
 
-	for (int i = 0; i < MAX_QUALITIES; ++i)
-		s.syncAsByte(_qualityId[i]);
-	for (int i = 0; i < MAX_QUALITIES; ++i)
-		s.syncAsSint32LE(_qualityValue[i]);
+	s.syncArrayAsByte(_qualityId, MAX_QUALITIES);
+	s.syncArrayAsSint32LE(_qualityValue, MAX_QUALITIES);
 }
 
 bool InventoryObject::hasQuality(int qualityId) const {
@@ -395,23 +395,15 @@ void File::openFile(const Common::String &filename) {
 /*------------------------------------------------------------------------*/
 
 void SynchronizedList::synchronize(Common::Serializer &s) {
-	int v = 0;
 	int count = size();
 	s.syncAsUint16LE(count);
 
-	if (s.isSaving()) {
-		for (int idx = 0; idx < count; ++idx) {
-			v = (*this)[idx];
-			s.syncAsSint32LE(v);
-		}
-	} else {
+	if (s.isLoading()) {
 		clear();
-		reserve(count);
-		for (int idx = 0; idx < count; ++idx) {
-			s.syncAsSint32LE(v);
-			push_back(v);
-		}
+		resize(count);
 	}
+	if (count)
+		s.syncArrayAsSint32LE(&(*this)[0], count);
 }
 
 } // End of namespace MADS
@@ -0,0 +1,170 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "engines/md5cache.h"
+
+#include "common/config-manager.h"
+#include "common/debug.h"
+#include "common/fs.h"
+#include "common/savefile.h"
+#include "common/system.h"
+#include "common/textconsole.h"
+
+namespace Common {
+DECLARE_SINGLETON(MD5Cache);
+}
+
+static const char *const kMD5CacheFileName = "md5cache.dat";
+
+enum {
+	kMD5CacheVersion = 1,
+	kMD5CacheFlushInterval = 10000
+};
+
+static Common::String readString(Common::ReadStream *stream) {
+	uint16 len = stream->readUint16LE();
+	Common::String str;
+	for (uint16 i = 0; i < len; ++i)
+		str += (char)stream->readByte();
+	return str;
+}
+
+static void writeString(Common::WriteStream *stream, const Common::String &str) {
+	stream->writeUint16LE(str.size());
+	stream->write(str.c_str(), str.size());
+}
+
+MD5Cache::MD5Cache() : _loaded(false), _dirty(false), _lastFlush(0) {
+}
+
+MD5Cache::~MD5Cache() {
+	flush();
+}
+
+bool MD5Cache::isEnabled() const {
+	return !ConfMan.hasKey("md5_cache") || ConfMan.getBool("md5_cache");
+}
+
+Common::String MD5Cache::makeKey(const Common::FSNode &node, uint32 md5Bytes) {
+	return Common::String::format("%u:%s", md5Bytes, node.getPath().c_str());
+}
+
+bool MD5Cache::lookup(const Common::FSNode &node, uint32 md5Bytes, Common::String &md5, int32 &size) {
+	if (!isEnabled())
+		return false;
+
+	uint32 fileSize, modificationTime;
+	if (!node.getFileStat(fileSize, modificationTime))
+		return false;
+
+	load();
+
+	EntryMap::const_iterator i = _entries.find(makeKey(node, md5Bytes));
+	if (i == _entries.end() || i->_value.size != fileSize || i->_value.modificationTime != modificationTime)
+		return false;
+
+	md5 = i->_value.md5;
+	size = fileSize;
+	return true;
+}
+
+void MD5Cache::store(const Common::FSNode &node, uint32 md5Bytes, const Common::String &md5) {
+	if (!isEnabled())
+		return;
+
+	Entry entry;
+	if (!node.getFileStat(entry.size, entry.modificationTime))
+		return;
+	entry.md5 = md5;
+
+	load();
+
+	_entries[makeKey(node, md5Bytes)] = entry;
+	_dirty = true;
+}
+
+void MD5Cache::load() {
+	if (_loaded)
+		return;
+	_loaded = true;
+
+	Common::SaveFileManager *saveFileMan = g_system->getSavefileManager();
+	Common::InSaveFile *file = saveFileMan ? saveFileMan->openRawFile(kMD5CacheFileName) : 0;
+	if (!file)
+		return;
+
+	if (file->readUint32BE() != MKTAG('M', 'D', '5', 'C') || file->readUint32LE() != kMD5CacheVersion) {
+		warning("MD5Cache: Ignoring invalid '%s'", kMD5CacheFileName);
+		delete file;
+		return;
+	}
+
+	uint32 count = file->readUint32LE();
+	for (uint32 i = 0; i < count && !file->eos() && !file->err(); ++i) {
+		Common::String key = readString(file);
+		Entry entry;
+		entry.size = file->readUint32LE();
+		entry.modificationTime = file->readUint32LE();
+		entry.md5 = readString(file);
+
+		if (!file->eos() && !file->err())
+			_entries[key] = entry;
+	}
+
+	debug(2, "MD5Cache: Loaded %d entries", _entries.size());
+	delete file;
+}
+
+void MD5Cache::flush(bool force) {
+	if (!_dirty)
+		return;
+
+	uint32 now = g_system->getMillis();
+	if (!force && now - _lastFlush < kMD5CacheFlushInterval)
+		return;
+
+	Common::SaveFileManager *saveFileMan = g_system->getSavefileManager();
+	Common::OutSaveFile *file = saveFileMan ? saveFileMan->openForSaving(kMD5CacheFileName, false) : 0;
+	if (!file) {
+		warning("MD5Cache: Failed to open '%s' for writing", kMD5CacheFileName);
+		return;
+	}
+
+	file->writeUint32BE(MKTAG('M', 'D', '5', 'C'));
+	file->writeUint32LE(kMD5CacheVersion);
+	file->writeUint32LE(_entries.size());
+	for (EntryMap::const_iterator i = _entries.begin(); i != _entries.end(); ++i) {
+		writeString(file, i->_key);
+		file->writeUint32LE(i->_value.size);
+		file->writeUint32LE(i->_value.modificationTime);
+		writeString(file, i->_value.md5);
+	}
+
+	file->finalize();
+	if (file->err())
+		warning("MD5Cache: Failed to write '%s'", kMD5CacheFileName);
+	delete file;
+
+	debug(2, "MD5Cache: Wrote %d entries", _entries.size());
+	_dirty = false;
+	_lastFlush = now;
+}
@@ -0,0 +1,98 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef ENGINES_MD5CACHE_H
+#define ENGINES_MD5CACHE_H
+
+#include "common/hashmap.h"
+#include "common/hash-str.h"
+#include "common/singleton.h"
+#include "common/str.h"
+
+namespace Common {
+class FSNode;
+}
+
+/**
+ * Persistent cache of the MD5 checksums computed during game detection.
+ *
+ * Entries are keyed by the path of the file and the number of bytes that
+ * were hashed, and are only considered valid as long as the size and the
+ * modification time of the file did not change. The cache is shared by all
+ * meta engines and stored in the saves directory.
+ *
+ * Caching can be disabled with the "md5_cache" config option.
+ */
+class MD5Cache : public Common::Singleton<MD5Cache> {
+public:
+	MD5Cache();
+	~MD5Cache();
+
+	/**
+	 * Look up the MD5 checksum of the first md5Bytes bytes of a file.
+	 *
+	 * @param node		the file
+	 * @param md5Bytes	the number of bytes hashed, 0 for the whole file
+	 * @param md5		set to the cached checksum
+	 * @param size		set to the size of the file
+	 * @return true if a valid entry was found
+	 */
+	bool lookup(const Common::FSNode &node, uint32 md5Bytes, Common::String &md5, int32 &size);
+
+	/**
+	 * Add the MD5 checksum of the first md5Bytes bytes of a file to the
+	 * cache. Nothing is stored if the file modification time cannot be
+	 * determined.
+	 */
+	void store(const Common::FSNode &node, uint32 md5Bytes, const Common::String &md5);
+
+	/**
+	 * Write the cache to disk, if it has been modified.
+	 *
+	 * @param force	if false, writing is skipped when the cache was written
+	 *              less than a few seconds ago
+	 */
+	void flush(bool force = true);
+
+private:
+	struct Entry {
+		uint32 size;
+		uint32 modificationTime;
+		Common::String md5;
+	};
+
+	typedef Common::HashMap<Common::String, Entry> EntryMap;
+	EntryMap _entries;
+
+	bool _loaded;
+	bool _dirty;
+	uint32 _lastFlush;
+
+	bool isEnabled() const;
+	void load();
+	static Common::String makeKey(const Common::FSNode &node, uint32 md5Bytes);
+};
+
+/** Convenience shortcut for accessing the MD5 cache. */
+#define MD5CacheMan MD5Cache::instance()
+
+#endif
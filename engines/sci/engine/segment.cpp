@@ -36,6 +36,11 @@ namespace Sci {
 //#define GC_DEBUG // Debug garbage collection
 //#define GC_DEBUG_VERBOSE // Debug garbage verbosely
 
+Common::Arena &getSegmentArena() {
+	static Common::Arena arena("SCI segments");
+	return arena;
+}
+
 SegmentObj *SegmentObj::createSegmentObj(SegmentType type) {
 	SegmentObj *mem = 0;
 	switch (type) {
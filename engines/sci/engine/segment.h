@@ -23,6 +23,7 @@
 #ifndef SCI_ENGINE_SEGMENT_H
 #define SCI_ENGINE_SEGMENT_H
 
+#include "common/arena.h"
 #include "common/serializer.h"
 #include "common/str.h"
 #include "sci/engine/object.h"
@@ -77,10 +78,17 @@ enum SegmentType {
 	SEG_TYPE_MAX // For sanity checking
 };
 
+/**
+ * The arena all segment objects are allocated from.
+ */
+Common::Arena &getSegmentArena();
+
 struct SegmentObj : public Common::Serializable {
 	SegmentType _type;
 
 public:
+	DECLARE_ARENA_ALLOCATED(getSegmentArena())
+
 	static SegmentObj *createSegmentObj(SegmentType type);
 
 public:
@@ -45,6 +45,10 @@ public:
 	virtual int32 size() const = 0;
 	virtual bool seek(int32 offs, int whence = SEEK_SET) = 0;
 
+	// The data has to go through read(), which decrypts it and keeps to the
+	// current subfile, so the raw bytes of the file must not be handed out
+	virtual const byte *getDataPointer() const { return 0; }
+
 // Unused
 #if 0
 	virtual bool eos() const = 0;
@@ -25,6 +25,7 @@
 #include "common/md5.h"
 #include "common/events.h"
 #include "common/system.h"
+#include "common/trace.h"
 #include "common/translation.h"
 
 #include "engines/util.h"
@@ -2183,6 +2184,8 @@ void ScummEngine_v0::scummLoop(int delta) {
 }
 
 void ScummEngine::scummLoop(int delta) {
+	TRACE_SCOPE("engine", "ScummEngine::scummLoop");
+
 	if (_game.version >= 3) {
 		VAR(VAR_TMR_1) += delta;
 		VAR(VAR_TMR_2) += delta;
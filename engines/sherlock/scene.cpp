@@ -1392,11 +1392,8 @@ void Scene::synchronize(Serializer &s) {
 		s.syncAsSint16LE(_goToScene);
 	}
 
-	for (int sceneNum = 1; sceneNum < SCENES_COUNT; ++sceneNum) {
-		for (int flag = 0; flag <= MAX_BGSHAPES; ++flag) {
-			s.syncAsByte(_sceneStats[sceneNum][flag]);
-		}
-	}
+	for (int sceneNum = 1; sceneNum < SCENES_COUNT; ++sceneNum)
+		s.syncArrayAsByte(_sceneStats[sceneNum], MAX_BGSHAPES + 1);
 }
 
 void Scene::checkBgShapes() {
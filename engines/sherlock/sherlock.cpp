@@ -261,8 +261,8 @@ void SherlockEngine::syncSoundSettings() {
 }
 
 void SherlockEngine::synchronize(Serializer &s) {
-	for (uint idx = 0; idx < _flags.size(); ++idx)
-		s.syncAsByte(_flags[idx]);
+	if (!_flags.empty())
+		s.syncArrayAsByte(&_flags[0], _flags.size());
 }
 
 bool SherlockEngine::canLoadGameStateCurrently() {
@@ -948,12 +948,8 @@ void Talk::popStack() {
 }
 
 void Talk::synchronize(Serializer &s) {
-	for (uint idx = 0; idx < _talkHistory.size(); ++idx) {
-		TalkHistoryEntry &he = _talkHistory[idx];
-
-		for (int flag = 0; flag < 16; ++flag)
-			s.syncAsByte(he._data[flag]);
-	}
+	for (uint idx = 0; idx < _talkHistory.size(); ++idx)
+		s.syncArrayAsByte(_talkHistory[idx]._data, 16);
 }
 
 OpcodeReturn Talk::cmdAddItemToInventory(const byte *&str) {
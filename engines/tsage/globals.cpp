@@ -205,8 +205,7 @@ void Globals::synchronize(Serializer &s) {
 
 	s.syncAsSint16LE(_dialogCenter.x); s.syncAsSint16LE(_dialogCenter.y);
 	_sounds.synchronize(s);
-	for (int i = 0; i < 256; ++i)
-		s.syncAsByte(_flags[i]);
+	s.syncArrayAsByte(_flags, 256);
 
 	s.syncAsSint16LE(_sceneOffset.x); s.syncAsSint16LE(_sceneOffset.y);
 	s.syncAsSint16LE(_prevSceneOffset.x); s.syncAsSint16LE(_prevSceneOffset.y);
@@ -647,10 +646,8 @@ void Ringworld2Globals::synchronize(Serializer &s) {
 	s.syncAsByte(_ductMazePanel2State);
 	s.syncAsByte(_ductMazePanel3State);
 
-	for (i = 0; i < 14; ++i)
-		s.syncAsByte(_spillLocation[i]);
-	for (i = 0; i < 1000; ++i)
-		s.syncAsByte(_desertMovements[i]);
+	s.syncArrayAsByte(_spillLocation, 14);
+	s.syncArrayAsByte(_desertMovements, 1000);
 	s.syncAsByte(_balloonAltitude);
 	for (i = 0; i < 12; ++i)
 		s.syncAsByte(_stripManager_lookupList[i]);
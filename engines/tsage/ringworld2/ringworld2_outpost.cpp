@@ -159,8 +159,7 @@ void Scene1337::synchronize(Serializer &s) {
 	s.syncAsSint16LE(_cursorCurStrip);
 	s.syncAsSint16LE(_cursorCurFrame);
 
-	for (int i = 0; i < 100; i++)
-		s.syncAsSint16LE(_availableCardsPile[i]);
+	s.syncArrayAsSint16LE(_availableCardsPile, 100);
 
 }
 
@@ -5952,8 +5952,7 @@ void Scene600::synchronize(Serializer &s) {
 	SceneExt::synchronize(s);
 
 	s.syncAsSint16LE(_roomState);
-	for (int i = 0; i < 256; i++)
-		s.syncAsByte(_pixelMap[i]);
+	s.syncArrayAsByte(_pixelMap, 256);
 }
 
 bool Scene600::Scanner::startAction(CursorType action, Event &event) {
@@ -33,6 +33,7 @@
 #include "common/rect.h"
 #include "graphics/surface.h"
 #include "common/list.h"
+#include "graphics/transform_cache.h"
 #include "graphics/transform_struct.h"
 
 namespace Wintermute {
@@ -80,6 +81,8 @@ public:
 
 	void invalidateTicket(RenderTicket *renderTicket);
 	void invalidateTicketsFromSurface(BaseSurfaceOSystem *surf);
+	/** The scaled and rotoscaled surfaces of the tickets, see RenderTicket. */
+	Graphics::TransformCache &getTransformCache() { return _transformCache; }
 	/**
 	 * Insert a new ticket into the queue, adding a dirty rect
 	 * @param renderTicket the ticket to be added.
@@ -128,6 +131,7 @@ private:
 	void drawFromSurface(RenderTicket *ticket, Common::Rect *dstRect, Common::Rect *clipRect);
 	Common::Rect *_dirtyRect;
 	Common::List<RenderTicket *> _renderQueue;
+	Graphics::TransformCache _transformCache;
 
 	bool _needsFlip;
 	RenderQueueIterator _lastFrameIter;
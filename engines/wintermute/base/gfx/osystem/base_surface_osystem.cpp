@@ -188,6 +188,10 @@ bool BaseSurfaceOSystem::finishLoad() {
 
 	_loaded = true;
 
+	// The transformed surfaces of the old image are stale now
+	BaseRenderOSystem *renderer = static_cast<BaseRenderOSystem *>(_gameRef->_renderer);
+	renderer->invalidateTicketsFromSurface(this);
+
 	return true;
 }
 
@@ -30,6 +30,7 @@
 #include "engines/wintermute/base/base_game.h"
 #include "engines/wintermute/base/gfx/osystem/render_ticket.h"
 #include "engines/wintermute/base/gfx/osystem/base_surface_osystem.h"
+#include "engines/wintermute/base/gfx/osystem/base_render_osystem.h"
 #include "graphics/transform_tools.h"
 #include "common/textconsole.h"
 
@@ -43,14 +44,8 @@ RenderTicket::RenderTicket(BaseSurfaceOSystem *owner, const Graphics::Surface *s
 	_wantsDraw(true),
 	_transform(transform) {
 	if (surf) {
-		_surface = new Graphics::Surface();
-		_surface->create((uint16)srcRect->width(), (uint16)srcRect->height(), surf->format);
-		assert(_surface->format.bytesPerPixel == 4);
-		// Get a clipped copy of the surface
-		for (int i = 0; i < _surface->h; i++) {
-			memcpy(_surface->getBasePtr(0, i), surf->getBasePtr(srcRect->left, srcRect->top + i), srcRect->width() * _surface->format.bytesPerPixel);
-		}
-		// Then scale it if necessary
+		assert(surf->format.bytesPerPixel == 4);
+		// Scale the surface if necessary
 		//
 		// NB: The numTimesX/numTimesY properties don't yet mix well with
 		// scaling and rotation, but there is no need for that functionality at
@@ -59,40 +54,54 @@ RenderTicket::RenderTicket(BaseSurfaceOSystem *owner, const Graphics::Surface *s
 		// (Mirroring should most likely be done before rotation. See also
 		// TransformTools.)
 		if (_transform._angle != Graphics::kDefaultAngle) {
-			Graphics::TransparentSurface src(*_surface, false);
-			Graphics::Surface *temp;
-			if (owner->_gameRef->getBilinearFiltering()) {
-				temp = src.rotoscaleT<Graphics::FILTER_BILINEAR>(transform);
-			} else {
-				temp = src.rotoscaleT<Graphics::FILTER_NEAREST>(transform);
-			}
-			_surface->free();
-			delete _surface;
-			_surface = temp;
+			_surface = transformSurface(surf, true);
 		} else if ((dstRect->width() != srcRect->width() ||
 					dstRect->height() != srcRect->height()) &&
 					_transform._numTimesX * _transform._numTimesY == 1) {
-			Graphics::TransparentSurface src(*_surface, false);
-			Graphics::Surface *temp;
-			if (owner->_gameRef->getBilinearFiltering()) {
-				temp = src.scaleT<Graphics::FILTER_BILINEAR>(dstRect->width(), dstRect->height());
-			} else {
-				temp = src.scaleT<Graphics::FILTER_NEAREST>(dstRect->width(), dstRect->height());
+			_surface = transformSurface(surf, false);
+		} else {
+			// Get a clipped copy of the surface
+			Graphics::Surface *copy = new Graphics::Surface();
+			copy->create((uint16)srcRect->width(), (uint16)srcRect->height(), surf->format);
+			for (int i = 0; i < copy->h; i++) {
+				memcpy(copy->getBasePtr(0, i), surf->getBasePtr(srcRect->left, srcRect->top + i), srcRect->width() * copy->format.bytesPerPixel);
 			}
-			_surface->free();
-			delete _surface;
-			_surface = temp;
+			_surface = SurfacePtr(copy, Graphics::SharedPtrSurfaceDeleter());
 		}
-	} else {
-		_surface = nullptr;
 	}
 }
 
-RenderTicket::~RenderTicket() {
-	if (_surface) {
-		_surface->free();
-		delete _surface;
+RenderTicket::SurfacePtr RenderTicket::transformSurface(const Graphics::Surface *surf, bool rotate) const {
+	const Graphics::TFilteringMode filteringMode = _owner->_gameRef->getBilinearFiltering() ? Graphics::FILTER_BILINEAR : Graphics::FILTER_NEAREST;
+
+	// Sprites are often drawn with the same transform for many frames in a
+	// row, so the results are kept in a cache of the renderer
+	Graphics::TransformCache &cache = static_cast<BaseRenderOSystem *>(_owner->_gameRef->_renderer)->getTransformCache();
+	const Graphics::TransformCache::Key key(_owner, _srcRect, _transform, (uint16)_dstRect.width(), (uint16)_dstRect.height(), filteringMode);
+	SurfacePtr result = cache.lookup(key);
+	if (result)
+		return result;
+
+	// The clipped area is transformed in place, it does not need to be copied
+	const Graphics::TransparentSurface src(surf->getSubArea(_srcRect), false);
+	Graphics::Surface *temp;
+	if (rotate) {
+		if (filteringMode == Graphics::FILTER_BILINEAR) {
+			temp = src.rotoscaleT<Graphics::FILTER_BILINEAR>(_transform);
+		} else {
+			temp = src.rotoscaleT<Graphics::FILTER_NEAREST>(_transform);
+		}
+	} else {
+		if (filteringMode == Graphics::FILTER_BILINEAR) {
+			temp = src.scaleT<Graphics::FILTER_BILINEAR>(_dstRect.width(), _dstRect.height());
+		} else {
+			temp = src.scaleT<Graphics::FILTER_NEAREST>(_dstRect.width(), _dstRect.height());
+		}
 	}
+
+	result = SurfacePtr(temp, Graphics::SharedPtrSurfaceDeleter());
+	cache.insert(key, result);
+	return result;
 }
 
 bool RenderTicket::operator==(const RenderTicket &t) const {
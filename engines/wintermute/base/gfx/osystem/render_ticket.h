@@ -31,6 +31,7 @@
 
 #include "graphics/transparent_surface.h"
 #include "graphics/surface.h"
+#include "common/ptr.h"
 #include "common/rect.h"
 
 namespace Wintermute {
@@ -53,8 +54,7 @@ class RenderTicket {
 public:
 	RenderTicket(BaseSurfaceOSystem *owner, const Graphics::Surface *surf, Common::Rect *srcRect, Common::Rect *dstRest, Graphics::TransformStruct transform);
 	RenderTicket() : _isValid(true), _wantsDraw(false), _transform(Graphics::TransformStruct()) {}
-	~RenderTicket();
-	const Graphics::Surface *getSurface() const { return _surface; }
+	const Graphics::Surface *getSurface() const { return _surface.get(); }
 	// Non-dirty-rects:
 	void drawToSurface(Graphics::Surface *_targetSurface) const;
 	// Dirty-rects:
@@ -71,8 +71,14 @@ public:
 	bool operator==(const RenderTicket &a) const;
 	const Common::Rect *getSrcRect() const { return &_srcRect; }
 private:
-	Graphics::Surface *_surface;
+	typedef Common::SharedPtr<Graphics::Surface> SurfacePtr;
+
+	/** The surface may be shared with other tickets, through the transform cache. */
+	SurfacePtr _surface;
 	Common::Rect _srcRect;
+
+	/** Scale or rotoscale the clipped area of surf, or take the result from the cache. */
+	SurfacePtr transformSurface(const Graphics::Surface *surf, bool rotate) const;
 };
 
 } // End of namespace Wintermute
@@ -25,6 +25,14 @@
 
 #include "common/endian.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CONVERSION_USE_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define CONVERSION_USE_NEON
+#include <arm_neon.h>
+#endif
+
 namespace Graphics {
 
 // TODO: YUV to RGB conversion function
@@ -96,6 +104,313 @@ inline void crossBlitLogic3BppSource(byte *dst, const byte *src, const uint w, c
 	}
 }
 
+/**
+ * The conversion between two formats, as a list of channels to move. Each
+ * channel is taken from the source pixel, expanded to 8 bits the way
+ * PixelFormat::colorToARGB() does it, and stored with the loss of the
+ * destination format, like PixelFormat::ARGBToColor() does.
+ */
+struct ChannelRemap {
+	struct Channel {
+		int srcShift;
+		int srcBits;
+		int dstShift;
+		int dstLoss;
+	};
+
+	Channel channels[4];
+	int numChannels;
+	/** Constant bits of every pixel: the alpha of sources without alpha. */
+	uint32 fill;
+};
+
+/**
+ * Prepare the conversion between two formats. This fails for formats with
+ * channels of 1 to 3 bits, which are expanded differently.
+ */
+bool prepareRemap(const PixelFormat &srcFmt, const PixelFormat &dstFmt, ChannelRemap &remap) {
+	const int srcShift[4] = { srcFmt.aShift, srcFmt.rShift, srcFmt.gShift, srcFmt.bShift };
+	const int srcBits[4] = { srcFmt.aBits(), srcFmt.rBits(), srcFmt.gBits(), srcFmt.bBits() };
+	const int dstShift[4] = { dstFmt.aShift, dstFmt.rShift, dstFmt.gShift, dstFmt.bShift };
+	const int dstLoss[4] = { dstFmt.aLoss, dstFmt.rLoss, dstFmt.gLoss, dstFmt.bLoss };
+
+	remap.numChannels = 0;
+	remap.fill = 0;
+	for (int i = 0; i < 4; ++i) {
+		if (srcBits[i] > 0 && srcBits[i] < 4)
+			return false;
+		if (dstLoss[i] == 8)
+			continue;
+
+		if (srcBits[i] == 0) {
+			// colorToARGB() gives full alpha, and 0 for missing colors
+			if (i == 0)
+				remap.fill |= (0xFF >> dstLoss[i]) << dstShift[i];
+			continue;
+		}
+
+		ChannelRemap::Channel &channel = remap.channels[remap.numChannels++];
+		channel.srcShift = srcShift[i];
+		channel.srcBits = srcBits[i];
+		channel.dstShift = dstShift[i];
+		channel.dstLoss = dstLoss[i];
+	}
+	return true;
+}
+
+inline uint32 remapPixel(uint32 color, const ChannelRemap &remap) {
+	uint32 result = remap.fill;
+	for (int i = 0; i < remap.numChannels; ++i) {
+		const ChannelRemap::Channel &channel = remap.channels[i];
+		// Repeat the top bits in the low bits, for 4 to 8 bit channels
+		const uint32 value = (color >> channel.srcShift) & ((1 << channel.srcBits) - 1);
+		const uint32 expanded = ((value << (8 - channel.srcBits)) | (value >> (2 * channel.srcBits - 8))) & 0xFF;
+		result |= (expanded >> channel.dstLoss) << channel.dstShift;
+	}
+	return result;
+}
+
+inline uint32 readPixel(const byte *src, uint bytesPerPixel) {
+	if (bytesPerPixel == 2)
+		return *(const uint16 *)src;
+	else if (bytesPerPixel == 3)
+		return READ_UINT24(src);
+	return *(const uint32 *)src;
+}
+
+inline void writePixel(byte *dst, uint bytesPerPixel, uint32 color) {
+	if (bytesPerPixel == 2)
+		*(uint16 *)dst = color;
+	else
+		*(uint32 *)dst = color;
+}
+
+/**
+ * The conversion between two formats with 8 bit channels at byte
+ * boundaries, which only moves bytes around within each pixel. Each byte
+ * of a destination pixel is a byte of the source pixel rotated left by 0,
+ * 8, 16 or 24 bits; masks[i] selects the bytes taken from the rotation by
+ * 8 * i.
+ */
+struct ByteShuffle {
+	uint32 masks[4];
+	/** Constant bits of every pixel: the alpha of sources without alpha. */
+	uint32 fill;
+};
+
+/**
+ * Prepare the conversion of 3 or 4 byte pixels to 4 byte pixels by moving
+ * bytes. This fails unless all channels have 8 bits at byte boundaries.
+ */
+bool prepareShuffle(const PixelFormat &srcFmt, const PixelFormat &dstFmt, ByteShuffle &shuffle) {
+	if ((srcFmt.bytesPerPixel != 3 && srcFmt.bytesPerPixel != 4) || dstFmt.bytesPerPixel != 4)
+		return false;
+
+	const int srcShift[4] = { srcFmt.aShift, srcFmt.rShift, srcFmt.gShift, srcFmt.bShift };
+	const int srcBits[4] = { srcFmt.aBits(), srcFmt.rBits(), srcFmt.gBits(), srcFmt.bBits() };
+	const int dstShift[4] = { dstFmt.aShift, dstFmt.rShift, dstFmt.gShift, dstFmt.bShift };
+	const int dstLoss[4] = { dstFmt.aLoss, dstFmt.rLoss, dstFmt.gLoss, dstFmt.bLoss };
+
+	memset(shuffle.masks, 0, sizeof(shuffle.masks));
+	shuffle.fill = 0;
+	for (int i = 0; i < 4; ++i) {
+		if (dstLoss[i] == 8)
+			continue;
+		if (dstLoss[i] != 0 || (dstShift[i] & 7))
+			return false;
+
+		if (srcBits[i] == 0) {
+			// colorToARGB() gives full alpha, and 0 for missing colors
+			if (i == 0)
+				shuffle.fill |= 0xFFU << dstShift[i];
+			continue;
+		}
+		if (srcBits[i] != 8 || (srcShift[i] & 7))
+			return false;
+
+		shuffle.masks[((dstShift[i] - srcShift[i]) & 31) / 8] |= 0xFFU << dstShift[i];
+	}
+	return true;
+}
+
+inline uint32 shufflePixel(uint32 color, const ByteShuffle &shuffle) {
+	return shuffle.fill
+		| (color & shuffle.masks[0])
+		| (((color << 8) | (color >> 24)) & shuffle.masks[1])
+		| (((color << 16) | (color >> 16)) & shuffle.masks[2])
+		| (((color << 24) | (color >> 8)) & shuffle.masks[3]);
+}
+
+#if defined(CONVERSION_USE_SSE2) || defined(CONVERSION_USE_NEON)
+
+/*
+ * The same conversion for four 2 or 4 byte pixels at a time, with one
+ * 32 bit lane per pixel.
+ */
+
+#if defined(CONVERSION_USE_SSE2)
+
+typedef __m128i conv_vec;
+
+static inline conv_vec vecLoad4(const byte *src, uint bytesPerPixel) {
+	if (bytesPerPixel == 2)
+		return _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i *)src), _mm_setzero_si128());
+	return _mm_loadu_si128((const __m128i *)src);
+}
+static inline void vecStore4(byte *dst, uint bytesPerPixel, conv_vec v) {
+	if (bytesPerPixel == 2) {
+		// Sign extend the lanes, so that the saturation does not change them
+		v = _mm_srai_epi32(_mm_slli_epi32(v, 16), 16);
+		_mm_storel_epi64((__m128i *)dst, _mm_packs_epi32(v, v));
+	} else {
+		_mm_storeu_si128((__m128i *)dst, v);
+	}
+}
+static inline conv_vec vecSplat(uint32 x) { return _mm_set1_epi32(x); }
+static inline conv_vec vecAnd(conv_vec a, conv_vec b) { return _mm_and_si128(a, b); }
+static inline conv_vec vecOr(conv_vec a, conv_vec b) { return _mm_or_si128(a, b); }
+static inline conv_vec vecShiftLeft(conv_vec a, int n) { return _mm_sll_epi32(a, _mm_cvtsi32_si128(n)); }
+static inline conv_vec vecShiftRight(conv_vec a, int n) { return _mm_srl_epi32(a, _mm_cvtsi32_si128(n)); }
+
+/** Load four 3 byte pixels into the low bytes of the lanes. */
+static inline conv_vec vecLoad4x24(const byte *src) {
+	// Exactly the twelve bytes of the pixels, so nothing past a row is read
+	const __m128i v = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *)src), _mm_cvtsi32_si128(READ_UINT32(src + 8)));
+	const __m128i p01 = _mm_unpacklo_epi32(v, _mm_srli_si128(v, 3));
+	const __m128i p23 = _mm_unpacklo_epi32(_mm_srli_si128(v, 6), _mm_srli_si128(v, 9));
+	return _mm_and_si128(_mm_unpacklo_epi64(p01, p23), _mm_set1_epi32(0xFFFFFF));
+}
+
+#elif defined(CONVERSION_USE_NEON)
+
+typedef uint32x4_t conv_vec;
+
+static inline conv_vec vecLoad4(const byte *src, uint bytesPerPixel) {
+	if (bytesPerPixel == 2)
+		return vmovl_u16(vld1_u16((const uint16 *)src));
+	return vld1q_u32((const uint32 *)src);
+}
+static inline void vecStore4(byte *dst, uint bytesPerPixel, conv_vec v) {
+	if (bytesPerPixel == 2)
+		vst1_u16((uint16 *)dst, vmovn_u32(v));
+	else
+		vst1q_u32((uint32 *)dst, v);
+}
+static inline conv_vec vecSplat(uint32 x) { return vdupq_n_u32(x); }
+static inline conv_vec vecAnd(conv_vec a, conv_vec b) { return vandq_u32(a, b); }
+static inline conv_vec vecOr(conv_vec a, conv_vec b) { return vorrq_u32(a, b); }
+static inline conv_vec vecShiftLeft(conv_vec a, int n) { return vshlq_u32(a, vdupq_n_s32(n)); }
+static inline conv_vec vecShiftRight(conv_vec a, int n) { return vshlq_u32(a, vdupq_n_s32(-n)); }
+
+/** Load four 3 byte pixels into the low bytes of the lanes. */
+static inline conv_vec vecLoad4x24(const byte *src) {
+	// Exactly the twelve bytes of the pixels, so nothing past a row is read
+	const uint8x16_t v = vcombine_u8(vld1_u8(src), vreinterpret_u8_u32(vdup_n_u32(READ_UINT32(src + 8))));
+	conv_vec p = vreinterpretq_u32_u8(v);
+	p = vsetq_lane_u32(vgetq_lane_u32(vreinterpretq_u32_u8(vextq_u8(v, v, 3)), 0), p, 1);
+	p = vsetq_lane_u32(vgetq_lane_u32(vreinterpretq_u32_u8(vextq_u8(v, v, 6)), 0), p, 2);
+	p = vsetq_lane_u32(vgetq_lane_u32(vreinterpretq_u32_u8(vextq_u8(v, v, 9)), 0), p, 3);
+	return vandq_u32(p, vdupq_n_u32(0xFFFFFF));
+}
+
+#endif
+
+static inline conv_vec remapPixels(conv_vec color, const ChannelRemap &remap) {
+	conv_vec result = vecSplat(remap.fill);
+	for (int i = 0; i < remap.numChannels; ++i) {
+		const ChannelRemap::Channel &channel = remap.channels[i];
+		const conv_vec value = vecAnd(vecShiftRight(color, channel.srcShift), vecSplat((1 << channel.srcBits) - 1));
+		const conv_vec expanded = vecOr(vecShiftLeft(value, 8 - channel.srcBits), vecShiftRight(value, 2 * channel.srcBits - 8));
+		result = vecOr(result, vecShiftLeft(vecShiftRight(vecAnd(expanded, vecSplat(0xFF)), channel.dstLoss), channel.dstShift));
+	}
+	return result;
+}
+
+static inline conv_vec shufflePixels(conv_vec color, const ByteShuffle &shuffle) {
+	conv_vec result = vecOr(vecSplat(shuffle.fill), vecAnd(color, vecSplat(shuffle.masks[0])));
+	for (int i = 1; i < 4; ++i) {
+		const conv_vec rotated = vecOr(vecShiftLeft(color, 8 * i), vecShiftRight(color, 32 - 8 * i));
+		result = vecOr(result, vecAnd(rotated, vecSplat(shuffle.masks[i])));
+	}
+	return result;
+}
+
+#endif
+
+/**
+ * Convert the pixels of one row with the given remapping. Rows are
+ * converted from right to left when the destination pixels are bigger,
+ * so that they can be converted in place.
+ */
+void remapRow(byte *dst, const byte *src, uint w, uint srcBpp, uint dstBpp, const ChannelRemap &remap) {
+	if (dstBpp <= srcBpp) {
+		uint x = 0;
+#if defined(CONVERSION_USE_SSE2) || defined(CONVERSION_USE_NEON)
+		if (srcBpp != 3) {
+			for (; x + 4 <= w; x += 4)
+				vecStore4(dst + x * dstBpp, dstBpp, remapPixels(vecLoad4(src + x * srcBpp, srcBpp), remap));
+		}
+#endif
+		for (; x < w; ++x)
+			writePixel(dst + x * dstBpp, dstBpp, remapPixel(readPixel(src + x * srcBpp, srcBpp), remap));
+	} else {
+		uint x = w;
+#if defined(CONVERSION_USE_SSE2) || defined(CONVERSION_USE_NEON)
+		if (srcBpp != 3) {
+			for (; x >= 4; x -= 4) {
+				// All four source pixels are loaded before any of them is overwritten
+				vecStore4(dst + (x - 4) * dstBpp, dstBpp, remapPixels(vecLoad4(src + (x - 4) * srcBpp, srcBpp), remap));
+			}
+		}
+#endif
+		while (x-- > 0)
+			writePixel(dst + x * dstBpp, dstBpp, remapPixel(readPixel(src + x * srcBpp, srcBpp), remap));
+	}
+}
+
+/**
+ * Convert the 3 or 4 byte pixels of one row to 4 byte pixels by moving
+ * bytes. Rows are converted from right to left, so that they can be
+ * converted in place.
+ */
+void shuffleRow(byte *dst, const byte *src, uint w, uint srcBpp, const ByteShuffle &shuffle) {
+	uint x = w;
+#if defined(CONVERSION_USE_SSE2) || defined(CONVERSION_USE_NEON)
+	if (srcBpp == 4) {
+		for (; x >= 4; x -= 4)
+			vecStore4(dst + (x - 4) * 4, 4, shufflePixels(vecLoad4(src + (x - 4) * 4, 4), shuffle));
+	}
+#ifdef SCUMM_LITTLE_ENDIAN
+	else {
+		for (; x >= 4; x -= 4)
+			vecStore4(dst + (x - 4) * 4, 4, shufflePixels(vecLoad4x24(src + (x - 4) * 3), shuffle));
+	}
+#endif
+#endif
+	while (x-- > 0)
+		*(uint32 *)(dst + x * 4) = shufflePixel(readPixel(src + x * srcBpp, srcBpp), shuffle);
+}
+
+template<typename DstColor>
+void crossBlitMapLogic(byte *dst, const byte *src, const uint w, const uint h,
+                       const uint dstPitch, const uint srcPitch, const uint32 *map) {
+	// Bottom up and from right to left, like for the other conversions to
+	// bigger pixels
+	for (uint y = h; y-- > 0;) {
+		const byte *srcRow = src + y * srcPitch;
+		DstColor *dstRow = (DstColor *)(dst + y * dstPitch);
+		uint x = w;
+		for (; x >= 4; x -= 4) {
+			dstRow[x - 1] = map[srcRow[x - 1]];
+			dstRow[x - 2] = map[srcRow[x - 2]];
+			dstRow[x - 3] = map[srcRow[x - 3]];
+			dstRow[x - 4] = map[srcRow[x - 4]];
+		}
+		while (x-- > 0)
+			dstRow[x] = map[srcRow[x]];
+	}
+}
+
 } // End of anonymous namespace
 
 // Function to blit a rect from one color format to another
@@ -126,6 +441,30 @@ bool crossBlit(byte *dst, const byte *src,
 		return true;
 	}
 
+	// Conversions between 8 bit channels only move bytes around
+	ByteShuffle shuffle;
+	if (prepareShuffle(srcFmt, dstFmt, shuffle)) {
+		// Bottom up, to allow converting in place, see below
+		for (uint y = h; y-- > 0;)
+			shuffleRow(dst + y * dstPitch, src + y * srcPitch, w, srcFmt.bytesPerPixel, shuffle);
+		return true;
+	}
+
+	// Most other conversions only move the channels around, which is done
+	// for four pixels at a time where possible
+	ChannelRemap remap;
+	if (prepareRemap(srcFmt, dstFmt, remap)) {
+		if (dstFmt.bytesPerPixel > srcFmt.bytesPerPixel) {
+			// Bottom up, to allow converting in place, see below
+			for (uint y = h; y-- > 0;)
+				remapRow(dst + y * dstPitch, src + y * srcPitch, w, srcFmt.bytesPerPixel, dstFmt.bytesPerPixel, remap);
+		} else {
+			for (uint y = 0; y < h; ++y)
+				remapRow(dst + y * dstPitch, src + y * srcPitch, w, srcFmt.bytesPerPixel, dstFmt.bytesPerPixel, remap);
+		}
+		return true;
+	}
+
 	// Faster, but larger, to provide optimized handling for each case.
 	const uint srcDelta = (srcPitch - w * srcFmt.bytesPerPixel);
 	const uint dstDelta = (dstPitch - w * dstFmt.bytesPerPixel);
@@ -167,4 +506,22 @@ bool crossBlit(byte *dst, const byte *src,
 	return true;
 }
 
+void convertPaletteToMap(uint32 *dst, const byte *src, uint colors, const Graphics::PixelFormat &format) {
+	for (uint i = 0; i < colors; ++i)
+		dst[i] = format.RGBToColor(src[i * 3], src[i * 3 + 1], src[i * 3 + 2]);
+}
+
+bool crossBlitMap(byte *dst, const byte *src,
+                  const uint dstPitch, const uint srcPitch,
+                  const uint w, const uint h,
+                  const uint bytesPerPixel, const uint32 *map) {
+	if (bytesPerPixel == 2)
+		crossBlitMapLogic<uint16>(dst, src, w, h, dstPitch, srcPitch, map);
+	else if (bytesPerPixel == 4)
+		crossBlitMapLogic<uint32>(dst, src, w, h, dstPitch, srcPitch, map);
+	else
+		return false;
+	return true;
+}
+
 } // End of namespace Graphics
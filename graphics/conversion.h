@@ -72,6 +72,39 @@ bool crossBlit(byte *dst, const byte *src,
                const uint w, const uint h,
                const Graphics::PixelFormat &dstFmt, const Graphics::PixelFormat &srcFmt);
 
+/**
+ * Converts palette entries to colors of the given format, to be used as
+ * map for crossBlitMap.
+ *
+ * @param dst		the buffer which will recieve the colors
+ * @param src		the palette, three bytes (RGB) per color
+ * @param colors	the number of palette entries to convert
+ * @param format	the format of the colors
+ */
+void convertPaletteToMap(uint32 *dst, const byte *src, uint colors, const Graphics::PixelFormat &format);
+
+/**
+ * Blits a rectangle of palette indices to a 2Bpp or 4Bpp format.
+ *
+ * @param dst			the buffer which will recieve the converted graphics data
+ * @param src			the buffer containing the palette indices
+ * @param dstPitch		width in bytes of one full line of the dest buffer
+ * @param srcPitch		width in bytes of one full line of the source buffer
+ * @param w				the width of the graphics data
+ * @param h				the height of the graphics data
+ * @param bytesPerPixel	the size of the destination pixels, 2 or 4
+ * @param map			the color of each of the 256 palette indices,
+ *						in the destination format
+ * @return				true if conversion completes successfully,
+ *						false if there is an error.
+ *
+ * @note Like crossBlit, this can convert in place.
+ */
+bool crossBlitMap(byte *dst, const byte *src,
+                  const uint dstPitch, const uint srcPitch,
+                  const uint w, const uint h,
+                  const uint bytesPerPixel, const uint32 *map);
+
 } // End of namespace Graphics
 
 #endif // GRAPHICS_CONVERSION_H
@@ -26,6 +26,16 @@
 #include "common/system.h"
 #include "common/textconsole.h"
 
+#ifdef USE_HQ_SCALERS
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HQ_USE_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define HQ_USE_NEON
+#include <arm_neon.h>
+#endif
+#endif
+
 int gBitFormat = 565;
 
 #ifdef USE_HQ_SCALERS
@@ -81,6 +91,26 @@ uint32 hqx_green_redBlue_Mask = 0;
 uint32 *RGBtoYUV = 0;
 }
 
+/**
+ * The row buffers of the hq scalers, see getHQRowBuffers(). They are grown
+ * when a wider area is scaled, and freed by DestroyScalers().
+ */
+static uint32 *hqRowBuffer = 0;
+static int hqRowBufferWidth = 0;
+
+void getHQRowBuffers(int width, uint32 *&yuvRows, uint16 *&patterns) {
+	if (width > hqRowBufferWidth) {
+		free(hqRowBuffer);
+		hqRowBuffer = (uint32 *)malloc(3 * (width + 2) * sizeof(uint32) + width * sizeof(uint16));
+		if (!hqRowBuffer)
+			error("[getHQRowBuffers] Cannot allocate memory for the row buffers");
+		hqRowBufferWidth = width;
+	}
+
+	yuvRows = hqRowBuffer;
+	patterns = (uint16 *)(hqRowBuffer + 3 * (width + 2));
+}
+
 void InitLUT(Graphics::PixelFormat format) {
 	uint8 r, g, b;
 	int Y, u, v;
@@ -117,6 +147,108 @@ void InitLUT(Graphics::PixelFormat format) {
 	hqx_green_redBlue_Mask = (hqx_greenMask << 16) | hqx_redBlueMask;
 #endif
 }
+
+void convertToHQYUV(uint32 *dst, const uint16 *src, int count) {
+	for (int i = 0; i < count; ++i)
+		dst[i] = RGBtoYUV[src[i]];
+}
+
+#if defined(HQ_USE_SSE2) || defined(HQ_USE_NEON)
+
+/*
+ * diffYUV() for four pixels at a time. Each byte of the YUV values is
+ * compared with its own threshold; the unused top byte never differs.
+ */
+
+#if defined(HQ_USE_SSE2)
+
+typedef __m128i hq_vec;
+
+static inline hq_vec vecLoad(const uint32 *src) { return _mm_loadu_si128((const __m128i *)src); }
+static inline hq_vec vecOr(hq_vec a, hq_vec b) { return _mm_or_si128(a, b); }
+static inline hq_vec vecZero() { return _mm_setzero_si128(); }
+
+/** bit in the lanes in which the YUV values differ, 0 in the others */
+static inline hq_vec vecDiffBit(hq_vec a, hq_vec b, uint32 bit) {
+	const __m128i diff = _mm_or_si128(_mm_subs_epu8(a, b), _mm_subs_epu8(b, a));
+	const __m128i excess = _mm_subs_epu8(diff, _mm_set1_epi32(0xFF300706));
+	return _mm_andnot_si128(_mm_cmpeq_epi32(excess, _mm_setzero_si128()), _mm_set1_epi32(bit));
+}
+
+static inline void vecStorePatterns(uint16 *dst, hq_vec patterns) {
+	_mm_storel_epi64((__m128i *)dst, _mm_packs_epi32(patterns, patterns));
+}
+
+#elif defined(HQ_USE_NEON)
+
+typedef uint32x4_t hq_vec;
+
+static inline hq_vec vecLoad(const uint32 *src) { return vld1q_u32(src); }
+static inline hq_vec vecOr(hq_vec a, hq_vec b) { return vorrq_u32(a, b); }
+static inline hq_vec vecZero() { return vdupq_n_u32(0); }
+
+/** bit in the lanes in which the YUV values differ, 0 in the others */
+static inline hq_vec vecDiffBit(hq_vec a, hq_vec b, uint32 bit) {
+	const uint8x16_t diff = vabdq_u8(vreinterpretq_u8_u32(a), vreinterpretq_u8_u32(b));
+	const uint32x4_t excess = vreinterpretq_u32_u8(vcgtq_u8(diff, vreinterpretq_u8_u32(vdupq_n_u32(0xFF300706))));
+	return vandq_u32(vtstq_u32(excess, excess), vdupq_n_u32(bit));
+}
+
+static inline void vecStorePatterns(uint16 *dst, hq_vec patterns) {
+	vst1_u16(dst, vmovn_u32(patterns));
+}
+
+#endif
+
+#endif
+
+void computeHQPatterns(uint16 *patterns, const uint32 *yuvAbove, const uint32 *yuv, const uint32 *yuvBelow, int width) {
+	int x = 0;
+
+#if defined(HQ_USE_SSE2) || defined(HQ_USE_NEON)
+	for (; x + 4 <= width; x += 4) {
+		const hq_vec w1 = vecLoad(yuvAbove + x), w2 = vecLoad(yuvAbove + x + 1), w3 = vecLoad(yuvAbove + x + 2);
+		const hq_vec w4 = vecLoad(yuv + x), w5 = vecLoad(yuv + x + 1), w6 = vecLoad(yuv + x + 2);
+		const hq_vec w7 = vecLoad(yuvBelow + x), w8 = vecLoad(yuvBelow + x + 1), w9 = vecLoad(yuvBelow + x + 2);
+
+		hq_vec pattern = vecZero();
+		pattern = vecOr(pattern, vecDiffBit(w5, w1, 0x0001));
+		pattern = vecOr(pattern, vecDiffBit(w5, w2, 0x0002));
+		pattern = vecOr(pattern, vecDiffBit(w5, w3, 0x0004));
+		pattern = vecOr(pattern, vecDiffBit(w5, w4, 0x0008));
+		pattern = vecOr(pattern, vecDiffBit(w5, w6, 0x0010));
+		pattern = vecOr(pattern, vecDiffBit(w5, w7, 0x0020));
+		pattern = vecOr(pattern, vecDiffBit(w5, w8, 0x0040));
+		pattern = vecOr(pattern, vecDiffBit(w5, w9, 0x0080));
+		pattern = vecOr(pattern, vecDiffBit(w2, w6, kHQDiff26));
+		pattern = vecOr(pattern, vecDiffBit(w6, w8, kHQDiff68));
+		pattern = vecOr(pattern, vecDiffBit(w8, w4, kHQDiff84));
+		pattern = vecOr(pattern, vecDiffBit(w4, w2, kHQDiff42));
+		vecStorePatterns(patterns + x, pattern);
+	}
+#endif
+
+	for (; x < width; ++x) {
+		const uint32 w1 = yuvAbove[x], w2 = yuvAbove[x + 1], w3 = yuvAbove[x + 2];
+		const uint32 w4 = yuv[x], w5 = yuv[x + 1], w6 = yuv[x + 2];
+		const uint32 w7 = yuvBelow[x], w8 = yuvBelow[x + 1], w9 = yuvBelow[x + 2];
+
+		int pattern = 0;
+		if (diffYUV(w5, w1)) pattern |= 0x0001;
+		if (diffYUV(w5, w2)) pattern |= 0x0002;
+		if (diffYUV(w5, w3)) pattern |= 0x0004;
+		if (diffYUV(w5, w4)) pattern |= 0x0008;
+		if (diffYUV(w5, w6)) pattern |= 0x0010;
+		if (diffYUV(w5, w7)) pattern |= 0x0020;
+		if (diffYUV(w5, w8)) pattern |= 0x0040;
+		if (diffYUV(w5, w9)) pattern |= 0x0080;
+		if (diffYUV(w2, w6)) pattern |= kHQDiff26;
+		if (diffYUV(w6, w8)) pattern |= kHQDiff68;
+		if (diffYUV(w8, w4)) pattern |= kHQDiff84;
+		if (diffYUV(w4, w2)) pattern |= kHQDiff42;
+		patterns[x] = pattern;
+	}
+}
 #endif
 
 
@@ -156,6 +288,9 @@ void DestroyScalers() {
 #ifdef USE_HQ_SCALERS
 	free(RGBtoYUV);
 	RGBtoYUV = 0;
+	free(hqRowBuffer);
+	hqRowBuffer = 0;
+	hqRowBufferWidth = 0;
 #endif
 }
 
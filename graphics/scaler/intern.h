@@ -218,4 +218,43 @@ static inline bool diffYUV(int yuv1, int yuv2) {
 */
 }
 
+#ifdef USE_HQ_SCALERS
+
+/**
+ * Bits of the patterns computed by computeHQPatterns(). The low eight bits
+ * tell which of the neighbors w1, w2, w3, w4, w6, w7, w8 and w9 differ from
+ * the center pixel w5; the others tell which pairs of orthogonal neighbors
+ * differ from each other.
+ */
+enum {
+	kHQNeighborsMask = 0x00FF,
+	kHQDiff26 = 0x0100,
+	kHQDiff68 = 0x0200,
+	kHQDiff84 = 0x0400,
+	kHQDiff42 = 0x0800
+};
+
+/**
+ * Look up the YUV values of count 16 bit pixels in the table of the hq
+ * scalers.
+ */
+void convertToHQYUV(uint32 *dst, const uint16 *src, int count);
+
+/**
+ * Get the buffers of the hq scalers for three rows of width + 2 YUV values,
+ * and for the patterns of a row of width pixels. The buffers are kept for
+ * the next calls, so scaling a frame does not allocate any memory.
+ */
+void getHQRowBuffers(int width, uint32 *&yuvRows, uint16 *&patterns);
+
+/**
+ * Compute the patterns of the hq scalers for one row of pixels, i.e.
+ * which of the neighbors of each pixel differ from it according to
+ * diffYUV(), see the kHQ* bits. The three rows of YUV values are those
+ * above, at, and below the row, each starting one pixel to the left of it.
+ */
+void computeHQPatterns(uint16 *patterns, const uint32 *yuvAbove, const uint32 *yuv, const uint32 *yuvBelow, int width);
+
+#endif
+
 #endif
@@ -19,7 +19,7 @@
  */
 
 /*
- * This file contains a C and MMX implementation of the Scale2x effect.
+ * This file contains a C, MMX and SSE2/NEON implementation of the Scale2x effect.
  *
  * You can find an high level description of the effect at :
  *
@@ -36,6 +36,12 @@
 
 #include "graphics/scaler/scale2x.h"
 
+#if defined(SCALE2X_USE_SSE2)
+#include <emmintrin.h>
+#elif defined(SCALE2X_USE_NEON)
+#include <arm_neon.h>
+#endif
+
 /***************************************************************************/
 /* Scale2x C implementation */
 
@@ -146,6 +152,95 @@ void scale2x_32_def(scale2x_uint32* dst0, scale2x_uint32* dst1, const scale2x_ui
 	scale2x_32_def_single(dst1, src2, src1, src0, count);
 }
 
+/***************************************************************************/
+/* Scale2x SSE2/NEON implementation */
+
+#if defined(SCALE2X_USE_SSE2) || defined(SCALE2X_USE_NEON)
+
+#if defined(SCALE2X_USE_SSE2)
+
+typedef __m128i scale2x_vec;
+
+static inline scale2x_vec scale2x_load(const scale2x_uint16* src) { return _mm_loadu_si128((const __m128i *)src); }
+static inline scale2x_vec scale2x_equal(scale2x_vec a, scale2x_vec b) { return _mm_cmpeq_epi16(a, b); }
+static inline scale2x_vec scale2x_or(scale2x_vec a, scale2x_vec b) { return _mm_or_si128(a, b); }
+/* mask & ~not */
+static inline scale2x_vec scale2x_and_not(scale2x_vec mask, scale2x_vec not_mask) { return _mm_andnot_si128(not_mask, mask); }
+static inline scale2x_vec scale2x_select(scale2x_vec mask, scale2x_vec a, scale2x_vec b) { return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b)); }
+
+static inline void scale2x_store_pairs(scale2x_uint16* dst, scale2x_vec a, scale2x_vec b) {
+	_mm_storeu_si128((__m128i *)dst, _mm_unpacklo_epi16(a, b));
+	_mm_storeu_si128((__m128i *)(dst + 8), _mm_unpackhi_epi16(a, b));
+}
+
+#else
+
+typedef uint16x8_t scale2x_vec;
+
+static inline scale2x_vec scale2x_load(const scale2x_uint16* src) { return vld1q_u16(src); }
+static inline scale2x_vec scale2x_equal(scale2x_vec a, scale2x_vec b) { return vceqq_u16(a, b); }
+static inline scale2x_vec scale2x_or(scale2x_vec a, scale2x_vec b) { return vorrq_u16(a, b); }
+/* mask & ~not */
+static inline scale2x_vec scale2x_and_not(scale2x_vec mask, scale2x_vec not_mask) { return vbicq_u16(mask, not_mask); }
+static inline scale2x_vec scale2x_select(scale2x_vec mask, scale2x_vec a, scale2x_vec b) { return vbslq_u16(mask, a, b); }
+
+static inline void scale2x_store_pairs(scale2x_uint16* dst, scale2x_vec a, scale2x_vec b) {
+	uint16x8x2_t pairs;
+	pairs.val[0] = a;
+	pairs.val[1] = b;
+	vst2q_u16(dst, pairs);
+}
+
+#endif
+
+/*
+ * Apply the Scale2x effect at a single row, eight pixels at a time.
+ * The rule is the one of scale2x_16_def_single(), with the branch replaced
+ * by masks, so the result is the same.
+ */
+static inline void scale2x_16_simd_single(scale2x_uint16* __restrict__ dst, const scale2x_uint16* __restrict__ src0, const scale2x_uint16* __restrict__ src1, const scale2x_uint16* __restrict__ src2, unsigned count) {
+	while (count >= 8) {
+		const scale2x_vec B = scale2x_load(src0);
+		const scale2x_vec D = scale2x_load(src1 - 1);
+		const scale2x_vec E = scale2x_load(src1);
+		const scale2x_vec F = scale2x_load(src1 + 1);
+		const scale2x_vec H = scale2x_load(src2);
+
+		const scale2x_vec keep = scale2x_or(scale2x_equal(B, H), scale2x_equal(D, F));
+		const scale2x_vec left = scale2x_and_not(scale2x_equal(D, B), keep);
+		const scale2x_vec right = scale2x_and_not(scale2x_equal(F, B), keep);
+
+		scale2x_store_pairs(dst, scale2x_select(left, B, E), scale2x_select(right, B, E));
+
+		src0 += 8;
+		src1 += 8;
+		src2 += 8;
+		dst += 16;
+		count -= 8;
+	}
+
+	scale2x_16_def_single(dst, src0, src1, src2, count);
+}
+
+/**
+ * Scale by a factor of 2 a row of pixels of 16 bits.
+ * This function operates like scale2x_16_def(), eight pixels at a time,
+ * using SSE2 or NEON intrinsics.
+ * @param src0 Pointer at the first pixel of the previous row.
+ * @param src1 Pointer at the first pixel of the current row.
+ * @param src2 Pointer at the first pixel of the next row.
+ * @param count Length in pixels of the src0, src1 and src2 rows.
+ * It must be at least 2.
+ * @param dst0 First destination row, double length in pixels.
+ * @param dst1 Second destination row, double length in pixels.
+ */
+void scale2x_16_simd(scale2x_uint16* dst0, scale2x_uint16* dst1, const scale2x_uint16* src0, const scale2x_uint16* src1, const scale2x_uint16* src2, unsigned count) {
+	scale2x_16_simd_single(dst0, src0, src1, src2, count);
+	scale2x_16_simd_single(dst1, src2, src1, src0, count);
+}
+
+#endif
+
 /***************************************************************************/
 /* Scale2x MMX implementation */
 
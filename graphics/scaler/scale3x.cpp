@@ -19,7 +19,7 @@
  */
 
 /*
- * This file contains a C and MMX implementation of the Scale2x effect.
+ * This file contains a C and SSE2/NEON implementation of the Scale3x effect.
  *
  * You can find an high level description of the effect at :
  *
@@ -36,6 +36,12 @@
 
 #include "graphics/scaler/scale3x.h"
 
+#if defined(SCALE3X_USE_SSE2)
+#include <emmintrin.h>
+#elif defined(SCALE3X_USE_NEON)
+#include <arm_neon.h>
+#endif
+
 /***************************************************************************/
 /* Scale3x C implementation */
 
@@ -220,3 +226,158 @@ void scale3x_32_def(scale3x_uint32* dst0, scale3x_uint32* dst1, scale3x_uint32*
 	scale3x_32_def_center(dst1, src0, src1, src2, count);
 	scale3x_32_def_border(dst2, src2, src1, src0, count);
 }
+
+/***************************************************************************/
+/* Scale3x SSE2/NEON implementation */
+
+#if defined(SCALE3X_USE_SSE2) || defined(SCALE3X_USE_NEON)
+
+#if defined(SCALE3X_USE_SSE2)
+
+typedef __m128i scale3x_vec;
+
+static inline scale3x_vec scale3x_load(const scale3x_uint16* src) { return _mm_loadu_si128((const __m128i *)src); }
+static inline scale3x_vec scale3x_equal(scale3x_vec a, scale3x_vec b) { return _mm_cmpeq_epi16(a, b); }
+static inline scale3x_vec scale3x_and(scale3x_vec a, scale3x_vec b) { return _mm_and_si128(a, b); }
+static inline scale3x_vec scale3x_or(scale3x_vec a, scale3x_vec b) { return _mm_or_si128(a, b); }
+/* mask & ~not */
+static inline scale3x_vec scale3x_and_not(scale3x_vec mask, scale3x_vec not_mask) { return _mm_andnot_si128(not_mask, mask); }
+static inline scale3x_vec scale3x_select(scale3x_vec mask, scale3x_vec a, scale3x_vec b) { return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b)); }
+
+/*
+ * Interleave a, b and c into a0 b0 c0 a1 b1 c1 ... c7. SSE2 has no three way
+ * interleave, so every output vector takes the lanes it needs from dword
+ * shuffles of the inputs and keeps them with one mask per input.
+ */
+static inline void scale3x_store_triples(scale3x_uint16* dst, scale3x_vec a, scale3x_vec b, scale3x_vec c) {
+	const __m128i m036 = _mm_setr_epi16(-1, 0, 0, -1, 0, 0, -1, 0);
+	const __m128i m147 = _mm_setr_epi16(0, -1, 0, 0, -1, 0, 0, -1);
+	const __m128i m25 = _mm_setr_epi16(0, 0, -1, 0, 0, -1, 0, 0);
+	const __m128i bl = _mm_slli_si128(b, 2);
+	const __m128i br = _mm_srli_si128(b, 2);
+
+	/* a0 b0 c0 a1 b1 c1 a2 b2 */
+	__m128i out = _mm_and_si128(_mm_shuffle_epi32(a, _MM_SHUFFLE(1, 1, 0, 0)), m036);
+	out = _mm_or_si128(out, _mm_and_si128(_mm_shuffle_epi32(bl, _MM_SHUFFLE(1, 1, 0, 0)), m147));
+	out = _mm_or_si128(out, _mm_and_si128(_mm_shuffle_epi32(c, _MM_SHUFFLE(0, 0, 0, 0)), m25));
+	_mm_storeu_si128((__m128i *)dst, out);
+
+	/* c2 a3 b3 c3 a4 b4 c4 a5 */
+	out = _mm_and_si128(_mm_shuffle_epi32(c, _MM_SHUFFLE(2, 2, 1, 1)), m036);
+	out = _mm_or_si128(out, _mm_and_si128(_mm_shuffle_epi32(a, _MM_SHUFFLE(2, 2, 1, 1)), m147));
+	out = _mm_or_si128(out, _mm_and_si128(_mm_shuffle_epi32(br, _MM_SHUFFLE(1, 1, 1, 1)), m25));
+	_mm_storeu_si128((__m128i *)(dst + 8), out);
+
+	/* b5 c5 a6 b6 c6 a7 b7 c7 */
+	out = _mm_and_si128(_mm_shuffle_epi32(br, _MM_SHUFFLE(3, 3, 2, 2)), m036);
+	out = _mm_or_si128(out, _mm_and_si128(_mm_shuffle_epi32(c, _MM_SHUFFLE(3, 3, 2, 2)), m147));
+	out = _mm_or_si128(out, _mm_and_si128(_mm_shuffle_epi32(a, _MM_SHUFFLE(3, 3, 3, 3)), m25));
+	_mm_storeu_si128((__m128i *)(dst + 16), out);
+}
+
+#else
+
+typedef uint16x8_t scale3x_vec;
+
+static inline scale3x_vec scale3x_load(const scale3x_uint16* src) { return vld1q_u16(src); }
+static inline scale3x_vec scale3x_equal(scale3x_vec a, scale3x_vec b) { return vceqq_u16(a, b); }
+static inline scale3x_vec scale3x_and(scale3x_vec a, scale3x_vec b) { return vandq_u16(a, b); }
+static inline scale3x_vec scale3x_or(scale3x_vec a, scale3x_vec b) { return vorrq_u16(a, b); }
+/* mask & ~not */
+static inline scale3x_vec scale3x_and_not(scale3x_vec mask, scale3x_vec not_mask) { return vbicq_u16(mask, not_mask); }
+static inline scale3x_vec scale3x_select(scale3x_vec mask, scale3x_vec a, scale3x_vec b) { return vbslq_u16(mask, a, b); }
+
+static inline void scale3x_store_triples(scale3x_uint16* dst, scale3x_vec a, scale3x_vec b, scale3x_vec c) {
+	uint16x8x3_t triples;
+	triples.val[0] = a;
+	triples.val[1] = b;
+	triples.val[2] = c;
+	vst3q_u16(dst, triples);
+}
+
+#endif
+
+/*
+ * Apply the Scale3x effect at the first or last row, eight pixels at a time.
+ * The rule is the one of scale3x_16_def_border(), with the branch replaced
+ * by masks, so the result is the same.
+ */
+static inline void scale3x_16_simd_border(scale3x_uint16* __restrict__ dst, const scale3x_uint16* __restrict__ src0, const scale3x_uint16* __restrict__ src1, const scale3x_uint16* __restrict__ src2, unsigned count) {
+	while (count >= 8) {
+		const scale3x_vec A = scale3x_load(src0 - 1);
+		const scale3x_vec B = scale3x_load(src0);
+		const scale3x_vec C = scale3x_load(src0 + 1);
+		const scale3x_vec D = scale3x_load(src1 - 1);
+		const scale3x_vec E = scale3x_load(src1);
+		const scale3x_vec F = scale3x_load(src1 + 1);
+		const scale3x_vec H = scale3x_load(src2);
+
+		const scale3x_vec keep = scale3x_or(scale3x_equal(B, H), scale3x_equal(D, F));
+		const scale3x_vec left = scale3x_and_not(scale3x_equal(D, B), keep);
+		const scale3x_vec right = scale3x_and_not(scale3x_equal(F, B), keep);
+		const scale3x_vec middle = scale3x_or(scale3x_and_not(left, scale3x_equal(E, C)), scale3x_and_not(right, scale3x_equal(E, A)));
+
+		scale3x_store_triples(dst, scale3x_select(left, D, E), scale3x_select(middle, B, E), scale3x_select(right, F, E));
+
+		src0 += 8;
+		src1 += 8;
+		src2 += 8;
+		dst += 24;
+		count -= 8;
+	}
+
+	scale3x_16_def_border(dst, src0, src1, src2, count);
+}
+
+/*
+ * Apply the Scale3x effect at the middle row, eight pixels at a time.
+ * The rule is the one of scale3x_16_def_center().
+ */
+static inline void scale3x_16_simd_center(scale3x_uint16* __restrict__ dst, const scale3x_uint16* __restrict__ src0, const scale3x_uint16* __restrict__ src1, const scale3x_uint16* __restrict__ src2, unsigned count) {
+	while (count >= 8) {
+		const scale3x_vec A = scale3x_load(src0 - 1);
+		const scale3x_vec B = scale3x_load(src0);
+		const scale3x_vec C = scale3x_load(src0 + 1);
+		const scale3x_vec D = scale3x_load(src1 - 1);
+		const scale3x_vec E = scale3x_load(src1);
+		const scale3x_vec F = scale3x_load(src1 + 1);
+		const scale3x_vec G = scale3x_load(src2 - 1);
+		const scale3x_vec H = scale3x_load(src2);
+		const scale3x_vec I = scale3x_load(src2 + 1);
+
+		const scale3x_vec keep = scale3x_or(scale3x_equal(B, H), scale3x_equal(D, F));
+		const scale3x_vec left = scale3x_or(scale3x_and_not(scale3x_equal(D, B), scale3x_equal(E, G)), scale3x_and_not(scale3x_equal(D, H), scale3x_equal(E, A)));
+		const scale3x_vec right = scale3x_or(scale3x_and_not(scale3x_equal(F, B), scale3x_equal(E, I)), scale3x_and_not(scale3x_equal(F, H), scale3x_equal(E, C)));
+
+		scale3x_store_triples(dst, scale3x_select(scale3x_and_not(left, keep), D, E), E, scale3x_select(scale3x_and_not(right, keep), F, E));
+
+		src0 += 8;
+		src1 += 8;
+		src2 += 8;
+		dst += 24;
+		count -= 8;
+	}
+
+	scale3x_16_def_center(dst, src0, src1, src2, count);
+}
+
+/**
+ * Scale by a factor of 3 a row of pixels of 16 bits.
+ * This function operates like scale3x_16_def(), eight pixels at a time,
+ * using SSE2 or NEON intrinsics.
+ * @param src0 Pointer at the first pixel of the previous row.
+ * @param src1 Pointer at the first pixel of the current row.
+ * @param src2 Pointer at the first pixel of the next row.
+ * @param count Length in pixels of the src0, src1 and src2 rows.
+ * It must be at least 2.
+ * @param dst0 First destination row, triple length in pixels.
+ * @param dst1 Second destination row, triple length in pixels.
+ * @param dst2 Third destination row, triple length in pixels.
+ */
+void scale3x_16_simd(scale3x_uint16* dst0, scale3x_uint16* dst1, scale3x_uint16* dst2, const scale3x_uint16* src0, const scale3x_uint16* src1, const scale3x_uint16* src2, unsigned count) {
+	scale3x_16_simd_border(dst0, src0, src1, src2, count);
+	scale3x_16_simd_center(dst1, src0, src1, src2, count);
+	scale3x_16_simd_border(dst2, src2, src1, src0, count);
+}
+
+#endif
@@ -0,0 +1,98 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "graphics/transform_cache.h"
+
+namespace Graphics {
+
+bool TransformCache::Key::operator==(const Key &k) const {
+	return owner == k.owner &&
+		srcRect == k.srcRect &&
+		width == k.width &&
+		height == k.height &&
+		filteringMode == k.filteringMode &&
+		transform._angle == k.transform._angle &&
+		transform._zoom == k.transform._zoom &&
+		transform._hotspot == k.transform._hotspot;
+}
+
+TransformCache::TransformCache(uint maxEntries, uint32 maxBytes)
+	: _maxEntries(maxEntries), _maxBytes(maxBytes), _bytes(0), _hits(0), _misses(0) {
+}
+
+TransformCache::SurfacePtr TransformCache::lookup(const Key &key) {
+	for (EntryList::iterator i = _entries.begin(); i != _entries.end(); ++i) {
+		if (i->key == key) {
+			_hits++;
+			if (i != _entries.begin()) {
+				_entries.push_front(*i);
+				_entries.erase(i);
+			}
+			return _entries.front().surface;
+		}
+	}
+
+	_misses++;
+	return SurfacePtr();
+}
+
+void TransformCache::insert(const Key &key, const SurfacePtr &surface) {
+	const uint32 bytes = surface->pitch * surface->h;
+	if (bytes > _maxBytes || !_maxEntries)
+		return;
+
+	while (!_entries.empty() && (_entries.size() >= _maxEntries || _bytes + bytes > _maxBytes)) {
+		_bytes -= _entries.back().bytes;
+		_entries.pop_back();
+	}
+
+	_entries.push_front(Entry(key, surface, bytes));
+	_bytes += bytes;
+}
+
+void TransformCache::invalidate(const void *owner) {
+	EntryList::iterator i = _entries.begin();
+	while (i != _entries.end()) {
+		if (i->key.owner == owner) {
+			_bytes -= i->bytes;
+			i = _entries.erase(i);
+		} else {
+			++i;
+		}
+	}
+}
+
+void TransformCache::clear() {
+	_entries.clear();
+	_bytes = 0;
+}
+
+TransformCache::Stats TransformCache::getStats() const {
+	Stats stats;
+	stats.hits = _hits;
+	stats.misses = _misses;
+	stats.entries = _entries.size();
+	stats.bytes = _bytes;
+	return stats;
+}
+
+} // End of namespace Graphics
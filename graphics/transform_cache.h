@@ -0,0 +1,118 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef GRAPHICS_TRANSFORM_CACHE_H
+#define GRAPHICS_TRANSFORM_CACHE_H
+
+#include "common/list.h"
+#include "common/ptr.h"
+#include "common/rect.h"
+#include "graphics/surface.h"
+#include "graphics/transparent_surface.h"
+
+namespace Graphics {
+
+/**
+ * A small cache of scaled and rotoscaled surfaces, for users which
+ * transform the same images over and over, e.g. for every frame. When the
+ * cache is full, the least recently used surfaces are dropped.
+ *
+ * Sources are identified by an owner pointer and the area of the owner's
+ * image which is transformed. The cache does not look at the source
+ * pixels, so owners have to call invalidate() whenever their image
+ * changes, and before they go away.
+ */
+class TransformCache {
+public:
+	typedef Common::SharedPtr<Surface> SurfacePtr;
+
+	/** What a cached surface was made from. */
+	struct Key {
+		const void *owner;
+		Common::Rect srcRect;
+		TransformStruct transform;
+		uint16 width;		///< Result size, for scaling
+		uint16 height;
+		TFilteringMode filteringMode;
+
+		Key(const void *owner_, const Common::Rect &srcRect_, const TransformStruct &transform_, uint16 width_, uint16 height_, TFilteringMode filteringMode_)
+			: owner(owner_), srcRect(srcRect_), transform(transform_), width(width_), height(height_), filteringMode(filteringMode_) {}
+
+		/**
+		 * Only the parts of the transform which affect the transformed
+		 * pixels are compared, so e.g. fading sprites still hit the cache.
+		 */
+		bool operator==(const Key &k) const;
+	};
+
+	struct Stats {
+		uint32 hits;
+		uint32 misses;
+		uint32 entries;
+		uint32 bytes;
+	};
+
+	/**
+	 * Create a cache holding at most maxEntries surfaces, with at most
+	 * maxBytes of pixels in total.
+	 */
+	explicit TransformCache(uint maxEntries = 32, uint32 maxBytes = 16 * 1024 * 1024);
+
+	/** Return the cached surface for key, or an empty pointer. */
+	SurfacePtr lookup(const Key &key);
+
+	/**
+	 * Add a transformed surface. Surfaces bigger than the whole cache are
+	 * not kept.
+	 */
+	void insert(const Key &key, const SurfacePtr &surface);
+
+	/** Drop all surfaces made from images of owner. */
+	void invalidate(const void *owner);
+
+	void clear();
+
+	Stats getStats() const;
+
+private:
+	struct Entry {
+		Key key;
+		SurfacePtr surface;
+		uint32 bytes;
+
+		Entry(const Key &key_, const SurfacePtr &surface_, uint32 bytes_) : key(key_), surface(surface_), bytes(bytes_) {}
+	};
+
+	typedef Common::List<Entry> EntryList;
+
+	/** The most recently used entry comes first. */
+	EntryList _entries;
+	uint _maxEntries;
+	uint32 _maxBytes;
+	uint32 _bytes;
+	uint32 _hits;
+	uint32 _misses;
+};
+
+} // End of namespace Graphics
+
+#endif
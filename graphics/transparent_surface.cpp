@@ -37,6 +37,14 @@
 #include "graphics/transparent_surface.h"
 #include "graphics/transform_tools.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TS_USE_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define TS_USE_NEON
+#include <arm_neon.h>
+#endif
+
 namespace Graphics {
 
 static const int kBModShift = 0;//img->format.bShift;
@@ -128,6 +136,267 @@ void doBlitBinaryFast(byte *ino, byte *outo, uint32 width, uint32 height, uint32
 	}
 }
 
+#if defined(TS_USE_SSE2) || defined(TS_USE_NEON)
+
+/*
+ * The blend functions below process four pixels at a time with these
+ * helpers. The pixels are split into two vectors of two pixels each, with
+ * one 16 bit lane per channel, and the scalar formulas are evaluated in
+ * those lanes, so the results are exactly the same as the ones of the
+ * scalar code. Only unflipped and horizontally flipped rows of 32 bit
+ * pixels are handled, the remaining pixels of a row are left to the
+ * scalar code.
+ */
+
+#if defined(TS_USE_SSE2)
+
+typedef __m128i ts_vec8;
+typedef __m128i ts_vec16;
+
+/** Load four pixels, in the order in which they are drawn. */
+static inline ts_vec8 vecLoadPixels(const byte *in, int32 inStep) {
+	if (inStep > 0)
+		return _mm_loadu_si128((const __m128i *)in);
+	return _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)(in - 12)), _MM_SHUFFLE(0, 1, 2, 3));
+}
+static inline ts_vec8 vecLoad(const byte *out) { return _mm_loadu_si128((const __m128i *)out); }
+static inline void vecStore(byte *out, ts_vec8 v) { _mm_storeu_si128((__m128i *)out, v); }
+static inline ts_vec16 vecLow(ts_vec8 v) { return _mm_unpacklo_epi8(v, _mm_setzero_si128()); }
+static inline ts_vec16 vecHigh(ts_vec8 v) { return _mm_unpackhi_epi8(v, _mm_setzero_si128()); }
+/** Pack two vectors of 16 bit lanes into bytes, with unsigned saturation. */
+static inline ts_vec8 vecPack(ts_vec16 lo, ts_vec16 hi) { return _mm_packus_epi16(lo, hi); }
+static inline ts_vec16 vecSplat(uint16 x) { return _mm_set1_epi16(x); }
+static inline ts_vec16 vecLoadLanes(const uint16 *lanes) { return _mm_loadu_si128((const __m128i *)lanes); }
+static inline ts_vec16 vecAdd(ts_vec16 a, ts_vec16 b) { return _mm_add_epi16(a, b); }
+static inline ts_vec16 vecSub(ts_vec16 a, ts_vec16 b) { return _mm_sub_epi16(a, b); }
+static inline ts_vec16 vecMul(ts_vec16 a, ts_vec16 b) { return _mm_mullo_epi16(a, b); }
+/** The upper 16 bits of the 32 bit products, that is (a * b) >> 16. */
+static inline ts_vec16 vecMulHigh(ts_vec16 a, ts_vec16 b) { return _mm_mulhi_epu16(a, b); }
+static inline ts_vec16 vecShift8(ts_vec16 a) { return _mm_srli_epi16(a, 8); }
+static inline ts_vec16 vecEqual(ts_vec16 a, ts_vec16 b) { return _mm_cmpeq_epi16(a, b); }
+/** Take the lanes of a where mask is set, and those of b elsewhere. */
+static inline ts_vec16 vecSelect(ts_vec16 mask, ts_vec16 a, ts_vec16 b) {
+	return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+/** Copy the alpha of each pixel to all of its lanes. */
+static inline ts_vec16 vecAlpha(ts_vec16 a) {
+	a = _mm_shufflelo_epi16(a, _MM_SHUFFLE(kAIndex, kAIndex, kAIndex, kAIndex));
+	return _mm_shufflehi_epi16(a, _MM_SHUFFLE(kAIndex, kAIndex, kAIndex, kAIndex));
+}
+
+#elif defined(TS_USE_NEON)
+
+typedef uint8x16_t ts_vec8;
+typedef uint16x8_t ts_vec16;
+
+/** Load four pixels, in the order in which they are drawn. */
+static inline ts_vec8 vecLoadPixels(const byte *in, int32 inStep) {
+	if (inStep > 0)
+		return vld1q_u8(in);
+	const uint32x4_t v = vrev64q_u32(vreinterpretq_u32_u8(vld1q_u8(in - 12)));
+	return vreinterpretq_u8_u32(vcombine_u32(vget_high_u32(v), vget_low_u32(v)));
+}
+static inline ts_vec8 vecLoad(const byte *out) { return vld1q_u8(out); }
+static inline void vecStore(byte *out, ts_vec8 v) { vst1q_u8(out, v); }
+static inline ts_vec16 vecLow(ts_vec8 v) { return vmovl_u8(vget_low_u8(v)); }
+static inline ts_vec16 vecHigh(ts_vec8 v) { return vmovl_u8(vget_high_u8(v)); }
+/** Pack two vectors of 16 bit lanes into bytes, with unsigned saturation. */
+static inline ts_vec8 vecPack(ts_vec16 lo, ts_vec16 hi) { return vcombine_u8(vqmovn_u16(lo), vqmovn_u16(hi)); }
+static inline ts_vec16 vecSplat(uint16 x) { return vdupq_n_u16(x); }
+static inline ts_vec16 vecLoadLanes(const uint16 *lanes) { return vld1q_u16(lanes); }
+static inline ts_vec16 vecAdd(ts_vec16 a, ts_vec16 b) { return vaddq_u16(a, b); }
+static inline ts_vec16 vecSub(ts_vec16 a, ts_vec16 b) { return vsubq_u16(a, b); }
+static inline ts_vec16 vecMul(ts_vec16 a, ts_vec16 b) { return vmulq_u16(a, b); }
+/** The upper 16 bits of the 32 bit products, that is (a * b) >> 16. */
+static inline ts_vec16 vecMulHigh(ts_vec16 a, ts_vec16 b) {
+	return vcombine_u16(vshrn_n_u32(vmull_u16(vget_low_u16(a), vget_low_u16(b)), 16),
+	                    vshrn_n_u32(vmull_u16(vget_high_u16(a), vget_high_u16(b)), 16));
+}
+static inline ts_vec16 vecShift8(ts_vec16 a) { return vshrq_n_u16(a, 8); }
+static inline ts_vec16 vecEqual(ts_vec16 a, ts_vec16 b) { return vceqq_u16(a, b); }
+/** Take the lanes of a where mask is set, and those of b elsewhere. */
+static inline ts_vec16 vecSelect(ts_vec16 mask, ts_vec16 a, ts_vec16 b) { return vbslq_u16(mask, a, b); }
+/** Copy the alpha of each pixel to all of its lanes. */
+static inline ts_vec16 vecAlpha(ts_vec16 a) {
+	uint64x2_t p = vshlq_u64(vreinterpretq_u64_u16(a), vdupq_n_s64(-16 * kAIndex));
+	p = vandq_u64(p, vdupq_n_u64(0xFFFF));
+	p = vorrq_u64(p, vshlq_n_u64(p, 16));
+	return vreinterpretq_u16_u64(vorrq_u64(p, vshlq_n_u64(p, 32)));
+}
+
+#endif
+
+/** A vector with the given values in the lanes of the respective channels. */
+static inline ts_vec16 vecChannels(uint16 a, uint16 r, uint16 g, uint16 b) {
+	uint16 lanes[8];
+	for (int i = 0; i < 8; i += 4) {
+		lanes[i + kAIndex] = a;
+		lanes[i + kRIndex] = r;
+		lanes[i + kGIndex] = g;
+		lanes[i + kBIndex] = b;
+	}
+	return vecLoadLanes(lanes);
+}
+
+/**
+ * The colormod factor for the additive and subtractive blend modes, in
+ * units of 1 / 256: those modes use the factor 1 for a component of 255.
+ */
+static inline uint16 modFactor(byte c) {
+	return c == 255 ? 256 : c;
+}
+
+/**
+ * Blend as many pixels of a row as possible, four at a time, and return
+ * their number. The remaining ones are left to the scalar code.
+ */
+static uint32 alphaBlendRow(const byte *in, byte *out, uint32 width, int32 inStep) {
+	const ts_vec16 zero = vecSplat(0);
+	const ts_vec16 full = vecSplat(255);
+	const ts_vec16 alphaLanes = vecChannels(0xFFFF, 0, 0, 0);
+
+	uint32 j = 0;
+	for (; j + 4 <= width; j += 4) {
+		const ts_vec8 src = vecLoadPixels(in, inStep);
+		const ts_vec8 dst = vecLoad(out);
+		ts_vec16 res[2];
+		for (int h = 0; h < 2; h++) {
+			const ts_vec16 s = h ? vecHigh(src) : vecLow(src);
+			const ts_vec16 d = h ? vecHigh(dst) : vecLow(dst);
+			const ts_vec16 a = vecAlpha(s);
+			ts_vec16 r = vecShift8(vecAdd(vecMul(s, a), vecMul(d, vecSub(full, a))));
+			r = vecSelect(alphaLanes, full, r);
+			res[h] = vecSelect(vecEqual(a, zero), d, r);
+		}
+		vecStore(out, vecPack(res[0], res[1]));
+		in += 4 * inStep;
+		out += 16;
+	}
+	return j;
+}
+
+static uint32 alphaBlendModRow(const byte *in, byte *out, uint32 width, int32 inStep, byte ca, byte cr, byte cg, byte cb) {
+	const ts_vec16 alphaMod = vecSplat(ca);
+	const ts_vec16 mod = vecChannels(0, cr, cg, cb);
+	const ts_vec16 full = vecSplat(255);
+	const ts_vec16 alphaLanes = vecChannels(0xFFFF, 0, 0, 0);
+
+	uint32 j = 0;
+	for (; j + 4 <= width; j += 4) {
+		const ts_vec8 src = vecLoadPixels(in, inStep);
+		const ts_vec8 dst = vecLoad(out);
+		ts_vec16 res[2];
+		for (int h = 0; h < 2; h++) {
+			const ts_vec16 s = h ? vecHigh(src) : vecLow(src);
+			const ts_vec16 d = h ? vecHigh(dst) : vecLow(dst);
+			const ts_vec16 ina = vecShift8(vecMul(vecAlpha(s), alphaMod));
+			const ts_vec16 r = vecAdd(vecShift8(vecMul(d, vecSub(full, ina))), vecMulHigh(vecMul(s, ina), mod));
+			res[h] = vecSelect(alphaLanes, full, r);
+		}
+		vecStore(out, vecPack(res[0], res[1]));
+		in += 4 * inStep;
+		out += 16;
+	}
+	return j;
+}
+
+static uint32 additiveBlendRow(const byte *in, byte *out, uint32 width, int32 inStep) {
+	const ts_vec16 colorLanes = vecChannels(0, 0xFFFF, 0xFFFF, 0xFFFF);
+
+	uint32 j = 0;
+	for (; j + 4 <= width; j += 4) {
+		const ts_vec8 src = vecLoadPixels(in, inStep);
+		const ts_vec8 dst = vecLoad(out);
+		ts_vec16 res[2];
+		for (int h = 0; h < 2; h++) {
+			const ts_vec16 s = h ? vecHigh(src) : vecLow(src);
+			const ts_vec16 d = h ? vecHigh(dst) : vecLow(dst);
+			const ts_vec16 add = vecShift8(vecMul(s, vecAlpha(s)));
+			res[h] = vecAdd(d, vecSelect(colorLanes, add, vecSplat(0)));
+		}
+		vecStore(out, vecPack(res[0], res[1]));
+		in += 4 * inStep;
+		out += 16;
+	}
+	return j;
+}
+
+static uint32 additiveBlendModRow(const byte *in, byte *out, uint32 width, int32 inStep, byte ca, byte cr, byte cg, byte cb) {
+	const ts_vec16 alphaMod = vecSplat(ca);
+	const ts_vec16 mod = vecChannels(0, modFactor(cr), modFactor(cg), modFactor(cb));
+
+	uint32 j = 0;
+	for (; j + 4 <= width; j += 4) {
+		const ts_vec8 src = vecLoadPixels(in, inStep);
+		const ts_vec8 dst = vecLoad(out);
+		ts_vec16 res[2];
+		for (int h = 0; h < 2; h++) {
+			const ts_vec16 s = h ? vecHigh(src) : vecLow(src);
+			const ts_vec16 d = h ? vecHigh(dst) : vecLow(dst);
+			const ts_vec16 ina = vecShift8(vecMul(vecAlpha(s), alphaMod));
+			res[h] = vecAdd(d, vecMulHigh(vecMul(s, ina), mod));
+		}
+		vecStore(out, vecPack(res[0], res[1]));
+		in += 4 * inStep;
+		out += 16;
+	}
+	return j;
+}
+
+static uint32 subtractiveBlendRow(const byte *in, byte *out, uint32 width, int32 inStep) {
+	const ts_vec16 colorLanes = vecChannels(0, 0xFFFF, 0xFFFF, 0xFFFF);
+
+	uint32 j = 0;
+	for (; j + 4 <= width; j += 4) {
+		const ts_vec8 src = vecLoadPixels(in, inStep);
+		const ts_vec8 dst = vecLoad(out);
+		ts_vec16 res[2];
+		for (int h = 0; h < 2; h++) {
+			const ts_vec16 s = h ? vecHigh(src) : vecLow(src);
+			const ts_vec16 d = h ? vecHigh(dst) : vecLow(dst);
+			const ts_vec16 sub = vecMulHigh(vecMul(s, d), vecAlpha(s));
+			res[h] = vecSub(d, vecSelect(colorLanes, sub, vecSplat(0)));
+		}
+		vecStore(out, vecPack(res[0], res[1]));
+		in += 4 * inStep;
+		out += 16;
+	}
+	return j;
+}
+
+static uint32 subtractiveBlendModRow(const byte *in, byte *out, uint32 width, int32 inStep, byte cr, byte cg, byte cb) {
+	const ts_vec16 mod = vecChannels(0, modFactor(cr), modFactor(cg), modFactor(cb));
+	const ts_vec16 full = vecSplat(255);
+	const ts_vec16 alphaLanes = vecChannels(0xFFFF, 0, 0, 0);
+
+	uint32 j = 0;
+	for (; j + 4 <= width; j += 4) {
+		const ts_vec8 src = vecLoadPixels(in, inStep);
+		const ts_vec8 dst = vecLoad(out);
+		ts_vec16 res[2];
+		for (int h = 0; h < 2; h++) {
+			const ts_vec16 s = h ? vecHigh(src) : vecLow(src);
+			const ts_vec16 d = h ? vecHigh(dst) : vecLow(dst);
+			// (in * out) * (a * mod) >> 24, split into two 16 bit products
+			const ts_vec16 sub = vecShift8(vecMulHigh(vecMul(s, d), vecMul(vecAlpha(s), mod)));
+			res[h] = vecSelect(alphaLanes, full, vecSub(d, sub));
+		}
+		vecStore(out, vecPack(res[0], res[1]));
+		in += 4 * inStep;
+		out += 16;
+	}
+	return j;
+}
+
+/** Blend the first pixels of a row with the given row function, if it can handle the row. */
+#define TS_BLEND_ROW(row, inStep) ((inStep) == 4 || (inStep) == -4 ? (row) : 0)
+
+#else
+
+#define TS_BLEND_ROW(row, inStep) 0
+
+#endif
+
 /**
  * Optimized version of doBlit to be used with alpha blended blitting
  * @param ino a pointer to the input surface
@@ -146,9 +415,10 @@ void doBlitAlphaBlend(byte *ino, byte *outo, uint32 width, uint32 height, uint32
 	if (color == 0xffffffff) {
 
 		for (uint32 i = 0; i < height; i++) {
-			out = outo;
-			in = ino;
-			for (uint32 j = 0; j < width; j++) {
+			uint32 j = TS_BLEND_ROW(alphaBlendRow(ino, outo, width, inStep), inStep);
+			in = ino + (int32)j * inStep;
+			out = outo + j * 4;
+			for (; j < width; j++) {
 
 				if (in[kAIndex] != 0) {
 					out[kAIndex] = 255;
@@ -171,9 +441,10 @@ void doBlitAlphaBlend(byte *ino, byte *outo, uint32 width, uint32 height, uint32
 		byte cb = (color >> kBModShift) & 0xFF;
 
 		for (uint32 i = 0; i < height; i++) {
-			out = outo;
-			in = ino;
-			for (uint32 j = 0; j < width; j++) {
+			uint32 j = TS_BLEND_ROW(alphaBlendModRow(ino, outo, width, inStep, ca, cr, cg, cb), inStep);
+			in = ino + (int32)j * inStep;
+			out = outo + j * 4;
+			for (; j < width; j++) {
 
 				uint32 ina = in[kAIndex] * ca >> 8;
 				out[kAIndex] = 255;
@@ -204,9 +475,10 @@ void doBlitAdditiveBlend(byte *ino, byte *outo, uint32 width, uint32 height, uin
 	if (color == 0xffffffff) {
 
 		for (uint32 i = 0; i < height; i++) {
-			out = outo;
-			in = ino;
-			for (uint32 j = 0; j < width; j++) {
+			uint32 j = TS_BLEND_ROW(additiveBlendRow(ino, outo, width, inStep), inStep);
+			in = ino + (int32)j * inStep;
+			out = outo + j * 4;
+			for (; j < width; j++) {
 
 				if (in[kAIndex] != 0) {
 					out[kRIndex] = MIN((in[kRIndex] * in[kAIndex] >> 8) + out[kRIndex], 255);
@@ -228,9 +500,10 @@ void doBlitAdditiveBlend(byte *ino, byte *outo, uint32 width, uint32 height, uin
 		byte cb = (color >> kBModShift) & 0xFF;
 
 		for (uint32 i = 0; i < height; i++) {
-			out = outo;
-			in = ino;
-			for (uint32 j = 0; j < width; j++) {
+			uint32 j = TS_BLEND_ROW(additiveBlendModRow(ino, outo, width, inStep, ca, cr, cg, cb), inStep);
+			in = ino + (int32)j * inStep;
+			out = outo + j * 4;
+			for (; j < width; j++) {
 
 				uint32 ina = in[kAIndex] * ca >> 8;
 
@@ -271,9 +544,10 @@ void doBlitSubtractiveBlend(byte *ino, byte *outo, uint32 width, uint32 height,
 	if (color == 0xffffffff) {
 
 		for (uint32 i = 0; i < height; i++) {
-			out = outo;
-			in = ino;
-			for (uint32 j = 0; j < width; j++) {
+			uint32 j = TS_BLEND_ROW(subtractiveBlendRow(ino, outo, width, inStep), inStep);
+			in = ino + (int32)j * inStep;
+			out = outo + j * 4;
+			for (; j < width; j++) {
 
 				if (in[kAIndex] != 0) {
 					out[kRIndex] = MAX(out[kRIndex] - ((in[kRIndex] * out[kRIndex]) * in[kAIndex] >> 16), 0);
@@ -294,25 +568,26 @@ void doBlitSubtractiveBlend(byte *ino, byte *outo, uint32 width, uint32 height,
 		byte cb = (color >> kBModShift) & 0xFF;
 
 		for (uint32 i = 0; i < height; i++) {
-			out = outo;
-			in = ino;
-			for (uint32 j = 0; j < width; j++) {
+			uint32 j = TS_BLEND_ROW(subtractiveBlendModRow(ino, outo, width, inStep, cr, cg, cb), inStep);
+			in = ino + (int32)j * inStep;
+			out = outo + j * 4;
+			for (; j < width; j++) {
 
 				out[kAIndex] = 255;
 				if (cb != 255) {
-					out[kBIndex] = MAX(out[kBIndex] - ((in[kBIndex] * cb  * (out[kBIndex]) * in[kAIndex]) >> 24), 0);
+					out[kBIndex] = MAX(out[kBIndex] - (int)((uint32)(in[kBIndex] * cb) * (out[kBIndex] * in[kAIndex]) >> 24), 0);
 				} else {
 					out[kBIndex] = MAX(out[kBIndex] - (in[kBIndex] * (out[kBIndex]) * in[kAIndex] >> 16), 0);
 				}
 
 				if (cg != 255) {
-					out[kGIndex] = MAX(out[kGIndex] - ((in[kGIndex] * cg  * (out[kGIndex]) * in[kAIndex]) >> 24), 0);
+					out[kGIndex] = MAX(out[kGIndex] - (int)((uint32)(in[kGIndex] * cg) * (out[kGIndex] * in[kAIndex]) >> 24), 0);
 				} else {
 					out[kGIndex] = MAX(out[kGIndex] - (in[kGIndex] * (out[kGIndex]) * in[kAIndex] >> 16), 0);
 				}
 
 				if (cr != 255) {
-					out[kRIndex] = MAX(out[kRIndex] - ((in[kRIndex] * cr * (out[kRIndex]) * in[kAIndex]) >> 24), 0);
+					out[kRIndex] = MAX(out[kRIndex] - (int)((uint32)(in[kRIndex] * cr) * (out[kRIndex] * in[kAIndex]) >> 24), 0);
 				} else {
 					out[kRIndex] = MAX(out[kRIndex] - (in[kRIndex] * (out[kRIndex]) * in[kAIndex] >> 16), 0);
 				}
@@ -676,6 +951,51 @@ systems.
 
 struct tColorRGBA { byte r; byte g; byte b; byte a; };
 
+/**
+ * Interpolate between four pixels, with the weights ex and ey of the right
+ * and the bottom pixels in 16.16 fixed point.
+ */
+static inline void interpolate(tColorRGBA *dp, const tColorRGBA *c00, const tColorRGBA *c01, const tColorRGBA *c10, const tColorRGBA *c11, int ex, int ey) {
+	int t1, t2;
+	t1 = ((((c01->r - c00->r) * ex) >> 16) + c00->r) & 0xff;
+	t2 = ((((c11->r - c10->r) * ex) >> 16) + c10->r) & 0xff;
+	dp->r = (((t2 - t1) * ey) >> 16) + t1;
+	t1 = ((((c01->g - c00->g) * ex) >> 16) + c00->g) & 0xff;
+	t2 = ((((c11->g - c10->g) * ex) >> 16) + c10->g) & 0xff;
+	dp->g = (((t2 - t1) * ey) >> 16) + t1;
+	t1 = ((((c01->b - c00->b) * ex) >> 16) + c00->b) & 0xff;
+	t2 = ((((c11->b - c10->b) * ex) >> 16) + c10->b) & 0xff;
+	dp->b = (((t2 - t1) * ey) >> 16) + t1;
+	t1 = ((((c01->a - c00->a) * ex) >> 16) + c00->a) & 0xff;
+	t2 = ((((c11->a - c10->a) * ex) >> 16) + c10->a) & 0xff;
+	dp->a = (((t2 - t1) * ey) >> 16) + t1;
+}
+
+/** Division rounding towards negative infinity, for b > 0. */
+static inline int64 divFloor(int64 a, int64 b) {
+	return a >= 0 ? a / b : -((b - 1 - a) / b);
+}
+
+/**
+ * Compute the range [start, end) of the x in [0, n) for which
+ * lo <= v + x * step < hi holds.
+ */
+static void clipSpan(int v, int step, int64 lo, int64 hi, int n, int &start, int &end) {
+	int64 first, last;
+	if (step > 0) {
+		first = -divFloor(v - lo, step);
+		last = -divFloor(v - hi, step);
+	} else if (step < 0) {
+		first = divFloor(v - hi, -step) + 1;
+		last = divFloor(v - lo, -step) + 1;
+	} else {
+		first = 0;
+		last = (v >= lo && v < hi) ? n : 0;
+	}
+	start = (int)CLIP<int64>(first, 0, n);
+	end = (int)CLIP<int64>(last, start, n);
+}
+
 template <TFilteringMode filteringMode>
 TransparentSurface *TransparentSurface::rotoscaleT(const TransformStruct &transform) const {
 
@@ -709,8 +1029,7 @@ TransparentSurface *TransparentSurface::rotoscaleT(const TransformStruct &transf
 	int icosy = (int)(invCos * (65536.0f * kDefaultZoomY / transform._zoom.y));
 	int isiny = (int)(invSin * (65536.0f * kDefaultZoomY / transform._zoom.y));
 
-
-	bool flipx = false, flipy = false; // TODO: See mirroring comment in RenderTicket ctor
+	// TODO: See mirroring comment in RenderTicket ctor
 
 	int xd = (srcRect.left + transform._hotspot.x) << 16;
 	int yd = (srcRect.top + transform._hotspot.y) << 16;
@@ -719,68 +1038,35 @@ TransparentSurface *TransparentSurface::rotoscaleT(const TransformStruct &transf
 
 	int ax = -icosx * cx;
 	int ay = -isiny * cx;
-	int sw = srcW - 1;
-	int sh = srcH - 1;
 
-	tColorRGBA *pc = (tColorRGBA*)target->getBasePtr(0, 0);
+	// The bilinear filter needs the pixels to the right and below as well
+	const int64 limitX = (int64)(filteringMode == FILTER_BILINEAR ? srcW - 1 : srcW) << 16;
+	const int64 limitY = (int64)(filteringMode == FILTER_BILINEAR ? srcH - 1 : srcH) << 16;
+	const int srcPitch = this->pitch / 4;
 
 	for (int y = 0; y < dstH; y++) {
 		int t = cy - y;
 		int sdx = ax + (isinx * t) + xd;
 		int sdy = ay - (icosy * t) + yd;
-		for (int x = 0; x < dstW; x++) {
-			int dx = (sdx >> 16);
-			int dy = (sdy >> 16);
-			if (flipx) {
-				dx = sw - dx;
-			}
-			if (flipy) {
-				dy = sh - dy;
-			}
 
+		// The source position moves along a straight line, so the pixels
+		// taken from inside the source form a single span of the row
+		int startX, endX, startY, endY;
+		clipSpan(sdx, icosx, 0, limitX, dstW, startX, endX);
+		clipSpan(sdy, isiny, 0, limitY, dstW, startY, endY);
+		startX = MAX(startX, startY);
+		endX = MIN(endX, endY);
+
+		tColorRGBA *pc = (tColorRGBA *)target->getBasePtr(0, y) + startX;
+		sdx += icosx * startX;
+		sdy += isiny * startX;
+
+		for (int x = startX; x < endX; x++) {
+			const tColorRGBA *sp = (const tColorRGBA *)getBasePtr(0, sdy >> 16) + (sdx >> 16);
 			if (filteringMode == FILTER_BILINEAR) {
-				if ((dx > -1) && (dy > -1) && (dx < sw) && (dy < sh)) {
-					const tColorRGBA *sp = (const tColorRGBA *)getBasePtr(dx, dy);
-					tColorRGBA c00, c01, c10, c11, cswap;
-					c00 = *sp;
-					sp += 1;
-					c01 = *sp;
-					sp += (this->pitch / 4);
-					c11 = *sp;
-					sp -= 1;
-					c10 = *sp;
-					if (flipx) {
-						cswap = c00; c00=c01; c01=cswap;
-						cswap = c10; c10=c11; c11=cswap;
-					}
-					if (flipy) {
-						cswap = c00; c00=c10; c10=cswap;
-						cswap = c01; c01=c11; c11=cswap;
-					}
-					/*
-					* Interpolate colors
-					*/
-					int ex = (sdx & 0xffff);
-					int ey = (sdy & 0xffff);
-					int t1, t2;
-					t1 = ((((c01.r - c00.r) * ex) >> 16) + c00.r) & 0xff;
-					t2 = ((((c11.r - c10.r) * ex) >> 16) + c10.r) & 0xff;
-					pc->r = (((t2 - t1) * ey) >> 16) + t1;
-					t1 = ((((c01.g - c00.g) * ex) >> 16) + c00.g) & 0xff;
-					t2 = ((((c11.g - c10.g) * ex) >> 16) + c10.g) & 0xff;
-					pc->g = (((t2 - t1) * ey) >> 16) + t1;
-					t1 = ((((c01.b - c00.b) * ex) >> 16) + c00.b) & 0xff;
-					t2 = ((((c11.b - c10.b) * ex) >> 16) + c10.b) & 0xff;
-					pc->b = (((t2 - t1) * ey) >> 16) + t1;
-					t1 = ((((c01.a - c00.a) * ex) >> 16) + c00.a) & 0xff;
-					t2 = ((((c11.a - c10.a) * ex) >> 16) + c10.a) & 0xff;
-					pc->a = (((t2 - t1) * ey) >> 16) + t1;
-				}
+				interpolate(pc, sp, sp + 1, sp + srcPitch, sp + srcPitch + 1, sdx & 0xffff, sdy & 0xffff);
 			} else {
-				if ((dx >= 0) && (dy >= 0) && (dx < srcW) && (dy < srcH)) {
-					const tColorRGBA *sp = (const tColorRGBA *)getBasePtr(dx, dy);
-					*pc = *sp;
-				}
+				*pc = *sp;
 			}
 			sdx += icosx;
 			sdy += isiny;
@@ -858,7 +1144,7 @@ TransparentSurface *TransparentSurface::scaleT(uint16 newWidth, uint16 newHeight
 
 		const tColorRGBA *sp = (const tColorRGBA *) getBasePtr(0, 0);
 		tColorRGBA *dp = (tColorRGBA *) target->getBasePtr(0, 0);
-		int spixelgap = srcW;
+		int spixelgap = this->pitch / 4;
 
 		if (flipx) {
 			sp += spixelw;
@@ -905,19 +1191,7 @@ TransparentSurface *TransparentSurface::scaleT(uint16 newWidth, uint16 newHeight
 				/*
 				* Draw and interpolate colors
 				*/
-				int t1, t2;
-				t1 = ((((c01->r - c00->r) * ex) >> 16) + c00->r) & 0xff;
-				t2 = ((((c11->r - c10->r) * ex) >> 16) + c10->r) & 0xff;
-				dp->r = (((t2 - t1) * ey) >> 16) + t1;
-				t1 = ((((c01->g - c00->g) * ex) >> 16) + c00->g) & 0xff;
-				t2 = ((((c11->g - c10->g) * ex) >> 16) + c10->g) & 0xff;
-				dp->g = (((t2 - t1) * ey) >> 16) + t1;
-				t1 = ((((c01->b - c00->b) * ex) >> 16) + c00->b) & 0xff;
-				t2 = ((((c11->b - c10->b) * ex) >> 16) + c10->b) & 0xff;
-				dp->b = (((t2 - t1) * ey) >> 16) + t1;
-				t1 = ((((c01->a - c00->a) * ex) >> 16) + c00->a) & 0xff;
-				t2 = ((((c11->a - c10->a) * ex) >> 16) + c10->a) & 0xff;
-				dp->a = (((t2 - t1) * ey) >> 16) + t1;
+				interpolate(dp, c00, c01, c10, c11, ex, ey);
 
 				/*
 				* Advance source pointer x
@@ -976,80 +1250,11 @@ TransparentSurface *TransparentSurface::scaleT(uint16 newWidth, uint16 newHeight
 }
 
 TransparentSurface *TransparentSurface::convertTo(const PixelFormat &dstFormat, const byte *palette) const {
-	assert(pixels);
-
-	TransparentSurface *surface = new TransparentSurface();
-
-	// If the target format is the same, just copy
-	if (format == dstFormat) {
-		surface->copyFrom(*this);
-		return surface;
-	}
-
-	if (format.bytesPerPixel == 0 || format.bytesPerPixel > 4)
-		error("Surface::convertTo(): Can only convert from 1Bpp, 2Bpp, 3Bpp, and 4Bpp");
-
-	if (dstFormat.bytesPerPixel != 2 && dstFormat.bytesPerPixel != 4)
-		error("Surface::convertTo(): Can only convert to 2Bpp and 4Bpp");
-
-	surface->create(w, h, dstFormat);
-
-	if (format.bytesPerPixel == 1) {
-		// Converting from paletted to high color
-		assert(palette);
-
-		for (int y = 0; y < h; y++) {
-			const byte *srcRow = (const byte *)getBasePtr(0, y);
-			byte *dstRow = (byte *)surface->getBasePtr(0, y);
-
-			for (int x = 0; x < w; x++) {
-				byte index = *srcRow++;
-				byte r = palette[index * 3];
-				byte g = palette[index * 3 + 1];
-				byte b = palette[index * 3 + 2];
-
-				uint32 color = dstFormat.RGBToColor(r, g, b);
-
-				if (dstFormat.bytesPerPixel == 2)
-					*((uint16 *)dstRow) = color;
-				else
-					*((uint32 *)dstRow) = color;
-
-				dstRow += dstFormat.bytesPerPixel;
-			}
-		}
-	} else {
-		// Converting from high color to high color
-		for (int y = 0; y < h; y++) {
-			const byte *srcRow = (const byte *)getBasePtr(0, y);
-			byte *dstRow = (byte *)surface->getBasePtr(0, y);
-
-			for (int x = 0; x < w; x++) {
-				uint32 srcColor;
-				if (format.bytesPerPixel == 2)
-					srcColor = READ_UINT16(srcRow);
-				else if (format.bytesPerPixel == 3)
-					srcColor = READ_UINT24(srcRow);
-				else
-					srcColor = READ_UINT32(srcRow);
-
-				srcRow += format.bytesPerPixel;
-
-				// Convert that color to the new format
-				byte r, g, b, a;
-				format.colorToARGB(srcColor, a, r, g, b);
-				uint32 color = dstFormat.ARGBToColor(a, r, g, b);
-
-				if (dstFormat.bytesPerPixel == 2)
-					*((uint16 *)dstRow) = color;
-				else
-					*((uint32 *)dstRow) = color;
-
-				dstRow += dstFormat.bytesPerPixel;
-			}
-		}
-	}
+	Surface *converted = Surface::convertTo(dstFormat, palette);
 
+	// Take over the pixels of the converted surface
+	TransparentSurface *surface = new TransparentSurface(*converted, false);
+	delete converted;
 	return surface;
 }
 
@@ -86,6 +86,14 @@
 #include "graphics/surface.h"
 #include "graphics/yuv_to_rgb.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define YUV_USE_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#define YUV_USE_NEON
+#include <arm_neon.h>
+#endif
+
 namespace Common {
 DECLARE_SINGLETON(Graphics::YUVToRGBManager);
 }
@@ -192,6 +200,257 @@ const YUVToRGBLookup *YUVToRGBManager::getLookup(Graphics::PixelFormat format, Y
 	return _lookup;
 }
 
+#if defined(YUV_USE_SSE2) || defined(YUV_USE_NEON)
+
+/*
+ * The conversion for eight pixels at a time, computing what the tables
+ * contain instead of looking it up. The chroma tables are replaced by
+ * fixed point factors in units of 1/32768, which give exactly the same
+ * (truncated) values for all 256 chroma values, and the rgbToPix table by
+ * clamping the channels and packing them into the pixel format.
+ */
+
+enum {
+	kCrToR = 45919,  // 0.419 / 0.299
+	kCrToG = 23383,  // 0.299 / 0.419
+	kCbToG = 11286,  // 0.114 / 0.331
+	kCbToB = 58111,  // 0.587 / 0.331
+	kITUScale = 38155 // 255 / 219
+};
+
+/**
+ * How the channels of a lookup are packed into pixels. 2 byte pixels are
+ * put together with shifts. 4 byte pixels are put together bytewise, so
+ * their channels have to be whole bytes; one of their bytes is left for
+ * alpha, or is unused.
+ */
+struct YUVPacking {
+	int shift[3];
+	int loss[3];
+	uint16 alpha;
+
+	int byteChannel[4]; ///< 0-2 for red, green and blue, 3 for the alpha byte
+	int16 alphaByte;
+
+	bool valid;
+
+	YUVPacking(const Graphics::PixelFormat &format) {
+		shift[0] = format.rShift;
+		shift[1] = format.gShift;
+		shift[2] = format.bShift;
+		loss[0] = format.rLoss;
+		loss[1] = format.gLoss;
+		loss[2] = format.bLoss;
+		alpha = format.RGBToColor(0, 0, 0) & 0xFFFF;
+
+		valid = true;
+		if (format.bytesPerPixel == 4) {
+			for (int i = 0; i < 4; ++i)
+				byteChannel[i] = 3;
+			for (int i = 0; i < 3; ++i) {
+				if (loss[i] != 0 || (shift[i] & 7) != 0 || byteChannel[shift[i] / 8] != 3)
+					valid = false;
+				else
+					byteChannel[shift[i] / 8] = i;
+			}
+
+			alphaByte = 0;
+			for (int i = 0; i < 4; ++i) {
+				if (byteChannel[i] == 3)
+					alphaByte = (format.RGBToColor(0, 0, 0) >> (i * 8)) & 0xFF;
+			}
+		}
+	}
+};
+
+#if defined(YUV_USE_SSE2)
+
+typedef __m128i yuv_vec;
+
+static inline yuv_vec vecLoad8(const byte *src) {
+	return _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)src), _mm_setzero_si128());
+}
+static inline yuv_vec vecSplat(int16 x) { return _mm_set1_epi16(x); }
+static inline yuv_vec vecAdd(yuv_vec a, yuv_vec b) { return _mm_add_epi16(a, b); }
+static inline yuv_vec vecSub(yuv_vec a, yuv_vec b) { return _mm_sub_epi16(a, b); }
+static inline yuv_vec vecMin(yuv_vec a, yuv_vec b) { return _mm_min_epi16(a, b); }
+static inline yuv_vec vecMax(yuv_vec a, yuv_vec b) { return _mm_max_epi16(a, b); }
+static inline yuv_vec vecAbs(yuv_vec a) { return _mm_max_epi16(a, _mm_sub_epi16(_mm_setzero_si128(), a)); }
+/** (a * m) >> 16, for unsigned a and m */
+static inline yuv_vec vecMulHi(yuv_vec a, uint16 m) { return _mm_mulhi_epu16(a, _mm_set1_epi16((int16)m)); }
+/** Give a the sign of b */
+static inline yuv_vec vecCopySign(yuv_vec a, yuv_vec b) {
+	const __m128i sign = _mm_srai_epi16(b, 15);
+	return _mm_sub_epi16(_mm_xor_si128(a, sign), sign);
+}
+/** Each of the lanes 0-3 (or 4-7) twice */
+static inline yuv_vec vecDoubleLow(yuv_vec a) { return _mm_unpacklo_epi16(a, a); }
+static inline yuv_vec vecDoubleHigh(yuv_vec a) { return _mm_unpackhi_epi16(a, a); }
+
+static inline __m128i packChannel(yuv_vec channel, const YUVPacking &p, int i) {
+	return _mm_sll_epi16(_mm_srl_epi16(channel, _mm_cvtsi32_si128(p.loss[i])), _mm_cvtsi32_si128(p.shift[i]));
+}
+
+static inline void vecStorePixels(uint16 *dst, const yuv_vec *channels, const YUVPacking &p) {
+	__m128i pixels = _mm_set1_epi16((int16)p.alpha);
+	pixels = _mm_or_si128(pixels, packChannel(channels[0], p, 0));
+	pixels = _mm_or_si128(pixels, packChannel(channels[1], p, 1));
+	pixels = _mm_or_si128(pixels, packChannel(channels[2], p, 2));
+	_mm_storeu_si128((__m128i *)dst, pixels);
+}
+
+static inline void vecStorePixels(uint32 *dst, const yuv_vec *channels, const YUVPacking &p) {
+	const __m128i low = _mm_or_si128(channels[p.byteChannel[0]], _mm_slli_epi16(channels[p.byteChannel[1]], 8));
+	const __m128i high = _mm_or_si128(channels[p.byteChannel[2]], _mm_slli_epi16(channels[p.byteChannel[3]], 8));
+	_mm_storeu_si128((__m128i *)dst, _mm_unpacklo_epi16(low, high));
+	_mm_storeu_si128((__m128i *)(dst + 4), _mm_unpackhi_epi16(low, high));
+}
+
+#elif defined(YUV_USE_NEON)
+
+typedef int16x8_t yuv_vec;
+
+static inline yuv_vec vecLoad8(const byte *src) { return vreinterpretq_s16_u16(vmovl_u8(vld1_u8(src))); }
+static inline yuv_vec vecSplat(int16 x) { return vdupq_n_s16(x); }
+static inline yuv_vec vecAdd(yuv_vec a, yuv_vec b) { return vaddq_s16(a, b); }
+static inline yuv_vec vecSub(yuv_vec a, yuv_vec b) { return vsubq_s16(a, b); }
+static inline yuv_vec vecMin(yuv_vec a, yuv_vec b) { return vminq_s16(a, b); }
+static inline yuv_vec vecMax(yuv_vec a, yuv_vec b) { return vmaxq_s16(a, b); }
+static inline yuv_vec vecAbs(yuv_vec a) { return vabsq_s16(a); }
+/** (a * m) >> 16, for unsigned a and m */
+static inline yuv_vec vecMulHi(yuv_vec a, uint16 m) {
+	const uint16x8_t ua = vreinterpretq_u16_s16(a);
+	const uint16x4_t low = vshrn_n_u32(vmull_n_u16(vget_low_u16(ua), m), 16);
+	const uint16x4_t high = vshrn_n_u32(vmull_n_u16(vget_high_u16(ua), m), 16);
+	return vreinterpretq_s16_u16(vcombine_u16(low, high));
+}
+/** Give a the sign of b */
+static inline yuv_vec vecCopySign(yuv_vec a, yuv_vec b) {
+	const int16x8_t sign = vshrq_n_s16(b, 15);
+	return vsubq_s16(veorq_s16(a, sign), sign);
+}
+/** Each of the lanes 0-3 (or 4-7) twice */
+static inline yuv_vec vecDoubleLow(yuv_vec a) { return vzipq_s16(a, a).val[0]; }
+static inline yuv_vec vecDoubleHigh(yuv_vec a) { return vzipq_s16(a, a).val[1]; }
+
+static inline uint16x8_t packChannel(yuv_vec channel, const YUVPacking &p, int i) {
+	const uint16x8_t value = vshlq_u16(vreinterpretq_u16_s16(channel), vdupq_n_s16(-p.loss[i]));
+	return vshlq_u16(value, vdupq_n_s16(p.shift[i]));
+}
+
+static inline void vecStorePixels(uint16 *dst, const yuv_vec *channels, const YUVPacking &p) {
+	uint16x8_t pixels = vdupq_n_u16(p.alpha);
+	pixels = vorrq_u16(pixels, packChannel(channels[0], p, 0));
+	pixels = vorrq_u16(pixels, packChannel(channels[1], p, 1));
+	pixels = vorrq_u16(pixels, packChannel(channels[2], p, 2));
+	vst1q_u16(dst, pixels);
+}
+
+static inline void vecStorePixels(uint32 *dst, const yuv_vec *channels, const YUVPacking &p) {
+	const uint16x8_t low = vreinterpretq_u16_s16(vorrq_s16(channels[p.byteChannel[0]], vshlq_n_s16(channels[p.byteChannel[1]], 8)));
+	const uint16x8_t high = vreinterpretq_u16_s16(vorrq_s16(channels[p.byteChannel[2]], vshlq_n_s16(channels[p.byteChannel[3]], 8)));
+	vst1q_u32(dst, vorrq_u32(vmovl_u16(vget_low_u16(low)), vshll_n_u16(vget_low_u16(high), 16)));
+	vst1q_u32(dst + 4, vorrq_u32(vmovl_u16(vget_high_u16(low)), vshll_n_u16(vget_high_u16(high), 16)));
+}
+
+#endif
+
+/**
+ * The offsets the chroma tables give for eight pairs of chroma values,
+ * with the products truncated towards zero like the tables. For the ITU
+ * scale, they are doubled like the luminance.
+ */
+template<bool kITU>
+static inline void chromaToOffsets(yuv_vec u, yuv_vec v, yuv_vec &r, yuv_vec &g, yuv_vec &b) {
+	const yuv_vec cr = vecSub(v, vecSplat(128));
+	const yuv_vec cb = vecSub(u, vecSplat(128));
+	// The absolute values are doubled, so that the factors can be in units of 1/32768
+	const yuv_vec crAbs = vecAdd(vecAbs(cr), vecAbs(cr));
+	const yuv_vec cbAbs = vecAdd(vecAbs(cb), vecAbs(cb));
+
+	r = vecCopySign(vecMulHi(crAbs, kCrToR), cr);
+	g = vecSub(vecSplat(0), vecAdd(vecCopySign(vecMulHi(crAbs, kCrToG), cr), vecCopySign(vecMulHi(cbAbs, kCbToG), cb)));
+	b = vecCopySign(vecMulHi(cbAbs, kCbToB), cb);
+
+	if (kITU) {
+		r = vecAdd(r, r);
+		g = vecAdd(g, g);
+		b = vecAdd(b, b);
+	}
+}
+
+/**
+ * Convert eight pixels. For the ITU scale, the luminance is taken twice
+ * above 16, so that clamping to [0, 438] and multiplying with 255 / 438
+ * gives the scaled channels.
+ */
+template<bool kITU, typename PixelInt>
+static inline void convertPixels(PixelInt *dst, const byte *ySrc, yuv_vec r, yuv_vec g, yuv_vec b, const YUVPacking &p) {
+	const int16 maxValue = kITU ? 2 * (235 - 16) : 255;
+
+	yuv_vec y = vecLoad8(ySrc);
+	if (kITU)
+		y = vecSub(vecAdd(y, y), vecSplat(2 * 16));
+
+	yuv_vec channels[4];
+	channels[0] = vecMin(vecMax(vecAdd(y, r), vecSplat(0)), vecSplat(maxValue));
+	channels[1] = vecMin(vecMax(vecAdd(y, g), vecSplat(0)), vecSplat(maxValue));
+	channels[2] = vecMin(vecMax(vecAdd(y, b), vecSplat(0)), vecSplat(maxValue));
+	channels[3] = vecSplat(p.alphaByte);
+	if (kITU) {
+		channels[0] = vecMulHi(channels[0], kITUScale);
+		channels[1] = vecMulHi(channels[1], kITUScale);
+		channels[2] = vecMulHi(channels[2], kITUScale);
+	}
+
+	vecStorePixels(dst, channels, p);
+}
+
+/**
+ * Convert one row of a YUV444 image, eight pixels at a time. Returns the
+ * number of pixels converted, the rest is left to the caller.
+ */
+template<bool kITU, typename PixelInt>
+int convertYUV444Row(PixelInt *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, int width, const YUVPacking &packing) {
+	// A local copy, which the stores cannot alias
+	const YUVPacking p = packing;
+
+	int x = 0;
+	for (; x + 8 <= width; x += 8) {
+		yuv_vec r, g, b;
+		chromaToOffsets<kITU>(vecLoad8(uSrc + x), vecLoad8(vSrc + x), r, g, b);
+		convertPixels<kITU>(dst + x, ySrc + x, r, g, b, p);
+	}
+	return x;
+}
+
+/**
+ * Convert two rows of a YUV420 image, which share their chroma values,
+ * sixteen pixels at a time. Returns the number of pixels per row
+ * converted, the rest is left to the caller.
+ */
+template<bool kITU, typename PixelInt>
+int convertYUV420Rows(PixelInt *dst0, PixelInt *dst1, const byte *ySrc0, const byte *ySrc1, const byte *uSrc, const byte *vSrc, int width, const YUVPacking &packing) {
+	// A local copy, which the stores cannot alias
+	const YUVPacking p = packing;
+
+	int x = 0;
+	for (; x + 16 <= width; x += 16) {
+		yuv_vec r, g, b;
+		chromaToOffsets<kITU>(vecLoad8(uSrc + x / 2), vecLoad8(vSrc + x / 2), r, g, b);
+
+		const yuv_vec r0 = vecDoubleLow(r), g0 = vecDoubleLow(g), b0 = vecDoubleLow(b);
+		const yuv_vec r1 = vecDoubleHigh(r), g1 = vecDoubleHigh(g), b1 = vecDoubleHigh(b);
+		convertPixels<kITU>(dst0 + x, ySrc0 + x, r0, g0, b0, p);
+		convertPixels<kITU>(dst0 + x + 8, ySrc0 + x + 8, r1, g1, b1, p);
+		convertPixels<kITU>(dst1 + x, ySrc1 + x, r0, g0, b0, p);
+		convertPixels<kITU>(dst1 + x + 8, ySrc1 + x + 8, r1, g1, b1, p);
+	}
+	return x;
+}
+
+#endif
+
 #define PUT_PIXEL(s, d) \
 	L = &rgbToPix[(s)]; \
 	*((PixelInt *)(d)) = (L[cr_r] | L[crb_g] | L[cb_b])
@@ -205,8 +464,25 @@ void convertYUV444ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup
 	const int16 *Cb_b_tab = Cb_g_tab + 256;
 	const uint32 *rgbToPix = lookup->getRGBToPix();
 
+#if defined(YUV_USE_SSE2) || defined(YUV_USE_NEON)
+	const YUVPacking packing(lookup->getFormat());
+	const bool itu = (lookup->getScale() == YUVToRGBManager::kScaleITU);
+#endif
+
 	for (int h = 0; h < yHeight; h++) {
-		for (int w = 0; w < yWidth; w++) {
+		int w = 0;
+#if defined(YUV_USE_SSE2) || defined(YUV_USE_NEON)
+		if (packing.valid && itu)
+			w = convertYUV444Row<true>((PixelInt *)dstPtr, ySrc, uSrc, vSrc, yWidth, packing);
+		else if (packing.valid)
+			w = convertYUV444Row<false>((PixelInt *)dstPtr, ySrc, uSrc, vSrc, yWidth, packing);
+		dstPtr += w * sizeof(PixelInt);
+		ySrc += w;
+		uSrc += w;
+		vSrc += w;
+#endif
+
+		for (; w < yWidth; w++) {
 			register const uint32 *L;
 
 			int16 cr_r  = Cr_r_tab[*vSrc];
@@ -254,8 +530,25 @@ void convertYUV420ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup
 	const int16 *Cb_b_tab = Cb_g_tab + 256;
 	const uint32 *rgbToPix = lookup->getRGBToPix();
 
+#if defined(YUV_USE_SSE2) || defined(YUV_USE_NEON)
+	const YUVPacking packing(lookup->getFormat());
+	const bool itu = (lookup->getScale() == YUVToRGBManager::kScaleITU);
+#endif
+
 	for (int h = 0; h < halfHeight; h++) {
-		for (int w = 0; w < halfWidth; w++) {
+		int w = 0;
+#if defined(YUV_USE_SSE2) || defined(YUV_USE_NEON)
+		if (packing.valid && itu)
+			w = convertYUV420Rows<true>((PixelInt *)dstPtr, (PixelInt *)(dstPtr + dstPitch), ySrc, ySrc + yPitch, uSrc, vSrc, yWidth, packing) / 2;
+		else if (packing.valid)
+			w = convertYUV420Rows<false>((PixelInt *)dstPtr, (PixelInt *)(dstPtr + dstPitch), ySrc, ySrc + yPitch, uSrc, vSrc, yWidth, packing) / 2;
+		dstPtr += 2 * w * sizeof(PixelInt);
+		ySrc += 2 * w;
+		uSrc += w;
+		vSrc += w;
+#endif
+
+		for (; w < halfWidth; w++) {
 			register const uint32 *L;
 
 			int16 cr_r  = Cr_r_tab[*vSrc];
@@ -24,6 +24,10 @@
 #include "common/config-manager.h"
 #include "common/file.h"
 #include "common/fs.h"
+#include "common/md5.h"
+#include "common/memstream.h"
+#include "common/savefile.h"
+#include "common/substream.h"
 #include "common/unzip.h"
 #include "common/tokenizer.h"
 #include "common/translation.h"
@@ -900,6 +904,11 @@ void ThemeEngine::unloadTheme() {
 	if (!_themeOk)
 		return;
 
+	clearThemeData();
+	_themeOk = false;
+}
+
+void ThemeEngine::clearThemeData() {
 	for (int i = 0; i < kDrawDataMAX; ++i) {
 		delete _widgets[i];
 		_widgets[i] = 0;
@@ -916,7 +925,6 @@ void ThemeEngine::unloadTheme() {
 	}
 
 	_themeEval->reset();
-	_themeOk = false;
 }
 
 bool ThemeEngine::loadDefaultXML() {
@@ -989,9 +997,37 @@ bool ThemeEngine::loadThemeXML(const Common::String &themeId) {
 		return false;
 	}
 
+	//
+	// The theme cache is only used if none of the STX files changed. Their
+	// size and modification time, or their CRC in zip files, tell without
+	// reading them; only archives which have neither are hashed.
+	//
+	Common::String checksum;
+	for (Common::ArchiveMemberList::iterator i = members.begin(); i != members.end(); ++i) {
+		Common::String fingerprint = (*i)->getFingerprint();
+		if (fingerprint.empty()) {
+			Common::SeekableReadStream *stream = (*i)->createReadStream();
+			if (!stream) {
+				warning("Failed to load STX file '%s'", (*i)->getDisplayName().c_str());
+				return false;
+			}
+
+			fingerprint = Common::computeStreamMD5AsString(*stream);
+			delete stream;
+		}
+
+		checksum += (*i)->getName() + ":" + fingerprint + ";";
+	}
+
+	if (loadThemeCache(checksum)) {
+		assert(!_themeName.empty());
+		return true;
+	}
+
 	//
 	// Loop over all STX files, load and parse them
 	//
+	Common::MemoryWriteStreamDynamic compiled(DisposeAfterUse::YES);
 	for (Common::ArchiveMemberList::iterator i = members.begin(); i != members.end(); ++i) {
 		assert((*i)->getName().hasSuffix(".stx"));
 
@@ -1001,19 +1037,98 @@ bool ThemeEngine::loadThemeXML(const Common::String &themeId) {
 			return false;
 		}
 
-		if (_parser->parse() == false) {
+		// Each file is preceded by the size of its compiled form
+		const uint32 sizePos = compiled.pos();
+		compiled.writeUint32LE(0);
+
+		if (_parser->parse(&compiled) == false) {
 			warning("Failed to parse STX file '%s'", (*i)->getDisplayName().c_str());
 			_parser->close();
 			return false;
 		}
 
+		WRITE_LE_UINT32(compiled.getData() + sizePos, compiled.pos() - sizePos - 4);
 		_parser->close();
 	}
 
+	saveThemeCache(checksum, compiled, members.size());
+
 	assert(!_themeName.empty());
 	return true;
 }
 
+static Common::String getThemeCacheFileName(const Common::String &themeId) {
+	Common::String fileName = "themecache-";
+	for (uint i = 0; i < themeId.size(); ++i)
+		fileName += Common::isAlnum(themeId[i]) ? themeId[i] : '_';
+	return fileName + ".dat";
+}
+
+enum {
+	kThemeCacheVersion = 2
+};
+
+bool ThemeEngine::loadThemeCache(const Common::String &checksum) {
+	Common::SaveFileManager *saveFileMan = g_system->getSavefileManager();
+	const Common::String fileName = getThemeCacheFileName(_themeId);
+	Common::InSaveFile *file = saveFileMan ? saveFileMan->openRawFile(fileName) : 0;
+	if (!file)
+		return false;
+
+	bool result = file->readUint32BE() == MKTAG('T', 'H', 'M', 'C') && file->readUint32LE() == kThemeCacheVersion;
+	if (result) {
+		const uint32 length = file->readUint32LE();
+		Common::String fileChecksum;
+		for (uint32 i = 0; i < length && !file->eos(); ++i)
+			fileChecksum += (char)file->readByte();
+		result = fileChecksum == checksum;
+	}
+
+	if (!result) {
+		debug(2, "ThemeEngine: Theme cache '%s' is out of date", fileName.c_str());
+		delete file;
+		return false;
+	}
+
+	const uint32 fileCount = file->readUint32LE();
+	for (uint32 i = 0; i < fileCount && result; ++i) {
+		const uint32 size = file->readUint32LE();
+		const uint32 start = file->pos();
+		Common::SeekableSubReadStream stream(file, start, start + size);
+		result = _parser->parseCompiled(&stream);
+		file->seek(start + size);
+	}
+
+	if (!result) {
+		// Throw away what was parsed, the STX files are parsed again
+		warning("Failed to parse theme cache '%s'", fileName.c_str());
+		clearThemeData();
+	}
+
+	delete file;
+	return result;
+}
+
+void ThemeEngine::saveThemeCache(const Common::String &checksum, Common::MemoryWriteStreamDynamic &compiled, uint32 fileCount) {
+	Common::SaveFileManager *saveFileMan = g_system->getSavefileManager();
+	const Common::String fileName = getThemeCacheFileName(_themeId);
+	Common::OutSaveFile *file = saveFileMan ? saveFileMan->openForSaving(fileName, false) : 0;
+	if (!file)
+		return;
+
+	file->writeUint32BE(MKTAG('T', 'H', 'M', 'C'));
+	file->writeUint32LE(kThemeCacheVersion);
+	file->writeUint32LE(checksum.size());
+	file->writeString(checksum);
+	file->writeUint32LE(fileCount);
+	file->write(compiled.getData(), compiled.size());
+
+	file->finalize();
+	if (file->err())
+		warning("Failed to write theme cache '%s'", fileName.c_str());
+	delete file;
+}
+
 
 
 /**********************************************************
@@ -2231,11 +2346,9 @@ bool ThemeEngine::themeConfigUsable(const Common::FSNode &node, Common::String &
 			stream.open("THEMERC", *zipArchive);
 		}
 		// Delete the ZIP archive again. Note: This only works because
-		// stream.open() only uses ZipArchive::createReadStreamForMember,
-		// and that in turn happens to read all the data for a given
-		// archive member into a memory block. So there will be no dangling
-		// reference to zipArchive anywhere. This could change if we
-		// ever modify ZipArchive::createReadStreamForMember.
+		// the streams returned by ZipArchive::createReadStreamForMember
+		// keep their own reference to the underlying ZIP file stream.
+		// So there will be no dangling reference to zipArchive anywhere.
 		delete zipArchive;
 	} else if (node.isDirectory()) {
 		Common::FSNode headerfile = node.getChild("THEMERC");
@@ -41,6 +41,10 @@
 
 class OSystem;
 
+namespace Common {
+class MemoryWriteStreamDynamic;
+}
+
 namespace Graphics {
 struct DrawStep;
 class VectorRenderer;
@@ -604,6 +608,21 @@ protected:
 	 */
 	bool loadThemeXML(const Common::String &themeId);
 
+	/**
+	 * Parses the STX files of a theme from the theme cache, if the cache
+	 * was written for exactly these files.
+	 *
+	 * @param checksum Names and fingerprints of the STX files.
+	 * @returns true if the theme was parsed from the cache.
+	 */
+	bool loadThemeCache(const Common::String &checksum);
+
+	/**
+	 * Writes the theme cache, the STX files of the theme compiled by
+	 * XMLParser::parse() one after another.
+	 */
+	void saveThemeCache(const Common::String &checksum, Common::MemoryWriteStreamDynamic &compiled, uint32 fileCount);
+
 	/**
 	 * Loads the default theme file (the embedded XML file found
 	 * in ThemeDefaultXML.cpp).
@@ -617,6 +636,12 @@ protected:
 	 */
 	void unloadTheme();
 
+	/**
+	 * Deletes the draw data, texts, colors and layouts parsed so far,
+	 * whether or not the theme was loaded completely.
+	 */
+	void clearThemeData();
+
 	const Graphics::Font *loadScalableFont(const Common::String &filename, const Common::String &charset, const int pointsize, Common::String &name);
 	const Graphics::Font *loadFont(const Common::String &filename, Common::String &name);
 	Common::String genCacheFilename(const Common::String &filename) const;
@@ -23,13 +23,19 @@
 // NB: This is really only necessary if USE_READLINE is defined
 #define FORBIDDEN_SYMBOL_ALLOW_ALL
 
+#include "common/arena.h"
+#include "common/archive.h"
+#include "common/bufferedstream.h"
+#include "common/config-manager.h"
+#include "common/coroutines.h"
 #include "common/debug.h"
 #include "common/debug-channels.h"
 #include "common/system.h"
+#include "common/timer.h"
+#include "common/trace.h"
 
 #ifndef DISABLE_MD5
 #include "common/md5.h"
-#include "common/archive.h"
 #include "common/macresman.h"
 #include "common/stream.h"
 #endif
@@ -73,6 +79,15 @@ Debugger::Debugger() {
 	registerCmd("md5",				WRAP_METHOD(Debugger, cmdMd5));
 	registerCmd("md5mac",			WRAP_METHOD(Debugger, cmdMd5Mac));
 #endif
+	registerCmd("searchman_stats",	WRAP_METHOD(Debugger, cmdSearchManStats));
+	registerCmd("config_stats",		WRAP_METHOD(Debugger, cmdConfigStats));
+	registerCmd("arenas",			WRAP_METHOD(Debugger, cmdArenas));
+	registerCmd("streams",			WRAP_METHOD(Debugger, cmdStreams));
+	registerCmd("coroutines",		WRAP_METHOD(Debugger, cmdCoroutines));
+	registerCmd("timers",			WRAP_METHOD(Debugger, cmdTimers));
+#ifdef ENABLE_TRACING
+	registerCmd("trace",			WRAP_METHOD(Debugger, cmdTrace));
+#endif
 
 	registerCmd("debuglevel",		WRAP_METHOD(Debugger, cmdDebugLevel));
 	registerCmd("debugflag_list",		WRAP_METHOD(Debugger, cmdDebugFlagsList));
@@ -596,11 +611,36 @@ bool Debugger::cmdMd5(int argc, const char **argv) {
 			debugPrintf("File '%s' not found\n", filename.c_str());
 		} else {
 			sort(list.begin(), list.end(), ArchiveMemberLess());
-			for (Common::ArchiveMemberList::iterator iter = list.begin(); iter != list.end(); ++iter) {
-				Common::SeekableReadStream *stream = (*iter)->createReadStream();
-				Common::String md5 = Common::computeStreamMD5AsString(*stream, length);
-				debugPrintf("%s  %s  %d\n", md5.c_str(), (*iter)->getDisplayName().c_str(), stream->size());
-				delete stream;
+
+			// Hash the files in batches, which is faster for patterns
+			// matching many of them. Only one batch is open at a time.
+			Common::ArchiveMemberList::iterator iter = list.begin();
+			while (iter != list.end()) {
+				Common::ArchiveMemberPtr members[Common::kMD5Lanes];
+				Common::ReadStream *streams[Common::kMD5Lanes];
+				int32 sizes[Common::kMD5Lanes];
+				uint count = 0;
+				for (; iter != list.end() && count < Common::kMD5Lanes; ++iter) {
+					Common::SeekableReadStream *stream = (*iter)->createReadStream();
+					if (!stream)
+						continue;
+					members[count] = *iter;
+					streams[count] = stream;
+					sizes[count] = stream->size();
+					++count;
+				}
+
+				uint8 digests[Common::kMD5Lanes][16];
+				if (count)
+					Common::computeStreamsMD5(streams, count, digests, length);
+
+				for (uint i = 0; i < count; ++i) {
+					Common::String md5;
+					for (int j = 0; j < 16; j++)
+						md5 += Common::String::format("%02x", (int)digests[i][j]);
+					debugPrintf("%s  %s  %d\n", md5.c_str(), members[i]->getDisplayName().c_str(), sizes[i]);
+					delete streams[i];
+				}
 			}
 		}
 	}
@@ -659,6 +699,151 @@ bool Debugger::cmdMd5Mac(int argc, const char **argv) {
 }
 #endif
 
+bool Debugger::cmdSearchManStats(int argc, const char **argv) {
+	const Common::SearchSet::IndexStats &stats = SearchMan.getIndexStats();
+	uint32 lookups = stats.hits + stats.misses;
+
+	debugPrintf("Cached names: %d\n", SearchMan.getIndexSize());
+	debugPrintf("Lookups: %d (%d hits, %d misses)\n", lookups, stats.hits, stats.misses);
+	if (lookups)
+		debugPrintf("Hit rate: %d%%\n", stats.hits * 100 / lookups);
+	debugPrintf("Invalidations: %d\n", stats.invalidations);
+	return true;
+}
+
+bool Debugger::cmdConfigStats(int argc, const char **argv) {
+	const Common::ConfigManager::Stats stats = ConfMan.getStats();
+
+	debugPrintf("Load time: %d ms\n", stats.loadTime);
+	debugPrintf("Domains: %d (%d parsed)\n", stats.domains, stats.parsedDomains);
+	debugPrintf("Flushes: %d (%d skipped), last one took %d ms\n", stats.flushes + stats.skippedFlushes,
+		stats.skippedFlushes, stats.flushTime);
+	return true;
+}
+
+bool Debugger::cmdArenas(int argc, const char **argv) {
+	if (!Common::Arena::getFirst()) {
+		debugPrintf("No arenas\n");
+		return true;
+	}
+
+	debugPrintf("%-20s %8s %10s %10s %10s %10s %6s\n", "Arena", "Blocks", "Requested", "Used", "Reserved", "Peak", "Frag");
+	for (const Common::Arena *arena = Common::Arena::getFirst(); arena; arena = arena->getNext()) {
+		const Common::Arena::Stats stats = arena->getStats();
+		// Fragmentation: the share of reserved memory not holding user data
+		int frag = stats.reservedBytes ? 100 - (int)(stats.requestedBytes * 100.0 / stats.reservedBytes) : 0;
+		debugPrintf("%-20s %8d %10d %10d %10d %10d %5d%%\n", arena->getName(), stats.liveBlocks,
+			(int)stats.requestedBytes, (int)stats.usedBytes, (int)stats.reservedBytes,
+			(int)stats.peakRequestedBytes, frag);
+	}
+	return true;
+}
+
+bool Debugger::cmdStreams(int argc, const char **argv) {
+	const Common::Array<Common::ReadAheadStats> streams = Common::ReadAheadStreamList::instance().getStats();
+	if (streams.empty()) {
+		debugPrintf("No read-ahead streams\n");
+		return true;
+	}
+
+	for (uint i = 0; i < streams.size(); ++i) {
+		const Common::ReadAheadStats &stats = streams[i];
+		debugPrintf("%s: window %d, %d bytes read, %d refills, %d seeks\n",
+			stats.name.empty() ? "(unnamed)" : stats.name.c_str(), stats.window,
+			stats.bytesRead, stats.refills, stats.seeks);
+
+		// Waiting times, by powers of two milliseconds
+		Common::String histogram = "  wait ms:";
+		for (int j = 0; j < Common::ReadAheadStats::kLatencyBuckets; ++j) {
+			if (!stats.latency[j])
+				continue;
+			if (j == 0)
+				histogram += Common::String::format(" <1:%d", stats.latency[j]);
+			else if (j == Common::ReadAheadStats::kLatencyBuckets - 1)
+				histogram += Common::String::format(" >=%d:%d", 1 << (j - 1), stats.latency[j]);
+			else
+				histogram += Common::String::format(" %d-%d:%d", 1 << (j - 1), 1 << j, stats.latency[j]);
+		}
+		debugPrintf("%s\n", histogram.c_str());
+	}
+	return true;
+}
+
+bool Debugger::cmdCoroutines(int argc, const char **argv) {
+	if (!Common::CoroutineScheduler::hasInstance()) {
+		debugPrintf("No coroutine scheduler\n");
+		return true;
+	}
+
+	if (argc > 1 && !strcmp(argv[1], "reset")) {
+		CoroScheduler.resetProfile();
+		debugPrintf("Coroutine profile cleared\n");
+		return true;
+	}
+
+	if (argc > 1 && (!strcmp(argv[1], "start") || !strcmp(argv[1], "stop"))) {
+		CoroScheduler.setProfiling(!strcmp(argv[1], "start"));
+		debugPrintf("Coroutine timing %s\n", CoroScheduler.isProfiling() ? "started" : "stopped");
+		return true;
+	}
+
+	const Common::Array<Common::CoroProfile> profile = CoroScheduler.getProfile();
+	if (profile.empty()) {
+		debugPrintf("No coroutines have been run\n");
+		return true;
+	}
+
+	debugPrintf("%6s %6s %8s %8s %8s %8s  %s\n", "Procs", "Active", "Runs", "Time ms", "Events", "Sleeps", "Coroutine");
+	for (uint i = 0; i < profile.size(); ++i) {
+		const Common::CoroProfile &entry = profile[i];
+		const Common::String name = entry.funcName ? Common::String(entry.funcName) :
+			Common::String::format("%p", (void *)entry.coroAddr);
+		debugPrintf("%6d %6d %8d %8d %8d %8d  %s\n", entry.processes, entry.active, entry.stats.runs,
+			entry.stats.time, entry.stats.eventWakeups, entry.stats.sleepWakeups, name.c_str());
+	}
+	if (CoroScheduler.isProfiling())
+		debugPrintf("Use '%s stop' to stop measuring times\n", argv[0]);
+	else
+		debugPrintf("Times are only measured after '%s start'\n", argv[0]);
+	debugPrintf("Use '%s reset' to clear the profile\n", argv[0]);
+	return true;
+}
+
+bool Debugger::cmdTimers(int argc, const char **argv) {
+	const Common::Array<Common::TimerStats> timers = g_system->getTimerManager()->getTimerStats();
+	if (timers.empty()) {
+		debugPrintf("No timer statistics\n");
+		return true;
+	}
+
+	// All intervals are in microseconds
+	debugPrintf("%-24s %8s %8s %8s %8s %8s %8s %8s\n", "Timer", "Calls", "Interval", "Mean", "Min", "Max", "Jitter", "Late ms");
+	for (uint i = 0; i < timers.size(); ++i) {
+		const Common::TimerStats &stats = timers[i];
+		debugPrintf("%-24s %8d %8d %8d %8d %8d %8d %8d\n", stats.id.c_str(), stats.calls, stats.interval,
+			stats.meanInterval, stats.minInterval, stats.maxInterval, stats.jitter, stats.maxLateness);
+	}
+	return true;
+}
+
+#ifdef ENABLE_TRACING
+bool Debugger::cmdTrace(int argc, const char **argv) {
+	if (argc == 3 && !strcmp(argv[1], "start")) {
+		if (Common::startTrace(argv[2]))
+			debugPrintf("Writing trace events to '%s'\n", argv[2]);
+		else
+			debugPrintf("Could not create '%s'\n", argv[2]);
+	} else if (argc == 2 && !strcmp(argv[1], "stop")) {
+		Common::stopTrace();
+		debugPrintf("Trace stopped\n");
+	} else {
+		debugPrintf("Tracing is %s\n", Common::gTraceEnabled ? "running" : "stopped");
+		debugPrintf("Usage: %s start <file> | stop\n", argv[0]);
+	}
+	return true;
+}
+#endif
+
 bool Debugger::cmdDebugLevel(int argc, const char **argv) {
 	if (argc == 1) { // print level
 		debugPrintf("Debugging is currently %s (set at level %d)\n", (gDebugLevel >= 0) ? "enabled" : "disabled", gDebugLevel);
@@ -221,6 +221,15 @@ protected:
 #ifndef DISABLE_MD5
 	bool cmdMd5(int argc, const char **argv);
 	bool cmdMd5Mac(int argc, const char **argv);
+#endif
+	bool cmdSearchManStats(int argc, const char **argv);
+	bool cmdConfigStats(int argc, const char **argv);
+	bool cmdArenas(int argc, const char **argv);
+	bool cmdStreams(int argc, const char **argv);
+	bool cmdCoroutines(int argc, const char **argv);
+	bool cmdTimers(int argc, const char **argv);
+#ifdef ENABLE_TRACING
+	bool cmdTrace(int argc, const char **argv);
 #endif
 	bool cmdDebugLevel(int argc, const char **argv);
 	bool cmdDebugFlagsList(int argc, const char **argv);
@@ -24,6 +24,10 @@
 #include "common/algorithm.h"
 #include "common/config-manager.h"
 #include "common/debug.h"
+#include "common/mutex.h"
+#include "common/queue.h"
+#include "common/stack.h"
+#include "common/stream.h"
 #include "common/system.h"
 #include "common/taskbar.h"
 #include "common/translation.h"
@@ -56,10 +60,215 @@ enum {
 	kCancelCmd = 'CNCL'
 };
 
+enum {
+	// Number of threads listing directories, if the backend supports them.
+	// Listing is mostly waiting for the file system, so this does not need
+	// to match the number of cores.
+	kScanThreads = 4,
+
+	// Worker threads read the start of up to this many files per directory,
+	// which is where most detectors look. Detection itself is not reentrant,
+	// but this way its reads are served from the OS cache.
+	kPrefetchFiles = 64,
+	kPrefetchBytes = 5000
+};
+
+/**
+ * Walks the directory tree for the mass add dialog.
+ *
+ * If the backend supports threads and semaphores, the tree is listed by a
+ * pool of worker threads, which also read ahead the data the detectors are
+ * going to look at. The listings are queued for the dialog, which then only
+ * has to run the detectors on them. Otherwise, the dialog lists the
+ * directories itself by calling scanNext().
+ *
+ * While the workers run, strings are made thread safe. Still, they never
+ * share String or FSNode instances with the dialog: pending directories are
+ * passed around as fresh copies of their paths, and a Result is not touched
+ * by a worker after it has been queued.
+ */
+class MassAddScanner {
+public:
+	struct Result {
+		Common::FSNode dir;
+		Common::FSList files;
+		int subdirs;
+	};
+
+	MassAddScanner(const Common::FSNode &startDir);
+	~MassAddScanner();
+
+	/** Whether directories are listed by worker threads. */
+	bool hasThreads() const { return !_threads.empty(); }
+
+	/** List the next pending directory on the calling thread. */
+	bool scanNext();
+
+	/** Take the next listing from the queue, or return 0 if none is ready. */
+	Result *popResult();
+
+	/** Whether all directories have been listed and taken from the queue. */
+	bool isFinished();
+
+private:
+	Common::Mutex _mutex;
+	Common::Stack<Common::String> _pending;
+	Common::Queue<Result *> _results;
+	int _busy;
+	bool _stop;
+	Common::Array<OSystem::ThreadRef> _threads;
+
+	/**
+	 * Counts the pending directories for the workers. Once everything has
+	 * been listed, or the scan is stopped, it is posted once more to wake up
+	 * the next worker, which in turn wakes up the next one when it quits.
+	 */
+	OSystem::SemaphoreRef _work;
+
+	bool takePending(Common::String &path);
+	void listDirectory(const Common::String &path, bool prefetch);
+
+	static void workerProc(void *param);
+};
+
+MassAddScanner::MassAddScanner(const Common::FSNode &startDir) : _busy(0), _stop(false) {
+	_pending.push(Common::String(startDir.getPath().c_str()));
+
+	_work = g_system->createSemaphore(_pending.size());
+	if (_work) {
+		Common::String::setThreadSafe(true);
+
+		for (int i = 0; i < kScanThreads; ++i) {
+			OSystem::ThreadRef thread = g_system->createThread(workerProc, this);
+			if (!thread)
+				break;
+			_threads.push_back(thread);
+		}
+
+		if (_threads.empty()) {
+			Common::String::setThreadSafe(false);
+			g_system->deleteSemaphore(_work);
+			_work = 0;
+		}
+	}
+
+	debug(1, "MassAddScanner: Using %d worker threads", _threads.size());
+}
+
+MassAddScanner::~MassAddScanner() {
+	if (_work) {
+		_mutex.lock();
+		_stop = true;
+		_mutex.unlock();
+		g_system->postSemaphore(_work);
+
+		for (uint i = 0; i < _threads.size(); ++i)
+			g_system->joinThread(_threads[i]);
+
+		g_system->deleteSemaphore(_work);
+		Common::String::setThreadSafe(false);
+	}
+
+	while (!_results.empty())
+		delete _results.pop();
+}
+
+void MassAddScanner::workerProc(void *param) {
+	MassAddScanner *scanner = (MassAddScanner *)param;
+
+	while (true) {
+		g_system->waitSemaphore(scanner->_work);
+
+		Common::String path;
+		if (!scanner->takePending(path)) {
+			// Everything has been listed, or we are stopping.
+			// Pass the wake up on to the next worker.
+			g_system->postSemaphore(scanner->_work);
+			break;
+		}
+
+		scanner->listDirectory(path, true);
+	}
+}
+
+bool MassAddScanner::scanNext() {
+	Common::String path;
+	if (!takePending(path))
+		return false;
+
+	listDirectory(path, false);
+	return true;
+}
+
+bool MassAddScanner::takePending(Common::String &path) {
+	Common::StackLock lock(_mutex);
+	if (_stop || _pending.empty())
+		return false;
+
+	path = Common::String(_pending.top().c_str());
+	_pending.pop();
+	++_busy;
+	return true;
+}
+
+void MassAddScanner::listDirectory(const Common::String &path, bool prefetch) {
+	Result *result = new Result();
+	Common::Array<Common::String> subdirs;
+	int prefetched = 0;
+
+	// Use a fresh copy of the path, so that the result shares nothing with
+	// the caller once it has been queued.
+	result->dir = Common::FSNode(Common::String(path.c_str()));
+	result->dir.getChildren(result->files, Common::FSNode::kListAll);
+
+	for (Common::FSList::const_iterator file = result->files.begin(); file != result->files.end(); ++file) {
+		if (file->isDirectory()) {
+			subdirs.push_back(Common::String(file->getPath().c_str()));
+		} else if (prefetch && prefetched < kPrefetchFiles) {
+			Common::SeekableReadStream *stream = file->createReadStream();
+			if (stream) {
+				byte buf[kPrefetchBytes];
+				stream->read(buf, sizeof(buf));
+				delete stream;
+			}
+			++prefetched;
+		}
+	}
+	result->subdirs = subdirs.size();
+
+	bool finished;
+	{
+		Common::StackLock lock(_mutex);
+		for (uint i = 0; i < subdirs.size(); ++i)
+			_pending.push(Common::String(subdirs[i].c_str()));
+		_results.push(result);
+		--_busy;
+		finished = _pending.empty() && _busy == 0;
+	}
+
+	if (_work) {
+		for (uint i = 0; i < subdirs.size(); ++i)
+			g_system->postSemaphore(_work);
+		if (finished)
+			g_system->postSemaphore(_work);
+	}
+}
+
+MassAddScanner::Result *MassAddScanner::popResult() {
+	Common::StackLock lock(_mutex);
+	return _results.empty() ? 0 : _results.pop();
+}
+
+bool MassAddScanner::isFinished() {
+	Common::StackLock lock(_mutex);
+	return _pending.empty() && _busy == 0 && _results.empty();
+}
+
 
 
 MassAddDialog::MassAddDialog(const Common::FSNode &startDir)
 	: Dialog("MassAdd"),
+	_scanner(0),
 	_dirsScanned(0),
 	_oldGamesCount(0),
 	_dirTotal(0),
@@ -70,7 +279,7 @@ MassAddDialog::MassAddDialog(const Common::FSNode &startDir)
 	StringArray l;
 
 	// The dir we start our scan at
-	_scanStack.push(startDir);
+	_scanner = new MassAddScanner(startDir);
 
 	// Removed for now... Why would you put a title on mass add dialog called "Mass Add Dialog"?
 	// new StaticTextWidget(this, "massadddialog_caption", "Mass Add Dialog");
@@ -119,6 +328,10 @@ MassAddDialog::MassAddDialog(const Common::FSNode &startDir)
 	}
 }
 
+MassAddDialog::~MassAddDialog() {
+	delete _scanner;
+}
+
 struct GameTargetLess {
 	bool operator()(const GameDescriptor &x, const GameDescriptor &y) const {
 		return x.preferredtarget().compareToIgnoreCase(y.preferredtarget()) < 0;
@@ -172,20 +385,29 @@ void MassAddDialog::handleCommand(CommandSender *sender, uint32 cmd, uint32 data
 }
 
 void MassAddDialog::handleTickle() {
-	if (_scanStack.empty())
+	if (!_scanner)
 		return;	// We have finished scanning
 
 	uint32 t = g_system->getMillis();
 
-	// Perform a breadth-first scan of the filesystem.
-	while (!_scanStack.empty() && (g_system->getMillis() - t) < kMaxScanTime) {
-		Common::FSNode dir = _scanStack.pop();
-
-		Common::FSList files;
-		if (!dir.getChildren(files, Common::FSNode::kListAll)) {
-			continue;
+	// Run the detectors on the directories listed so far.
+	while ((g_system->getMillis() - t) < kMaxScanTime) {
+		MassAddScanner::Result *scanned = _scanner->popResult();
+		if (!scanned) {
+			// Without worker threads, we have to list the directories ourselves.
+			if (!_scanner->hasThreads() && _scanner->scanNext())
+				continue;
+
+			if (_scanner->isFinished()) {
+				delete _scanner;
+				_scanner = 0;
+			}
+			break;
 		}
 
+		const Common::FSNode &dir = scanned->dir;
+		const Common::FSList &files = scanned->files;
+
 		// Run the detector on the dir
 		GameList candidates(EngineMan.detectGames(files));
 
@@ -230,15 +452,9 @@ void MassAddDialog::handleTickle() {
 			_list->append(result.description());
 		}
 
-
-		// Recurse into all subdirs
-		for (Common::FSList::const_iterator file = files.begin(); file != files.end(); ++file) {
-			if (file->isDirectory()) {
-				_scanStack.push(*file);
-
-				_dirTotal++;
-			}
-		}
+		// The subdirs are queued by the scanner
+		_dirTotal += scanned->subdirs;
+		delete scanned;
 
 		_dirsScanned++;
 
@@ -252,7 +468,7 @@ void MassAddDialog::handleTickle() {
 	// Update the dialog
 	Common::String buf;
 
-	if (_scanStack.empty()) {
+	if (!_scanner) {
 		// Enable the OK button
 		_okButton->setEnabled(true);
 
@@ -0,0 +1,29 @@
+#ifndef TEST_BENCHMARK_BENCHMARK_H
+#define TEST_BENCHMARK_BENCHMARK_H
+
+#include <time.h>
+
+#include "common/scummsys.h"
+
+/**
+ * Measures processor time for the benchmarks. The benchmarks are built
+ * with FORBIDDEN_SYMBOL_ALLOW_ALL, so plain clock() and printf() are fine.
+ */
+class BenchmarkTimer {
+	clock_t _start;
+
+public:
+	BenchmarkTimer() : _start(clock()) {}
+
+	double elapsedMs() const {
+		return (double)(clock() - _start) * 1000.0 / CLOCKS_PER_SEC;
+	}
+
+	/** Print the time since construction, and the time per operation. */
+	void report(const char *name, uint32 operations) const {
+		const double ms = elapsedMs();
+		printf("\n  %-48s %9.2f ms %9.2f ns/op", name, ms, operations ? ms * 1000000.0 / operations : 0.0);
+	}
+};
+
+#endif
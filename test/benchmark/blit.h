@@ -0,0 +1,240 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/str.h"
+#include "common/util.h"
+#include "graphics/transform_cache.h"
+#include "graphics/transform_tools.h"
+#include "graphics/transparent_surface.h"
+
+#include "test/benchmark/benchmark.h"
+
+class BlitBenchmarkSuite : public CxxTest::TestSuite {
+	enum {
+#ifdef SCUMM_LITTLE_ENDIAN
+		kA = 0, kB = 1, kG = 2, kR = 3,
+#else
+		kA = 3, kB = 2, kG = 1, kR = 0,
+#endif
+		kWidth = 320,
+		kHeight = 200,
+		kBlits = 200,
+		kPixels = kWidth * kHeight * kBlits
+	};
+
+	Graphics::TransparentSurface _src;
+	Graphics::Surface _dst;
+
+	void run(const char *name, Graphics::TSpriteBlendMode mode, uint32 color, int flipping = Graphics::FLIP_NONE) {
+		BenchmarkTimer timer;
+		for (int i = 0; i < kBlits; ++i)
+			_src.blit(_dst, 0, 0, flipping, nullptr, color, -1, -1, mode);
+		timer.report(name, kPixels);
+	}
+
+	/**
+	 * The per pixel loops which TransparentSurface used for unflipped blits
+	 * before it blended four pixels at a time.
+	 */
+	template<int mode, bool colorMod>
+	static void referenceBlit(const Graphics::Surface &src, Graphics::Surface &dst, uint32 color) {
+		const uint32 ca = color >> 24, cr = (color >> 16) & 0xFF, cg = (color >> 8) & 0xFF, cb = color & 0xFF;
+
+		for (int y = 0; y < src.h; ++y) {
+			const byte *in = (const byte *)src.getBasePtr(0, y);
+			byte *out = (byte *)dst.getBasePtr(0, y);
+			for (int x = 0; x < src.w; ++x, in += 4, out += 4) {
+				if (!colorMod) {
+					if (in[kA] == 0)
+						continue;
+					if (mode == Graphics::BLEND_NORMAL) {
+						out[kA] = 255;
+						out[kR] = ((in[kR] * in[kA]) + out[kR] * (255 - in[kA])) >> 8;
+						out[kG] = ((in[kG] * in[kA]) + out[kG] * (255 - in[kA])) >> 8;
+						out[kB] = ((in[kB] * in[kA]) + out[kB] * (255 - in[kA])) >> 8;
+					} else if (mode == Graphics::BLEND_ADDITIVE) {
+						out[kR] = MIN((in[kR] * in[kA] >> 8) + out[kR], 255);
+						out[kG] = MIN((in[kG] * in[kA] >> 8) + out[kG], 255);
+						out[kB] = MIN((in[kB] * in[kA] >> 8) + out[kB], 255);
+					} else {
+						out[kR] = MAX(out[kR] - ((in[kR] * out[kR]) * in[kA] >> 16), 0);
+						out[kG] = MAX(out[kG] - ((in[kG] * out[kG]) * in[kA] >> 16), 0);
+						out[kB] = MAX(out[kB] - ((in[kB] * out[kB]) * in[kA] >> 16), 0);
+					}
+				} else if (mode == Graphics::BLEND_NORMAL) {
+					const uint32 ina = in[kA] * ca >> 8;
+					out[kA] = 255;
+					out[kB] = (out[kB] * (255 - ina) >> 8) + (in[kB] * ina * cb >> 16);
+					out[kG] = (out[kG] * (255 - ina) >> 8) + (in[kG] * ina * cg >> 16);
+					out[kR] = (out[kR] * (255 - ina) >> 8) + (in[kR] * ina * cr >> 16);
+				} else if (mode == Graphics::BLEND_ADDITIVE) {
+					const uint32 ina = in[kA] * ca >> 8;
+					out[kB] = MIN<uint32>(out[kB] + (cb != 255 ? in[kB] * cb * ina >> 16 : in[kB] * ina >> 8), 255);
+					out[kG] = MIN<uint32>(out[kG] + (cg != 255 ? in[kG] * cg * ina >> 16 : in[kG] * ina >> 8), 255);
+					out[kR] = MIN<uint32>(out[kR] + (cr != 255 ? in[kR] * cr * ina >> 16 : in[kR] * ina >> 8), 255);
+				} else {
+					out[kA] = 255;
+					out[kB] = out[kB] - (cb != 255 ? (in[kB] * cb) * (out[kB] * in[kA]) >> 24 : in[kB] * out[kB] * in[kA] >> 16);
+					out[kG] = out[kG] - (cg != 255 ? (in[kG] * cg) * (out[kG] * in[kA]) >> 24 : in[kG] * out[kG] * in[kA] >> 16);
+					out[kR] = out[kR] - (cr != 255 ? (in[kR] * cr) * (out[kR] * in[kA]) >> 24 : in[kR] * out[kR] * in[kA] >> 16);
+				}
+			}
+		}
+	}
+
+	/**
+	 * Time the reference loops and the blit for a blend mode, starting
+	 * from the same destination, and check that they agree.
+	 */
+	template<int mode, bool colorMod>
+	void compare(const char *name, uint32 color) {
+		Graphics::Surface reference;
+		reference.copyFrom(_dst);
+		{
+			BenchmarkTimer timer;
+			for (int i = 0; i < kBlits; ++i)
+				referenceBlit<mode, colorMod>(_src, reference, color);
+			timer.report(Common::String::format("%s, reference", name).c_str(), kPixels);
+		}
+		run(name, (Graphics::TSpriteBlendMode)mode, color);
+		TS_ASSERT(!memcmp(reference.getPixels(), _dst.getPixels(), kWidth * kHeight * 4));
+		reference.free();
+	}
+
+	/**
+	 * The bilinear rotoscaling loop which TransparentSurface used before it
+	 * clipped each row once, with bounds checks for every pixel.
+	 */
+	static Graphics::TransparentSurface *referenceRotoscale(const Graphics::TransparentSurface &src, const Graphics::TransformStruct &transform) {
+		Common::Point newHotspot;
+		const Common::Rect rect = Graphics::TransformTools::newRect(Common::Rect(0, 0, src.w, src.h), transform, &newHotspot);
+		const int dstW = rect.width(), dstH = rect.height();
+		Graphics::TransparentSurface *target = new Graphics::TransparentSurface();
+		target->create(dstW, dstH, src.format);
+
+		const uint32 invAngle = 360 - (transform._angle % 360);
+		const float invCos = cos(invAngle * M_PI / 180.0);
+		const float invSin = sin(invAngle * M_PI / 180.0);
+		const int icosx = (int)(invCos * (65536.0f * Graphics::kDefaultZoomX / transform._zoom.x));
+		const int isinx = (int)(invSin * (65536.0f * Graphics::kDefaultZoomX / transform._zoom.x));
+		const int icosy = (int)(invCos * (65536.0f * Graphics::kDefaultZoomY / transform._zoom.y));
+		const int isiny = (int)(invSin * (65536.0f * Graphics::kDefaultZoomY / transform._zoom.y));
+		const int sw = src.w - 1, sh = src.h - 1;
+
+		for (int y = 0; y < dstH; y++) {
+			const int t = newHotspot.y - y;
+			int sdx = -icosx * newHotspot.x + isinx * t + (transform._hotspot.x << 16);
+			int sdy = -isiny * newHotspot.x - icosy * t + (transform._hotspot.y << 16);
+			byte *pc = (byte *)target->getBasePtr(0, y);
+			for (int x = 0; x < dstW; x++, pc += 4) {
+				const int dx = sdx >> 16, dy = sdy >> 16;
+				if (dx > -1 && dy > -1 && dx < sw && dy < sh) {
+					const byte *c00 = (const byte *)src.getBasePtr(dx, dy);
+					const byte *c01 = c00 + 4, *c10 = c00 + src.pitch, *c11 = c10 + 4;
+					const int ex = sdx & 0xffff, ey = sdy & 0xffff;
+					for (int i = 0; i < 4; i++) {
+						const int t1 = ((((c01[i] - c00[i]) * ex) >> 16) + c00[i]) & 0xff;
+						const int t2 = ((((c11[i] - c10[i]) * ex) >> 16) + c10[i]) & 0xff;
+						pc[i] = (((t2 - t1) * ey) >> 16) + t1;
+					}
+				}
+				sdx += icosx;
+				sdy += isiny;
+			}
+		}
+		return target;
+	}
+
+public:
+	void setUp() {
+		const Graphics::PixelFormat format(4, 8, 8, 8, 8, 24, 16, 8, 0);
+		_src.create(kWidth, kHeight, format);
+		_dst.create(kWidth, kHeight, format);
+
+		uint32 x = 12345;
+		byte *src = (byte *)_src.getPixels();
+		byte *dst = (byte *)_dst.getPixels();
+		for (int i = 0; i < kWidth * kHeight * 4; ++i) {
+			x = x * 1103515245 + 12345;
+			src[i] = x >> 16;
+			dst[i] = x >> 24;
+		}
+	}
+
+	void tearDown() {
+		_src.free();
+		_dst.free();
+	}
+
+	void test_blit() {
+		_src.setAlphaMode(Graphics::ALPHA_OPAQUE);
+		run("blit opaque, per pixel", Graphics::BLEND_NORMAL, 0xFFFFFFFF);
+		_src.setAlphaMode(Graphics::ALPHA_BINARY);
+		run("blit binary, per pixel", Graphics::BLEND_NORMAL, 0xFFFFFFFF);
+		_src.setAlphaMode(Graphics::ALPHA_FULL);
+		compare<Graphics::BLEND_NORMAL, false>("blit normal, per pixel", 0xFFFFFFFF);
+		run("blit normal flipped, per pixel", Graphics::BLEND_NORMAL, 0xFFFFFFFF, Graphics::FLIP_H);
+		compare<Graphics::BLEND_NORMAL, true>("blit normal colormod, per pixel", 0xC0FF8040);
+		compare<Graphics::BLEND_ADDITIVE, false>("blit additive, per pixel", 0xFFFFFFFF);
+		compare<Graphics::BLEND_ADDITIVE, true>("blit additive colormod, per pixel", 0xC0FF8040);
+		compare<Graphics::BLEND_SUBTRACTIVE, false>("blit subtractive, per pixel", 0xFFFFFFFF);
+		compare<Graphics::BLEND_SUBTRACTIVE, true>("blit subtractive colormod, per pixel", 0xC0FF8040);
+	}
+
+	void test_transform() {
+		const Graphics::TransformStruct transform(130, 130, 20, kWidth / 2, kHeight / 2);
+		const int kTransforms = 20;
+		uint32 pixels = 0;
+		Graphics::TransparentSurface *reference = 0;
+		{
+			BenchmarkTimer timer;
+			for (int i = 0; i < kTransforms; ++i) {
+				if (reference) {
+					reference->free();
+					delete reference;
+				}
+				reference = referenceRotoscale(_src, transform);
+				pixels += reference->w * reference->h;
+			}
+			timer.report("rotoscale bilinear, per pixel, reference", pixels);
+		}
+		{
+			BenchmarkTimer timer;
+			for (int i = 0; i < kTransforms; ++i) {
+				Graphics::TransparentSurface *result = _src.rotoscaleT<Graphics::FILTER_BILINEAR>(transform);
+				if (i == 0)
+					TS_ASSERT(!memcmp(result->getPixels(), reference->getPixels(), result->pitch * result->h));
+				result->free();
+				delete result;
+			}
+			timer.report("rotoscale bilinear, per pixel", pixels);
+		}
+		reference->free();
+		delete reference;
+
+		// Drawing the same sprite with the same transform, frame after
+		// frame, as the Wintermute renderer does through its cache
+		Graphics::TransformCache cache;
+		const Graphics::TransformCache::Key key(&_src, Common::Rect(0, 0, kWidth, kHeight), transform, 0, 0, Graphics::FILTER_BILINEAR);
+		{
+			BenchmarkTimer timer;
+			for (int i = 0; i < kTransforms; ++i) {
+				Graphics::TransformCache::SurfacePtr result = cache.lookup(key);
+				if (!result) {
+					result = Graphics::TransformCache::SurfacePtr(_src.rotoscaleT<Graphics::FILTER_BILINEAR>(transform), Graphics::SharedPtrSurfaceDeleter());
+					cache.insert(key, result);
+				}
+			}
+			timer.report("rotoscale bilinear through cache, per pixel", pixels);
+		}
+
+		{
+			BenchmarkTimer timer;
+			for (int i = 0; i < kTransforms; ++i) {
+				Graphics::TransparentSurface *result = _src.scaleT<Graphics::FILTER_BILINEAR>(kWidth * 3 / 2, kHeight * 3 / 2);
+				result->free();
+				delete result;
+			}
+			timer.report("scale bilinear, per pixel", kTransforms * (kWidth * 3 / 2) * (kHeight * 3 / 2));
+		}
+	}
+};
@@ -0,0 +1,118 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/array.h"
+#include "common/list.h"
+#include "common/str.h"
+
+#include "test/benchmark/benchmark.h"
+
+/**
+ * An element owning a heap buffer, which counts the allocations made for
+ * it. Copies allocate, moves only take the buffer over.
+ */
+class CountedBuffer {
+	byte *_data;
+
+public:
+	static uint32 _allocations;
+
+	CountedBuffer() : _data(alloc()) {}
+	CountedBuffer(const CountedBuffer &other) : _data(alloc()) { memcpy(_data, other._data, 64); }
+#if __cplusplus >= 201103L
+	CountedBuffer(CountedBuffer &&other) : _data(other._data) { other._data = 0; }
+#endif
+	~CountedBuffer() { free(_data); }
+
+	CountedBuffer &operator=(const CountedBuffer &other) {
+		memcpy(_data, other._data, 64);
+		return *this;
+	}
+
+private:
+	static byte *alloc() {
+		++_allocations;
+		return (byte *)calloc(64, 1);
+	}
+};
+
+uint32 CountedBuffer::_allocations = 0;
+
+/**
+ * Typical loops of engine code: arrays filled one element at a time, and
+ * strings and arrays returned by value. Built as C++11, the containers move
+ * their elements where they used to copy them; build both ways and compare
+ * the allocation counts.
+ */
+class ContainerBenchmarkSuite : public CxxTest::TestSuite {
+	enum {
+		kElements = 2000,
+		kRounds = 50
+	};
+
+	static Common::Array<CountedBuffer> makeArray() {
+		Common::Array<CountedBuffer> array;
+		for (uint i = 0; i < kElements; ++i)
+			array.push_back(CountedBuffer());
+		return array;
+	}
+
+	static Common::String makeName(uint i) {
+		return Common::String::format("script_%u_with_a_long_symbol_name", i);
+	}
+
+public:
+	void test_info() {
+#if __cplusplus >= 201103L
+		printf("\n  Built with move semantics");
+#else
+		printf("\n  Built without move semantics");
+#endif
+	}
+
+	void test_array_push_back() {
+		CountedBuffer::_allocations = 0;
+		BenchmarkTimer timer;
+		for (uint r = 0; r < kRounds; ++r) {
+			Common::Array<CountedBuffer> array;
+			for (uint i = 0; i < kElements; ++i)
+				array.push_back(CountedBuffer());
+		}
+		timer.report("Array push_back", kElements * kRounds);
+		printf(" %8.2f allocs/op", (double)CountedBuffer::_allocations / (kElements * kRounds));
+	}
+
+	void test_array_emplace_back() {
+		CountedBuffer::_allocations = 0;
+		BenchmarkTimer timer;
+		for (uint r = 0; r < kRounds; ++r) {
+			Common::Array<CountedBuffer> array;
+			for (uint i = 0; i < kElements; ++i)
+				array.emplace_back();
+		}
+		timer.report("Array emplace_back", kElements * kRounds);
+		printf(" %8.2f allocs/op", (double)CountedBuffer::_allocations / (kElements * kRounds));
+	}
+
+	void test_array_return() {
+		Common::Array<CountedBuffer> array;
+		CountedBuffer::_allocations = 0;
+		BenchmarkTimer timer;
+		for (uint r = 0; r < kRounds; ++r)
+			array = makeArray();
+		timer.report("Array returned by value", kElements * kRounds);
+		printf(" %8.2f allocs/op", (double)CountedBuffer::_allocations / (kElements * kRounds));
+	}
+
+	void test_string_array() {
+		BenchmarkTimer timer;
+		for (uint r = 0; r < kRounds; ++r) {
+			Common::Array<Common::String> names;
+			Common::List<Common::String> list;
+			for (uint i = 0; i < kElements; ++i) {
+				names.push_back(makeName(i));
+				list.push_back(makeName(i));
+			}
+		}
+		timer.report("String::format into Array and List", kElements * kRounds);
+	}
+};
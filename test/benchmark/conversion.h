@@ -0,0 +1,115 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/endian.h"
+#include "common/str.h"
+#include "graphics/conversion.h"
+#include "graphics/pixelformat.h"
+
+#include "test/benchmark/benchmark.h"
+
+class ConversionBenchmarkSuite : public CxxTest::TestSuite {
+	enum {
+		kWidth = 640,
+		kHeight = 480,
+		kFrames = 100,
+		kPixels = kWidth * kHeight * kFrames
+	};
+
+	byte *_src;
+	byte *_dst;
+
+	/**
+	 * The conversion of each pixel through colorToARGB() and ARGBToColor(),
+	 * which crossBlit() did for all formats before.
+	 */
+	template<typename DstColor>
+	static void referenceConvert(byte *dst, const byte *src, const Graphics::PixelFormat &dstFmt, const Graphics::PixelFormat &srcFmt) {
+		for (uint i = 0; i < kWidth * kHeight; ++i) {
+			uint32 color;
+			if (srcFmt.bytesPerPixel == 2)
+				color = *(const uint16 *)src;
+			else if (srcFmt.bytesPerPixel == 3)
+				color = READ_UINT24(src);
+			else
+				color = *(const uint32 *)src;
+			src += srcFmt.bytesPerPixel;
+
+			byte a, r, g, b;
+			srcFmt.colorToARGB(color, a, r, g, b);
+			*(DstColor *)dst = dstFmt.ARGBToColor(a, r, g, b);
+			dst += sizeof(DstColor);
+		}
+	}
+
+	void run(const char *name, const Graphics::PixelFormat &dstFmt, const Graphics::PixelFormat &srcFmt) {
+		const uint size = kWidth * kHeight * dstFmt.bytesPerPixel;
+		byte *reference = (byte *)malloc(size);
+		{
+			BenchmarkTimer timer;
+			for (int i = 0; i < kFrames; ++i) {
+				if (dstFmt.bytesPerPixel == 2)
+					referenceConvert<uint16>(reference, _src, dstFmt, srcFmt);
+				else
+					referenceConvert<uint32>(reference, _src, dstFmt, srcFmt);
+			}
+			timer.report(Common::String::format("%s, reference", name).c_str(), kPixels);
+		}
+		{
+			BenchmarkTimer timer;
+			for (int i = 0; i < kFrames; ++i)
+				Graphics::crossBlit(_dst, _src, kWidth * dstFmt.bytesPerPixel, kWidth * srcFmt.bytesPerPixel, kWidth, kHeight, dstFmt, srcFmt);
+			timer.report(name, kPixels);
+		}
+		TS_ASSERT(!memcmp(reference, _dst, size));
+		free(reference);
+	}
+
+public:
+	void setUp() {
+		_src = (byte *)malloc(kWidth * kHeight * 4);
+		_dst = (byte *)malloc(kWidth * kHeight * 4);
+		for (uint i = 0; i < kWidth * kHeight * 4; ++i)
+			_src[i] = (byte)(i * 7 + (i >> 9));
+	}
+
+	void tearDown() {
+		free(_src);
+		free(_dst);
+	}
+
+	void test_cross_blit() {
+		const Graphics::PixelFormat rgb565(2, 5, 6, 5, 0, 11, 5, 0, 0);
+		const Graphics::PixelFormat bgr888(3, 8, 8, 8, 0, 0, 8, 16, 0);
+		const Graphics::PixelFormat rgba8888(4, 8, 8, 8, 8, 24, 16, 8, 0);
+		const Graphics::PixelFormat argb8888(4, 8, 8, 8, 8, 16, 8, 0, 24);
+		const Graphics::PixelFormat xrgb8888(4, 8, 8, 8, 0, 16, 8, 0, 0);
+
+		run("crossBlit RGB565 to RGBA8888, per pixel", rgba8888, rgb565);
+		run("crossBlit RGBA8888 to RGB565, per pixel", rgb565, rgba8888);
+		run("crossBlit ARGB8888 to RGBA8888, per pixel", rgba8888, argb8888);
+		run("crossBlit BGR888 to RGBA8888, per pixel", rgba8888, bgr888);
+
+		run("crossBlit XRGB8888 to RGBA8888, per pixel", rgba8888, xrgb8888);
+
+		// Surface::convertTo() used to look up the palette for each pixel
+		const byte *palette = _src;
+		uint32 *dst = (uint32 *)_dst;
+		{
+			BenchmarkTimer timer;
+			for (int i = 0; i < kFrames; ++i) {
+				for (uint p = 0; p < kWidth * kHeight; ++p) {
+					const byte *color = palette + _src[p] * 3;
+					dst[p] = rgba8888.RGBToColor(color[0], color[1], color[2]);
+				}
+			}
+			timer.report("crossBlitMap CLUT8 to RGBA8888, per pixel, reference", kPixels);
+		}
+
+		uint32 map[256];
+		Graphics::convertPaletteToMap(map, palette, 256, rgba8888);
+		BenchmarkTimer timer;
+		for (int i = 0; i < kFrames; ++i)
+			Graphics::crossBlitMap(_dst, _src, kWidth * 4, kWidth, kWidth, kHeight, 4, map);
+		timer.report("crossBlitMap CLUT8 to RGBA8888, per pixel", kPixels);
+	}
+};
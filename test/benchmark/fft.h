@@ -0,0 +1,63 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/dct.h"
+#include "common/rdft.h"
+#include "common/str.h"
+
+#include "test/benchmark/benchmark.h"
+
+class FFTBenchmarkSuite : public CxxTest::TestSuite {
+	enum {
+		kMaxBits = 11,
+		kSamples = 4 * 1024 * 1024,
+		kSetups = 2000
+	};
+
+	float _input[1 << kMaxBits];
+	float _data[1 << kMaxBits];
+
+public:
+	void setUp() {
+		for (int i = 0; i < (1 << kMaxBits); i++)
+			_input[i] = (float)((i * 7919) % 1000) / 500.0f - 1.0f;
+	}
+
+	void test_transforms() {
+		// The sizes used by Bink audio and QDM2. Each transform gets the
+		// same number of samples through.
+		for (int bits = 9; bits <= kMaxBits; bits++) {
+			const int n = 1 << bits;
+			const uint32 transforms = kSamples / n;
+
+			{
+				Common::RDFT rdft(bits, Common::RDFT::DFT_C2R);
+				BenchmarkTimer timer;
+				for (uint32 i = 0; i < transforms; i++) {
+					// Fresh input, so the values do not grow out of range
+					memcpy(_data, _input, n * sizeof(float));
+					rdft.calc(_data);
+				}
+				timer.report(Common::String::format("RDFT %d, per transform", n).c_str(), transforms);
+			}
+
+			{
+				Common::DCT dct(bits, Common::DCT::DCT_III);
+				BenchmarkTimer timer;
+				for (uint32 i = 0; i < transforms; i++) {
+					memcpy(_data, _input, n * sizeof(float));
+					dct.calc(_data);
+				}
+				timer.report(Common::String::format("DCT %d, per transform", n).c_str(), transforms);
+			}
+		}
+	}
+
+	void test_setup() {
+		// Codecs set up their transforms for every stream
+		BenchmarkTimer timer;
+		for (int i = 0; i < kSetups; i++) {
+			Common::DCT dct(kMaxBits, Common::DCT::DCT_III);
+		}
+		timer.report("DCT 2048 setup", kSetups);
+	}
+};
@@ -0,0 +1,138 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/flathashmap.h"
+#include "common/hashmap.h"
+#include "common/hash-str.h"
+
+#include "test/benchmark/benchmark.h"
+
+class HashMapBenchmarkSuite : public CxxTest::TestSuite {
+	enum {
+		kKeys = 100000,
+		kLookupRounds = 20,
+		kSmallKeys = 300
+	};
+
+	Common::Array<uint> _keys;
+	Common::Array<uint> _order;
+	Common::Array<Common::String> _strings;
+
+	template<class Map>
+	uint32 runIntMap(const char *name) {
+		uint32 sum = 0;
+		Map map;
+		{
+			BenchmarkTimer timer;
+			for (uint i = 0; i < kKeys; ++i)
+				map[_keys[i]] = i;
+			timer.report(Common::String::format("%s insert", name).c_str(), kKeys);
+		}
+		{
+			// Look the keys up in a different order than they were inserted
+			// in, so node based maps do not get to walk their memory pool
+			// sequentially.
+			BenchmarkTimer timer;
+			for (uint r = 0; r < kLookupRounds; ++r) {
+				for (uint i = 0; i < kKeys; ++i)
+					sum += map.getVal(_keys[_order[i]], 0);
+			}
+			timer.report(Common::String::format("%s lookup hit", name).c_str(), kKeys * kLookupRounds);
+		}
+		{
+			BenchmarkTimer timer;
+			for (uint r = 0; r < kLookupRounds; ++r) {
+				for (uint i = 0; i < kKeys; ++i)
+					sum += map.contains(_keys[_order[i]] + 1);
+			}
+			timer.report(Common::String::format("%s lookup miss", name).c_str(), kKeys * kLookupRounds);
+		}
+		{
+			BenchmarkTimer timer;
+			for (uint i = 0; i < kKeys; i += 2)
+				map.erase(_keys[i]);
+			for (uint i = 0; i < kKeys; i += 2)
+				map[_keys[i] + 7] = i;
+			timer.report(Common::String::format("%s erase/reinsert", name).c_str(), kKeys);
+		}
+		return sum;
+	}
+
+	template<class Map>
+	uint32 runSmallIntMap(const char *name) {
+		// Few, small keys, like the script numbers in SCI's segment manager
+		uint32 sum = 0;
+		Map map;
+		for (uint i = 0; i < kSmallKeys; ++i)
+			map[i * 3] = i;
+
+		BenchmarkTimer timer;
+		for (uint r = 0; r < kLookupRounds; ++r) {
+			for (uint i = 0; i < kKeys; ++i)
+				sum += map.getVal(_order[i] % kSmallKeys * 3, 0);
+		}
+		timer.report(Common::String::format("%s lookup hit", name).c_str(), kKeys * kLookupRounds);
+		return sum;
+	}
+
+	template<class Map>
+	uint32 runStringMap(const char *name) {
+		uint32 sum = 0;
+		Map map;
+		{
+			BenchmarkTimer timer;
+			for (uint i = 0; i < _strings.size(); ++i)
+				map[_strings[i]] = i;
+			timer.report(Common::String::format("%s insert", name).c_str(), _strings.size());
+		}
+		{
+			BenchmarkTimer timer;
+			for (uint r = 0; r < kLookupRounds; ++r) {
+				for (uint i = 0; i < _strings.size(); ++i)
+					sum += map.getVal(_strings[_order[i] % _strings.size()], 0);
+			}
+			timer.report(Common::String::format("%s lookup", name).c_str(), _strings.size() * kLookupRounds);
+		}
+		return sum;
+	}
+
+public:
+	void setUp() {
+		uint32 x = 1;
+		for (uint i = 0; i < kKeys; ++i) {
+			_keys.push_back(i * 2654435761U);
+			_order.push_back(i);
+		}
+		for (uint i = kKeys - 1; i > 0; --i) {
+			x = x * 1103515245 + 12345;
+			SWAP(_order[i], _order[(x >> 8) % (i + 1)]);
+		}
+
+		// Names shaped like config keys and script symbols
+		for (uint i = 0; i < kKeys / 4; ++i)
+			_strings.push_back(Common::String::format("domain_%u_key_%u", i % 97, i));
+	}
+
+	void tearDown() {
+		_keys.clear();
+		_order.clear();
+		_strings.clear();
+	}
+
+	void test_int_keys() {
+		uint32 a = runIntMap<Common::HashMap<uint, uint> >("HashMap<uint>");
+		uint32 b = runIntMap<Common::FlatHashMap<uint, uint> >("FlatHashMap<uint>");
+		TS_ASSERT_EQUALS(a, b);
+	}
+
+	void test_small_int_keys() {
+		uint32 a = runSmallIntMap<Common::HashMap<int, uint> >("HashMap<int>, small");
+		uint32 b = runSmallIntMap<Common::FlatHashMap<int, uint> >("FlatHashMap<int>, small");
+		TS_ASSERT_EQUALS(a, b);
+	}
+
+	void test_string_keys() {
+		uint32 a = runStringMap<Common::HashMap<Common::String, uint, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> >("HashMap<String>");
+		uint32 b = runStringMap<Common::FlatHashMap<Common::String, uint, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> >("FlatHashMap<String>");
+		TS_ASSERT_EQUALS(a, b);
+	}
+};
@@ -0,0 +1,82 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/bitstream.h"
+#include "common/huffman.h"
+#include "common/memstream.h"
+
+#include "test/benchmark/benchmark.h"
+
+class HuffmanBenchmarkSuite : public CxxTest::TestSuite {
+	enum {
+		kCodeCount = 16,
+		kSymbols = 1000000
+	};
+
+	uint8 _lengths[kCodeCount];
+	uint32 _codesMSB[kCodeCount];
+	uint32 _codesLSB[kCodeCount];
+	byte *_msb;
+	byte *_lsb;
+	uint32 _size;
+
+public:
+	void setUp() {
+		// Symbol i < 15 is coded as i ones followed by a zero, symbol 15 as
+		// 15 ones. Short codes are the common ones in the message.
+		for (uint32 i = 0; i < kCodeCount; i++) {
+			_lengths[i] = (i < kCodeCount - 1) ? i + 1 : i;
+			_codesMSB[i] = (i < kCodeCount - 1) ? ((1 << (i + 1)) - 2) : ((1 << i) - 1);
+			_codesLSB[i] = (1 << i) - 1;
+		}
+
+		_size = kSymbols * 2 + 4;
+		_msb = (byte *)calloc(_size, 1);
+		_lsb = (byte *)calloc(_size, 1);
+
+		uint32 x = 1;
+		uint32 pos = 0;
+		for (uint32 i = 0; i < kSymbols; i++) {
+			x = x * 1103515245 + 12345;
+			uint32 symbol = 0;
+			while (symbol < kCodeCount - 1 && ((x >> (16 + symbol)) & 1))
+				symbol++;
+
+			for (uint32 j = 0; j < _lengths[symbol]; j++, pos++) {
+				if ((_codesMSB[symbol] >> (_lengths[symbol] - 1 - j)) & 1)
+					_msb[pos / 8] |= 0x80 >> (pos % 8);
+				if ((_codesLSB[symbol] >> j) & 1)
+					_lsb[pos / 8] |= 1 << (pos % 8);
+			}
+		}
+	}
+
+	void tearDown() {
+		free(_msb);
+		free(_lsb);
+	}
+
+	void test_get_symbol() {
+		uint32 sum = 0;
+		{
+			Common::Huffman huffman(0, kCodeCount, _codesMSB, _lengths);
+			Common::MemoryReadStream stream(_msb, _size);
+			Common::BitStream32BEMSB bits(stream);
+
+			BenchmarkTimer timer;
+			for (uint32 i = 0; i < kSymbols; i++)
+				sum += huffman.getSymbol(bits);
+			timer.report("Huffman::getSymbol, 32 bit MSB", kSymbols);
+		}
+		{
+			Common::Huffman huffman(0, kCodeCount, _codesLSB, _lengths, 0, false);
+			Common::MemoryReadStream stream(_lsb, _size);
+			Common::BitStream8LSB bits(stream);
+
+			BenchmarkTimer timer;
+			for (uint32 i = 0; i < kSymbols; i++)
+				sum -= huffman.getSymbol(bits);
+			timer.report("Huffman::getSymbol, 8 bit LSB", kSymbols);
+		}
+		TS_ASSERT_EQUALS(sum, 0u);
+	}
+};
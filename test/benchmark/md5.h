@@ -0,0 +1,53 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/md5.h"
+#include "common/memstream.h"
+
+#include "test/benchmark/benchmark.h"
+
+class MD5BenchmarkSuite : public CxxTest::TestSuite {
+	enum {
+		kFiles = 8,
+		kFileSize = 4 * 1024 * 1024,
+		kBlocks = kFiles * kFileSize / 64
+	};
+
+	byte *_data;
+
+public:
+	void setUp() {
+		_data = (byte *)malloc(kFileSize);
+		for (uint32 i = 0; i < kFileSize; ++i)
+			_data[i] = (byte)(i * 13 + (i >> 10));
+	}
+
+	void tearDown() {
+		free(_data);
+	}
+
+	void test_md5() {
+		uint8 single[kFiles][16];
+		uint8 batch[kFiles][16];
+		{
+			BenchmarkTimer timer;
+			for (int i = 0; i < kFiles; ++i) {
+				Common::MemoryReadStream stream(_data, kFileSize);
+				Common::computeStreamMD5(stream, single[i]);
+			}
+			timer.report("computeStreamMD5, per block", kBlocks);
+		}
+		{
+			Common::ReadStream *streams[kFiles];
+			for (int i = 0; i < kFiles; ++i)
+				streams[i] = new Common::MemoryReadStream(_data, kFileSize);
+
+			BenchmarkTimer timer;
+			Common::computeStreamsMD5(streams, kFiles, batch);
+			timer.report("computeStreamsMD5, per block", kBlocks);
+
+			for (int i = 0; i < kFiles; ++i)
+				delete streams[i];
+		}
+		TS_ASSERT(!memcmp(single, batch, sizeof(single)));
+	}
+};
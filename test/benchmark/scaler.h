@@ -0,0 +1,173 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/scaler.h"
+#include "graphics/scaler/intern.h"
+#include "graphics/scaler/scale2x.h"
+#include "graphics/scaler/scale3x.h"
+
+#include "test/benchmark/benchmark.h"
+
+#ifdef USE_HQ_SCALERS
+extern "C" uint32 *RGBtoYUV;
+#endif
+
+class ScalerBenchmarkSuite : public CxxTest::TestSuite {
+	enum {
+		kWidth = 320,
+		kHeight = 200,
+		kPitch = kWidth + 2,
+		kFrames = 50,
+		kPixels = kWidth * kHeight * kFrames
+	};
+
+	uint16 *_src;
+	uint16 *_dst;
+
+	void run(const char *name, ScalerProc *scaler, int factor) {
+		// The scalers read one pixel around the area they scale
+		const uint8 *src = (const uint8 *)(_src + kPitch + 1);
+
+		BenchmarkTimer timer;
+		for (int i = 0; i < kFrames; ++i)
+			scaler(src, kPitch * 2, (uint8 *)_dst, kWidth * factor * 2, kWidth, kHeight);
+		timer.report(name, kPixels);
+	}
+
+	typedef void (*Scale2xRow)(scale2x_uint16 *, scale2x_uint16 *, const scale2x_uint16 *, const scale2x_uint16 *, const scale2x_uint16 *, unsigned);
+	typedef void (*Scale3xRow)(scale3x_uint16 *, scale3x_uint16 *, scale3x_uint16 *, const scale3x_uint16 *, const scale3x_uint16 *, const scale3x_uint16 *, unsigned);
+
+	void runScale2xRows(const char *name, Scale2xRow row) {
+		const uint16 *src = _src + kPitch + 1;
+		BenchmarkTimer timer;
+		for (int i = 0; i < kFrames; ++i) {
+			for (int y = 0; y < kHeight; ++y) {
+				uint16 *dst = _dst + y * 2 * kWidth * 2;
+				row(dst, dst + kWidth * 2, src + (y - 1) * kPitch, src + y * kPitch, src + (y + 1) * kPitch, kWidth);
+			}
+		}
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+		scale2x_mmx_emms();
+#endif
+		timer.report(name, kPixels);
+	}
+
+	void runScale3xRows(const char *name, Scale3xRow row) {
+		const uint16 *src = _src + kPitch + 1;
+		BenchmarkTimer timer;
+		for (int i = 0; i < kFrames; ++i) {
+			for (int y = 0; y < kHeight; ++y) {
+				uint16 *dst = _dst + y * 3 * kWidth * 3;
+				row(dst, dst + kWidth * 3, dst + kWidth * 6, src + (y - 1) * kPitch, src + y * kPitch, src + (y + 1) * kPitch, kWidth);
+			}
+		}
+		timer.report(name, kPixels);
+	}
+
+#ifdef USE_HQ_SCALERS
+	/**
+	 * The neighbor bits of the patterns of a row, as the hq scalers
+	 * computed them before: for each pixel, from the lookup table.
+	 */
+	static void referencePatterns(uint16 *patterns, const uint16 *p, int width) {
+		for (int x = 0; x < width; ++x, ++p) {
+			const int w5 = p[0];
+			const int yuv5 = RGBtoYUV[w5];
+			const int w[8] = { p[-kPitch - 1], p[-kPitch], p[-kPitch + 1], p[-1], p[1], p[kPitch - 1], p[kPitch], p[kPitch + 1] };
+			int pattern = 0;
+			for (int i = 0; i < 8; ++i) {
+				if (w5 != w[i] && diffYUV(yuv5, RGBtoYUV[w[i]]))
+					pattern |= 1 << i;
+			}
+			patterns[x] = pattern;
+		}
+	}
+#endif
+
+public:
+	void setUp() {
+		InitScalers(565);
+
+		// Flat areas with edges, dithering and a gradient, like game graphics
+		_src = (uint16 *)malloc(kPitch * (kHeight + 2) * 2);
+		_dst = (uint16 *)malloc(kWidth * kHeight * 3 * 3 * 2);
+		for (int y = 0; y < kHeight + 2; ++y) {
+			for (int x = 0; x < kPitch; ++x) {
+				uint16 color;
+				if (y < kHeight / 3)
+					color = ((x / 16 + y / 12) % 5) * 0x3186;
+				else if (y < kHeight * 2 / 3)
+					color = ((x ^ y) & 1) ? 0xF800 : 0x001F;
+				else
+					color = (x / 10) << 11 | (y / 4) << 5 | (x / 20);
+				_src[y * kPitch + x] = color;
+			}
+		}
+	}
+
+	void tearDown() {
+		free(_src);
+		free(_dst);
+		DestroyScalers();
+	}
+
+	void test_scalers() {
+		run("AdvMame2x, per source pixel", AdvMame2x, 2);
+		run("AdvMame3x, per source pixel", AdvMame3x, 3);
+#ifdef USE_HQ_SCALERS
+		run("HQ2x, per source pixel", HQ2x, 2);
+		run("HQ3x, per source pixel", HQ3x, 3);
+#endif
+	}
+
+	void test_rows() {
+		// The rows of AdvMame2x and AdvMame3x, with the code they used before
+		runScale2xRows("Scale2x rows C, per source pixel, reference", scale2x_16_def);
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+		runScale2xRows("Scale2x rows MMX, per source pixel, reference", scale2x_16_mmx);
+#endif
+#if defined(SCALE2X_USE_SSE2) || defined(SCALE2X_USE_NEON)
+		runScale2xRows("Scale2x rows, per source pixel", scale2x_16_simd);
+#endif
+		runScale3xRows("Scale3x rows C, per source pixel, reference", scale3x_16_def);
+#if defined(SCALE3X_USE_SSE2) || defined(SCALE3X_USE_NEON)
+		runScale3xRows("Scale3x rows, per source pixel", scale3x_16_simd);
+#endif
+	}
+
+#ifdef USE_HQ_SCALERS
+	void test_hq_patterns() {
+		// The interpolation of the hq scalers is unchanged, only the way
+		// they compare the pixels to their neighbors is new
+		uint16 *patterns = (uint16 *)malloc(kWidth * sizeof(uint16));
+		uint32 *yuv = (uint32 *)malloc(3 * (kWidth + 2) * sizeof(uint32));
+		const uint16 *src = _src + kPitch + 1;
+		{
+			BenchmarkTimer timer;
+			for (int i = 0; i < kFrames; ++i) {
+				for (int y = 0; y < kHeight; ++y)
+					referencePatterns(patterns, src + y * kPitch, kWidth);
+			}
+			timer.report("hq patterns, per source pixel, reference", kPixels);
+		}
+		{
+			BenchmarkTimer timer;
+			for (int i = 0; i < kFrames; ++i) {
+				uint32 *rows[3] = { yuv, yuv + kWidth + 2, yuv + 2 * (kWidth + 2) };
+				convertToHQYUV(rows[0], src - kPitch - 1, kWidth + 2);
+				convertToHQYUV(rows[1], src - 1, kWidth + 2);
+				for (int y = 0; y < kHeight; ++y) {
+					convertToHQYUV(rows[2], src + (y + 1) * kPitch - 1, kWidth + 2);
+					computeHQPatterns(patterns, rows[0], rows[1], rows[2], kWidth);
+					uint32 *row = rows[0];
+					rows[0] = rows[1];
+					rows[1] = rows[2];
+					rows[2] = row;
+				}
+			}
+			timer.report("hq patterns, per source pixel", kPixels);
+		}
+		free(patterns);
+		free(yuv);
+	}
+#endif
+};
@@ -0,0 +1,87 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/memstream.h"
+#include "common/str.h"
+#include "common/xmlparser.h"
+
+#include "test/benchmark/benchmark.h"
+
+class BenchmarkXMLParser : public Common::XMLParser {
+public:
+	uint32 _keys;
+
+	BenchmarkXMLParser() : _keys(0) {}
+
+protected:
+	CUSTOM_XML_PARSER(BenchmarkXMLParser) {
+		XML_KEY(doc)
+			XML_KEY(item)
+				XML_PROP(id, true)
+				XML_PROP(rgb, false)
+				XML_PROP(size, false)
+				XML_KEY(sub)
+					XML_PROP(name, true)
+					XML_PROP(value, false)
+				KEY_END()
+			KEY_END()
+		KEY_END()
+	} PARSER_END()
+
+	bool parserCallback_doc(ParserNode *node) { _keys++; return true; }
+	bool parserCallback_item(ParserNode *node) { _keys += node->values["id"].size(); return true; }
+	bool parserCallback_sub(ParserNode *node) { _keys += node->values["name"].size(); return true; }
+};
+
+class XMLParserBenchmarkSuite : public CxxTest::TestSuite {
+	Common::String _xml;
+
+public:
+	void setUp() {
+		// Shaped like a theme: many small keys with a few properties each
+		_xml = "<?xml version = '1.0'?>\n<!-- Benchmark document -->\n<doc>\n";
+		for (int i = 0; i < 3000; ++i) {
+			_xml += Common::String::format("\t<item id = 'Item.%d' rgb = '%d, %d, %d' size = '%d, 20'>\n", i, i & 255, (i * 3) & 255, (i * 7) & 255, i);
+			for (int j = 0; j < 3; ++j)
+				_xml += Common::String::format("\t\t<sub name = \"sub%d\" value = '%d'/>\n", j, i * j);
+			_xml += "\t</item>\n";
+		}
+		_xml += "</doc>\n";
+	}
+
+	void test_parse() {
+		const int rounds = 5;
+		uint32 keys = 0;
+		BenchmarkXMLParser parser;
+		{
+			BenchmarkTimer timer;
+			for (int i = 0; i < rounds; ++i) {
+				parser.loadBuffer((const byte *)_xml.c_str(), _xml.size());
+				TS_ASSERT(parser.parse());
+				parser.close();
+			}
+			timer.report("XMLParser::parse (per byte)", _xml.size() * rounds);
+		}
+		keys = parser._keys;
+		TS_ASSERT_LESS_THAN(0u, keys);
+	}
+
+	void test_parse_compiled() {
+		const int rounds = 5;
+		BenchmarkXMLParser parser;
+		Common::MemoryWriteStreamDynamic compiled(DisposeAfterUse::YES);
+		parser.loadBuffer((const byte *)_xml.c_str(), _xml.size());
+		TS_ASSERT(parser.parse(&compiled));
+		parser.close();
+
+		const uint32 keys = parser._keys;
+		{
+			BenchmarkTimer timer;
+			for (int i = 0; i < rounds; ++i) {
+				Common::MemoryReadStream stream(compiled.getData(), compiled.size());
+				TS_ASSERT(parser.parseCompiled(&stream));
+			}
+			timer.report("XMLParser::parseCompiled (per XML byte)", _xml.size() * rounds);
+		}
+		TS_ASSERT_EQUALS(parser._keys, keys * (rounds + 1));
+	}
+};
@@ -0,0 +1,152 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/str.h"
+#include "common/util.h"
+#include "graphics/surface.h"
+#include "graphics/yuv_to_rgb.h"
+
+#include "test/benchmark/benchmark.h"
+
+class YUVToRGBBenchmarkSuite : public CxxTest::TestSuite {
+	enum {
+		kWidth = 640,
+		kHeight = 480,
+		kFrames = 100,
+		kPixels = kWidth * kHeight * kFrames
+	};
+
+	byte *_y;
+	byte *_u;
+	byte *_v;
+
+	/**
+	 * The lookup tables of YUVToRGBManager for the ITU luminance range,
+	 * which convert420() and convert444() used for every pixel before they
+	 * converted eight pixels at a time.
+	 */
+	int16 _colorTab[4 * 256];
+	uint32 _rgbToPix[3 * 768];
+
+	void buildTables(const Graphics::PixelFormat &format) {
+		for (int i = 0; i < 256; i++) {
+			const int16 c = i - 128;
+			_colorTab[i] = (int16)((0.419 / 0.299) * c) + 0 * 768 + 256;
+			_colorTab[256 + i] = (int16)(-(0.299 / 0.419) * c) + 1 * 768 + 256;
+			_colorTab[512 + i] = (int16)(-(0.114 / 0.331) * c);
+			_colorTab[768 + i] = (int16)((0.587 / 0.331) * c) + 2 * 768 + 256;
+		}
+		for (int i = 0; i < 768; i++) {
+			const int value = (CLIP(i - 256, 16, 235) - 16) * 255 / 219;
+			_rgbToPix[i] = format.RGBToColor(value, 0, 0);
+			_rgbToPix[768 + i] = format.RGBToColor(0, value, 0);
+			_rgbToPix[2 * 768 + i] = format.RGBToColor(0, 0, value);
+		}
+	}
+
+	template<typename PixelInt>
+	void reference444(PixelInt *dst) const {
+		const int16 *colorTab = _colorTab;
+		const uint32 *rgbToPix = _rgbToPix;
+		for (int i = 0; i < kWidth * kHeight; ++i) {
+			const int16 crR = colorTab[_v[i]];
+			const int16 crbG = colorTab[256 + _v[i]] + colorTab[512 + _u[i]];
+			const int16 cbB = colorTab[768 + _u[i]];
+			const uint32 *L = &rgbToPix[_y[i]];
+			dst[i] = L[crR] | L[crbG] | L[cbB];
+		}
+	}
+
+	template<typename PixelInt>
+	void reference420(PixelInt *dst) const {
+		const int16 *colorTab = _colorTab;
+		const uint32 *rgbToPix = _rgbToPix;
+		const byte *ySrc = _y, *uSrc = _u, *vSrc = _v;
+		for (int y = 0; y < kHeight; y += 2) {
+			for (int x = 0; x < kWidth; x += 2) {
+				const int16 crR = colorTab[*vSrc];
+				const int16 crbG = colorTab[256 + *vSrc] + colorTab[512 + *uSrc];
+				const int16 cbB = colorTab[768 + *uSrc];
+				++uSrc;
+				++vSrc;
+
+				const uint32 *L = &rgbToPix[ySrc[0]];
+				dst[0] = L[crR] | L[crbG] | L[cbB];
+				L = &rgbToPix[ySrc[1]];
+				dst[1] = L[crR] | L[crbG] | L[cbB];
+				L = &rgbToPix[ySrc[kWidth]];
+				dst[kWidth] = L[crR] | L[crbG] | L[cbB];
+				L = &rgbToPix[ySrc[kWidth + 1]];
+				dst[kWidth + 1] = L[crR] | L[crbG] | L[cbB];
+				ySrc += 2;
+				dst += 2;
+			}
+			ySrc += kWidth;
+			dst += kWidth;
+		}
+	}
+
+	template<typename PixelInt>
+	void runReference(const char *name, Graphics::Surface &reference, bool yuv420) {
+		buildTables(reference.format);
+		BenchmarkTimer timer;
+		for (int i = 0; i < kFrames; ++i) {
+			if (yuv420)
+				reference420((PixelInt *)reference.getPixels());
+			else
+				reference444((PixelInt *)reference.getPixels());
+		}
+		timer.report(Common::String::format("%s, reference", name).c_str(), kPixels);
+	}
+
+	void run(const char *name, const Graphics::PixelFormat &format, bool yuv420) {
+		Graphics::Surface reference, surface;
+		reference.create(kWidth, kHeight, format);
+		surface.create(kWidth, kHeight, format);
+
+		if (format.bytesPerPixel == 2)
+			runReference<uint16>(name, reference, yuv420);
+		else
+			runReference<uint32>(name, reference, yuv420);
+
+		BenchmarkTimer timer;
+		for (int i = 0; i < kFrames; ++i) {
+			if (yuv420)
+				YUVToRGBMan.convert420(&surface, Graphics::YUVToRGBManager::kScaleITU, _y, _u, _v, kWidth, kHeight, kWidth, kWidth / 2);
+			else
+				YUVToRGBMan.convert444(&surface, Graphics::YUVToRGBManager::kScaleITU, _y, _u, _v, kWidth, kHeight, kWidth, kWidth);
+		}
+		timer.report(name, kPixels);
+
+		TS_ASSERT(!memcmp(reference.getPixels(), surface.getPixels(), kWidth * kHeight * format.bytesPerPixel));
+		reference.free();
+		surface.free();
+	}
+
+public:
+	void setUp() {
+		_y = (byte *)malloc(kWidth * kHeight);
+		_u = (byte *)malloc(kWidth * kHeight);
+		_v = (byte *)malloc(kWidth * kHeight);
+		for (uint i = 0; i < kWidth * kHeight; ++i) {
+			_y[i] = (byte)(i * 7 + (i >> 9));
+			_u[i] = (byte)(i * 3);
+			_v[i] = (byte)(i >> 5);
+		}
+	}
+
+	void tearDown() {
+		free(_y);
+		free(_u);
+		free(_v);
+	}
+
+	void test_convert() {
+		const Graphics::PixelFormat rgb565(2, 5, 6, 5, 0, 11, 5, 0, 0);
+		const Graphics::PixelFormat xrgb8888(4, 8, 8, 8, 0, 16, 8, 0, 0);
+
+		run("convert420 to RGB565, per pixel", rgb565, true);
+		run("convert420 to XRGB8888, per pixel", xrgb8888, true);
+		run("convert444 to RGB565, per pixel", rgb565, false);
+		run("convert444 to XRGB8888, per pixel", xrgb8888, false);
+	}
+};
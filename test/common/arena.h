@@ -0,0 +1,69 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/arena.h"
+
+class ArenaTestSuite : public CxxTest::TestSuite {
+public:
+	void test_allocate() {
+		Common::Arena arena("test");
+
+		byte *small = (byte *)arena.allocate(10);
+		byte *medium = (byte *)arena.allocate(200);
+		byte *large = (byte *)arena.allocate(100000);
+		memset(small, 1, 10);
+		memset(medium, 2, 200);
+		memset(large, 3, 100000);
+
+		// Blocks are suitably aligned for any type
+		TS_ASSERT_EQUALS((size_t)small % 8, 0u);
+		TS_ASSERT_EQUALS((size_t)large % 8, 0u);
+
+		Common::Arena::Stats stats = arena.getStats();
+		TS_ASSERT_EQUALS(stats.liveBlocks, 3u);
+		TS_ASSERT_EQUALS(stats.requestedBytes, 100210u);
+		TS_ASSERT_EQUALS(stats.usedBytes, 16u + 256u + 100000u);
+		TS_ASSERT(stats.reservedBytes >= stats.usedBytes);
+
+		arena.deallocate(large);
+		arena.deallocate(small);
+		arena.deallocate(0);
+		TS_ASSERT_EQUALS(medium[199], 2);
+
+		stats = arena.getStats();
+		TS_ASSERT_EQUALS(stats.liveBlocks, 1u);
+		TS_ASSERT_EQUALS(stats.requestedBytes, 200u);
+		TS_ASSERT_EQUALS(stats.peakRequestedBytes, 100210u);
+		TS_ASSERT_EQUALS(stats.allocations, 3u);
+
+		arena.deallocate(medium);
+		arena.freeUnusedPages();
+		TS_ASSERT_EQUALS(arena.getStats().reservedBytes, 0u);
+	}
+
+	void test_free_all() {
+		Common::Arena arena("test");
+		for (int i = 0; i < 1000; ++i)
+			arena.allocate(i * 7);
+
+		arena.freeAll();
+		Common::Arena::Stats stats = arena.getStats();
+		TS_ASSERT_EQUALS(stats.liveBlocks, 0u);
+		TS_ASSERT_EQUALS(stats.requestedBytes, 0u);
+		TS_ASSERT_EQUALS(stats.reservedBytes, 0u);
+
+		// The arena is still usable afterwards
+		arena.deallocate(arena.allocate(64));
+		TS_ASSERT_EQUALS(arena.getStats().allocations, 1001u);
+	}
+
+	void test_list() {
+		Common::Arena a("a");
+		{
+			Common::Arena b("b");
+			TS_ASSERT_EQUALS(Common::Arena::getFirst(), &b);
+			TS_ASSERT_EQUALS(b.getNext(), &a);
+		}
+		TS_ASSERT_EQUALS(Common::Arena::getFirst(), &a);
+		TS_ASSERT_EQUALS(a.getNext(), (const Common::Arena *)0);
+	}
+};
@@ -353,6 +353,32 @@ class ArrayTestSuite : public CxxTest::TestSuite
 		TS_ASSERT_EQUALS(array[1], 163);
 	}
 
+	void test_push_back_self() {
+		Common::Array<Common::String> array;
+		array.push_back("first element, long enough to live on the heap");
+
+		// Some of these push_backs of an element of the array itself have
+		// to grow it
+		for (int i = 0; i < 4; ++i) {
+			array.resize(array.size() * 2 - 1);
+			array.push_back(array[0]);
+		}
+		TS_ASSERT_EQUALS(array.size(), 16u);
+		TS_ASSERT_EQUALS(array.back(), "first element, long enough to live on the heap");
+	}
+
+	void test_emplace_back() {
+		Common::Array<Common::String> array;
+		array.emplace_back("abcdef", 3);
+		array.emplace_back();
+		TS_ASSERT_EQUALS(array.emplace_back("ghi", 2), "gh");
+
+		TS_ASSERT_EQUALS(array.size(), 3u);
+		TS_ASSERT_EQUALS(array[0], "abc");
+		TS_ASSERT(array[1].empty());
+		TS_ASSERT_EQUALS(array[2], "gh");
+	}
+
 };
 
 struct ListElement {
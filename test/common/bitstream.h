@@ -149,4 +149,62 @@ class BitStreamTestSuite : public CxxTest::TestSuite
 		TS_ASSERT_EQUALS(bs.peekBits(5), 12u);
 		TS_ASSERT(!bs.eos());
 	}
+
+	void test_peek_bits_across_values() {
+		byte contents[] = { 0x12, 0x34, 0x56, 0x78, 0x9A };
+
+		Common::MemoryReadStream ms(contents, sizeof(contents));
+
+		Common::BitStream8MSB bs(ms);
+		bs.skip(4);
+		TS_ASSERT_EQUALS(bs.peekBits(32), 0x23456789u);
+		TS_ASSERT_EQUALS(bs.pos(), 4u);
+		TS_ASSERT_EQUALS(bs.getBits(12), 0x234u);
+		TS_ASSERT_EQUALS(bs.pos(), 16u);
+
+		// Past the end, peeking reads zeros
+		TS_ASSERT_EQUALS(bs.peekBits(32), 0x56789A00u);
+		TS_ASSERT_EQUALS(bs.getBits(24), 0x56789Au);
+		TS_ASSERT(bs.eos());
+
+		bs.rewind();
+		TS_ASSERT_EQUALS(bs.getBits(32), 0x12345678u);
+		TS_ASSERT_EQUALS(bs.pos(), 32u);
+	}
+
+	void test_peek_bits_across_values_lsb() {
+		byte contents[] = { 0x12, 0x34, 0x56, 0x78, 0x9A };
+
+		Common::MemoryReadStream ms(contents, sizeof(contents));
+
+		Common::BitStream8LSB bs(ms);
+		bs.skip(4);
+		TS_ASSERT_EQUALS(bs.peekBits(32), 0xA7856341u);
+		TS_ASSERT_EQUALS(bs.getBits(12), 0x341u);
+		TS_ASSERT_EQUALS(bs.pos(), 16u);
+		TS_ASSERT_EQUALS(bs.peekBits(32), 0x009A7856u);
+
+		Common::MemoryReadStream ms32(contents, 4);
+		Common::BitStream32LELSB bs32(ms32);
+		bs32.skip(4);
+		TS_ASSERT_EQUALS(bs32.peekBits(32), 0x07856341u);
+		TS_ASSERT_EQUALS(bs32.getBits(28), 0x7856341u);
+		TS_ASSERT(bs32.eos());
+	}
+
+	void test_align_after_peek() {
+		byte contents[] = { 0x12, 0x34, 0x56, 0x78, 0x9A };
+
+		Common::MemoryReadStream ms(contents, sizeof(contents));
+
+		// Peeking reads ahead, aligning hands the data stream back right
+		// after the last value used
+		Common::BitStream8MSB bs(ms);
+		TS_ASSERT_EQUALS(bs.getBits(4), 0x1u);
+		TS_ASSERT_EQUALS(bs.peekBits(24), 0x234567u);
+		bs.align();
+		TS_ASSERT_EQUALS(bs.pos(), 8u);
+		TS_ASSERT_EQUALS(ms.pos(), 1);
+		TS_ASSERT_EQUALS(ms.readByte(), 0x34);
+	}
 };
@@ -0,0 +1,133 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/config-manager.h"
+#include "common/memstream.h"
+
+class ConfigManagerTestSuite : public CxxTest::TestSuite {
+	static const char *configText() {
+		return
+			"[scummvm]\n"
+			"gfx_mode=2x\n"
+			"\n"
+			"# The comment of monkey\n"
+			"[monkey]\r\n"
+			"description = The Secret of Monkey Island\r\n"
+			"# Where the game is\r\n"
+			"path=/games/monkey\r\n"
+			"gameid=monkey\r\n"
+			"\r\n"
+			"[misc]\n"
+			"foo=bar\n"
+			"\n"
+			"[tentacle]\n"
+			"  GameID  =tentacle\n"
+			"# A trailing comment, which goes to the next domain\n";
+	}
+
+	static void load(const char *text) {
+		Common::MemoryReadStream stream((const byte *)text, strlen(text));
+		ConfMan.loadFromStream(stream);
+	}
+
+	static Common::String save() {
+		Common::MemoryWriteStreamDynamic stream(DisposeAfterUse::YES);
+		ConfMan.saveToStream(stream);
+		return Common::String((const char *)stream.getData(), stream.size());
+	}
+
+public:
+	void test_lazy_parsing() {
+		load(configText());
+
+		Common::ConfigManager::Stats stats = ConfMan.getStats();
+		TS_ASSERT_EQUALS(stats.domains, 3u);
+		TS_ASSERT_EQUALS(stats.parsedDomains, 0u);
+
+		TS_ASSERT(ConfMan.hasGameDomain("monkey"));
+		TS_ASSERT(ConfMan.hasGameDomain("tentacle"));
+		TS_ASSERT(ConfMan.hasMiscDomain("misc"));
+		TS_ASSERT_EQUALS(ConfMan.getStats().parsedDomains, 0u);
+
+		TS_ASSERT_EQUALS(ConfMan.get("path", "monkey"), "/games/monkey");
+		TS_ASSERT_EQUALS(ConfMan.get("description", "monkey"), "The Secret of Monkey Island");
+		TS_ASSERT_EQUALS(ConfMan.getStats().parsedDomains, 1u);
+
+		const Common::ConfigManager::Domain *monkey = ConfMan.getDomain("monkey");
+		TS_ASSERT_EQUALS(monkey->getDomainComment(), "# The comment of monkey\n");
+		TS_ASSERT_EQUALS(monkey->getKVComment("path"), "# Where the game is\n");
+
+		const Common::ConfigManager::Domain *tentacle = ConfMan.getDomain("tentacle");
+		TS_ASSERT_EQUALS(tentacle->getVal("gameid"), "tentacle");
+		TS_ASSERT(!tentacle->hasKVComment("description"));
+		TS_ASSERT_EQUALS(ConfMan.get("gfx_mode", "scummvm"), "2x");
+	}
+
+	void test_save_unmodified() {
+		load(configText());
+
+		// Unmodified domains are copied, including their formatting
+		Common::String text = save();
+		TS_ASSERT(text.contains("description = The Secret of Monkey Island\r\n"));
+		TS_ASSERT(text.contains("  GameID  =tentacle\n"));
+		TS_ASSERT_EQUALS(ConfMan.getStats().parsedDomains, 0u);
+
+		// ... and saving again gives the same text
+		load(text.c_str());
+		TS_ASSERT_EQUALS(save(), text);
+	}
+
+	void test_reads_do_not_modify() {
+		load(configText());
+
+		// Neither reading through a non-const domain nor setting a value to
+		// what it already is modifies the domain, so it is copied as it was
+		Common::ConfigManager::Domain *monkey = ConfMan.getDomain("monkey");
+		TS_ASSERT_EQUALS((*monkey)["path"], "/games/monkey");
+		TS_ASSERT_EQUALS(monkey->getVal("gameid"), "monkey");
+		ConfMan.set("description", "The Secret of Monkey Island", "monkey");
+
+		TS_ASSERT(save().contains("description = The Secret of Monkey Island\r\n"));
+	}
+
+	void test_save_modified() {
+		load(configText());
+
+		ConfMan.set("path", "/other/monkey", "monkey");
+		ConfMan.addGameDomain("loom");
+		ConfMan.set("gameid", "loom", "loom");
+		ConfMan.removeMiscDomain("misc");
+
+		Common::String text = save();
+		TS_ASSERT(text.contains("description=The Secret of Monkey Island\n"));
+		TS_ASSERT(text.contains("  GameID  =tentacle\n"));
+
+		load(text.c_str());
+		TS_ASSERT_EQUALS(ConfMan.get("path", "monkey"), "/other/monkey");
+		TS_ASSERT_EQUALS(ConfMan.getDomain("monkey")->getKVComment("path"), "# Where the game is\n");
+		TS_ASSERT_EQUALS(ConfMan.get("gameid", "tentacle"), "tentacle");
+		TS_ASSERT_EQUALS(ConfMan.get("gameid", "loom"), "loom");
+		TS_ASSERT(!ConfMan.hasMiscDomain("misc"));
+		TS_ASSERT_EQUALS(ConfMan.getStats().domains, 3u);
+	}
+
+	void test_comments_of_unparsed_domains() {
+		load(configText());
+
+		// Reading comments parses the domain
+		const Common::ConfigManager::Domain *monkey = ConfMan.getDomain("monkey");
+		TS_ASSERT(monkey->hasKVComment("path"));
+		TS_ASSERT_EQUALS(monkey->getKVComment("path"), "# Where the game is\n");
+		TS_ASSERT_EQUALS(ConfMan.getStats().parsedDomains, 1u);
+
+		// Setting comments modifies the domain, so they are saved
+		ConfMan.getDomain("tentacle")->setKVComment("gameid", "# The id\n");
+		ConfMan.getDomain("misc")->setDomainComment("# Miscellaneous\n");
+		Common::String text = save();
+		TS_ASSERT(text.contains("# The id\nGameID=tentacle\n"));
+		TS_ASSERT(text.contains("# Miscellaneous\n[misc]\n"));
+
+		load(text.c_str());
+		TS_ASSERT_EQUALS(ConfMan.getDomain("tentacle")->getKVComment("gameid"), "# The id\n");
+		TS_ASSERT_EQUALS(ConfMan.getDomain("misc")->getDomainComment(), "# Miscellaneous\n");
+	}
+};
@@ -0,0 +1,83 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/dct.h"
+#include "common/fft.h"
+#include "common/rdft.h"
+
+class FFTTestSuite : public CxxTest::TestSuite {
+	static void fillData(float *data, int n) {
+		uint32 x = 1;
+		for (int i = 0; i < n; i++) {
+			x = x * 1103515245 + 12345;
+			data[i] = (float)((x >> 8) & 0xFFFF) / 32768.0f - 1.0f;
+		}
+	}
+
+public:
+	void test_fft() {
+		// Check against a plain DFT, for sizes with and without the passes
+		for (int bits = 2; bits <= 10; bits++) {
+			const int n = 1 << bits;
+			Common::Complex *z = new Common::Complex[n];
+			Common::Complex *in = new Common::Complex[n];
+			fillData((float *)in, 2 * n);
+
+			for (int inverse = 0; inverse <= 1; inverse++) {
+				memcpy(z, in, n * sizeof(Common::Complex));
+
+				Common::FFT fft(bits, inverse);
+				fft.permute(z);
+				fft.calc(z);
+
+				const double sign = inverse ? 1.0 : -1.0;
+				for (int k = 0; k < n; k++) {
+					double re = 0.0, im = 0.0;
+					for (int j = 0; j < n; j++) {
+						const double a = sign * 2 * M_PI * j * k / n;
+						re += in[j].re * cos(a) - in[j].im * sin(a);
+						im += in[j].re * sin(a) + in[j].im * cos(a);
+					}
+					TS_ASSERT_DELTA(z[k].re, re, 1e-3);
+					TS_ASSERT_DELTA(z[k].im, im, 1e-3);
+				}
+			}
+
+			delete[] z;
+			delete[] in;
+		}
+	}
+
+	void test_rdft_round_trip() {
+		const int bits = 9;
+		const int n = 1 << bits;
+		float data[n], orig[n];
+		fillData(orig, n);
+		memcpy(data, orig, sizeof(data));
+
+		Common::RDFT forward(bits, Common::RDFT::DFT_R2C);
+		Common::RDFT inverse(bits, Common::RDFT::IDFT_C2R);
+		forward.calc(data);
+		inverse.calc(data);
+
+		// The inverse is scaled by n / 2
+		for (int i = 0; i < n; i++)
+			TS_ASSERT_DELTA(data[i] * 2 / n, orig[i], 1e-4);
+	}
+
+	void test_dct_round_trip() {
+		const int bits = 8;
+		const int n = 1 << bits;
+		float data[n], orig[n];
+		fillData(orig, n);
+		memcpy(data, orig, sizeof(data));
+
+		Common::DCT dct2(bits, Common::DCT::DCT_II);
+		Common::DCT dct3(bits, Common::DCT::DCT_III);
+		dct2.calc(data);
+		dct3.calc(data);
+
+		// DCT_III includes the scaling to make it the inverse of DCT_II
+		for (int i = 0; i < n; i++)
+			TS_ASSERT_DELTA(data[i], orig[i], 1e-4);
+	}
+};
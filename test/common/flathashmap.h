@@ -0,0 +1,142 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/flathashmap.h"
+#include "common/hashmap.h"
+#include "common/hash-str.h"
+
+class FlatHashMapTestSuite : public CxxTest::TestSuite
+{
+	public:
+	void test_add_remove() {
+		Common::FlatHashMap<int, int> container;
+		TS_ASSERT(container.empty());
+		container[0] = 17;
+		container[1] = 33;
+		container[2] = 45;
+		TS_ASSERT(container.contains(1));
+		TS_ASSERT(!container.contains(17));
+		container.erase(1);
+		TS_ASSERT(!container.contains(1));
+		container[1] = 42;
+		TS_ASSERT_EQUALS(container[1], 42);
+		container.erase(container.find(0));
+		container.erase(1);
+		container.erase(2);
+		TS_ASSERT(container.empty());
+		TS_ASSERT_EQUALS(container.begin(), container.end());
+	}
+
+	void test_lookup_with_default() {
+		Common::FlatHashMap<int, int> container;
+		container[0] = 17;
+		container[1] = -1;
+
+		const Common::FlatHashMap<int, int> &containerRef = container;
+
+		TS_ASSERT_EQUALS(containerRef.getVal(0), 17);
+		TS_ASSERT_EQUALS(containerRef.getVal(17), 0);
+		TS_ASSERT_EQUALS(containerRef.getVal(1, -10), -1);
+		TS_ASSERT_EQUALS(containerRef.getVal(17, -10), -10);
+		TS_ASSERT_EQUALS(containerRef.find(17), containerRef.end());
+		TS_ASSERT_EQUALS(container.size(), 2u);
+	}
+
+	void test_string_keys() {
+		Common::FlatHashMap<Common::String, int, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> container;
+		container["foo"] = 1;
+		container.setVal("Bar", 2);
+		TS_ASSERT(container.contains("FOO"));
+		TS_ASSERT_EQUALS(container["bar"], 2);
+		TS_ASSERT_EQUALS(container.find("BAR")->_key, "Bar");
+		TS_ASSERT(!container.contains("quux"));
+
+		container.clear(true);
+		TS_ASSERT(container.empty());
+		TS_ASSERT(!container.contains("foo"));
+	}
+
+	void test_copy() {
+		Common::FlatHashMap<int, int> map1, map2;
+		for (int i = 0; i < 100; ++i)
+			map1[i * 7] = i;
+		map1.erase(14);
+
+		map2 = map1;
+		Common::FlatHashMap<int, int> map3(map1);
+		map1.clear();
+		TS_ASSERT_EQUALS(map2.size(), 99u);
+		TS_ASSERT_EQUALS(map3.size(), 99u);
+		TS_ASSERT_EQUALS(map2[49], 7);
+		TS_ASSERT_EQUALS(map3[693], 99);
+		TS_ASSERT(!map3.contains(14));
+	}
+
+	void test_against_hashmap() {
+		// Random inserts and erases, checked against the node based HashMap.
+		// Enough keys to go through several rehashes, and enough erases to
+		// fill the table with deleted markers.
+		Common::FlatHashMap<uint, uint> flat;
+		Common::HashMap<uint, uint> reference;
+
+		uint32 x = 1;
+		for (int i = 0; i < 20000; ++i) {
+			x = x * 1103515245 + 12345;
+			const uint key = (x >> 8) % 3000;
+			if (x & 0x80000000) {
+				flat.erase(key);
+				reference.erase(key);
+			} else {
+				flat[key] = i;
+				reference[key] = i;
+			}
+		}
+
+		TS_ASSERT_EQUALS(flat.size(), reference.size());
+		for (Common::HashMap<uint, uint>::const_iterator i = reference.begin(); i != reference.end(); ++i)
+			TS_ASSERT_EQUALS(flat.getVal(i->_key, (uint)-1), i->_value);
+
+		uint count = 0;
+		for (Common::FlatHashMap<uint, uint>::const_iterator i = flat.begin(); i != flat.end(); ++i) {
+			TS_ASSERT(reference.contains(i->_key));
+			++count;
+		}
+		TS_ASSERT_EQUALS(count, flat.size());
+	}
+
+	struct CollidingHash {
+		uint operator()(uint) const { return 0; }
+	};
+
+	void test_erase_in_probe_chain() {
+		// All keys share one probe sequence spanning several groups, so
+		// erased slots in its middle must not end lookups of later keys.
+		Common::FlatHashMap<uint, uint, CollidingHash> map;
+		for (uint i = 0; i < 40; ++i)
+			map[i] = i;
+
+		for (uint i = 0; i < 40; i += 3)
+			map.erase(i);
+		for (uint i = 0; i < 40; ++i)
+			TS_ASSERT_EQUALS(map.contains(i), i % 3 != 0);
+
+		for (uint i = 0; i < 40; i += 3)
+			map[i] = i + 100;
+		for (uint i = 0; i < 40; ++i)
+			TS_ASSERT_EQUALS(map.getVal(i, 0), i % 3 ? i : i + 100);
+		TS_ASSERT_EQUALS(map.size(), 40u);
+	}
+
+	void test_erase_while_iterating() {
+		Common::FlatHashMap<int, int> container;
+		for (int i = 0; i < 50; ++i)
+			container[i] = i;
+
+		for (Common::FlatHashMap<int, int>::iterator i = container.begin(); i != container.end(); ++i) {
+			if (i->_value & 1)
+				container.erase(i);
+		}
+		TS_ASSERT_EQUALS(container.size(), 25u);
+		TS_ASSERT(container.contains(48));
+		TS_ASSERT(!container.contains(49));
+	}
+};
@@ -141,4 +141,95 @@ class HuffmanTestSuite : public CxxTest::TestSuite {
 		TS_ASSERT_EQUALS(h.getSymbol(bs), expected[5]);
 		TS_ASSERT_EQUALS(h.getSymbol(bs), expected[6]);
 	}
+
+	void test_long_codes() {
+		/*
+		 * Codes longer than the first level of the lookup table, in both
+		 * bit orders. Symbol i < 15 is coded as i ones followed by a zero,
+		 * symbol 15 as 15 ones.
+		 */
+		const uint32 codeCount = 16;
+		uint8 lengths[codeCount];
+		uint32 codesMSB[codeCount], codesLSB[codeCount];
+		for (uint32 i = 0; i < codeCount; i++) {
+			lengths[i] = (i < codeCount - 1) ? i + 1 : i;
+			codesMSB[i] = (i < codeCount - 1) ? ((1 << (i + 1)) - 2) : ((1 << i) - 1);
+			// The first bit is the lowest one
+			codesLSB[i] = (1 << i) - 1;
+		}
+
+		const uint32 message[] = { 14, 0, 15, 9, 10, 1, 15, 12, 3, 0, 13 };
+		const uint32 messageSize = ARRAYSIZE(message);
+
+		// Write the message both ways
+		byte msb[16], lsb[16];
+		memset(msb, 0, sizeof(msb));
+		memset(lsb, 0, sizeof(lsb));
+		uint32 pos = 0;
+		for (uint32 i = 0; i < messageSize; i++) {
+			for (uint32 j = 0; j < lengths[message[i]]; j++, pos++) {
+				if ((codesMSB[message[i]] >> (lengths[message[i]] - 1 - j)) & 1)
+					msb[pos / 8] |= 0x80 >> (pos % 8);
+				if ((codesLSB[message[i]] >> j) & 1)
+					lsb[pos / 8] |= 1 << (pos % 8);
+			}
+		}
+
+		Common::Huffman hMSB(0, codeCount, codesMSB, lengths);
+		Common::Huffman hLSB(0, codeCount, codesLSB, lengths, 0, false);
+		// Built for the other bit order, so decoding bit by bit
+		Common::Huffman hLSBSlow(0, codeCount, codesLSB, lengths);
+
+		Common::MemoryReadStream msMSB(msb, sizeof(msb));
+		Common::BitStream8MSB bsMSB(msMSB);
+		Common::MemoryReadStream msLSB(lsb, sizeof(lsb));
+		Common::BitStream32LELSB bsLSB(msLSB);
+		Common::MemoryReadStream msLSBSlow(lsb, sizeof(lsb));
+		Common::BitStream32LELSB bsLSBSlow(msLSBSlow);
+
+		for (uint32 i = 0; i < messageSize; i++) {
+			TS_ASSERT_EQUALS(hMSB.getSymbol(bsMSB), message[i]);
+			TS_ASSERT_EQUALS(hLSB.getSymbol(bsLSB), message[i]);
+			TS_ASSERT_EQUALS(hLSBSlow.getSymbol(bsLSBSlow), message[i]);
+		}
+		TS_ASSERT_EQUALS(bsMSB.pos(), pos);
+		TS_ASSERT_EQUALS(bsLSB.pos(), pos);
+		TS_ASSERT_EQUALS(bsLSBSlow.pos(), pos);
+	}
+
+	void test_very_long_codes() {
+		/*
+		 * Codes too long for a second level table, which are decoded bit
+		 * by bit. Symbol i < 27 is coded as i ones followed by a zero,
+		 * symbol 27 as 27 ones.
+		 */
+		const uint32 codeCount = 28;
+		uint8 lengths[codeCount];
+		uint32 codes[codeCount];
+		for (uint32 i = 0; i < codeCount; i++) {
+			lengths[i] = (i < codeCount - 1) ? i + 1 : i;
+			codes[i] = (i < codeCount - 1) ? ((1 << (i + 1)) - 2) : ((1 << i) - 1);
+		}
+
+		const uint32 message[] = { 26, 0, 27, 3, 17, 9, 27, 1 };
+		const uint32 messageSize = ARRAYSIZE(message);
+
+		byte data[32];
+		memset(data, 0, sizeof(data));
+		uint32 pos = 0;
+		for (uint32 i = 0; i < messageSize; i++) {
+			for (uint32 j = 0; j < lengths[message[i]]; j++, pos++) {
+				if ((codes[message[i]] >> (lengths[message[i]] - 1 - j)) & 1)
+					data[pos / 8] |= 0x80 >> (pos % 8);
+			}
+		}
+
+		Common::Huffman h(0, codeCount, codes, lengths);
+		Common::MemoryReadStream ms(data, sizeof(data));
+		Common::BitStream8MSB bs(ms);
+
+		for (uint32 i = 0; i < messageSize; i++)
+			TS_ASSERT_EQUALS(h.getSymbol(bs), message[i]);
+		TS_ASSERT_EQUALS(bs.pos(), pos);
+	}
 };
@@ -272,4 +272,23 @@ class ListTestSuite : public CxxTest::TestSuite
 		TS_ASSERT_EQUALS(container.front(), 99);
 		TS_ASSERT_EQUALS(container.back(),  99);
 	}
+
+	void test_move() {
+#if __cplusplus >= 201103L
+		Common::List<int> container;
+		container.push_back(1);
+		container.push_back(2);
+
+		Common::List<int> moved(Common::move(container));
+		TS_ASSERT(container.empty());
+		TS_ASSERT_EQUALS(moved.size(), 2u);
+		TS_ASSERT_EQUALS(moved.back(), 2);
+
+		container.push_back(3);
+		container = Common::move(moved);
+		TS_ASSERT_EQUALS(container.size(), 2u);
+		TS_ASSERT_EQUALS(container.front(), 1);
+		TS_ASSERT(moved.empty());
+#endif
+	}
 };
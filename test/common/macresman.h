@@ -0,0 +1,91 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/macresman.h"
+#include "common/memstream.h"
+
+class MacResManagerTestSuite : public CxxTest::TestSuite {
+	enum {
+		kForkSize = 256 + 16 + 68,
+		kFileSize = 128 + 384
+	};
+
+	byte _file[kFileSize];
+
+	// A MacBinary file with an empty data fork, and a resource fork with two
+	// resources of type 'TEST': 128 named "hello" containing "abc", and 129
+	// containing "defgh"
+	void buildFile() {
+		memset(_file, 0, sizeof(_file));
+		_file[1] = 4;
+		memcpy(_file + 2, "test", 4);
+		WRITE_BE_UINT32(_file + 83, 0);
+		WRITE_BE_UINT32(_file + 87, kForkSize);
+
+		byte *fork = _file + 128;
+		WRITE_BE_UINT32(fork, 256);
+		WRITE_BE_UINT32(fork + 4, 272);
+		WRITE_BE_UINT32(fork + 8, 16);
+		WRITE_BE_UINT32(fork + 12, 68);
+
+		byte *data = fork + 256;
+		WRITE_BE_UINT32(data, 3);
+		memcpy(data + 4, "abc", 3);
+		WRITE_BE_UINT32(data + 7, 5);
+		memcpy(data + 11, "defgh", 5);
+
+		byte *map = fork + 272;
+		WRITE_BE_UINT16(map + 24, 28);		// type list
+		WRITE_BE_UINT16(map + 26, 62);		// name list
+		WRITE_BE_UINT16(map + 28, 0);		// one type
+		WRITE_BE_UINT32(map + 30, MKTAG('T','E','S','T'));
+		WRITE_BE_UINT16(map + 34, 1);		// two resources
+		WRITE_BE_UINT16(map + 36, 10);		// reference list
+		WRITE_BE_UINT16(map + 38, 128);
+		WRITE_BE_UINT16(map + 40, 0);
+		WRITE_BE_UINT32(map + 42, 0);
+		WRITE_BE_UINT16(map + 50, 129);
+		WRITE_BE_UINT16(map + 52, 0xFFFF);
+		WRITE_BE_UINT32(map + 54, 7);
+		map[62] = 5;
+		memcpy(map + 63, "hello", 5);
+	}
+
+	static Common::String readAll(Common::SeekableReadStream *stream) {
+		Common::String str;
+		while (stream && !stream->eos()) {
+			byte b = stream->readByte();
+			if (!stream->eos())
+				str += (char)b;
+		}
+		return str;
+	}
+
+public:
+	void test_resources() {
+		buildFile();
+		Common::SeekableReadStream *res128;
+		Common::SeekableReadStream *res129;
+
+		{
+			Common::MacResManager resMan;
+			TS_ASSERT(resMan.loadFromMacBinary(*new Common::MemoryReadStream(_file, sizeof(_file))));
+
+			Common::MacResIDArray ids = resMan.getResIDArray(MKTAG('T','E','S','T'));
+			TS_ASSERT_EQUALS(ids.size(), 2u);
+			TS_ASSERT_EQUALS(ids[0], 128);
+			TS_ASSERT_EQUALS(ids[1], 129);
+			TS_ASSERT_EQUALS(resMan.getResName(MKTAG('T','E','S','T'), 128), "hello");
+
+			res128 = resMan.getResource("hello");
+			res129 = resMan.getResource(MKTAG('T','E','S','T'), 129);
+			TS_ASSERT(!resMan.getResource(MKTAG('T','E','S','T'), 130));
+		}
+
+		// The resources refer to the data of the fork, and keep it open
+		TS_ASSERT_EQUALS(res128->getDataPointer(), _file + 128 + 256 + 4);
+		TS_ASSERT_EQUALS(readAll(res128), "abc");
+		TS_ASSERT_EQUALS(readAll(res129), "defgh");
+		delete res128;
+		delete res129;
+	}
+};
@@ -47,4 +47,33 @@ class MD5TestSuite : public CxxTest::TestSuite {
 		}
 	}
 
+	void test_computeStreamsMD5() {
+		// Messages of different lengths, so that the lanes run out of data
+		// at different times, and more messages than lanes
+		const int kCount = 7;
+		const uint32 sizes[kCount] = { 0, 1, 64, 4096, 10000, 5000, 129 };
+		byte *data = (byte *)malloc(10000);
+		for (int i = 0; i < 10000; i++)
+			data[i] = (byte)(i * 7 + (i >> 8));
+
+		for (uint32 length = 0; length <= 4096; length += 4096) {
+			Common::ReadStream *streams[kCount];
+			uint8 digests[kCount][16];
+			for (int i = 0; i < kCount; i++)
+				streams[i] = new Common::MemoryReadStream(data, sizes[i]);
+
+			TS_ASSERT(Common::computeStreamsMD5(streams, kCount, digests, length));
+
+			for (int i = 0; i < kCount; i++) {
+				uint8 expected[16];
+				Common::MemoryReadStream stream(data, sizes[i]);
+				Common::computeStreamMD5(stream, expected, length);
+				TS_ASSERT(!memcmp(digests[i], expected, 16));
+				delete streams[i];
+			}
+		}
+
+		free(data);
+	}
+
 };
@@ -0,0 +1,116 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/bufferedstream.h"
+#include "common/memstream.h"
+
+class ReadAheadStreamTestSuite : public CxxTest::TestSuite {
+	enum {
+		kSize = 1024 * 1024 + 123
+	};
+
+	byte *_data;
+
+	const Common::ReadAheadStats *findStats(const Common::Array<Common::ReadAheadStats> &stats, const char *name) {
+		for (uint i = 0; i < stats.size(); ++i) {
+			if (stats[i].name == name)
+				return &stats[i];
+		}
+		return 0;
+	}
+
+public:
+	void setUp() {
+		_data = (byte *)malloc(kSize);
+		for (uint32 i = 0; i < kSize; ++i)
+			_data[i] = (byte)(i * 7 + (i >> 8));
+	}
+
+	void tearDown() {
+		free(_data);
+	}
+
+	void test_sequential() {
+		Common::MemoryReadStream ms(_data, kSize);
+		Common::SeekableReadStream *stream = Common::wrapReadAheadStream(&ms, DisposeAfterUse::NO, "sequential");
+		TS_ASSERT_EQUALS(stream->size(), (int32)kSize);
+
+		byte buf[1000];
+		bool ok = true;
+		uint32 total = 0;
+		while (!stream->eos()) {
+			const uint32 n = stream->read(buf, sizeof(buf));
+			ok = ok && !memcmp(buf, _data + total, n);
+			total += n;
+		}
+		TS_ASSERT(ok);
+		TS_ASSERT_EQUALS(total, (uint32)kSize);
+		TS_ASSERT(!stream->err());
+
+		// Sequential reading grew the window
+		Common::Array<Common::ReadAheadStats> stats = Common::ReadAheadStreamList::instance().getStats();
+		const Common::ReadAheadStats *s = findStats(stats, "sequential");
+		TS_ASSERT(s);
+		TS_ASSERT_EQUALS(s->window, 256u * 1024);
+		TS_ASSERT_EQUALS(s->bytesRead, (uint32)kSize);
+		TS_ASSERT_LESS_THAN(s->refills, 15u);
+		TS_ASSERT_EQUALS(s->seeks, 0u);
+
+		delete stream;
+		TS_ASSERT(!findStats(Common::ReadAheadStreamList::instance().getStats(), "sequential"));
+	}
+
+	void test_random_access() {
+		Common::MemoryReadStream ms(_data, kSize);
+		Common::SeekableReadStream *stream = Common::wrapReadAheadStream(&ms, DisposeAfterUse::NO, "random");
+
+		byte buf[5000];
+		bool ok = true;
+		uint32 x = 1;
+		for (int i = 0; i < 500; ++i) {
+			x = x * 1103515245 + 12345;
+			const uint32 start = (x >> 8) % kSize;
+			const uint32 len = MIN<uint32>((x >> 4) % sizeof(buf), kSize - start);
+			stream->seek(start);
+			ok = ok && stream->read(buf, len) == len && !memcmp(buf, _data + start, len);
+			ok = ok && stream->pos() == (int32)(start + len);
+		}
+		TS_ASSERT(ok);
+
+		// Random access sticks to the smallest windows; only reads which
+		// cross the end of a window count as sequential
+		Common::Array<Common::ReadAheadStats> stats = Common::ReadAheadStreamList::instance().getStats();
+		TS_ASSERT_LESS_THAN_EQUALS(findStats(stats, "random")->window, 8u * 1024);
+		TS_ASSERT_LESS_THAN(400u, findStats(stats, "random")->seeks);
+		delete stream;
+	}
+
+	void test_seek() {
+		Common::MemoryReadStream ms(_data, kSize);
+		Common::SeekableReadStream *stream = Common::wrapReadAheadStream(&ms, DisposeAfterUse::NO);
+
+		// Seeking back into the buffer
+		stream->seek(100);
+		TS_ASSERT_EQUALS(stream->readByte(), _data[100]);
+		stream->seek(-50, SEEK_CUR);
+		TS_ASSERT_EQUALS(stream->pos(), 51);
+		TS_ASSERT_EQUALS(stream->readByte(), _data[51]);
+
+		// Big reads go to the parent stream directly
+		byte *big = (byte *)malloc(300000);
+		TS_ASSERT_EQUALS(stream->read(big, 300000), 300000u);
+		TS_ASSERT(!memcmp(big, _data + 52, 300000));
+		free(big);
+
+		stream->seek(-1, SEEK_END);
+		TS_ASSERT_EQUALS(stream->readByte(), _data[kSize - 1]);
+		TS_ASSERT(!stream->eos());
+		stream->readByte();
+		TS_ASSERT(stream->eos());
+
+		TS_ASSERT(stream->seek(0, SEEK_SET));
+		TS_ASSERT(!stream->eos());
+		TS_ASSERT(!stream->seek(-1, SEEK_SET));
+		TS_ASSERT_EQUALS(stream->readByte(), _data[0]);
+		delete stream;
+	}
+};
@@ -0,0 +1,147 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/archive.h"
+#include "common/memstream.h"
+
+class NamedArchive : public Common::Archive {
+	Common::String _name;
+
+public:
+	mutable int _lookups;
+	bool _reported;	///< whether hasFile() reports the member
+	bool _openable;	///< whether createReadStreamForMember() opens it
+
+	NamedArchive(const char *name) : _name(name), _lookups(0), _reported(true), _openable(true) {}
+
+	virtual bool hasFile(const Common::String &name) const {
+		++_lookups;
+		return _reported && name.equalsIgnoreCase(_name);
+	}
+
+	virtual int listMembers(Common::ArchiveMemberList &list) const {
+		list.push_back(Common::ArchiveMemberPtr(new Common::GenericArchiveMember(_name, this)));
+		return 1;
+	}
+
+	virtual const Common::ArchiveMemberPtr getMember(const Common::String &name) const {
+		return Common::ArchiveMemberPtr(new Common::GenericArchiveMember(_name, this));
+	}
+
+	virtual Common::SeekableReadStream *createReadStreamForMember(const Common::String &name) const {
+		if (!_openable || !name.equalsIgnoreCase(_name))
+			return 0;
+		return new Common::MemoryReadStream((const byte *)_name.c_str(), _name.size());
+	}
+};
+
+class IndexedSearchSet : public Common::SearchSet {
+public:
+	IndexedSearchSet() { setUseIndex(true); }
+};
+
+class SearchSetTestSuite : public CxxTest::TestSuite {
+public:
+	void test_index() {
+		IndexedSearchSet set;
+		NamedArchive *a = new NamedArchive("a.dat");
+		NamedArchive *b = new NamedArchive("b.dat");
+		set.add("a", a);
+		set.add("b", b);
+
+		TS_ASSERT(set.hasFile("b.dat"));
+		TS_ASSERT_EQUALS(a->_lookups, 1);
+		TS_ASSERT_EQUALS(set.getIndexStats().misses, 1u);
+
+		// Answered by the index, which asks the archives up to the owning
+		// one again, but none behind it
+		NamedArchive *c = new NamedArchive("d.dat");
+		set.add("c", c, -10);
+		TS_ASSERT(set.hasFile("b.dat"));
+		Common::SeekableReadStream *stream = set.createReadStreamForMember("B.DAT");
+		TS_ASSERT(stream);
+		TS_ASSERT_EQUALS(stream->size(), 5);
+		delete stream;
+		TS_ASSERT_EQUALS(a->_lookups, 3);
+		TS_ASSERT_EQUALS(c->_lookups, 0);
+		TS_ASSERT_EQUALS(set.getIndexStats().hits, 1u);
+
+		// Misses are not remembered
+		TS_ASSERT(!set.hasFile("c.dat"));
+		TS_ASSERT(!set.createReadStreamForMember("c.dat"));
+		TS_ASSERT_EQUALS(set.getIndexStats().hits, 1u);
+		TS_ASSERT_EQUALS(set.getIndexSize(), 1u);
+	}
+
+	void test_index_fallback() {
+		IndexedSearchSet set;
+		NamedArchive *broken = new NamedArchive("a.dat");
+		NamedArchive *a = new NamedArchive("a.dat");
+		NamedArchive *hidden = new NamedArchive("b.dat");
+		set.add("broken", broken, 20);
+		set.add("a", a, 10);
+		set.add("hidden", hidden);
+
+		// The indexed archive fails to open the member, the next one is used
+		broken->_openable = false;
+		Common::SeekableReadStream *stream = set.createReadStreamForMember("a.dat");
+		TS_ASSERT(stream);
+		delete stream;
+
+		// Members hasFile() does not report are still opened, also after
+		// they were looked up before
+		hidden->_reported = false;
+		TS_ASSERT(!set.hasFile("b.dat"));
+		stream = set.createReadStreamForMember("b.dat");
+		TS_ASSERT(stream);
+		delete stream;
+
+		// Archives which get a member later on are found
+		hidden->_reported = true;
+		TS_ASSERT(set.hasFile("b.dat"));
+	}
+
+	void test_index_shadowed_later() {
+		IndexedSearchSet set;
+		NamedArchive *a = new NamedArchive("a.dat");
+		NamedArchive *b = new NamedArchive("a.dat");
+		b->_reported = false;
+		set.add("a", a, 10);
+		set.add("b", b);
+		b->_openable = false;
+
+		// Indexed in the lower priority archive ...
+		TS_ASSERT(set.hasFile("a.dat"));
+		a->_reported = false;
+		b->_reported = true;
+		TS_ASSERT(set.hasFile("a.dat"));
+		TS_ASSERT_EQUALS(set.getArchiveForMember("a.dat"), b);
+
+		// ... until the higher priority one gets the member
+		a->_reported = true;
+		TS_ASSERT_EQUALS(set.getArchiveForMember("a.dat"), a);
+		Common::SeekableReadStream *stream = set.createReadStreamForMember("a.dat");
+		TS_ASSERT(stream);
+		delete stream;
+	}
+
+	void test_index_invalidation() {
+		IndexedSearchSet set;
+		set.add("a", new NamedArchive("x.dat"));
+		TS_ASSERT(set.hasFile("x.dat"));
+		TS_ASSERT(!set.hasFile("y.dat"));
+
+		set.add("b", new NamedArchive("y.dat"), 10);
+		TS_ASSERT_EQUALS(set.getIndexStats().invalidations, 1u);
+		TS_ASSERT(set.hasFile("y.dat"));
+
+		// A higher priority archive shadows the indexed one
+		NamedArchive *c = new NamedArchive("x.dat");
+		set.add("c", c, 20);
+		TS_ASSERT(set.getMember("x.dat"));
+		TS_ASSERT_EQUALS(c->_lookups, 1);
+
+		set.remove("b");
+		TS_ASSERT(!set.hasFile("y.dat"));
+		TS_ASSERT(set.hasFile("x.dat"));
+	}
+};
@@ -70,4 +70,17 @@ class SeekableSubReadStreamTestSuite : public CxxTest::TestSuite {
 		b = ssrs.readByte();
 		TS_ASSERT_EQUALS(b, 1);
 	}
+
+	void test_data_pointer() {
+		byte contents[10] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+		Common::MemoryReadStream ms(contents, 10);
+		TS_ASSERT_EQUALS(ms.getDataPointer(), contents);
+
+		Common::SeekableSubReadStream ssrs(&ms, 2, 8);
+		TS_ASSERT_EQUALS(ssrs.getDataPointer(), contents + 2);
+
+		// Nested substreams add up their offsets
+		Common::SeekableSubReadStream nested(&ssrs, 3, 6);
+		TS_ASSERT_EQUALS(nested.getDataPointer(), contents + 5);
+	}
 };
@@ -1,5 +1,6 @@
 #include <cxxtest/TestSuite.h>
 
+#include "common/memstream.h"
 #include "common/serializer.h"
 #include "common/stream.h"
 
@@ -108,4 +109,97 @@ public:
 	void test_read_v2_as_v2() {
 		readVersioned_v2(_inStreamV2, 2);
 	}
+
+	// Syncs arrays with every kind of conversion
+	static void syncArrays(Common::Serializer &ser, int16 *native, int *wide, uint16 *be, bool *flags) {
+		ser.syncArrayAsSint16LE(native, 300);
+		ser.syncArrayAsSint16LE(wide, 300);
+		ser.syncArrayAsUint16BE(be, 3);
+		ser.syncArrayAsByte(flags, 3);
+	}
+
+	void test_arrays() {
+		int16 native[300];
+		int wide[300];
+		uint16 be[3] = { 0x0102, 0x0304, 0xFFFF };
+		bool flags[3] = { true, false, true };
+		for (int i = 0; i < 300; ++i) {
+			native[i] = i * 100 - 15000;
+			wide[i] = -i;
+		}
+
+		Common::MemoryWriteStreamDynamic out(DisposeAfterUse::YES);
+		Common::Serializer saver(0, &out);
+		syncArrays(saver, native, wide, be, flags);
+		TS_ASSERT_EQUALS(saver.bytesSynced(), 1209u);
+		TS_ASSERT_EQUALS(out.size(), 1209u);
+
+		// The layout is the same as with single values
+		const byte *data = out.getData();
+		TS_ASSERT_EQUALS(READ_LE_UINT16(data + 2), (uint16)-14900);
+		TS_ASSERT_EQUALS(READ_LE_UINT16(data + 602), (uint16)-1);
+		TS_ASSERT_EQUALS(READ_BE_UINT16(data + 1202), 0x0304);
+		TS_ASSERT_EQUALS(data[1206], 1);
+		TS_ASSERT_EQUALS(data[1207], 0);
+
+		int16 native2[300];
+		int wide2[300];
+		uint16 be2[3];
+		bool flags2[3];
+		Common::MemoryReadStream in(out.getData(), out.size());
+		Common::Serializer loader(&in, 0);
+		syncArrays(loader, native2, wide2, be2, flags2);
+		TS_ASSERT_EQUALS(loader.bytesSynced(), 1209u);
+		TS_ASSERT(!memcmp(native, native2, sizeof(native)));
+		TS_ASSERT(!memcmp(wide, wide2, sizeof(wide)));
+		TS_ASSERT(!memcmp(be, be2, sizeof(be)));
+		TS_ASSERT(flags2[0] && !flags2[1] && flags2[2]);
+	}
+
+	// Saves two chunks, the second one with a nested chunk
+	static void saveChunks(Common::WriteStream *stream) {
+		Common::Serializer ser(0, stream);
+		ser.syncVersion(2);
+
+		uint32 a = 1, b = 2, c = 3;
+		ser.beginChunk();
+		ser.syncAsUint32LE(a);
+		ser.endChunk();
+
+		ser.beginChunk();
+		ser.syncAsUint16LE(b);
+		ser.beginChunk();
+		ser.syncAsUint32LE(c);
+		ser.endChunk();
+		ser.syncAsUint16LE(b);
+		ser.endChunk();
+
+		ser.syncAsByte(a);
+		TS_ASSERT_EQUALS(ser.bytesSynced(), 29u);
+	}
+
+	void test_chunks() {
+		Common::MemoryWriteStreamDynamic out(DisposeAfterUse::YES);
+		saveChunks(&out);
+		TS_ASSERT_EQUALS(out.size(), 29u);
+
+		Common::MemoryReadStream in(out.getData(), out.size());
+		Common::Serializer ser(&in, 0);
+		ser.syncVersion(2);
+
+		// Read only part of the first chunk, and skip the second one
+		uint16 value = 0;
+		TS_ASSERT_EQUALS(ser.beginChunk(), 4u);
+		ser.syncAsUint16LE(value);
+		TS_ASSERT_EQUALS(value, 1);
+		ser.endChunk();
+
+		TS_ASSERT_EQUALS(ser.beginChunk(), 12u);
+		ser.endChunk();
+
+		ser.syncAsByte(value);
+		TS_ASSERT_EQUALS(value, 1);
+		TS_ASSERT_EQUALS(ser.bytesSynced(), 29u);
+		TS_ASSERT_EQUALS(in.pos(), 29);
+	}
 };
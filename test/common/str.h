@@ -516,4 +516,23 @@ class StringTestSuite : public CxxTest::TestSuite
 		TS_ASSERT_EQUALS(s3, "TestTestTest");
 		TS_ASSERT_EQUALS(s4, "TestTestTestTestTestTestTestTestTestTestTest");
 	}
+
+	void test_move() {
+#if __cplusplus >= 201103L
+		Common::String s1("This string is too long for the builtin storage");
+		const char *storage = s1.c_str();
+
+		Common::String s2(Common::move(s1));
+		TS_ASSERT_EQUALS(s2.c_str(), storage);
+		TS_ASSERT(s1.empty());
+
+		Common::String s3("short");
+		s3 = Common::move(s2);
+		TS_ASSERT_EQUALS(s3.c_str(), storage);
+		TS_ASSERT(s2.empty());
+
+		s2 = Common::move(Common::String("short"));
+		TS_ASSERT_EQUALS(s2, "short");
+#endif
+	}
 };
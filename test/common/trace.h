@@ -0,0 +1,81 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/memstream.h"
+#include "common/trace.h"
+
+class TraceTestSuite : public CxxTest::TestSuite {
+	static Common::TraceRecorder::Event event(char phase, const char *category, const char *name, uint64 time, int32 value = 0) {
+		Common::TraceRecorder::Event e;
+		e.category = category;
+		e.name = name;
+		e.time = time;
+		e.value = value;
+		e.phase = phase;
+		return e;
+	}
+
+	static Common::String finish(Common::TraceRecorder *recorder, Common::MemoryWriteStreamDynamic *stream) {
+		TS_ASSERT(recorder->stop());
+		Common::String text((const char *)stream->getData(), stream->size());
+		delete stream;
+		delete recorder;
+		return text;
+	}
+
+public:
+	void test_events() {
+		Common::MemoryWriteStreamDynamic *stream = new Common::MemoryWriteStreamDynamic(DisposeAfterUse::YES);
+		Common::TraceRecorder *recorder = new Common::TraceRecorder(false);
+		recorder->start(stream, DisposeAfterUse::NO);
+
+		recorder->addEvent(event(Common::TraceRecorder::kPhaseBegin, "engine", "loop", 5000000));
+		recorder->addEvent(event(Common::TraceRecorder::kPhaseCounter, "audio", "channels", 5000100, 7));
+		recorder->addEvent(event(Common::TraceRecorder::kPhaseEnd, "engine", "loop", 5000250));
+		TS_ASSERT_EQUALS(recorder->getPendingEvents(), 3u);
+
+		recorder->flush();
+		TS_ASSERT_EQUALS(recorder->getPendingEvents(), 0u);
+
+		// Timestamps are relative to the first event, and above 32 bits here
+		recorder->addEvent(event(Common::TraceRecorder::kPhaseFrame, "frame", "Frame", 5000000 + 5000000000ULL));
+
+		const Common::String text = finish(recorder, stream);
+		TS_ASSERT_EQUALS(text,
+			"[\n"
+			"{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"engine\"}},\n"
+			"{\"name\":\"loop\",\"cat\":\"engine\",\"ph\":\"B\",\"ts\":0,\"pid\":1,\"tid\":1},\n"
+			"{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"audio\"}},\n"
+			"{\"name\":\"channels\",\"cat\":\"audio\",\"ph\":\"C\",\"ts\":100,\"pid\":1,\"tid\":2,\"args\":{\"value\":7}},\n"
+			"{\"name\":\"loop\",\"cat\":\"engine\",\"ph\":\"E\",\"ts\":250,\"pid\":1,\"tid\":1},\n"
+			"{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":3,\"args\":{\"name\":\"frame\"}},\n"
+			"{\"name\":\"Frame\",\"cat\":\"frame\",\"ph\":\"i\",\"ts\":5000000000,\"pid\":1,\"tid\":3,\"s\":\"g\"}\n"
+			"]\n");
+	}
+
+	void test_empty() {
+		Common::MemoryWriteStreamDynamic *stream = new Common::MemoryWriteStreamDynamic(DisposeAfterUse::YES);
+		Common::TraceRecorder *recorder = new Common::TraceRecorder(false);
+		recorder->start(stream, DisposeAfterUse::NO);
+		TS_ASSERT_EQUALS(finish(recorder, stream), "[\n\n]\n");
+	}
+
+	void test_stopped() {
+		Common::TraceRecorder recorder(false);
+
+		// Events are ignored unless the recorder is started
+		recorder.addEvent(event(Common::TraceRecorder::kPhaseInstant, "engine", "early", 100));
+		TS_ASSERT_EQUALS(recorder.getPendingEvents(), 0u);
+
+		Common::MemoryWriteStreamDynamic stream(DisposeAfterUse::YES);
+		recorder.start(&stream, DisposeAfterUse::NO);
+		recorder.addEvent(event(Common::TraceRecorder::kPhaseInstant, "engine", "now", 200));
+		TS_ASSERT(recorder.stop());
+		recorder.addEvent(event(Common::TraceRecorder::kPhaseInstant, "engine", "late", 300));
+		TS_ASSERT_EQUALS(recorder.getPendingEvents(), 0u);
+
+		const Common::String text((const char *)stream.getData(), stream.size());
+		TS_ASSERT(text.contains("\"now\""));
+		TS_ASSERT(!text.contains("\"early\""));
+		TS_ASSERT(!text.contains("\"late\""));
+	}
+};
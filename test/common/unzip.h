@@ -0,0 +1,218 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/archive.h"
+#include "common/memstream.h"
+#include "common/unzip.h"
+#include "common/zlib.h"
+
+/*
+ * Builds a ZIP file in memory. Deflated members are produced by stripping
+ * the gzip header and trailer from the output of wrapCompressedWriteStream().
+ */
+class ZipBuilder {
+	struct Entry {
+		Common::String name;
+		uint16 method;
+		uint32 crc;
+		uint32 compressedSize;
+		uint32 uncompressedSize;
+		uint32 offset;
+	};
+
+	Common::MemoryWriteStreamDynamic _zip;
+	Common::Array<Entry> _entries;
+
+public:
+	ZipBuilder() : _zip(DisposeAfterUse::NO) {}
+
+	void addFile(const char *name, const byte *data, uint32 size, bool deflate) {
+		Entry e;
+		e.name = name;
+		e.method = 0;
+		e.crc = 0;
+		e.uncompressedSize = size;
+		e.offset = _zip.pos();
+
+		const byte *payload = data;
+		uint32 payloadSize = size;
+
+		Common::MemoryWriteStreamDynamic deflated(DisposeAfterUse::YES);
+		if (deflate) {
+			byte *gzData = 0;
+			uint32 gzSize = 0;
+			compress(data, size, gzData, gzSize);
+			// Without ZLIB support the data is not compressed, keep it stored
+			if (gzData && gzSize > 18 && gzData[0] == 0x1F && gzData[1] == 0x8B) {
+				e.method = 8;
+				e.crc = READ_LE_UINT32(gzData + gzSize - 8);
+				deflated.write(gzData + 10, gzSize - 18);
+				payload = deflated.getData();
+				payloadSize = deflated.size();
+			}
+			free(gzData);
+		}
+		e.compressedSize = payloadSize;
+
+		_zip.writeUint32LE(0x04034b50);
+		_zip.writeUint16LE(20);
+		_zip.writeUint16LE(0);
+		_zip.writeUint16LE(e.method);
+		_zip.writeUint32LE(0);
+		_zip.writeUint32LE(e.crc);
+		_zip.writeUint32LE(e.compressedSize);
+		_zip.writeUint32LE(e.uncompressedSize);
+		_zip.writeUint16LE(e.name.size());
+		_zip.writeUint16LE(0);
+		_zip.write(e.name.c_str(), e.name.size());
+		_zip.write(payload, payloadSize);
+
+		_entries.push_back(e);
+	}
+
+	static void compress(const byte *data, uint32 size, byte *&out, uint32 &outSize) {
+		Common::MemoryWriteStreamDynamic *mem = new Common::MemoryWriteStreamDynamic(DisposeAfterUse::NO);
+		Common::WriteStream *w = Common::wrapCompressedWriteStream(mem);
+		w->write(data, size);
+		w->finalize();
+		out = mem->getData();
+		outSize = mem->size();
+		delete w;
+	}
+
+	Common::Archive *makeArchive() {
+		uint32 centralOffset = _zip.pos();
+		for (uint i = 0; i < _entries.size(); ++i) {
+			const Entry &e = _entries[i];
+			_zip.writeUint32LE(0x02014b50);
+			_zip.writeUint16LE(20);
+			_zip.writeUint16LE(20);
+			_zip.writeUint16LE(0);
+			_zip.writeUint16LE(e.method);
+			_zip.writeUint32LE(0);
+			_zip.writeUint32LE(e.crc);
+			_zip.writeUint32LE(e.compressedSize);
+			_zip.writeUint32LE(e.uncompressedSize);
+			_zip.writeUint16LE(e.name.size());
+			_zip.writeUint16LE(0);
+			_zip.writeUint16LE(0);
+			_zip.writeUint16LE(0);
+			_zip.writeUint16LE(0);
+			_zip.writeUint32LE(0);
+			_zip.writeUint32LE(e.offset);
+			_zip.write(e.name.c_str(), e.name.size());
+		}
+		uint32 centralSize = _zip.pos() - centralOffset;
+
+		_zip.writeUint32LE(0x06054b50);
+		_zip.writeUint16LE(0);
+		_zip.writeUint16LE(0);
+		_zip.writeUint16LE(_entries.size());
+		_zip.writeUint16LE(_entries.size());
+		_zip.writeUint32LE(centralSize);
+		_zip.writeUint32LE(centralOffset);
+		_zip.writeUint16LE(0);
+
+		return Common::makeZipArchive(new Common::MemoryReadStream(_zip.getData(), _zip.size(), DisposeAfterUse::YES));
+	}
+};
+
+class UnzipTestSuite : public CxxTest::TestSuite {
+	enum {
+		kBigSize = 2 * 1024 * 1024
+	};
+
+	byte *_big;
+
+	static void fillData(byte *data, uint32 size) {
+		// Compressible, but not trivially so
+		uint32 x = 12345;
+		for (uint32 i = 0; i < size; ++i) {
+			x = x * 1103515245 + 12345;
+			data[i] = (i % 7 == 0) ? (byte)(x >> 16) : (byte)(i / 100);
+		}
+	}
+
+	bool checkRange(Common::SeekableReadStream *stream, uint32 start, uint32 len) {
+		byte *buf = (byte *)malloc(len);
+		stream->seek(start, SEEK_SET);
+		bool ok = stream->read(buf, len) == len && !memcmp(buf, _big + start, len);
+		free(buf);
+		return ok;
+	}
+
+public:
+	void setUp() {
+		_big = (byte *)malloc(kBigSize);
+		fillData(_big, kBigSize);
+	}
+
+	void tearDown() {
+		free(_big);
+	}
+
+	void test_stored_member() {
+		ZipBuilder zip;
+		zip.addFile("stored.bin", _big, 1000, false);
+		Common::Archive *archive = zip.makeArchive();
+		TS_ASSERT(archive);
+
+		Common::SeekableReadStream *stream = archive->createReadStreamForMember("STORED.BIN");
+		TS_ASSERT(stream);
+		TS_ASSERT_EQUALS(stream->size(), 1000);
+		TS_ASSERT(checkRange(stream, 500, 500));
+		TS_ASSERT(checkRange(stream, 0, 10));
+
+		byte b;
+		stream->seek(0, SEEK_END);
+		TS_ASSERT_EQUALS(stream->read(&b, 1), 0u);
+		TS_ASSERT(stream->eos());
+
+		// The member stream outlives the archive
+		delete archive;
+		TS_ASSERT(checkRange(stream, 100, 200));
+		delete stream;
+	}
+
+	void test_deflated_member() {
+		ZipBuilder zip;
+		zip.addFile("small.bin", _big, 5000, true);
+		zip.addFile("big.bin", _big, kBigSize, true);
+		Common::Archive *archive = zip.makeArchive();
+		TS_ASSERT(archive);
+
+		Common::SeekableReadStream *small = archive->createReadStreamForMember("small.bin");
+		Common::SeekableReadStream *big = archive->createReadStreamForMember("big.bin");
+		TS_ASSERT(small);
+		TS_ASSERT(big);
+		delete archive;
+
+		TS_ASSERT_EQUALS(big->size(), (int32)kBigSize);
+
+		// Sequential read in uneven chunks, interleaved with another member
+		uint32 pos = 0;
+		while (pos < kBigSize) {
+			uint32 len = MIN<uint32>(70000, kBigSize - pos);
+			TS_ASSERT(checkRange(big, pos, len));
+			TS_ASSERT(checkRange(small, pos % 4000, 1000));
+			pos += len;
+		}
+
+		byte b;
+		TS_ASSERT_EQUALS(big->read(&b, 1), 0u);
+		TS_ASSERT(big->eos());
+		TS_ASSERT(!big->err());
+
+		// Backward and forward seeks
+		TS_ASSERT(checkRange(big, 1500000, 1000));
+		TS_ASSERT(checkRange(big, 10, 1000));
+		TS_ASSERT(checkRange(big, kBigSize - 100, 100));
+		TS_ASSERT(checkRange(big, 700000, 70000));
+
+		big->seek(-10, SEEK_END);
+		TS_ASSERT_EQUALS(big->pos(), (int32)kBigSize - 10);
+		TS_ASSERT(!big->seek(1, SEEK_END));
+
+		delete small;
+		delete big;
+	}
+};
@@ -0,0 +1,177 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/memstream.h"
+#include "common/xmlparser.h"
+
+class TestXMLParser : public Common::XMLParser {
+public:
+	Common::String _log;
+
+protected:
+	CUSTOM_XML_PARSER(TestXMLParser) {
+		XML_KEY(doc)
+			XML_KEY(item)
+				XML_PROP(id, true)
+				XML_PROP(color, false)
+				XML_KEY(sub)
+					XML_PROP(name, true)
+				KEY_END()
+			KEY_END()
+		KEY_END()
+	} PARSER_END()
+
+	bool parserCallback_doc(ParserNode *node) {
+		_log += "doc;";
+		return true;
+	}
+
+	bool parserCallback_item(ParserNode *node) {
+		_log += "item " + node->values["id"];
+		if (node->values.contains("color"))
+			_log += " " + node->values["color"];
+		_log += ";";
+		return true;
+	}
+
+	bool parserCallback_sub(ParserNode *node) {
+		_log += "sub " + node->values["name"] + " in " + getParentNode(node)->values["id"] + ";";
+		return true;
+	}
+
+	bool closedKeyCallback(ParserNode *node) {
+		_log += "/" + node->name + ";";
+		return true;
+	}
+};
+
+class XMLParserTestSuite : public CxxTest::TestSuite {
+	static bool parse(TestXMLParser &parser, const char *xml) {
+		parser._log.clear();
+		parser.loadBuffer((const byte *)xml, strlen(xml));
+		bool result = parser.parse();
+		parser.close();
+		return result;
+	}
+
+	public:
+	void test_name_table() {
+		Common::XMLNameTable names;
+		TS_ASSERT_EQUALS(names.find("id", 2), -1);
+		TS_ASSERT_EQUALS(names.intern("id", 2), 0);
+		TS_ASSERT_EQUALS(names.intern("idle", 2), 0);
+		TS_ASSERT_EQUALS(names.intern("name"), 1);
+
+		// Enough names to grow the table a few times
+		for (int i = 0; i < 500; ++i)
+			names.intern(Common::String::format("name%d", i));
+		TS_ASSERT_EQUALS(names.size(), 502u);
+		TS_ASSERT_EQUALS(names.find("name", 4), 1);
+		TS_ASSERT_EQUALS(names.getName(names.find("name123", 7)), "name123");
+	}
+
+	void test_pull_parser() {
+		const char *xml = "<?xml version = '1.0'?>\n<!-- comment -->\n<a x='1' y = \"two words\"><b z=3/></a>";
+		Common::XMLNameTable names;
+		Common::XMLPullParser parser(xml, strlen(xml), names);
+
+		TS_ASSERT_EQUALS(parser.next(), Common::XMLPullParser::kEventKeyStart);
+		TS_ASSERT(parser.isHeader());
+		TS_ASSERT(parser.getName().equals("xml"));
+		TS_ASSERT_EQUALS(parser.next(), Common::XMLPullParser::kEventKeyEnd);
+
+		TS_ASSERT_EQUALS(parser.next(), Common::XMLPullParser::kEventKeyStart);
+		TS_ASSERT(!parser.isHeader());
+		TS_ASSERT(parser.getName().equals("a"));
+		TS_ASSERT(!parser.getName().equals("ab"));
+		TS_ASSERT_EQUALS(parser.getProperties().size(), 2u);
+		TS_ASSERT_EQUALS(parser.getProperties()[0].name, names.find("x", 1));
+		TS_ASSERT(parser.getProperties()[1].value.equals("two words"));
+		// Values point into the source
+		TS_ASSERT(parser.getProperties()[1].value.data > xml && parser.getProperties()[1].value.data < xml + strlen(xml));
+		TS_ASSERT_EQUALS(parser.getDepth(), 1u);
+
+		TS_ASSERT_EQUALS(parser.next(), Common::XMLPullParser::kEventKeyStart);
+		TS_ASSERT(parser.getName().equals("b"));
+		TS_ASSERT_EQUALS(parser.getProperties()[0].value.toString(), "3");
+		TS_ASSERT_EQUALS(parser.next(), Common::XMLPullParser::kEventKeyEnd);
+		TS_ASSERT_EQUALS(parser.next(), Common::XMLPullParser::kEventKeyEnd);
+		TS_ASSERT(parser.getName().equals("a"));
+		TS_ASSERT_EQUALS(parser.next(), Common::XMLPullParser::kEventEOF);
+	}
+
+	void test_pull_parser_errors() {
+		const char *const docs[] = {
+			"<a/>",							// No header
+			"<?xml version='1'?><a></b>",	// Wrong closure
+			"<?xml version='1'?><a x='1' x='2'/>",
+			"<?xml version='1'?><!-- a -- b --><a/>",
+			"<?xml version='1'?><a x='1/>",
+			"<?xml version='1'?>text"
+		};
+
+		for (int i = 0; i < ARRAYSIZE(docs); ++i) {
+			Common::XMLNameTable names;
+			Common::XMLPullParser parser(docs[i], strlen(docs[i]), names);
+			Common::XMLPullParser::Event event;
+			do {
+				event = parser.next();
+			} while (event == Common::XMLPullParser::kEventKeyStart || event == Common::XMLPullParser::kEventKeyEnd);
+			TS_ASSERT_EQUALS(event, Common::XMLPullParser::kEventError);
+			TS_ASSERT(!parser.getError().empty());
+		}
+	}
+
+	void test_parse() {
+		TestXMLParser parser;
+		TS_ASSERT(parse(parser,
+			"<?xml version = '1.0'?>\n"
+			"<doc>\n"
+			"\t<item id = 'first' color = 'red'>\n"
+			"\t\t<sub name = 'one'/>\n"
+			"\t</item>\n"
+			"\t<!-- a comment -->\n"
+			"\t<item id = second/>\n"
+			"</doc>\n"));
+		TS_ASSERT_EQUALS(parser._log, "/xml;doc;item first red;sub one in first;/sub;/item;item second;/item;/doc;");
+	}
+
+	void test_parse_errors() {
+		TestXMLParser parser;
+		// Missing required property
+		TS_ASSERT(!parse(parser, "<?xml version = '1.0'?><doc><item/></doc>"));
+		// Unknown property
+		TS_ASSERT(!parse(parser, "<?xml version = '1.0'?><doc><item id='a' size='1'/></doc>"));
+		// Key outside of its parent
+		TS_ASSERT(!parse(parser, "<?xml version = '1.0'?><doc><sub name='a'/></doc>"));
+		// Unsupported version
+		TS_ASSERT(!parse(parser, "<?xml version = '2.0'?><doc/>"));
+		// Unclosed key
+		TS_ASSERT(!parse(parser, "<?xml version = '1.0'?><doc>"));
+		// Parsing still works afterwards
+		TS_ASSERT(parse(parser, "<?xml version = '1.0'?><doc/>"));
+		TS_ASSERT_EQUALS(parser._log, "/xml;doc;/doc;");
+	}
+
+	void test_parse_compiled() {
+		const char *xml =
+			"<?xml version = '1.0'?>"
+			"<doc><item id = 'a'><sub name = 'x'/><sub name = 'y'/></item><item id = 'b' color = 'blue'/></doc>";
+
+		TestXMLParser parser;
+		Common::MemoryWriteStreamDynamic compiled(DisposeAfterUse::YES);
+		parser.loadBuffer((const byte *)xml, strlen(xml));
+		TS_ASSERT(parser.parse(&compiled));
+		parser.close();
+		const Common::String log = parser._log;
+
+		// A new parser sees the same keys, in the same order
+		TestXMLParser other;
+		Common::MemoryReadStream stream(compiled.getData(), compiled.size());
+		TS_ASSERT(other.parseCompiled(&stream));
+		TS_ASSERT_EQUALS(other._log, log);
+
+		// Truncated data is rejected
+		Common::MemoryReadStream truncated(compiled.getData(), compiled.size() - 3);
+		TS_ASSERT(!other.parseCompiled(&truncated));
+	}
+};
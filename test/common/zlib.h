@@ -0,0 +1,119 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/memstream.h"
+#include "common/zlib.h"
+
+class ZlibTestSuite : public CxxTest::TestSuite {
+	enum {
+		kBigSize = 3 * 1024 * 1024
+	};
+
+	byte *_big;
+
+	static void fillData(byte *data, uint32 size) {
+		// Compressible, but not trivially so
+		uint32 x = 54321;
+		for (uint32 i = 0; i < size; ++i) {
+			x = x * 1103515245 + 12345;
+			data[i] = (i % 5 == 0) ? (byte)(x >> 16) : (byte)(i / 300);
+		}
+	}
+
+	static Common::SeekableReadStream *compress(const byte *data, uint32 size) {
+		Common::MemoryWriteStreamDynamic *mem = new Common::MemoryWriteStreamDynamic(DisposeAfterUse::NO);
+		Common::WriteStream *w = Common::wrapCompressedWriteStream(mem);
+		w->write(data, size);
+		w->finalize();
+		byte *out = mem->getData();
+		uint32 outSize = mem->size();
+		delete w;
+		return new Common::MemoryReadStream(out, outSize, DisposeAfterUse::YES);
+	}
+
+	bool checkRange(Common::SeekableReadStream *stream, uint32 start, uint32 len) {
+		byte *buf = (byte *)malloc(len);
+		stream->seek(start, SEEK_SET);
+		bool ok = stream->read(buf, len) == len && !memcmp(buf, _big + start, len);
+		free(buf);
+		return ok;
+	}
+
+public:
+	void setUp() {
+		_big = (byte *)malloc(kBigSize);
+		fillData(_big, kBigSize);
+	}
+
+	void tearDown() {
+		free(_big);
+	}
+
+	void test_round_trip() {
+		Common::SeekableReadStream *stream = Common::wrapCompressedReadStream(compress(_big, 1000));
+		TS_ASSERT_EQUALS(stream->size(), 1000);
+		TS_ASSERT(checkRange(stream, 0, 1000));
+
+		byte b;
+		TS_ASSERT_EQUALS(stream->read(&b, 1), 0u);
+		TS_ASSERT(stream->eos());
+		TS_ASSERT(!stream->err());
+		delete stream;
+	}
+
+	void test_seek() {
+		Common::SeekableReadStream *stream = Common::wrapCompressedReadStream(compress(_big, kBigSize));
+		TS_ASSERT_EQUALS(stream->size(), (int32)kBigSize);
+
+		// Read everything, which sets up the checkpoints
+		TS_ASSERT(checkRange(stream, 0, kBigSize));
+		TS_ASSERT_EQUALS(stream->pos(), (int32)kBigSize);
+
+		// Backward seeks resume from checkpoints, or from the start
+		TS_ASSERT(checkRange(stream, 2 * 1024 * 1024 + 17, 100000));
+		TS_ASSERT(checkRange(stream, 1234, 5000));
+		TS_ASSERT(checkRange(stream, 1024 * 1024 - 3, 70000));
+		TS_ASSERT(checkRange(stream, kBigSize - 10, 10));
+
+		// A forward seek from the start jumps over the checkpoints before
+		stream->seek(0, SEEK_SET);
+		TS_ASSERT(checkRange(stream, 2500000, 300000));
+
+		stream->seek(-100, SEEK_END);
+		TS_ASSERT_EQUALS(stream->pos(), (int32)kBigSize - 100);
+		TS_ASSERT(!stream->err());
+		delete stream;
+	}
+
+	void test_seek_before_checkpoints() {
+		// Seeking before reading far enough to take any checkpoint
+		Common::SeekableReadStream *stream = Common::wrapCompressedReadStream(compress(_big, kBigSize));
+		TS_ASSERT(checkRange(stream, 1500000, 1000));
+		TS_ASSERT(checkRange(stream, 1000, 1000));
+		TS_ASSERT(checkRange(stream, 3000000, 1000));
+		delete stream;
+	}
+
+	void test_reused_write_stream() {
+		// The second stream reuses the state of the first one, which must
+		// not leave any traces in the output
+		Common::SeekableReadStream *first = compress(_big, 200000);
+		Common::SeekableReadStream *other = compress(_big + 1000, 5000);
+		Common::SeekableReadStream *second = compress(_big, 200000);
+		delete other;
+
+		TS_ASSERT_EQUALS(first->size(), second->size());
+		byte *a = (byte *)malloc(first->size());
+		byte *b = (byte *)malloc(second->size());
+		first->read(a, first->size());
+		second->read(b, second->size());
+		TS_ASSERT(!memcmp(a, b, first->size()));
+		free(a);
+		free(b);
+
+		first->seek(0, SEEK_SET);
+		Common::SeekableReadStream *stream = Common::wrapCompressedReadStream(first);
+		TS_ASSERT(checkRange(stream, 0, 200000));
+		delete stream;
+		delete second;
+	}
+};
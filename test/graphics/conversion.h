@@ -0,0 +1,113 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/endian.h"
+#include "graphics/conversion.h"
+#include "graphics/pixelformat.h"
+
+class ConversionTestSuite : public CxxTest::TestSuite {
+	enum {
+		kWidth = 13,
+		kHeight = 3,
+		kMaxPitch = (kWidth + 3) * 4
+	};
+
+	static Graphics::PixelFormat format(int i) {
+		switch (i) {
+		case 0: return Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0);   // RGB565
+		case 1: return Graphics::PixelFormat(2, 5, 5, 5, 0, 10, 5, 0, 0);   // RGB555
+		case 2: return Graphics::PixelFormat(2, 5, 5, 5, 1, 10, 5, 0, 15);  // ARGB1555
+		case 3: return Graphics::PixelFormat(2, 4, 4, 4, 4, 8, 4, 0, 12);   // ARGB4444
+		case 4: return Graphics::PixelFormat(3, 8, 8, 8, 0, 16, 8, 0, 0);   // RGB888
+		case 5: return Graphics::PixelFormat(3, 8, 8, 8, 0, 0, 8, 16, 0);   // BGR888
+		case 6: return Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0);  // RGBA8888
+		case 7: return Graphics::PixelFormat(4, 8, 8, 8, 8, 16, 8, 0, 24);  // ARGB8888
+		case 8: return Graphics::PixelFormat(4, 8, 8, 8, 8, 0, 8, 16, 24);  // ABGR8888
+		default: return Graphics::PixelFormat(4, 8, 8, 8, 0, 16, 8, 0, 0); // XRGB8888
+		}
+	}
+
+	static const int kNumFormats = 10;
+
+	static uint32 readPixel(const byte *p, int bytesPerPixel) {
+		if (bytesPerPixel == 2)
+			return READ_UINT16(p);
+		if (bytesPerPixel == 3)
+			return READ_UINT24(p);
+		return READ_UINT32(p);
+	}
+
+	static void fill(byte *data, uint size, uint32 seed) {
+		for (uint i = 0; i < size; ++i) {
+			seed = seed * 1103515245 + 12345;
+			data[i] = seed >> 16;
+		}
+	}
+
+	/** Convert with crossBlit, and compare to the conversion of each pixel on its own. */
+	static bool checkConversion(const Graphics::PixelFormat &srcFmt, const Graphics::PixelFormat &dstFmt, bool inPlace) {
+		const uint srcPitch = kWidth * srcFmt.bytesPerPixel + (inPlace ? 0 : 5);
+		const uint dstPitch = kWidth * dstFmt.bytesPerPixel + (inPlace ? 0 : 3);
+		byte src[kMaxPitch * kHeight];
+		byte dst[kMaxPitch * kHeight];
+		fill(src, sizeof(src), 7);
+		memcpy(dst, src, sizeof(dst));
+
+		if (!Graphics::crossBlit(dst, inPlace ? dst : src, dstPitch, srcPitch, kWidth, kHeight, dstFmt, srcFmt))
+			return false;
+
+		for (int y = 0; y < kHeight; ++y) {
+			for (int x = 0; x < kWidth; ++x) {
+				byte a, r, g, b;
+				srcFmt.colorToARGB(readPixel(src + y * srcPitch + x * srcFmt.bytesPerPixel, srcFmt.bytesPerPixel), a, r, g, b);
+				const uint32 expected = dstFmt.ARGBToColor(a, r, g, b);
+				if (readPixel(dst + y * dstPitch + x * dstFmt.bytesPerPixel, dstFmt.bytesPerPixel) != expected)
+					return false;
+			}
+		}
+		return true;
+	}
+
+public:
+	void test_cross_blit() {
+		for (int i = 0; i < kNumFormats; ++i) {
+			for (int j = 0; j < kNumFormats; ++j) {
+				const Graphics::PixelFormat srcFmt = format(i);
+				const Graphics::PixelFormat dstFmt = format(j);
+				// Equal formats are copied, including unused bits
+				if (dstFmt.bytesPerPixel == 3 || i == j)
+					continue;
+				TSM_ASSERT((srcFmt.toString() + " -> " + dstFmt.toString()).c_str(), checkConversion(srcFmt, dstFmt, false));
+				TSM_ASSERT((srcFmt.toString() + " -> " + dstFmt.toString()).c_str(), checkConversion(srcFmt, dstFmt, true));
+			}
+		}
+	}
+
+	void test_cross_blit_map() {
+		byte palette[256 * 3];
+		fill(palette, sizeof(palette), 3);
+
+		for (int i = 0; i < kNumFormats; ++i) {
+			const Graphics::PixelFormat dstFmt = format(i);
+			if (dstFmt.bytesPerPixel == 3)
+				continue;
+
+			uint32 map[256];
+			Graphics::convertPaletteToMap(map, palette, 256, dstFmt);
+
+			// In place, from the start of the buffer
+			const uint dstPitch = kWidth * dstFmt.bytesPerPixel;
+			byte src[kWidth * kHeight];
+			byte dst[kMaxPitch * kHeight];
+			fill(src, sizeof(src), 11);
+			memcpy(dst, src, sizeof(src));
+			TS_ASSERT(Graphics::crossBlitMap(dst, dst, dstPitch, kWidth, kWidth, kHeight, dstFmt.bytesPerPixel, map));
+
+			bool equal = true;
+			for (int p = 0; p < kWidth * kHeight; ++p) {
+				const byte *color = palette + src[p] * 3;
+				equal &= readPixel(dst + p * dstFmt.bytesPerPixel, dstFmt.bytesPerPixel) == dstFmt.RGBToColor(color[0], color[1], color[2]);
+			}
+			TS_ASSERT(equal);
+		}
+	}
+};
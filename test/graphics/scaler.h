@@ -0,0 +1,174 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/util.h"
+#include "graphics/scaler.h"
+#include "graphics/scaler/intern.h"
+#include "graphics/scaler/scale2x.h"
+#include "graphics/scaler/scale3x.h"
+
+class ScalerTestSuite : public CxxTest::TestSuite {
+	enum {
+		kWidth = 29,
+		kPitch = kWidth + 2,
+		kRows = 8,
+
+		// A frame with a width which is not a multiple of the vector size,
+		// and a pitch bigger than the width plus the border
+		kFrameWidth = 61,
+		kFrameHeight = 19,
+		kFramePitch = kFrameWidth + 5
+	};
+
+	uint16 _src[kRows * kPitch];
+
+	static void fillPixels(uint16 *pixels, int count, uint32 seed) {
+		// Mostly runs of a few colors, with nearby and random ones mixed in,
+		// so every rule and every threshold of the scalers gets exercised
+		uint32 x = seed;
+		for (int i = 0; i < count; ++i) {
+			x = x * 1103515245 + 12345;
+			const uint16 base = ((i / 3) & 1) ? 0x8410 : 0x4208;
+			switch ((x >> 16) % 4) {
+			case 0: pixels[i] = base; break;
+			case 1: pixels[i] = base + ((x >> 8) & 0x0821); break;
+			case 2: pixels[i] = base ^ 0xFFFF; break;
+			default: pixels[i] = (uint16)(x >> 12); break;
+			}
+		}
+	}
+
+	void fillSource(uint32 seed) {
+		fillPixels(_src, kRows * kPitch, seed);
+	}
+
+#ifdef USE_HQ_SCALERS
+	/** Scale a frame, and return the FNV-1a hash of the result. */
+	static uint32 hashScaledFrame(ScalerProc *scaler, int factor, uint32 seed) {
+		// The scalers read one pixel around the area they scale
+		uint16 src[kFramePitch * (kFrameHeight + 2)];
+		fillPixels(src, ARRAYSIZE(src), seed);
+
+		const int dstPitch = factor * kFrameWidth + 3;
+		uint16 *dst = new uint16[dstPitch * factor * kFrameHeight];
+		scaler((const uint8 *)(src + kFramePitch + 1), kFramePitch * 2, (uint8 *)dst, dstPitch * 2, kFrameWidth, kFrameHeight);
+
+		uint32 hash = 2166136261U;
+		for (int y = 0; y < factor * kFrameHeight; ++y) {
+			for (int x = 0; x < factor * kFrameWidth; ++x) {
+				const uint16 pixel = dst[y * dstPitch + x];
+				hash = (hash ^ (pixel & 0xFF)) * 16777619;
+				hash = (hash ^ (pixel >> 8)) * 16777619;
+			}
+		}
+		delete[] dst;
+		return hash;
+	}
+#endif
+
+public:
+	void setUp() {
+		InitScalers(565);
+	}
+
+	void tearDown() {
+		DestroyScalers();
+	}
+
+#ifdef USE_HQ_SCALERS
+	void test_hq_patterns() {
+		uint32 yuv[kRows * kPitch];
+		uint16 patterns[kWidth];
+
+		for (uint32 seed = 1; seed <= 20; ++seed) {
+			fillSource(seed);
+			convertToHQYUV(yuv, _src, kRows * kPitch);
+
+			for (int y = 1; y < kRows - 1; ++y) {
+				const uint32 *above = yuv + (y - 1) * kPitch, *row = above + kPitch, *below = row + kPitch;
+				// Also cover widths which leave a remainder
+				const int width = kWidth - y;
+				computeHQPatterns(patterns, above, row, below, width);
+
+				for (int x = 0; x < width; ++x) {
+					const uint32 w[9] = {
+						above[x], above[x + 1], above[x + 2],
+						row[x], row[x + 1], row[x + 2],
+						below[x], below[x + 1], below[x + 2]
+					};
+					int expected = 0;
+					for (int i = 0, bit = 1; i < 9; ++i) {
+						if (i == 4)
+							continue;
+						if (diffYUV(w[4], w[i]))
+							expected |= bit;
+						bit <<= 1;
+					}
+					if (diffYUV(w[1], w[5])) expected |= kHQDiff26;
+					if (diffYUV(w[5], w[7])) expected |= kHQDiff68;
+					if (diffYUV(w[7], w[3])) expected |= kHQDiff84;
+					if (diffYUV(w[3], w[1])) expected |= kHQDiff42;
+					TS_ASSERT_EQUALS(patterns[x], expected);
+				}
+			}
+		}
+	}
+#endif
+
+#ifdef USE_HQ_SCALERS
+	void test_hq_frames() {
+		// The hashes of the frames scaled by HQ2x and HQ3x before they
+		// computed the patterns a row at a time, for each seed
+		static const uint32 expected[2][2][3] = {
+			// 565: HQ2x, HQ3x
+			{ { 0xFB08652B, 0x9F421002, 0xC989EFBF }, { 0x93082691, 0x8A60FD59, 0xF0FCCF9D } },
+			// 555: HQ2x, HQ3x
+			{ { 0x9EF5C2E9, 0xC4EDF638, 0x700F5009 }, { 0x207C35A8, 0x95109B7C, 0xD4C12122 } }
+		};
+
+		for (int format = 0; format < 2; ++format) {
+			DestroyScalers();
+			InitScalers(format ? 555 : 565);
+			for (uint32 seed = 1; seed <= 3; ++seed) {
+				TS_ASSERT_EQUALS(hashScaledFrame(HQ2x, 2, seed), expected[format][0][seed - 1]);
+				TS_ASSERT_EQUALS(hashScaledFrame(HQ3x, 3, seed), expected[format][1][seed - 1]);
+			}
+		}
+	}
+#endif
+
+#if defined(SCALE2X_USE_SSE2) || defined(SCALE2X_USE_NEON)
+	void test_scale2x_simd() {
+		uint16 expected[2][2 * kWidth], result[2][2 * kWidth];
+
+		for (uint32 seed = 1; seed <= 20; ++seed) {
+			fillSource(seed);
+			for (int y = 1; y < kRows - 1; ++y) {
+				const uint16 *src = _src + y * kPitch + 1;
+				const unsigned width = kWidth - y;
+				scale2x_16_def(expected[0], expected[1], src - kPitch, src, src + kPitch, width);
+				scale2x_16_simd(result[0], result[1], src - kPitch, src, src + kPitch, width);
+				TS_ASSERT(!memcmp(expected[0], result[0], 2 * width * sizeof(uint16)));
+				TS_ASSERT(!memcmp(expected[1], result[1], 2 * width * sizeof(uint16)));
+			}
+		}
+	}
+#endif
+
+#if defined(SCALE3X_USE_SSE2) || defined(SCALE3X_USE_NEON)
+	void test_scale3x_simd() {
+		uint16 expected[3][3 * kWidth], result[3][3 * kWidth];
+
+		for (uint32 seed = 1; seed <= 20; ++seed) {
+			fillSource(seed);
+			for (int y = 1; y < kRows - 1; ++y) {
+				const uint16 *src = _src + y * kPitch + 1;
+				const unsigned width = kWidth - y;
+				scale3x_16_def(expected[0], expected[1], expected[2], src - kPitch, src, src + kPitch, width);
+				scale3x_16_simd(result[0], result[1], result[2], src - kPitch, src, src + kPitch, width);
+				for (int i = 0; i < 3; ++i)
+					TS_ASSERT(!memcmp(expected[i], result[i], 3 * width * sizeof(uint16)));
+			}
+		}
+	}
+#endif
+};
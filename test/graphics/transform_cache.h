@@ -0,0 +1,99 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/transform_cache.h"
+
+class TransformCacheTestSuite : public CxxTest::TestSuite {
+	typedef Graphics::TransformCache::SurfacePtr SurfacePtr;
+	typedef Graphics::TransformCache::Key Key;
+
+	static SurfacePtr makeSurface(int size) {
+		Graphics::Surface *surf = new Graphics::Surface();
+		surf->create(size, size, Graphics::TransparentSurface::getSupportedPixelFormat());
+		return SurfacePtr(surf, Graphics::SharedPtrSurfaceDeleter());
+	}
+
+	static Key makeKey(const void *owner, int zoom, uint32 alpha = 0xFFFFFFFF) {
+		return Key(owner, Common::Rect(0, 0, 10, 10), Graphics::TransformStruct(zoom, zoom, 30, 1, 2, Graphics::BLEND_NORMAL, alpha), 20, 20, Graphics::FILTER_BILINEAR);
+	}
+
+public:
+	void test_lookup() {
+		Graphics::TransformCache cache;
+		int a, b;
+		SurfacePtr surf = makeSurface(8);
+		cache.insert(makeKey(&a, 150), surf);
+
+		TS_ASSERT_EQUALS(cache.lookup(makeKey(&a, 150)).get(), surf.get());
+		// Blending parameters do not affect the transformed pixels
+		TS_ASSERT_EQUALS(cache.lookup(makeKey(&a, 150, 0x80FF0000)).get(), surf.get());
+		TS_ASSERT(!cache.lookup(makeKey(&a, 151)));
+		TS_ASSERT(!cache.lookup(makeKey(&b, 150)));
+
+		Key other = makeKey(&a, 150);
+		other.transform._hotspot.x = 5;
+		TS_ASSERT(!cache.lookup(other));
+		other = makeKey(&a, 150);
+		other.filteringMode = Graphics::FILTER_NEAREST;
+		TS_ASSERT(!cache.lookup(other));
+
+		Graphics::TransformCache::Stats stats = cache.getStats();
+		TS_ASSERT_EQUALS(stats.hits, 2u);
+		TS_ASSERT_EQUALS(stats.misses, 4u);
+		TS_ASSERT_EQUALS(stats.entries, 1u);
+		TS_ASSERT_EQUALS(stats.bytes, 8u * 8 * 4);
+	}
+
+	void test_eviction() {
+		Graphics::TransformCache cache(3, 1024 * 1024);
+		int owner;
+		for (int i = 0; i < 3; ++i)
+			cache.insert(makeKey(&owner, 100 + i), makeSurface(4));
+
+		// The first one is used again, so the second one is the oldest
+		TS_ASSERT(cache.lookup(makeKey(&owner, 100)));
+		cache.insert(makeKey(&owner, 103), makeSurface(4));
+		TS_ASSERT(cache.lookup(makeKey(&owner, 100)));
+		TS_ASSERT(!cache.lookup(makeKey(&owner, 101)));
+		TS_ASSERT(cache.lookup(makeKey(&owner, 102)));
+		TS_ASSERT(cache.lookup(makeKey(&owner, 103)));
+		TS_ASSERT_EQUALS(cache.getStats().entries, 3u);
+	}
+
+	void test_byte_limit() {
+		Graphics::TransformCache cache(10, 2 * 16 * 16 * 4);
+		int owner;
+		cache.insert(makeKey(&owner, 100), makeSurface(16));
+		cache.insert(makeKey(&owner, 101), makeSurface(16));
+		cache.insert(makeKey(&owner, 102), makeSurface(16));
+		TS_ASSERT(!cache.lookup(makeKey(&owner, 100)));
+		TS_ASSERT(cache.lookup(makeKey(&owner, 102)));
+		TS_ASSERT_EQUALS(cache.getStats().bytes, 2u * 16 * 16 * 4);
+
+		// Surfaces bigger than the cache are not kept at all
+		cache.insert(makeKey(&owner, 103), makeSurface(32));
+		TS_ASSERT(!cache.lookup(makeKey(&owner, 103)));
+		TS_ASSERT_EQUALS(cache.getStats().entries, 2u);
+	}
+
+	void test_invalidate() {
+		Graphics::TransformCache cache;
+		int a, b;
+		SurfacePtr surf = makeSurface(4);
+		cache.insert(makeKey(&a, 100), surf);
+		cache.insert(makeKey(&b, 100), makeSurface(4));
+		cache.insert(makeKey(&a, 200), makeSurface(4));
+
+		cache.invalidate(&a);
+		TS_ASSERT(!cache.lookup(makeKey(&a, 100)));
+		TS_ASSERT(!cache.lookup(makeKey(&a, 200)));
+		TS_ASSERT(cache.lookup(makeKey(&b, 100)));
+		TS_ASSERT_EQUALS(cache.getStats().bytes, 4u * 4 * 4);
+
+		// Users of a surface keep it after it left the cache
+		TS_ASSERT_EQUALS(surf->w, 4);
+
+		cache.clear();
+		TS_ASSERT_EQUALS(cache.getStats().entries, 0u);
+		TS_ASSERT_EQUALS(cache.getStats().bytes, 0u);
+	}
+};
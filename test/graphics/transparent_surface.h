@@ -0,0 +1,139 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/util.h"
+#include "graphics/transparent_surface.h"
+
+class TransparentSurfaceTestSuite : public CxxTest::TestSuite {
+	enum {
+#ifdef SCUMM_LITTLE_ENDIAN
+		kA = 0, kB = 1, kG = 2, kR = 3,
+#else
+		kA = 3, kB = 2, kG = 1, kR = 0,
+#endif
+		kWidth = 37,
+		kHeight = 5
+	};
+
+	static void fill(Graphics::Surface &surf, uint32 seed) {
+		surf.create(kWidth, kHeight, Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0));
+		byte *p = (byte *)surf.getPixels();
+		for (int i = 0; i < kWidth * kHeight * 4; ++i) {
+			seed = seed * 1103515245 + 12345;
+			p[i] = seed >> 16;
+		}
+		// Make sure that the extreme alpha values are covered
+		for (int i = 0; i < kWidth * kHeight; i += 3)
+			p[i * 4 + kA] = (i % 2) ? 0 : 255;
+	}
+
+	/** The blend formulas of the scalar code, for one pixel. */
+	static void blendPixel(const byte *in, byte *out, Graphics::TSpriteBlendMode mode, uint32 color) {
+		const int ca = (color >> 24) & 0xFF;
+		const int c[4] = { 0, (int)(color >> 16) & 0xFF, (int)(color >> 8) & 0xFF, (int)color & 0xFF };
+		const int index[4] = { kA, kR, kG, kB };
+		const int a = in[kA];
+
+		if (color == 0xFFFFFFFF) {
+			if (a == 0)
+				return;
+			for (int i = 1; i < 4; ++i) {
+				const int s = in[index[i]];
+				const int d = out[index[i]];
+				if (mode == Graphics::BLEND_NORMAL)
+					out[index[i]] = (s * a + d * (255 - a)) >> 8;
+				else if (mode == Graphics::BLEND_ADDITIVE)
+					out[index[i]] = MIN(d + (s * a >> 8), 255);
+				else
+					out[index[i]] = d - (s * d * a >> 16);
+			}
+			if (mode == Graphics::BLEND_NORMAL)
+				out[kA] = 255;
+			return;
+		}
+
+		const int ina = a * ca >> 8;
+		for (int i = 1; i < 4; ++i) {
+			const uint32 s = in[index[i]];
+			const uint32 d = out[index[i]];
+			if (mode == Graphics::BLEND_NORMAL)
+				out[index[i]] = (d * (255 - ina) >> 8) + (s * ina * c[i] >> 16);
+			else if (mode == Graphics::BLEND_ADDITIVE)
+				out[index[i]] = MIN<uint32>(d + (c[i] == 255 ? s * ina >> 8 : s * ina * c[i] >> 16), 255);
+			else
+				out[index[i]] = d - (c[i] == 255 ? s * d * a >> 16 : s * c[i] * d * a >> 24);
+		}
+		if (mode != Graphics::BLEND_ADDITIVE)
+			out[kA] = 255;
+	}
+
+	static bool checkBlit(int flipping, Graphics::TSpriteBlendMode mode, uint32 color) {
+		Graphics::TransparentSurface src;
+		Graphics::Surface dst, expected;
+		fill(src, 1);
+		fill(dst, 2);
+		fill(expected, 2);
+
+		src.blit(dst, 0, 0, flipping, nullptr, color, -1, -1, mode);
+
+		for (int y = 0; y < kHeight; ++y) {
+			for (int x = 0; x < kWidth; ++x) {
+				const int sx = (flipping & Graphics::FLIP_H) ? kWidth - 1 - x : x;
+				const int sy = (flipping & Graphics::FLIP_V) ? kHeight - 1 - y : y;
+				blendPixel((const byte *)src.getBasePtr(sx, sy), (byte *)expected.getBasePtr(x, y), mode, color);
+			}
+		}
+
+		const bool equal = !memcmp(dst.getPixels(), expected.getPixels(), kWidth * kHeight * 4);
+		src.free();
+		dst.free();
+		expected.free();
+		return equal;
+	}
+
+public:
+	void test_blend_modes() {
+		static const uint32 colors[] = { 0xFFFFFFFF, 0x80FFFFFF, 0xFF7F3FFF, 0xC0FF2080, 0x01000000 };
+		static const int flips[] = {
+			Graphics::FLIP_NONE, Graphics::FLIP_H, Graphics::FLIP_V, Graphics::FLIP_HV
+		};
+
+		for (int mode = Graphics::BLEND_NORMAL; mode < Graphics::NUM_BLEND_MODES; ++mode) {
+			for (int c = 0; c < ARRAYSIZE(colors); ++c) {
+				for (int f = 0; f < ARRAYSIZE(flips); ++f)
+					TS_ASSERT(checkBlit(flips[f], (Graphics::TSpriteBlendMode)mode, colors[c]));
+			}
+		}
+	}
+
+	void test_transform_sub_area() {
+		// Transforming a part of a surface in place gives the same result
+		// as transforming a copy of that part
+		Graphics::Surface full;
+		fill(full, 3);
+		const Graphics::TransparentSurface area(full.getSubArea(Common::Rect(3, 1, 30, 5)), false);
+		Graphics::TransparentSurface copy;
+		copy.copyFrom(area);
+
+		Graphics::TransparentSurface *a = area.scaleT<Graphics::FILTER_BILINEAR>(50, 9);
+		Graphics::TransparentSurface *b = copy.scaleT<Graphics::FILTER_BILINEAR>(50, 9);
+		TS_ASSERT(!memcmp(a->getPixels(), b->getPixels(), 50 * 9 * 4));
+		a->free();
+		b->free();
+		delete a;
+		delete b;
+
+		const Graphics::TransformStruct transform(150, 120, 33, 5, 2);
+		a = area.rotoscaleT<Graphics::FILTER_BILINEAR>(transform);
+		b = copy.rotoscaleT<Graphics::FILTER_BILINEAR>(transform);
+		TS_ASSERT_EQUALS(a->w, b->w);
+		TS_ASSERT_EQUALS(a->h, b->h);
+		TS_ASSERT(!memcmp(a->getPixels(), b->getPixels(), a->pitch * a->h));
+		a->free();
+		b->free();
+		delete a;
+		delete b;
+
+		copy.free();
+		full.free();
+	}
+};
@@ -0,0 +1,128 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/surface.h"
+#include "graphics/yuv_to_rgb.h"
+
+class YUVToRGBTestSuite : public CxxTest::TestSuite {
+	static Graphics::PixelFormat format(int i) {
+		switch (i) {
+		case 0: return Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0);  // RGB565
+		case 1: return Graphics::PixelFormat(2, 5, 5, 5, 1, 0, 5, 10, 15); // ABGR1555
+		case 2: return Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0); // RGBA8888
+		case 3: return Graphics::PixelFormat(4, 8, 8, 8, 0, 16, 8, 0, 0); // XRGB8888
+		default: return Graphics::PixelFormat(4, 6, 6, 6, 0, 12, 6, 0, 0); // 32 bit with 6 bit channels
+		}
+	}
+
+	static const int kNumFormats = 5;
+
+	static uint32 getPixel(const Graphics::Surface &surface, int x, int y) {
+		if (surface.format.bytesPerPixel == 2)
+			return *(const uint16 *)surface.getBasePtr(x, y);
+		return *(const uint32 *)surface.getBasePtr(x, y);
+	}
+
+	/**
+	 * Convert a YUV444 image which contains every pair of chroma values, with
+	 * a tail which is not a multiple of the vector size. Returns the number
+	 * of pixels which differ from the lookup tables. Those pixels are
+	 * converted one column at a time: rows narrower than eight pixels are
+	 * converted through the tables only.
+	 */
+	static int check444(const Graphics::PixelFormat &format, Graphics::YUVToRGBManager::LuminanceScale scale, int yOffset) {
+		const int width = 256 + 5, height = 256, pitch = width + 3;
+		byte *y = new byte[pitch * height];
+		byte *u = new byte[pitch * height];
+		byte *v = new byte[pitch * height];
+		for (int row = 0; row < height; ++row) {
+			for (int x = 0; x < pitch; ++x) {
+				y[row * pitch + x] = x * 7 + row * 13 + yOffset;
+				u[row * pitch + x] = x;
+				v[row * pitch + x] = row;
+			}
+		}
+
+		Graphics::Surface surface, column;
+		surface.create(width, height, format);
+		column.create(1, height, format);
+		YUVToRGBMan.convert444(&surface, scale, y, u, v, width, height, pitch, pitch);
+
+		int errors = 0;
+		for (int x = 0; x < width; ++x) {
+			YUVToRGBMan.convert444(&column, scale, y + x, u + x, v + x, 1, height, pitch, pitch);
+			for (int row = 0; row < height; ++row) {
+				if (getPixel(surface, x, row) != getPixel(column, 0, row))
+					errors++;
+			}
+		}
+
+		surface.free();
+		column.free();
+		delete[] y;
+		delete[] u;
+		delete[] v;
+		return errors;
+	}
+
+	/**
+	 * The same for a YUV420 image, converted two columns at a time: rows
+	 * narrower than sixteen pixels are converted through the tables only.
+	 */
+	static int check420(const Graphics::PixelFormat &format, Graphics::YUVToRGBManager::LuminanceScale scale) {
+		const int width = 2 * (64 + 5), height = 2 * 48, yPitch = width + 4;
+		const int uvPitch = width / 2 + 1;
+		byte *y = new byte[yPitch * height];
+		byte *u = new byte[uvPitch * height / 2];
+		byte *v = new byte[uvPitch * height / 2];
+		for (int row = 0; row < height; ++row) {
+			for (int x = 0; x < yPitch; ++x)
+				y[row * yPitch + x] = x * 5 + row * 11;
+		}
+		for (int row = 0; row < height / 2; ++row) {
+			for (int x = 0; x < uvPitch; ++x) {
+				u[row * uvPitch + x] = x * 4 + row * 3;
+				v[row * uvPitch + x] = row * 6 - x * 9;
+			}
+		}
+
+		Graphics::Surface surface, columns;
+		surface.create(width, height, format);
+		columns.create(2, height, format);
+		YUVToRGBMan.convert420(&surface, scale, y, u, v, width, height, yPitch, uvPitch);
+
+		int errors = 0;
+		for (int x = 0; x < width; x += 2) {
+			YUVToRGBMan.convert420(&columns, scale, y + x, u + x / 2, v + x / 2, 2, height, yPitch, uvPitch);
+			for (int row = 0; row < height; ++row) {
+				if (getPixel(surface, x, row) != getPixel(columns, 0, row) || getPixel(surface, x + 1, row) != getPixel(columns, 1, row))
+					errors++;
+			}
+		}
+
+		surface.free();
+		columns.free();
+		delete[] y;
+		delete[] u;
+		delete[] v;
+		return errors;
+	}
+
+public:
+	void test_convert444() {
+		for (int i = 0; i < kNumFormats; ++i) {
+			TS_ASSERT_EQUALS(check444(format(i), Graphics::YUVToRGBManager::kScaleFull, 0), 0);
+			TS_ASSERT_EQUALS(check444(format(i), Graphics::YUVToRGBManager::kScaleITU, 0), 0);
+		}
+
+		// Other luminance values for the same chroma values
+		TS_ASSERT_EQUALS(check444(format(2), Graphics::YUVToRGBManager::kScaleFull, 128), 0);
+		TS_ASSERT_EQUALS(check444(format(2), Graphics::YUVToRGBManager::kScaleITU, 128), 0);
+	}
+
+	void test_convert420() {
+		for (int i = 0; i < kNumFormats; ++i) {
+			TS_ASSERT_EQUALS(check420(format(i), Graphics::YUVToRGBManager::kScaleFull), 0);
+			TS_ASSERT_EQUALS(check420(format(i), Graphics::YUVToRGBManager::kScaleITU), 0);
+		}
+	}
+};
@@ -25,6 +25,7 @@
 #include "audio/audiostream.h"
 #include "audio/mixer.h" // for kMaxChannelVolume
 
+#include "common/bufferedstream.h"
 #include "common/rational.h"
 #include "common/file.h"
 #include "common/system.h"
@@ -89,7 +90,11 @@ bool VideoDecoder::loadFile(const Common::String &filename) {
 		return false;
 	}
 
-	return loadStream(file);
+	// Streams from memory-mapped files don't need to be read ahead
+	if (file->getDataPointer())
+		return loadStream(file);
+
+	return loadStream(Common::wrapReadAheadStream(file, DisposeAfterUse::YES, filename));
 }
 
 bool VideoDecoder::needsUpdate() const {